@@ -0,0 +1,54 @@
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "debug_link.h"
+
+#define DEBUG_LINK_MSG_ID_attitude 1
+#define DEBUG_LINK_MSG_SIZE_attitude 28
+#define DEBUG_LINK_MSG_LEN_attitude \
+    (DEBUG_LINK_HEADER_SIZE + DEBUG_LINK_MSG_SIZE_attitude + DEBUG_LINK_CHECKSUM_SIZE)
+
+typedef struct __attribute__((packed)) __debug_link_msg_attitude_t {
+    float q[4]; //quaternion
+    float rpy[3]; //euler angles
+} debug_link_msg_attitude_t;
+
+static_assert(sizeof(debug_link_msg_attitude_t) == DEBUG_LINK_MSG_SIZE_attitude,
+              "unexpected layout of debug_link_msg_attitude_t");
+
+static inline size_t pack_debug_link_attitude_msg(debug_link_msg_attitude_t *msg, uint8_t *data)
+{
+    memcpy(&data[DEBUG_LINK_HEADER_SIZE], msg, DEBUG_LINK_MSG_SIZE_attitude);
+    return finish_debug_link_msg(data, DEBUG_LINK_MSG_ID_attitude,
+                                 DEBUG_LINK_MSG_SIZE_attitude);
+}
+
+static inline int unpack_debug_link_attitude_msg(debug_link_msg_attitude_t *msg, const uint8_t *data, size_t size)
+{
+    int retval = check_debug_link_msg(data, size, DEBUG_LINK_MSG_ID_attitude,
+                                      DEBUG_LINK_MSG_SIZE_attitude);
+    if (retval < 0)
+        return retval;
+
+    memcpy(msg, &data[DEBUG_LINK_HEADER_SIZE], DEBUG_LINK_MSG_SIZE_attitude);
+    return DEBUG_LINK_MSG_LEN_attitude;
+}
+
+static inline int batch_debug_link_attitude_msg(debug_link_batch_t *batch, debug_link_msg_attitude_t *msg)
+{
+    return debug_link_batch_add(batch, DEBUG_LINK_MSG_ID_attitude, msg,
+                                DEBUG_LINK_MSG_SIZE_attitude);
+}
+
+static inline int decode_debug_link_attitude_payload(debug_link_msg_attitude_t *msg, const uint8_t *payload, size_t size)
+{
+    if (size != DEBUG_LINK_MSG_SIZE_attitude)
+        return -1;
+
+    memcpy(msg, payload, DEBUG_LINK_MSG_SIZE_attitude);
+    return 0;
+}
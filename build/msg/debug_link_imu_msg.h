@@ -0,0 +1,54 @@
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "debug_link.h"
+
+#define DEBUG_LINK_MSG_ID_imu 0
+#define DEBUG_LINK_MSG_SIZE_imu 24
+#define DEBUG_LINK_MSG_LEN_imu \
+    (DEBUG_LINK_HEADER_SIZE + DEBUG_LINK_MSG_SIZE_imu + DEBUG_LINK_CHECKSUM_SIZE)
+
+typedef struct __attribute__((packed)) __debug_link_msg_imu_t {
+    float accel[3]; //acceleration
+    float gyro[3]; //angular velocity
+} debug_link_msg_imu_t;
+
+static_assert(sizeof(debug_link_msg_imu_t) == DEBUG_LINK_MSG_SIZE_imu,
+              "unexpected layout of debug_link_msg_imu_t");
+
+static inline size_t pack_debug_link_imu_msg(debug_link_msg_imu_t *msg, uint8_t *data)
+{
+    memcpy(&data[DEBUG_LINK_HEADER_SIZE], msg, DEBUG_LINK_MSG_SIZE_imu);
+    return finish_debug_link_msg(data, DEBUG_LINK_MSG_ID_imu,
+                                 DEBUG_LINK_MSG_SIZE_imu);
+}
+
+static inline int unpack_debug_link_imu_msg(debug_link_msg_imu_t *msg, const uint8_t *data, size_t size)
+{
+    int retval = check_debug_link_msg(data, size, DEBUG_LINK_MSG_ID_imu,
+                                      DEBUG_LINK_MSG_SIZE_imu);
+    if (retval < 0)
+        return retval;
+
+    memcpy(msg, &data[DEBUG_LINK_HEADER_SIZE], DEBUG_LINK_MSG_SIZE_imu);
+    return DEBUG_LINK_MSG_LEN_imu;
+}
+
+static inline int batch_debug_link_imu_msg(debug_link_batch_t *batch, debug_link_msg_imu_t *msg)
+{
+    return debug_link_batch_add(batch, DEBUG_LINK_MSG_ID_imu, msg,
+                                DEBUG_LINK_MSG_SIZE_imu);
+}
+
+static inline int decode_debug_link_imu_payload(debug_link_msg_imu_t *msg, const uint8_t *payload, size_t size)
+{
+    if (size != DEBUG_LINK_MSG_SIZE_imu)
+        return -1;
+
+    memcpy(msg, payload, DEBUG_LINK_MSG_SIZE_imu);
+    return 0;
+}
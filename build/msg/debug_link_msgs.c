@@ -0,0 +1,25 @@
+#include <stddef.h>
+
+#include "debug_link_decoder.h"
+
+static const struct debug_link_field_desc imu_fields[] = {
+    {DEBUG_LINK_TYPE_FLOAT, 3},
+    {DEBUG_LINK_TYPE_FLOAT, 3},
+};
+
+static const struct debug_link_field_desc attitude_fields[] = {
+    {DEBUG_LINK_TYPE_FLOAT, 4},
+    {DEBUG_LINK_TYPE_FLOAT, 3},
+};
+
+static const struct debug_link_field_desc pid_fields[] = {
+    {DEBUG_LINK_TYPE_FLOAT, 3},
+};
+
+const struct debug_link_msg_desc debug_link_msgs[] = {
+    {"imu", 0, 24, 6, imu_fields, 2},
+    {"attitude", 1, 28, 7, attitude_fields, 2},
+    {"pid", 2, 12, 3, pid_fields, 1},
+};
+
+const size_t debug_link_msg_cnt = 3;
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "debug_link.h"
+
+#define DEBUG_LINK_MSG_ID_pid 2
+#define DEBUG_LINK_MSG_SIZE_pid 12
+#define DEBUG_LINK_MSG_LEN_pid \
+    (DEBUG_LINK_HEADER_SIZE + DEBUG_LINK_MSG_SIZE_pid + DEBUG_LINK_CHECKSUM_SIZE)
+
+typedef struct __attribute__((packed)) __debug_link_msg_pid_t {
+    float error_rpy[3]; //error
+} debug_link_msg_pid_t;
+
+static_assert(sizeof(debug_link_msg_pid_t) == DEBUG_LINK_MSG_SIZE_pid,
+              "unexpected layout of debug_link_msg_pid_t");
+
+static inline size_t pack_debug_link_pid_msg(debug_link_msg_pid_t *msg, uint8_t *data)
+{
+    memcpy(&data[DEBUG_LINK_HEADER_SIZE], msg, DEBUG_LINK_MSG_SIZE_pid);
+    return finish_debug_link_msg(data, DEBUG_LINK_MSG_ID_pid,
+                                 DEBUG_LINK_MSG_SIZE_pid);
+}
+
+static inline int unpack_debug_link_pid_msg(debug_link_msg_pid_t *msg, const uint8_t *data, size_t size)
+{
+    int retval = check_debug_link_msg(data, size, DEBUG_LINK_MSG_ID_pid,
+                                      DEBUG_LINK_MSG_SIZE_pid);
+    if (retval < 0)
+        return retval;
+
+    memcpy(msg, &data[DEBUG_LINK_HEADER_SIZE], DEBUG_LINK_MSG_SIZE_pid);
+    return DEBUG_LINK_MSG_LEN_pid;
+}
+
+static inline int batch_debug_link_pid_msg(debug_link_batch_t *batch, debug_link_msg_pid_t *msg)
+{
+    return debug_link_batch_add(batch, DEBUG_LINK_MSG_ID_pid, msg,
+                                DEBUG_LINK_MSG_SIZE_pid);
+}
+
+static inline int decode_debug_link_pid_payload(debug_link_msg_pid_t *msg, const uint8_t *payload, size_t size)
+{
+    if (size != DEBUG_LINK_MSG_SIZE_pid)
+        return -1;
+
+    memcpy(msg, payload, DEBUG_LINK_MSG_SIZE_pid);
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include <arch/host.h>
+#include <fs/fs.h>
+#include <kernel/kernel.h>
+#include <kernel/kfifo.h>
+#include <kernel/mutex.h>
+#include <kernel/preempt.h>
+#include <kernel/wait.h>
+#include <printk.h>
+
+#define CONSOLE_RX_BUF_SIZE 100
+
+static struct {
+    wait_queue_head_t rx_wait_list;
+    struct kfifo *rx_fifo;
+    struct mutex rx_mtx;
+    size_t rx_wait_size;
+} console;
+
+static int console_open(struct inode *inode, struct file *file)
+{
+    return 0;
+}
+
+static ssize_t console_read(struct file *filp,
+                            char *buf,
+                            size_t size,
+                            off_t offset)
+{
+    mutex_lock(&console.rx_mtx);
+
+    preempt_disable();
+    console.rx_wait_size = size;
+    wait_event(console.rx_wait_list, kfifo_len(console.rx_fifo) >= size);
+    preempt_enable();
+
+    kfifo_out(console.rx_fifo, buf, size);
+
+    mutex_unlock(&console.rx_mtx);
+
+    return size;
+}
+
+static ssize_t console_write(struct file *filp,
+                             const char *buf,
+                             size_t size,
+                             off_t offset)
+{
+    host_console_write(buf, size);
+    return size;
+}
+
+static struct file_operations console_file_ops = {
+    .read = console_read,
+    .write = console_write,
+    .open = console_open,
+};
+
+void Console_IRQHandler(void)
+{
+    char buf[CONSOLE_RX_BUF_SIZE];
+
+    /* The tick may come before the console is initialized */
+    if (!console.rx_fifo)
+        return;
+
+    size_t avail = kfifo_avail(console.rx_fifo);
+    if (avail == 0)
+        return;
+
+    int n = host_console_read(buf, avail);
+    for (int i = 0; i < n; i++)
+        kfifo_put(console.rx_fifo, &buf[i]);
+
+    if (console.rx_wait_size &&
+        kfifo_len(console.rx_fifo) >= console.rx_wait_size) {
+        console.rx_wait_size = 0;
+        wake_up(&console.rx_wait_list);
+    }
+}
+
+static void console_init(char *dev_name, char *desc)
+{
+    /* Register the console to the file system */
+    register_chrdev(dev_name, &console_file_ops);
+
+    /* Create wait queue for synchronization */
+    init_waitqueue_head(&console.rx_wait_list);
+
+    /* Create rx buffer */
+    console.rx_fifo = kfifo_alloc(sizeof(uint8_t), CONSOLE_RX_BUF_SIZE);
+
+    mutex_init(&console.rx_mtx);
+
+    printk("chardev %s: %s", dev_name, desc);
+}
+
+void early_write(char *buf, size_t size)
+{
+    host_console_write(buf, size);
+}
+
+void __board_init(void)
+{
+    console_init("console", "shell (stdio of the host)");
+}
@@ -1,9 +1,16 @@
 #include <errno.h>
+#include <fcntl.h>
 #include <string.h>
+#include <sys/imu.h>
 
 #include <fs/fs.h>
 #include <kernel/delay.h>
+#include <kernel/kernel.h>
+#include <kernel/kfifo.h>
 #include <kernel/preempt.h>
+#include <kernel/time.h>
+#include <kernel/trace.h>
+#include <kernel/wait.h>
 #include <printk.h>
 
 #include "lpf.h"
@@ -15,6 +22,23 @@
 
 #define MPU6500_EXTI_ISR_PRIORITY 14
 
+/* Register address followed by the accelerometer, temperature and
+ * gyroscope registers */
+#define MPU6500_BURST_SIZE 15
+
+/* Samples kept for /dev/imu0_fifo, 0 disables the device */
+#define MPU6500_FIFO_DEPTH 32
+
+#define MPU6500_SLOT_CNT 3
+
+/* Published measurements. The sequence is odd while the ISR writes the
+ * slot, so a reader retries if the slot changed during the copy */
+struct mpu6500_slot {
+    volatile uint32_t seq;
+    struct imu_sample sample;
+    float accel_lpf[3];
+};
+
 static struct mpu6500_device mpu6500 = {
     .accel_fs = MPU6500_GYRO_FS_8G,
     .gyro_fs = MPU6500_GYRO_FS_1000_DPS,
@@ -23,6 +47,53 @@ static struct mpu6500_device mpu6500 = {
 /* First order low-pass filter for acceleromter */
 static float mpu6500_lpf_gain;
 
+/* Triple buffer written by the ISR, the readers copy the latest slot */
+static struct mpu6500_slot mpu6500_slots[MPU6500_SLOT_CNT];
+static volatile int mpu6500_latest;
+
+static uint8_t mpu6500_dma_tx[MPU6500_BURST_SIZE];
+static uint8_t mpu6500_dma_rx[MPU6500_BURST_SIZE];
+
+/* CS: GPIO A4 */
+static struct spi_device mpu6500_spi = {
+    .bus = SPI_BUS1,
+    .cs_port = GPIOA,
+    .cs_pin = GPIO_Pin_4,
+    .mode = SPI_MODE_3,
+    .prescaler = SPI_BaudRatePrescaler_4,
+};
+
+static void mpu6500_dma_complete(struct spi_transfer *xfer);
+
+static struct spi_transfer mpu6500_burst = {
+    .dev = &mpu6500_spi,
+    .tx_buf = mpu6500_dma_tx,
+    .rx_buf = mpu6500_dma_rx,
+    .len = MPU6500_BURST_SIZE,
+    .complete = mpu6500_dma_complete,
+};
+
+#if (MPU6500_FIFO_DEPTH != 0)
+static struct kfifo *mpu6500_fifo;
+static wait_queue_head_t mpu6500_fifo_wait_list;
+#endif
+
+static void mpu6500_read_slot(struct mpu6500_slot *copy)
+{
+    struct mpu6500_slot *slot;
+    uint32_t seq;
+
+    /* The ISR never waits for the readers, retry if it overtook us */
+    do {
+        slot = &mpu6500_slots[mpu6500_latest];
+        seq = slot->seq;
+        asm volatile("" ::: "memory");
+        copy->sample = slot->sample;
+        memcpy(copy->accel_lpf, slot->accel_lpf, sizeof(copy->accel_lpf));
+        asm volatile("" ::: "memory");
+    } while ((seq & 1) || seq != slot->seq);
+}
+
 static int mpu6500_accel_open(struct inode *inode, struct file *file)
 {
     return 0;
@@ -36,9 +107,9 @@ static ssize_t mpu6500_accel_read(struct file *filp,
     if (size != sizeof(float[3]))
         return -EINVAL;
 
-    preempt_disable();
-    memcpy(buf, mpu6500.accel_lpf, sizeof(float[3]));
-    preempt_enable();
+    struct mpu6500_slot slot;
+    mpu6500_read_slot(&slot);
+    memcpy(buf, slot.accel_lpf, sizeof(float[3]));
 
     return size;
 }
@@ -61,9 +132,9 @@ static ssize_t mpu6500_gyro_read(struct file *filp,
     if (size != sizeof(float[3]))
         return -EINVAL;
 
-    preempt_disable();
-    memcpy(buf, mpu6500.gyro_raw, sizeof(float[3]));
-    preempt_enable();
+    struct mpu6500_slot slot;
+    mpu6500_read_slot(&slot);
+    memcpy(buf, slot.sample.gyro, sizeof(float[3]));
 
     return size;
 }
@@ -73,6 +144,75 @@ static struct file_operations mpu6500_gyro_fops = {
     .open = mpu6500_gyro_open,
 };
 
+static int mpu6500_imu_open(struct inode *inode, struct file *file)
+{
+    return 0;
+}
+
+static ssize_t mpu6500_imu_read(struct file *filp,
+                                char *buf,
+                                size_t size,
+                                off_t offset)
+{
+    if (size < sizeof(struct imu_sample))
+        return -EINVAL;
+
+    /* Return the latest sample */
+    struct mpu6500_slot slot;
+    mpu6500_read_slot(&slot);
+    memcpy(buf, &slot.sample, sizeof(struct imu_sample));
+
+    return sizeof(struct imu_sample);
+}
+
+static struct file_operations mpu6500_imu_fops = {
+    .read = mpu6500_imu_read,
+    .open = mpu6500_imu_open,
+};
+
+#if (MPU6500_FIFO_DEPTH != 0)
+static int mpu6500_fifo_open(struct inode *inode, struct file *file)
+{
+    return 0;
+}
+
+static ssize_t mpu6500_fifo_read(struct file *filp,
+                                 char *buf,
+                                 size_t size,
+                                 off_t offset)
+{
+    size_t n = size / sizeof(struct imu_sample);
+    if (n == 0)
+        return -EINVAL;
+
+    preempt_disable();
+
+    if (kfifo_is_empty(mpu6500_fifo) && (filp->f_flags & O_NONBLOCK)) {
+        preempt_enable();
+        return -EAGAIN;
+    }
+
+    /* Wait for a sample then return all the queued ones that fit */
+    wait_event(mpu6500_fifo_wait_list, !kfifo_is_empty(mpu6500_fifo));
+
+    size_t len = kfifo_len(mpu6500_fifo);
+    if (n > len)
+        n = len;
+
+    for (size_t i = 0; i < n; i++)
+        kfifo_get(mpu6500_fifo, &buf[i * sizeof(struct imu_sample)]);
+
+    preempt_enable();
+
+    return n * sizeof(struct imu_sample);
+}
+
+static struct file_operations mpu6500_fifo_fops = {
+    .read = mpu6500_fifo_read,
+    .open = mpu6500_fifo_open,
+};
+#endif
+
 static void mpu6500_interrupt_init(void)
 {
     RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOD, ENABLE);
@@ -104,39 +244,39 @@ static void mpu6500_interrupt_init(void)
     NVIC_Init(&NVIC_InitStruct);
 }
 
-static inline void mpu6500_spi_init(void)
-{
-    spi1_init();
-}
-
-static inline uint8_t mpu6500_spi_w8r8(uint8_t data)
-{
-    return spi1_w8r8(data);
-}
-
-static inline void mpu6500_spi_set_chipselect(bool chipselect)
+static int mpu6500_read_byte(uint8_t address, uint8_t *data)
 {
-    spi1_set_chipselect(chipselect);
-}
+    uint8_t tx[2] = {address | 0x80, 0xff};
+    uint8_t rx[2];
+
+    struct spi_transfer xfer = {
+        .dev = &mpu6500_spi,
+        .tx_buf = tx,
+        .rx_buf = rx,
+        .len = sizeof(tx),
+    };
 
-static uint8_t mpu6500_read_byte(uint8_t address)
-{
-    uint8_t read;
+    int retval = spi_sync_polled(&xfer);
+    if (retval < 0)
+        return retval;
 
-    mpu6500_spi_set_chipselect(true);
-    mpu6500_spi_w8r8(address | 0x80);
-    read = mpu6500_spi_w8r8(0xff);
-    mpu6500_spi_set_chipselect(false);
+    *data = rx[1];
 
-    return read;
+    return 0;
 }
 
 static void mpu6500_write_byte(uint8_t address, uint8_t data)
 {
-    mpu6500_spi_set_chipselect(true);
-    mpu6500_spi_w8r8(address);
-    mpu6500_spi_w8r8(data);
-    mpu6500_spi_set_chipselect(false);
+    uint8_t tx[2] = {address, data};
+
+    struct spi_transfer xfer = {
+        .dev = &mpu6500_spi,
+        .tx_buf = tx,
+        .len = sizeof(tx),
+    };
+
+    if (spi_sync_polled(&xfer) < 0)
+        printk("mpu6500: failed to write register 0x%x", address);
 }
 
 void __msleep(uint32_t ms)
@@ -151,7 +291,10 @@ void __msleep(uint32_t ms)
 
 static uint8_t mpu6500_read_who_am_i()
 {
-    uint8_t id = mpu6500_read_byte(MPU6500_WHO_AM_I);
+    uint8_t id;
+    if (mpu6500_read_byte(MPU6500_WHO_AM_I, &id) < 0)
+        id = 0;
+
     __msleep(5);
     return id;
 }
@@ -176,7 +319,7 @@ static void mpu6500_convert_to_scale(void)
 void mpu6500_init(void)
 {
     mpu6500_interrupt_init();
-    mpu6500_spi_init();
+    spi_device_init(&mpu6500_spi);
     __msleep(50);
 
     /* Probe the sensor */
@@ -233,41 +376,69 @@ void mpu6500_init(void)
     mpu6500_write_byte(MPU6500_ACCEL_CONFIG2, ACCEL_DLPF_BANDWIDTH_20Hz);
     __msleep(100);
 
-    /* Enable data-ready interrupt */
-    mpu6500_write_byte(MPU6500_INT_ENABLE, 0x01);
-    __msleep(100);
-
     /* Sampling time = 0.001s (1KHz), Cutoff frequency = 25Hz */
     lpf_first_order_init(&mpu6500_lpf_gain, 0.001, 25);
 
+    /* Burst read from the first measurement register */
+    memset(mpu6500_dma_tx, 0xff, sizeof(mpu6500_dma_tx));
+    mpu6500_dma_tx[0] = MPU6500_ACCEL_XOUT_H | 0x80;
+
+#if (MPU6500_FIFO_DEPTH != 0)
+    mpu6500_fifo = kfifo_alloc(sizeof(struct imu_sample), MPU6500_FIFO_DEPTH);
+    init_waitqueue_head(&mpu6500_fifo_wait_list);
+#endif
+
+    /* Enable the data-ready interrupt, which queues the burst reads from
+     * now on */
+    mpu6500_write_byte(MPU6500_INT_ENABLE, 0x01);
+    __msleep(100);
+
     register_chrdev("accel0", &mpu6500_accel_fops);
     register_chrdev("gyro0", &mpu6500_gyro_fops);
+    register_chrdev("imu0", &mpu6500_imu_fops);
     printk("accel0: mp6500 accelerometer");
     printk("gyro0: mpu6500 gyroscope");
+    printk("imu0: mpu6500 samples");
+
+#if (MPU6500_FIFO_DEPTH != 0)
+    register_chrdev("imu0_fifo", &mpu6500_fifo_fops);
+    printk("imu0_fifo: mpu6500 sample queue of %d", MPU6500_FIFO_DEPTH);
+#endif
 }
 
-void mpu6500_interrupt_handler(void)
+static void mpu6500_publish(void)
+{
+    int next = (mpu6500_latest + 1) % MPU6500_SLOT_CNT;
+    struct mpu6500_slot *slot = &mpu6500_slots[next];
+
+    slot->seq++;
+    asm volatile("" ::: "memory");
+
+    slot->sample.timestamp = mpu6500.timestamp;
+    slot->sample.seq = mpu6500.seq;
+    memcpy(slot->sample.accel, mpu6500.accel_raw, sizeof(float[3]));
+    memcpy(slot->sample.gyro, mpu6500.gyro_raw, sizeof(float[3]));
+    slot->sample.temp = mpu6500.temp_raw;
+    memcpy(slot->accel_lpf, mpu6500.accel_lpf, sizeof(float[3]));
+
+    asm volatile("" ::: "memory");
+    slot->seq++;
+
+    mpu6500_latest = next;
+
+#if (MPU6500_FIFO_DEPTH != 0)
+    /* The oldest sample is overwritten if the consumer falls behind */
+    kfifo_put(mpu6500_fifo, &slot->sample);
+    wake_up_all(&mpu6500_fifo_wait_list);
+#endif
+}
+
+static void mpu6500_dma_complete(struct spi_transfer *xfer)
 {
-    uint8_t buffer[14];
-
-    /* Read measurements */
-    mpu6500_spi_set_chipselect(true);
-    mpu6500_spi_w8r8(MPU6500_ACCEL_XOUT_H | 0x80);
-    buffer[0] = mpu6500_spi_w8r8(0xff);
-    buffer[1] = mpu6500_spi_w8r8(0xff);
-    buffer[2] = mpu6500_spi_w8r8(0xff);
-    buffer[3] = mpu6500_spi_w8r8(0xff);
-    buffer[4] = mpu6500_spi_w8r8(0xff);
-    buffer[5] = mpu6500_spi_w8r8(0xff);
-    buffer[6] = mpu6500_spi_w8r8(0xff);
-    buffer[7] = mpu6500_spi_w8r8(0xff);
-    buffer[8] = mpu6500_spi_w8r8(0xff);
-    buffer[9] = mpu6500_spi_w8r8(0xff);
-    buffer[10] = mpu6500_spi_w8r8(0xff);
-    buffer[11] = mpu6500_spi_w8r8(0xff);
-    buffer[12] = mpu6500_spi_w8r8(0xff);
-    buffer[13] = mpu6500_spi_w8r8(0xff);
-    mpu6500_spi_set_chipselect(false);
+    uint8_t *buffer = &mpu6500_dma_rx[1];
+
+    if (xfer->status < 0)
+        return;
 
     /* Composite measurements */
     mpu6500.accel_unscaled[0] = -s8_to_s16(buffer[0], buffer[1]);
@@ -288,12 +459,36 @@ void mpu6500_interrupt_handler(void)
                     mpu6500_lpf_gain);
     lpf_first_order(mpu6500.accel_raw[2], &(mpu6500.accel_lpf[2]),
                     mpu6500_lpf_gain);
+
+    mpu6500_publish();
+}
+
+void mpu6500_interrupt_handler(void)
+{
+    uint32_t seq = mpu6500.drdy_cnt++;
+    uint64_t timestamp = ktime_get_ns() / 1000;
+
+    /* Read measurements, decoded by the DMA completion. The sample is
+     * dropped if the previous burst is still queued or running */
+    if (spi_async(&mpu6500_burst) < 0) {
+        mpu6500.overruns++;
+        return;
+    }
+
+    /* The completion runs in an ISR of the same priority, so not before
+     * this returns */
+    mpu6500.seq = seq;
+    mpu6500.timestamp = timestamp;
 }
 
 void EXTI15_10_IRQHandler(void)
 {
+    trace_irq_enter();
+
     if (EXTI_GetITStatus(EXTI_Line10) == SET) {
         mpu6500_interrupt_handler();
         EXTI_ClearITPendingBit(EXTI_Line10);
     }
+
+    trace_irq_exit();
 }
@@ -91,6 +91,12 @@ struct mpu6500_device {
     /* Update rate */
     float last_read_time;
     float update_freq;
+
+    /* Burst read */
+    uint64_t timestamp; /* Data-ready time of the sample in microseconds */
+    uint32_t seq;       /* Data-ready interrupt of the sample */
+    uint32_t drdy_cnt;  /* Data-ready interrupts */
+    uint32_t overruns;  /* Samples dropped as the DMA was still busy */
 };
 
 void mpu6500_init(void);
@@ -1,18 +1,70 @@
+#include <errno.h>
 #include <stdbool.h>
+#include <stddef.h>
 
+#include <common/list.h>
+#include <kernel/kernel.h>
+#include <kernel/preempt.h>
+#include <kernel/trace.h>
+#include <kernel/wait.h>
 #include <printk.h>
 
-#include "stm32f4xx.h"
+#include "spi.h"
+#include "stm32f4xx_conf.h"
+
+#define SPI1_DMA_ISR_PRIORITY 14
+
+struct spi_bus {
+    SPI_TypeDef *spi;
+    DMA_Stream_TypeDef *rx_stream;
+    DMA_Stream_TypeDef *tx_stream;
+    uint32_t dma_channel;
+    uint32_t rx_flags;
+    uint32_t tx_flags;
+    uint32_t rx_it_tc;
+    uint32_t rx_it_te;
+    void (*init)(void);
+
+    bool initialized;
+    struct list_head queue;      /* Transfers waiting for the bus */
+    struct spi_transfer *active; /* Transfer owning the DMA */
+    struct spi_device *dev;      /* Device the bus is configured for */
+    wait_queue_head_t wait_list; /* Threads blocked in spi_sync() */
+};
+
+static void spi1_init(void);
+
+static struct spi_bus spi_buses[SPI_BUS_CNT] = {
+    [SPI_BUS1] =
+        {
+            .spi = SPI1,
+            .rx_stream = DMA2_Stream0,
+            .tx_stream = DMA2_Stream3,
+            .dma_channel = DMA_Channel_3,
+            .rx_flags = DMA_FLAG_TCIF0 | DMA_FLAG_HTIF0 | DMA_FLAG_TEIF0 |
+                        DMA_FLAG_DMEIF0 | DMA_FLAG_FEIF0,
+            .tx_flags = DMA_FLAG_TCIF3 | DMA_FLAG_HTIF3 | DMA_FLAG_TEIF3 |
+                        DMA_FLAG_DMEIF3 | DMA_FLAG_FEIF3,
+            .rx_it_tc = DMA_IT_TCIF0,
+            .rx_it_te = DMA_IT_TEIF0,
+            .init = spi1_init,
+        },
+};
+
+/* Clocked out when the transfer has no tx buffer, or filled when it has no
+ * rx buffer */
+static const uint8_t spi_dummy_tx = 0xff;
+static uint8_t spi_dummy_rx;
 
 /* SPI1
- * CS:   GPIO A4
  * SCK:  GPIO A5
  * MISO: GPIO A6
  * MOSI: GPIO A7
  */
-void spi1_init(void)
+static void spi1_init(void)
 {
     RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOA, ENABLE);
+    RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_DMA2, ENABLE);
     RCC_APB2PeriphClockCmd(RCC_APB2Periph_SPI1, ENABLE);
 
     GPIO_PinAFConfig(GPIOA, GPIO_PinSource5, GPIO_AF_SPI1);
@@ -28,10 +80,24 @@ void spi1_init(void)
     };
     GPIO_Init(GPIOA, &GPIO_InitStruct);
 
-    GPIO_InitStruct.GPIO_Pin = GPIO_Pin_4;
-    GPIO_InitStruct.GPIO_Mode = GPIO_Mode_OUT;
-    GPIO_InitStruct.GPIO_PuPd = GPIO_PuPd_UP;
-    GPIO_Init(GPIOA, &GPIO_InitStruct);
+    /* Initialize interrupt of the DMA2 stream0 (SPI1 RX) */
+    NVIC_InitTypeDef NVIC_InitStruct = {
+        .NVIC_IRQChannel = DMA2_Stream0_IRQn,
+        .NVIC_IRQChannelPreemptionPriority = SPI1_DMA_ISR_PRIORITY,
+        .NVIC_IRQChannelSubPriority = 0,
+        .NVIC_IRQChannelCmd = ENABLE,
+    };
+    NVIC_Init(&NVIC_InitStruct);
+
+    printk("spi1: full duplex mode");
+}
+
+static void spi_bus_init(struct spi_bus *bus)
+{
+    if (bus->initialized)
+        return;
+
+    bus->init();
 
     SPI_InitTypeDef SPI_InitStruct = {
         .SPI_Direction = SPI_Direction_2Lines_FullDuplex,
@@ -40,32 +106,238 @@ void spi1_init(void)
         .SPI_CPOL = SPI_CPOL_High,
         .SPI_CPHA = SPI_CPHA_2Edge,
         .SPI_NSS = SPI_NSS_Soft,
-        .SPI_BaudRatePrescaler = SPI_BaudRatePrescaler_4,
+        .SPI_BaudRatePrescaler = SPI_BaudRatePrescaler_256,
         .SPI_FirstBit = SPI_FirstBit_MSB,
         .SPI_CRCPolynomial = 7,
     };
-    SPI_Init(SPI1, &SPI_InitStruct);
+    SPI_Init(bus->spi, &SPI_InitStruct);
+    SPI_Cmd(bus->spi, ENABLE);
+
+    INIT_LIST_HEAD(&bus->queue);
+    init_waitqueue_head(&bus->wait_list);
+    bus->active = NULL;
+    bus->dev = NULL;
+    bus->initialized = true;
+}
 
-    SPI_Cmd(SPI1, ENABLE);
+void spi_device_init(struct spi_device *dev)
+{
+    spi_bus_init(&spi_buses[dev->bus]);
 
-    printk("spi1: full duplex mode");
+    /* Deselect the chip */
+    GPIO_InitTypeDef GPIO_InitStruct = {
+        .GPIO_Pin = dev->cs_pin,
+        .GPIO_Mode = GPIO_Mode_OUT,
+        .GPIO_Speed = GPIO_Speed_50MHz,
+        .GPIO_OType = GPIO_OType_PP,
+        .GPIO_PuPd = GPIO_PuPd_UP,
+    };
+    GPIO_SetBits(dev->cs_port, dev->cs_pin);
+    GPIO_Init(dev->cs_port, &GPIO_InitStruct);
+}
+
+static void spi_bus_configure(struct spi_bus *bus, struct spi_device *dev)
+{
+    if (bus->dev == dev)
+        return;
+
+    /* The clock settings can only be changed while the SPI is disabled */
+    uint16_t mask = SPI_CR1_CPOL | SPI_CR1_CPHA | SPI_CR1_BR;
+    SPI_Cmd(bus->spi, DISABLE);
+    bus->spi->CR1 = (bus->spi->CR1 & ~mask) | dev->mode | dev->prescaler;
+    SPI_Cmd(bus->spi, ENABLE);
+
+    bus->dev = dev;
+}
+
+static void spi_bus_start(struct spi_bus *bus)
+{
+    if (bus->active || list_empty(&bus->queue))
+        return;
+
+    struct spi_transfer *xfer =
+        list_first_entry(&bus->queue, struct spi_transfer, list);
+    list_del(&xfer->list);
+    bus->active = xfer;
+
+    spi_bus_configure(bus, xfer->dev);
+    GPIO_ResetBits(xfer->dev->cs_port, xfer->dev->cs_pin);
+
+    DMA_InitTypeDef DMA_InitStructure = {
+        .DMA_BufferSize = (uint32_t) xfer->len,
+        .DMA_FIFOMode = DMA_FIFOMode_Disable,
+        .DMA_FIFOThreshold = DMA_FIFOThreshold_Full,
+        .DMA_MemoryBurst = DMA_MemoryBurst_Single,
+        .DMA_MemoryDataSize = DMA_MemoryDataSize_Byte,
+        .DMA_Mode = DMA_Mode_Normal,
+        .DMA_PeripheralBaseAddr = (uint32_t) (&bus->spi->DR),
+        .DMA_PeripheralBurst = DMA_PeripheralBurst_Single,
+        .DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte,
+        .DMA_PeripheralInc = DMA_PeripheralInc_Disable,
+        .DMA_Priority = DMA_Priority_High,
+        .DMA_Channel = bus->dma_channel,
+    };
+
+    /* RX */
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralToMemory;
+    if (xfer->rx_buf) {
+        DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t) xfer->rx_buf;
+        DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    } else {
+        DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t) &spi_dummy_rx;
+        DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Disable;
+    }
+    DMA_Init(bus->rx_stream, &DMA_InitStructure);
+
+    /* TX */
+    DMA_InitStructure.DMA_DIR = DMA_DIR_MemoryToPeripheral;
+    if (xfer->tx_buf) {
+        DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t) xfer->tx_buf;
+        DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    } else {
+        DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t) &spi_dummy_tx;
+        DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Disable;
+    }
+    DMA_Init(bus->tx_stream, &DMA_InitStructure);
+
+    DMA_ClearFlag(bus->rx_stream, bus->rx_flags);
+    DMA_ClearFlag(bus->tx_stream, bus->tx_flags);
+    DMA_ITConfig(bus->rx_stream, DMA_IT_TC | DMA_IT_TE, ENABLE);
+
+    /* Start the RX stream first so no byte is missed */
+    DMA_Cmd(bus->rx_stream, ENABLE);
+    DMA_Cmd(bus->tx_stream, ENABLE);
+    SPI_I2S_DMACmd(bus->spi, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, ENABLE);
 }
 
-uint8_t spi1_w8r8(uint8_t data)
+int spi_async(struct spi_transfer *xfer)
 {
-    while (SPI_I2S_GetFlagStatus(SPI1, SPI_FLAG_TXE) == RESET)
+    if (!xfer->dev || xfer->len == 0)
+        return -EINVAL;
+
+    struct spi_bus *bus = &spi_buses[xfer->dev->bus];
+
+    preempt_disable();
+
+    if (xfer->busy) {
+        preempt_enable();
+        return -EBUSY;
+    }
+
+    xfer->busy = true;
+    xfer->status = 0;
+    list_add_tail(&xfer->list, &bus->queue);
+
+    /* Start right away if the bus is idle */
+    spi_bus_start(bus);
+
+    preempt_enable();
+
+    return 0;
+}
+
+int spi_sync(struct spi_transfer *xfer)
+{
+    int retval;
+
+    preempt_disable();
+
+    retval = spi_async(xfer);
+    if (retval == 0) {
+        /* Sleep until the DMA ISR completes the transfer */
+        struct spi_bus *bus = &spi_buses[xfer->dev->bus];
+        wait_event(bus->wait_list, !xfer->busy);
+        retval = xfer->status;
+    }
+
+    preempt_enable();
+
+    return retval;
+}
+
+static uint8_t spi_w8r8(SPI_TypeDef *spi, uint8_t data)
+{
+    while (SPI_I2S_GetFlagStatus(spi, SPI_FLAG_TXE) == RESET)
         ;
-    SPI_I2S_SendData(SPI1, data);
+    SPI_I2S_SendData(spi, data);
 
-    while (SPI_I2S_GetFlagStatus(SPI1, SPI_FLAG_RXNE) == RESET)
+    while (SPI_I2S_GetFlagStatus(spi, SPI_FLAG_RXNE) == RESET)
         ;
-    return SPI_I2S_ReceiveData(SPI1);
+    return SPI_I2S_ReceiveData(spi);
+}
+
+int spi_sync_polled(struct spi_transfer *xfer)
+{
+    if (!xfer->dev || xfer->len == 0)
+        return -EINVAL;
+
+    struct spi_bus *bus = &spi_buses[xfer->dev->bus];
+
+    preempt_disable();
+
+    /* Only for the bring-up before the DMA transfers are queued */
+    if (bus->active || !list_empty(&bus->queue)) {
+        preempt_enable();
+        return -EBUSY;
+    }
+
+    spi_bus_configure(bus, xfer->dev);
+    GPIO_ResetBits(xfer->dev->cs_port, xfer->dev->cs_pin);
+
+    for (size_t i = 0; i < xfer->len; i++) {
+        uint8_t c = spi_w8r8(bus->spi, xfer->tx_buf ? xfer->tx_buf[i] : 0xff);
+        if (xfer->rx_buf)
+            xfer->rx_buf[i] = c;
+    }
+
+    GPIO_SetBits(xfer->dev->cs_port, xfer->dev->cs_pin);
+
+    preempt_enable();
+
+    return 0;
+}
+
+static void spi_dma_irq(struct spi_bus *bus)
+{
+    struct spi_transfer *xfer = bus->active;
+    int status;
+
+    if (DMA_GetITStatus(bus->rx_stream, bus->rx_it_tc) == SET) {
+        status = 0;
+    } else if (DMA_GetITStatus(bus->rx_stream, bus->rx_it_te) == SET) {
+        status = -EIO;
+    } else {
+        return;
+    }
+
+    DMA_ClearITPendingBit(bus->rx_stream, bus->rx_it_tc | bus->rx_it_te);
+    DMA_ITConfig(bus->rx_stream, DMA_IT_TC | DMA_IT_TE, DISABLE);
+    DMA_Cmd(bus->rx_stream, DISABLE);
+    DMA_Cmd(bus->tx_stream, DISABLE);
+    SPI_I2S_DMACmd(bus->spi, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, DISABLE);
+
+    if (!xfer)
+        return;
+
+    GPIO_SetBits(xfer->dev->cs_port, xfer->dev->cs_pin);
+    bus->active = NULL;
+
+    /* Keep the bus busy before running the callback */
+    spi_bus_start(bus);
+
+    xfer->status = status;
+    xfer->busy = false;
+
+    if (xfer->complete)
+        xfer->complete(xfer);
+
+    if (!list_empty(&bus->wait_list))
+        wake_up_all(&bus->wait_list);
 }
 
-void spi1_set_chipselect(bool chipselect)
+void DMA2_Stream0_IRQHandler(void)
 {
-    if (chipselect)
-        GPIO_ResetBits(GPIOA, GPIO_Pin_4);
-    else
-        GPIO_SetBits(GPIOA, GPIO_Pin_4);
+    trace_irq_enter();
+    spi_dma_irq(&spi_buses[SPI_BUS1]);
+    trace_irq_exit();
 }
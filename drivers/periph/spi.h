@@ -1,11 +1,54 @@
 #ifndef __SPI_H__
 #define __SPI_H__
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
-void spi1_init(void);
+#include <common/list.h>
 
-uint8_t spi1_w8r8(uint8_t data);
-void spi1_set_chipselect(bool chipselect);
+#include "stm32f4xx.h"
+
+/* Clock polarity and phase */
+#define SPI_MODE_0 (SPI_CPOL_Low | SPI_CPHA_1Edge)
+#define SPI_MODE_1 (SPI_CPOL_Low | SPI_CPHA_2Edge)
+#define SPI_MODE_2 (SPI_CPOL_High | SPI_CPHA_1Edge)
+#define SPI_MODE_3 (SPI_CPOL_High | SPI_CPHA_2Edge)
+
+enum {
+    SPI_BUS1 = 0,
+    SPI_BUS_CNT,
+};
+
+/* Chip on a bus, the bus is reconfigured whenever the next transfer is for
+ * another device */
+struct spi_device {
+    int bus;              /* SPI_BUS1... */
+    GPIO_TypeDef *cs_port;
+    uint16_t cs_pin;
+    uint16_t mode;      /* SPI_MODE_0...SPI_MODE_3 */
+    uint16_t prescaler; /* SPI_BaudRatePrescaler_2...256 */
+};
+
+struct spi_transfer {
+    struct spi_device *dev;
+    const uint8_t *tx_buf; /* NULL clocks out 0xff */
+    uint8_t *rx_buf;       /* NULL discards the received bytes */
+    size_t len;
+
+    /* Called by the DMA ISR once the chip select is released */
+    void (*complete)(struct spi_transfer *xfer);
+    void *context;
+
+    int status;         /* 0 or -EIO once completed */
+    volatile bool busy; /* Queued or in progress */
+    struct list_head list;
+};
+
+void spi_device_init(struct spi_device *dev);
+
+int spi_async(struct spi_transfer *xfer);
+int spi_sync(struct spi_transfer *xfer);
+int spi_sync_polled(struct spi_transfer *xfer);
 
 #endif
@@ -12,6 +12,7 @@
 #include <kernel/preempt.h>
 #include <kernel/printk.h>
 #include <kernel/sched.h>
+#include <kernel/trace.h>
 #include <kernel/tty.h>
 
 #include "stm32f4xx_conf.h"
@@ -249,16 +250,22 @@ void serial1_init(uint32_t baudrate, char *dev_name, char *desc)
 
 void USART1_IRQHandler(void)
 {
+    trace_irq_enter();
+
     if (USART_GetITStatus(USART1, USART_IT_RXNE) == SET) {
         uint8_t c = USART_ReceiveData(USART1);
 
         if (uart1.rx_callback)
             uart1.rx_callback(c);
     }
+
+    trace_irq_exit();
 }
 
 void DMA2_Stream7_IRQHandler(void)
 {
+    trace_irq_enter();
+
     if (DMA_GetITStatus(DMA2_Stream7, DMA_IT_TCIF7) == SET) {
         DMA_ClearITPendingBit(DMA2_Stream7, DMA_IT_TCIF7);
         DMA_ITConfig(DMA2_Stream7, DMA_IT_TC, DISABLE);
@@ -266,6 +273,8 @@ void DMA2_Stream7_IRQHandler(void)
         uart1.tx_ready = true;
         wake_up(&uart1.tx_wait_list);
     }
+
+    trace_irq_exit();
 }
 
 /*==============*
@@ -282,14 +291,27 @@ static ssize_t uart2_read(struct file *filp,
                           size_t size,
                           off_t offset)
 {
+    if (size == 0)
+        return 0;
+
     mutex_lock(&uart2.rx_mtx);
 
+    /* Return whatever is received like a tty, so the MAVLink receiver can
+     * read in bulk without waiting for a full buffer */
     preempt_disable();
-    uart2.rx_wait_size = size;
-    wait_event(uart2.rx_wait_list, kfifo_len(uart2.rx_fifo) >= size);
-    preempt_enable();
 
-    kfifo_out(uart2.rx_fifo, buf, size);
+    uart2.rx_wait_size = 1;
+    wait_event(uart2.rx_wait_list, kfifo_len(uart2.rx_fifo) > 0);
+
+    size_t len = kfifo_len(uart2.rx_fifo);
+    if (size > len)
+        size = len;
+
+    /* The FIFO hands out one byte per call */
+    for (size_t i = 0; i < size; i++)
+        kfifo_get(uart2.rx_fifo, &buf[i]);
+
+    preempt_enable();
 
     mutex_unlock(&uart2.rx_mtx);
 
@@ -383,12 +405,16 @@ void serial2_init(uint32_t baudrate, char *dev_name, char *desc)
 
 void USART2_IRQHandler(void)
 {
+    trace_irq_enter();
+
     if (USART_GetITStatus(USART2, USART_IT_RXNE) == SET) {
         uint8_t c = USART_ReceiveData(USART2);
 
         if (uart2.rx_callback)
             uart2.rx_callback(c);
     }
+
+    trace_irq_exit();
 }
 
 /*==============*
@@ -580,16 +606,22 @@ void serial3_init(uint32_t baudrate, char *dev_name, char *desc)
 
 void USART3_IRQHandler(void)
 {
+    trace_irq_enter();
+
     if (USART_GetITStatus(USART3, USART_IT_RXNE) == SET) {
         uint8_t c = USART_ReceiveData(USART3);
 
         if (uart3.rx_callback)
             uart3.rx_callback(c);
     }
+
+    trace_irq_exit();
 }
 
 void DMA1_Stream4_IRQHandler(void)
 {
+    trace_irq_enter();
+
     if (DMA_GetITStatus(DMA1_Stream4, DMA_IT_TCIF4) == SET) {
         DMA_ClearITPendingBit(DMA1_Stream4, DMA_IT_TCIF4);
         DMA_ITConfig(DMA1_Stream4, DMA_IT_TC, DISABLE);
@@ -597,4 +629,6 @@ void DMA1_Stream4_IRQHandler(void)
         uart3.tx_ready = true;
         wake_up(&uart3.tx_wait_list);
     }
+
+    trace_irq_exit();
 }
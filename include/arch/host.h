@@ -0,0 +1,138 @@
+/**
+ * @file
+ */
+#ifndef __HOST_H__
+#define __HOST_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* The host port links the kernel with a runner (platform/host_startup.c)
+ * built against the C library of the host. The runner emulates the
+ * interrupt controller, the system timer and the console of the target,
+ * and exports the services below to the kernel */
+
+/* Interrupt sources of the host */
+#define HOST_IRQ_TICK 0x1    /* SIGALRM of the interval timer */
+#define HOST_IRQ_ONESHOT 0x2 /* Signal of the one-shot timer */
+
+/**
+ * @brief  Mask the interrupts (i.e., the SIGALRM tick) of the host
+ * @param  None
+ * @retval None
+ */
+void host_irq_disable(void);
+
+/**
+ * @brief  Unmask the interrupts of the host and serve the tick that arrived
+ *         while the interrupts are masked
+ * @param  None
+ * @retval None
+ */
+void host_irq_enable(void);
+
+/**
+ * @brief  Check if the tick interrupt is being served
+ * @param  None
+ * @retval bool: true if the caller runs in the interrupt context.
+ */
+bool host_irq_active(void);
+
+/**
+ * @brief  Leave the interrupt context so the next tick can be taken
+ * @param  None
+ * @retval None
+ */
+void host_irq_return(void);
+
+/**
+ * @brief  Get and clear the interrupt sources raised since the last call
+ * @param  None
+ * @retval unsigned int: The HOST_IRQ_* bits.
+ */
+unsigned int host_irq_take(void);
+
+/**
+ * @brief  Get the address interrupted by the tick being served
+ * @param  masked: Set to true if the tick arrived while the interrupts are
+ *         masked, the address is then where the interrupts are unmasked.
+ * @retval unsigned long: The interrupted address.
+ */
+unsigned long host_irq_pc(bool *masked);
+
+/**
+ * @brief  Start the interval timer of the host to generate the ticks
+ * @param  freq: The tick frequency in Hz.
+ * @retval None
+ */
+void host_timer_start(unsigned int freq);
+
+/**
+ * @brief  Arm the one-shot timer of the host, replacing the previous request
+ * @param  nsec: The time to wait in nanoseconds.
+ * @retval None
+ */
+void host_oneshot_start(uint64_t nsec);
+
+/**
+ * @brief  Disarm the one-shot timer of the host
+ * @param  None
+ * @retval None
+ */
+void host_oneshot_cancel(void);
+
+/**
+ * @brief  Read the monotonic clock of the host
+ * @param  None
+ * @retval uint64_t: The time in nanoseconds.
+ */
+uint64_t host_clock_nsec(void);
+
+/**
+ * @brief  Read the received characters of the console without blocking
+ * @param  buf: The buffer for storing the characters.
+ * @param  size: The size of the buffer.
+ * @retval int: The number of the characters read.
+ */
+int host_console_read(char *buf, size_t size);
+
+/**
+ * @brief  Write characters to the console
+ * @param  buf: The characters to write.
+ * @param  size: The number of the characters.
+ * @retval None
+ */
+void host_console_write(const char *buf, size_t size);
+
+/**
+ * @brief  Suspend the host process until the next interrupt
+ * @param  None
+ * @retval None
+ */
+void host_wait_for_interrupt(void);
+
+/**
+ * @brief  Terminate the host process
+ * @param  status: The exit status.
+ * @retval None
+ */
+void host_exit(int status);
+
+/**
+ * @brief  The main function of the kernel image, renamed at link time
+ * @param  None
+ * @retval int: Never returns.
+ */
+int tenok_main(void);
+
+/**
+ * @brief  The interrupt entry of the kernel. The runner redirects the
+ *         interrupted thread here with the interrupted address pushed on
+ *         the stack like an exception entry
+ * @param  None
+ * @retval None
+ */
+void __host_irq_entry(void);
+
+#endif
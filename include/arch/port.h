@@ -9,6 +9,18 @@
 
 #define NACKED __attribute__((naked))
 
+#ifdef BUILD_HOST
+/* The syscall number is passed with the eax and the arguments are left on
+ * the stack for the __host_syscall to build the context frame */
+#define SYSCALL(num)             \
+    asm volatile(                \
+        "movl %0, %%eax      \n" \
+        "jmp  __host_syscall \n" ::"i"(num))
+
+/* The return value is passed to the return handler as its first argument */
+#define SAVE_SYSCALL_RETVAL(ptr) \
+    asm volatile("movl 4(%%esp), %0" : "=r"(*ptr));
+#else
 #define SYSCALL(num)     \
     asm volatile(        \
         "push {r7}   \n" \
@@ -18,8 +30,77 @@
         "bx lr       \n" ::"i"(num))
 
 #define SAVE_SYSCALL_RETVAL(ptr) asm volatile("mov %0, r0" : "=r"(*ptr));
+#endif
+
+#ifdef BUILD_HOST
+void preempt_disable(void);
+void preempt_enable(void);
+
+/* The host has no exclusive monitor, the interrupts are masked from the
+ * load_exclusive() to the paired store_exclusive() or clear_exclusive()
+ * instead */
+static inline uint32_t load_exclusive(volatile uint32_t *addr)
+{
+    preempt_disable();
+    return *addr;
+}
+
+static inline bool store_exclusive(volatile uint32_t *addr, uint32_t val)
+{
+    *addr = val;
+    preempt_enable();
+    return true;
+}
+
+static inline void clear_exclusive(void)
+{
+    preempt_enable();
+}
+#else
+/**
+ * @brief  Load a word and tag the address for exclusive access (LDREX)
+ * @param  addr: The address of the word to load.
+ * @retval uint32_t: The loaded value.
+ */
+static inline uint32_t load_exclusive(volatile uint32_t *addr)
+{
+    uint32_t val;
+    asm volatile("ldrex %0, [%1]" : "=r"(val) : "r"(addr) : "memory");
+    return val;
+}
+
+/**
+ * @brief  Store a word if the address is still tagged for exclusive
+ *         access (STREX). Note that the exclusive monitor is cleared on
+ *         every exception entry and return, thus the store fails if the
+ *         caller is preempted after the load_exclusive()
+ * @param  addr: The address of the word to store.
+ * @param  val: The value to store.
+ * @retval bool: true on success and false if the store is aborted.
+ */
+static inline bool store_exclusive(volatile uint32_t *addr, uint32_t val)
+{
+    uint32_t failed;
+    asm volatile("strex %0, %2, [%1]"
+                 : "=&r"(failed)
+                 : "r"(addr), "r"(val)
+                 : "memory");
+    return failed == 0;
+}
+
+/**
+ * @brief  Clear the exclusive access tag of the last load_exclusive() (CLREX)
+ * @param  None
+ * @retval None
+ */
+static inline void clear_exclusive(void)
+{
+    asm volatile("clrex" ::: "memory");
+}
+#endif
 
 void system_ticks_update(void);
+void system_oneshot_update(void);
 
 /**
  * @brief  Get the current ARM processor mode
@@ -76,6 +157,61 @@ void __stack_init(uint32_t **stack_top,
                   uint32_t return_handler,
                   uint32_t args[4]);
 
+/**
+ * @brief  Get the time elapsed since the last system tick by reading the
+ *         counter of the system timer. The function must be called in the
+ *         privileged mode
+ * @param  None
+ * @retval uint32_t: The elapsed time in nanoseconds.
+ */
+uint32_t get_tick_elapsed_nsec(void);
+
+/**
+ * @brief  Get the resolution of the system timer counter
+ * @param  None
+ * @retval uint32_t: The resolution in nanoseconds.
+ */
+uint32_t get_timer_resolution_nsec(void);
+
+/**
+ * @brief  Arm the one-shot timer to call system_oneshot_update() once the
+ *         time is up, replacing the previous request. Used for the deadlines
+ *         that fall between two system ticks
+ * @param  nsec: The time to wait in nanoseconds.
+ * @retval None
+ */
+void oneshot_timer_start(uint32_t nsec);
+
+/**
+ * @brief  Disarm the one-shot timer
+ * @param  None
+ * @retval None
+ */
+void oneshot_timer_cancel(void);
+
+/**
+ * @brief  Enable the CPU cycle counter. Targets without the DWT cycle counter
+ *         (e.g., QEMU) fall back to the system time
+ * @param  None
+ * @retval None
+ */
+void cycle_counter_init(void);
+
+/**
+ * @brief  Get the CPU cycle count. The function must be called in the
+ *         privileged mode
+ * @param  None
+ * @retval uint32_t: The free-running cycle count, which wraps around.
+ */
+uint32_t get_cycle_count(void);
+
+/**
+ * @brief  Get the frequency of the CPU cycle counter
+ * @param  None
+ * @retval uint32_t: The frequency in Hz.
+ */
+uint32_t get_cycle_freq(void);
+
 /**
  * @brief  Get syscall number
  * @param  sp: The stack pointer points to the top of the thread stack.
@@ -10,8 +10,8 @@
 
 #define END(name) .size name, .- name /* Calculate the section size */
 
-#define ENDPROC(name)       \
-    .type name, % function; \
+#define ENDPROC(name)     \
+    .type name, STT_FUNC; \
     END(name)
 
 #endif
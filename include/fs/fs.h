@@ -122,7 +122,7 @@ struct file {
     struct file_operations *f_op;
     uint32_t f_events;
     int f_flags;
-    struct list_head list;
+    struct list_head poll_wait_list; /* Poll wait entries of the file */
 };
 
 struct file_operations {
@@ -149,6 +149,7 @@ void link_stderr_dev(char *path);
 
 int register_chrdev(char *name, struct file_operations *fops);
 int register_blkdev(char *name, struct file_operations *fops);
+int register_proc_file(char *name, struct file_operations *fops);
 
 int fs_read_dir(DIR *dirp, struct dirent *dirent);
 uint32_t fs_get_block_addr(struct inode *inode, int blk_index);
@@ -0,0 +1,22 @@
+/**
+ * @file
+ */
+#ifndef __LOG_DEV_H__
+#define __LOG_DEV_H__
+
+#include "kconfig.h"
+
+#if (LOG_DEV_ENABLE != 0)
+/**
+ * @brief  Register the log device (/dev/log)
+ * @param  None
+ * @retval None
+ */
+void log_dev_init(void);
+#else
+static inline void log_dev_init(void)
+{
+}
+#endif
+
+#endif
@@ -0,0 +1,47 @@
+/**
+ * @file
+ */
+#ifndef __KERNEL_EPOLL_H__
+#define __KERNEL_EPOLL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+
+#include <common/list.h>
+#include <fs/fs.h>
+#include <kernel/poll.h>
+#include <kernel/wait.h>
+
+struct epitem {
+    struct poll_wait_entry wait; /* Registered on the watched file */
+    struct eventpoll *ep;        /* The epoll instance of the item */
+    struct file *filp;           /* The watched file */
+    struct epoll_event event;    /* The events to watch and the user data */
+    int fd;                      /* The watched file descriptor */
+    bool ready;                  /* The item is linked to the ready list */
+    struct list_head rdllink;    /* Linked to the ready list of the epoll */
+    struct list_head list;       /* Linked to the item list of the epoll */
+};
+
+struct eventpoll {
+    struct file file;            /* Readable with the items ready */
+    struct list_head items;      /* All watched items */
+    struct list_head rdllist;    /* Items with events observed */
+    uint32_t gen;                /* Incremented whenever the file is closed */
+    struct wait_queue wait_list; /* Threads blocked in epoll_wait() */
+};
+
+void __epoll_init(struct eventpoll *ep);
+void __epoll_release(struct eventpoll *ep);
+int __epoll_ctl(struct eventpoll *ep,
+                int op,
+                int fd,
+                struct file *filp,
+                struct epoll_event *event);
+int __epoll_harvest(struct eventpoll *ep,
+                    struct epoll_event *events,
+                    int maxevents);
+struct eventpoll *file_to_epoll(struct file *filp);
+
+#endif
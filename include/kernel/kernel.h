@@ -16,6 +16,7 @@
 #include <common/util.h>
 #include <fs/fs.h>
 #include <kernel/kfifo.h>
+#include <kernel/mutex.h>
 #include <kernel/time.h>
 #include <kernel/wait.h>
 
@@ -33,11 +34,6 @@ struct syscall_info {
     uint32_t num;
 };
 
-struct staged_handler_info {
-    uint32_t func;
-    uint32_t args[4];
-};
-
 enum {
     THREAD_WAIT,
     THREAD_READY,
@@ -61,6 +57,12 @@ struct task_struct {
     /* For recording message queue descriptors belongs to the task */
     uint32_t bitmap_mqds[BITMAP_SIZE(MQUEUE_MAX)];
 
+    /* For recording epoll descriptors belongs to the task */
+    uint32_t bitmap_epolls[BITMAP_SIZE(EPOLL_MAX)];
+
+    /* For recording timer files belongs to the task */
+    uint32_t bitmap_timerfds[BITMAP_SIZE(TIMERFD_MAX)];
+
     struct list_head threads_list; /* List of all threads of the task */
     struct list_head list;         /* Linked to the global task list */
 };
@@ -78,6 +80,8 @@ struct thread_info {
     /* Syscall */
     unsigned long *syscall_args[4]; /* Pointer to the syscall arguments */
     unsigned long *syscall_stack_top;
+    unsigned long syscall_num; /* Number of the syscall under handling */
+    uint32_t syscall_cycles;   /* Cycle count at the entry of the syscall */
     bool syscall_mode;
     bool syscall_is_timeout; /* Indicate if the syscall waiting time is up */
     struct timespec syscall_timeout; /* For setting timeout of the syscall */
@@ -89,11 +93,10 @@ struct thread_info {
     uint32_t sleep_ticks;       /* Remained ticks to sleep */
     uint32_t preempt_cnt;       /* For preserving threads's preemption level */
     uint16_t tid;               /* Thread ID */
-    uint16_t timer_cnt;         /* The number of timers that the thread has */
     uint8_t privilege;          /* Current execution privilege level */
     uint8_t status;             /* Thread status */
     uint8_t priority;           /* Thread priority */
-    uint8_t original_priority;  /* Original priority before inheritance */
+    uint8_t original_priority;  /* Base priority without inheritance */
     bool kernel_thread;         /* Kernel thread or user thread */
     bool priority_inherited;    /* True if current priority is inherited */
     bool detached;              /* Thread is detached or not */
@@ -101,21 +104,32 @@ struct thread_info {
     char name[THREAD_NAME_MAX]; /* Thread name */
     struct thread_once *once_control; /* For handling pthread_once_control */
 
+    /* Wait queue the thread is blocked on, for requeuing on priority change */
+    struct wait_queue *wait_queue;
+    struct wait_bucket *wait_bucket; /* Lent to the wait queue while blocked */
+
+    /* Mutexes */
+    struct mutex *waiting_mutex; /* The mutex that the thread is blocked on */
+    struct list_head mutex_list; /* Contended PI mutexes owned by the thread */
+
     /* Signals */
     struct sigaction *sig_table[SIGNAL_CNT];
-    struct kfifo signal_queue; /* The queue for pending signals */
-    sigset_t sig_wait_set;     /* The set of the signals to wait */
-    uint32_t signal_cnt;       /* The number of pending signals in the queue */
-    int *ret_sig;              /* For storing retval of the sigwait */
-    siginfo_t *ret_siginfo;    /* For storing siginfo of wait */
-    bool wait_for_signal;      /* Indicates the thread is waiting for signal */
+    siginfo_t *sig_queue;    /* Pending signals sorted by the priority */
+    uint16_t sig_queue_size; /* Capacity of the signal queue */
+    uint16_t sig_queue_cnt;  /* The number of pending signals in the queue */
+    siginfo_t sig_info;      /* Info of the signal under handling */
+    sigset_t sig_wait_set;   /* The set of the signals to wait */
+    int *ret_sig;            /* For storing retval of the sigwait */
+    siginfo_t *ret_siginfo;  /* For storing siginfo of wait */
+    bool wait_for_signal;    /* Indicates the thread is waiting for signal */
+    struct list_head timer_sig_list; /* Timers with pending signals */
+    struct timer *notify_timer; /* Timer that the callback thread serves */
 
     /* Lists */
-    struct list_head timers_list;     /* List of timers belongs to the thread */
-    struct list_head poll_files_list; /* List of all files polling for */
-    struct list_head task_list;       /* Linked to the task thread list */
-    struct list_head thread_list;     /* Linked to the global thread list */
-    struct list_head timeout_list;    /* Linked to the global timeout list */
+    struct list_head timers_list;  /* List of timers belongs to the thread */
+    struct list_head task_list;    /* Linked to the task thread list */
+    struct list_head thread_list;  /* Linked to the global thread list */
+    struct list_head timeout_list; /* Linked to the global timeout list */
     struct list_head join_list; /* Linked to another thread waiting for join */
     struct list_head list;      /* Linked to a scheduling list */
 };
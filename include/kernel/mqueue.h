@@ -8,6 +8,9 @@
 #include <stddef.h>
 #include <unistd.h>
 
+#include <common/list.h>
+#include <kernel/wait.h>
+
 struct mqueue_data {
     struct list_head list;
     size_t size;
@@ -21,8 +24,8 @@ struct mqueue {
     size_t cnt;
     struct list_head free_list;
     struct list_head used_list[MQ_PRIO_MAX + 1];
-    struct list_head r_wait_list;
-    struct list_head w_wait_list;
+    struct wait_queue r_wait_list;
+    struct wait_queue w_wait_list;
     struct list_head list;
 };
 
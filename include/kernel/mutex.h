@@ -7,6 +7,7 @@
 #include <stdbool.h>
 
 #include <common/list.h>
+#include <kernel/wait.h>
 
 struct mutex_attr {
     int protocol;
@@ -15,16 +16,19 @@ struct mutex_attr {
 struct mutex {
     int protocol;
     struct thread_info *owner;
-    struct list_head wait_list;
+    struct wait_queue wait_list; /* Waiting threads ordered by priority */
+    struct list_head list;       /* Linked to the mutex list of the owner */
 };
 
 struct cond {
-    struct list_head task_wait_list;
+    struct wait_queue task_wait_list;
 };
 
 void __mutex_init(struct mutex *mtx);
-void thread_inherit_priority(struct mutex *mutex);
-void thread_reset_inherited_priority(struct mutex *mutex);
+void mutex_wait(struct mutex *mtx);
+void mutex_remove_waiter(struct thread_info *thread);
+struct thread_info *mutex_top_waiter(struct mutex *mtx);
+void thread_update_priority(struct thread_info *thread);
 
 /**
  * @brief  Initialize the mutex.
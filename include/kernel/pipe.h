@@ -8,12 +8,18 @@
 
 #include <fs/fs.h>
 #include <kernel/kfifo.h>
+#include <kernel/wait.h>
+
+/* The waiters are bucketed by the log2 of their request size, covering the
+ * requests up to 255 bytes (PIPE_BUF is 100) while the last class also takes
+ * the larger ones */
+#define PIPE_WAIT_CLASSES 8
 
 struct pipe {
     struct kfifo *fifo;
     struct file file;
-    struct list_head r_wait_list;
-    struct list_head w_wait_list;
+    struct wait_queue r_wait_list[PIPE_WAIT_CLASSES];
+    struct wait_queue w_wait_list[PIPE_WAIT_CLASSES];
 };
 
 int fifo_init(int fd,
@@ -4,8 +4,51 @@
 #ifndef __KERNEL_POLL_H__
 #define __KERNEL_POLL_H__
 
+#include <common/list.h>
 #include <fs/fs.h>
 
+struct poll_wait_entry;
+
+typedef void (*poll_func_t)(struct poll_wait_entry *entry,
+                            struct file *notify_file);
+
+struct poll_wait_entry {
+    poll_func_t func;      /* Callback function for the file events */
+    struct list_head list; /* Linked to the poll wait list of the file */
+};
+
+/**
+ * @brief  Register a poll wait entry on the file so the callback function
+ *         is called whenever the file events are notified
+ * @param  filp: The file to wait for events.
+ * @param  entry: The poll wait entry to register.
+ * @param  func: The callback function for the file events.
+ * @retval None
+ */
+void poll_add_wait(struct file *filp,
+                   struct poll_wait_entry *entry,
+                   poll_func_t func);
+
+/**
+ * @brief  Unregister a poll wait entry from the file
+ * @param  entry: The poll wait entry to unregister.
+ * @retval None
+ */
+void poll_remove_wait(struct poll_wait_entry *entry);
+
+/**
+ * @brief  Detach all poll wait entries from the file being closed and call
+ *         their callback functions, which see the entries unlinked
+ * @param  filp: The file being closed.
+ * @retval None
+ */
+void poll_release(struct file *filp);
+
+/**
+ * @brief  Notify the pollers of the file that the file events are updated
+ * @param  notify_file: The file that has new events.
+ * @retval None
+ */
 void poll_notify(struct file *notify_file);
 
 #endif
@@ -5,7 +5,9 @@
 #define __KERNEL_PRINTK_H__
 
 /**
- * @brief  Display a kernel message.
+ * @brief  Display a kernel message. Only the arguments are recorded and the
+ *         message is formatted later by printkd, thus the format string must
+ *         be persistent (string arguments are copied)
  * @param  format: The formatting string.
  * @param  variable arguments: The variables used by the
  *         formatting specifiers.
@@ -0,0 +1,40 @@
+/**
+ * @file
+ */
+#ifndef __KERNEL_PROFILER_H__
+#define __KERNEL_PROFILER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "kconfig.h"
+
+#if (PROFILER_ENABLE != 0)
+/**
+ * @brief  Register the profiler device (/dev/prof)
+ * @param  None
+ * @retval None
+ */
+void profiler_init(void);
+
+/**
+ * @brief  Record the interrupted context into the sample buffer. Called by
+ *         the tick interrupt of the port
+ * @param  pc: The interrupted program counter.
+ * @param  lr: The interrupted link register, or 0 if not available.
+ * @param  kernel: true if the kernel or an interrupt is interrupted instead
+ *         of the running thread.
+ * @retval None
+ */
+void profiler_sample(uint32_t pc, uint32_t lr, bool kernel);
+#else
+static inline void profiler_init(void)
+{
+}
+
+static inline void profiler_sample(uint32_t pc, uint32_t lr, bool kernel)
+{
+}
+#endif
+
+#endif
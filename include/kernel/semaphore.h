@@ -7,10 +7,11 @@
 #include <stdint.h>
 
 #include <common/list.h>
+#include <kernel/wait.h>
 
 struct semaphore {
     int32_t count;
-    struct list_head wait_list;
+    struct wait_queue wait_list;
 };
 
 /**
@@ -5,8 +5,13 @@
 #define __KERNEL_SIGNAL_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 
+#include <signal.h>
+
+bool is_rt_signal(int signum);
 bool is_signal_defined(int signum);
+bool is_sigset_valid(const sigset_t *set);
 uint32_t sig2bit(int signum);
 int get_signal_index(int signum);
 
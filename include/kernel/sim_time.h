@@ -0,0 +1,37 @@
+/**
+ * @file
+ */
+#ifndef __KERNEL_SIM_TIME_H__
+#define __KERNEL_SIM_TIME_H__
+
+#include <stdbool.h>
+
+#include "kconfig.h"
+
+#if (SIM_TIME_ENABLE != 0)
+/**
+ * @brief  Register the simulator time device (/dev/simtime)
+ * @param  None
+ * @retval None
+ */
+void sim_time_init(void);
+
+/**
+ * @brief  Account a tick of the system timer. Called by the tick handler
+ * @param  None
+ * @retval bool: True if the simulator drives the system time, and the tick
+ *         must not advance it.
+ */
+bool sim_time_tick(void);
+#else
+static inline void sim_time_init(void)
+{
+}
+
+static inline bool sim_time_tick(void)
+{
+    return false;
+}
+#endif
+
+#endif
@@ -0,0 +1,50 @@
+/**
+ * @file
+ */
+#ifndef __KERNEL_SYSCALL_STAT_H__
+#define __KERNEL_SYSCALL_STAT_H__
+
+#include "kconfig.h"
+
+struct thread_info;
+
+#if (SYSCALL_STAT_ENABLE != 0)
+/**
+ * @brief  Register the syscall statistics device (/dev/syscalls)
+ * @param  None
+ * @retval None
+ */
+void syscall_stat_init(void);
+
+/**
+ * @brief  Count the syscall and start timing it. Called by the kernel after
+ *         setting up the syscall of the thread
+ * @param  thread: The thread invoking the syscall.
+ * @param  num: The syscall number.
+ * @retval None
+ */
+void syscall_stat_enter(struct thread_info *thread, unsigned long num);
+
+/**
+ * @brief  Record the latency of the syscall returned by the thread, including
+ *         the time the thread is blocked
+ * @param  thread: The thread returning from the syscall.
+ * @retval None
+ */
+void syscall_stat_exit(struct thread_info *thread);
+#else
+static inline void syscall_stat_init(void)
+{
+}
+
+static inline void syscall_stat_enter(struct thread_info *thread,
+                                      unsigned long num)
+{
+}
+
+static inline void syscall_stat_exit(struct thread_info *thread)
+{
+}
+#endif
+
+#endif
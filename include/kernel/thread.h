@@ -9,6 +9,11 @@
 
 #include <common/list.h>
 
+#include "kconfig.h"
+
+#define PRI_RESERVED 2
+#define KTHREAD_PRI_MAX (THREAD_PRIORITY_MAX + PRI_RESERVED)
+
 #define CURRENT_THREAD_INFO(var) struct thread_info *var = current_thread_info()
 
 struct thread_attr {
@@ -17,6 +22,7 @@ struct thread_attr {
     size_t stacksize; /* Bytes */
     int schedpolicy;
     int detachstate;
+    int sigqueuesize; /* Depth of the signal queue, 0 for the default */
 };
 
 struct thread_once {
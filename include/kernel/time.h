@@ -5,32 +5,131 @@
 #define __KERNEL_TIME_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <time.h>
 
 #include <common/list.h>
+#include <kernel/thread.h>
 
 typedef int64_t ktime_t;
 
+struct ktimer;
+
+typedef void (*ktimer_func_t)(struct ktimer *timer, uint64_t expirations);
+
+struct ktimer {
+    struct timespec expiry;   /* Absolute time of the next expiration */
+    struct timespec interval; /* Zero for the one-shot timer */
+    ktimer_func_t func;       /* Called by the tick handler on expiration */
+    bool armed;               /* The timer is linked to the armed list */
+    struct list_head list;    /* Linked to the armed timer list */
+};
+
 struct timer {
     int id;
-    int flags;
-    bool enabled;
-    struct sigevent sev;
-    struct itimerspec setting;
-    struct itimerspec ret_time; /* For returning current time */
-    struct timespec counter;    /* Internal countdown counter */
-    struct thread_info *thread; /* The thread that the timer belongs to */
-    struct list_head g_list;    /* Linked to the global timer list */
-    struct list_head list;      /* Linked to the thread timer list */
+    bool notify_pending;          /* The last notification is not delivered */
+    int overrun;                  /* Expirations after the pending one */
+    int overrun_last;             /* Overrun of the last delivered one */
+    struct sigevent sev;          /* Notification method of the timer */
+    struct ktimer ktimer;         /* Expires on the absolute time */
+    struct thread_info *thread;   /* The thread that the timer belongs to */
+    struct list_head notify_list; /* Linked to the notification list */
+    struct list_head list;        /* Linked to the thread timer list */
+
+    /* SIGEV_THREAD notification */
+    struct thread_attr notify_attr;    /* Attributes of the callback thread */
+    struct thread_info *notify_thread; /* The running callback thread */
 };
 
 void timer_up_count(struct timespec *time);
-void timer_down_count(struct timespec *time);
 void time_add(struct timespec *time, time_t sec, long nsec);
 void get_sys_time(struct timespec *tp);
 void set_sys_time(const struct timespec *tp);
 void system_timer_update(void);
 
+/**
+ * @brief  Switch the system time between the system timer and the external
+ *         time source. The time continues from its current value
+ * @param  external: True to be driven by system_ticks_advance() only.
+ * @retval None
+ */
+void set_sys_time_external(bool external);
+
+/**
+ * @brief  Check if the system time is driven by the external time source
+ * @param  None
+ * @retval bool: True for the external time source.
+ */
+bool sys_time_is_external(void);
+
+/**
+ * @brief  Set the time elapsed since the last tick of the external time
+ *         source, which replaces the interpolation with the system timer
+ * @param  nsec: The elapsed time in nanoseconds, less than a tick.
+ * @retval None
+ */
+void set_sys_time_elapsed(uint32_t nsec);
+
+/**
+ * @brief  Run the tick handling for the ticks elapsed on the external time
+ *         source, which expires the timers and wakes up the sleeping threads
+ * @param  ticks: The number of the ticks to advance.
+ * @retval None
+ */
+void system_ticks_advance(uint32_t ticks);
+
+/**
+ * @brief  Initialize a kernel timer
+ * @param  timer: The timer to initialize.
+ * @param  func: The expiration callback function. It is called by the tick
+ *         handler with the number of the expirations observed.
+ * @retval None
+ */
+void ktimer_init(struct ktimer *timer, ktimer_func_t func);
+
+/**
+ * @brief  Arm the kernel timer on the absolute time of the system clock.
+ *         A periodic timer is rescheduled by whole intervals from the
+ *         previous deadline, hence its phase does not drift
+ * @param  timer: The timer to arm.
+ * @param  expiry: The absolute time of the first expiration.
+ * @param  interval: The period of the timer or zero for the one-shot timer.
+ * @retval None
+ */
+void ktimer_start(struct ktimer *timer,
+                  const struct timespec *expiry,
+                  const struct timespec *interval);
+
+/**
+ * @brief  Disarm the kernel timer
+ * @param  timer: The timer to disarm.
+ * @retval None
+ */
+void ktimer_cancel(struct ktimer *timer);
+
+/**
+ * @brief  Get the earliest expiration of all armed kernel timers
+ * @param  expiry: For returning the expiration time.
+ * @retval bool: false if no timer is armed.
+ */
+bool ktimer_next_expiry(struct timespec *expiry);
+
+/**
+ * @brief  Get the time until the next expiration of the kernel timer
+ * @param  timer: The timer to provide.
+ * @param  remaining: For returning the remaining time, zero if disarmed.
+ * @retval None
+ */
+void ktimer_remaining(struct ktimer *timer, struct timespec *remaining);
+
+/**
+ * @brief  Expire the kernel timers, called by the tick handler
+ * @param  None
+ * @retval None
+ */
+void ktimers_update(void);
+
 ktime_t ktime_get(void);
+ktime_t ktime_get_ns(void);
 
 #endif
@@ -0,0 +1,31 @@
+/**
+ * @file
+ */
+#ifndef __KERNEL_TIMERFD_H__
+#define __KERNEL_TIMERFD_H__
+
+#include <stdint.h>
+#include <time.h>
+
+#include <fs/fs.h>
+#include <kernel/time.h>
+#include <kernel/wait.h>
+
+struct timerfd {
+    struct file file;
+    struct ktimer ktimer;        /* Expires on the absolute time */
+    uint64_t expirations;        /* Expirations since the last read */
+    uint32_t gen;                /* Incremented whenever the file is closed */
+    struct wait_queue wait_list; /* Threads blocked in read() */
+};
+
+void __timerfd_init(struct timerfd *tfd);
+void __timerfd_release(struct timerfd *tfd);
+int __timerfd_settime(struct timerfd *tfd,
+                      int flags,
+                      const struct itimerspec *new_value,
+                      struct itimerspec *old_value);
+void __timerfd_gettime(struct timerfd *tfd, struct itimerspec *curr_value);
+struct timerfd *file_to_timerfd(struct file *filp);
+
+#endif
@@ -0,0 +1,75 @@
+/**
+ * @file
+ */
+#ifndef __KERNEL_TRACE_H__
+#define __KERNEL_TRACE_H__
+
+#include <stdint.h>
+
+#include "kconfig.h"
+
+/* Call site reported for the sections of the kernel loop */
+#define TRACE_SITE_KERNEL 0
+
+#if (IRQSOFF_TRACE_ENABLE != 0)
+/**
+ * @brief  Register the trace files (/proc/irqsoff and /proc/interrupts)
+ * @param  None
+ * @retval None
+ */
+void trace_init(void);
+
+/**
+ * @brief  Start timing a preemption-disabled section. Called with the
+ *         interrupts disabled
+ * @param  site: The return address of the caller that disables the
+ *         preemption.
+ * @retval None
+ */
+void trace_preempt_off(uintptr_t site);
+
+/**
+ * @brief  Stop timing the preemption-disabled section and record its
+ *         duration for the call site. Called with the interrupts disabled
+ * @param  None
+ * @retval None
+ */
+void trace_preempt_on(void);
+
+/**
+ * @brief  Start timing an interrupt handler
+ * @param  None
+ * @retval None
+ */
+void trace_irq_enter(void);
+
+/**
+ * @brief  Stop timing the interrupt handler and record its duration for the
+ *         exception number
+ * @param  None
+ * @retval None
+ */
+void trace_irq_exit(void);
+#else
+static inline void trace_init(void)
+{
+}
+
+static inline void trace_preempt_off(uintptr_t site)
+{
+}
+
+static inline void trace_preempt_on(void)
+{
+}
+
+static inline void trace_irq_enter(void)
+{
+}
+
+static inline void trace_irq_exit(void)
+{
+}
+#endif
+
+#endif
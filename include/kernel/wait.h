@@ -5,14 +5,29 @@
 #define __KERNEL_WAIT_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include <common/list.h>
-#include <kernel/kernel.h>
 #include <kernel/sched.h>
 #include <kernel/thread.h>
 
 typedef struct list_head wait_queue_head_t;
 
+/* Lists of the waiters by the thread priority, the bitmap marks the
+ * non-empty lists */
+struct wait_bucket {
+    uint32_t bitmap;
+    struct list_head lists[KTHREAD_PRI_MAX + 1];
+    struct wait_bucket *next; /* Spares lent by the other waiters */
+};
+
+/* Priority-ordered wait queue, FIFO within a priority. The object only keeps
+ * a pointer to the bucket lent by its first waiter while every later waiter
+ * lends its own as a spare, thus a leaving thread takes one back in O(1) */
+struct wait_queue {
+    struct wait_bucket *bucket;
+};
+
 /**
  * @brief  Declare and initialize a wait queue
  * @param  name: Name of the wait queue variable.
@@ -70,6 +85,72 @@ void wake_up(struct list_head *wait_list);
  */
 void wake_up_all(struct list_head *wait_list);
 
+/**
+ * @brief  Initialize the priority-ordered wait queue
+ * @param  wq: The wait queue to initialize.
+ * @retval None
+ */
+void init_wait_queue(struct wait_queue *wq);
+
+/**
+ * @brief  Check if the wait queue may have threads waiting on it without
+ *         locking. A false positive is possible but a false negative is not
+ * @param  wq: The wait queue to check.
+ * @retval bool: true if the wait queue may not be empty.
+ */
+static inline bool wait_queue_active(struct wait_queue *wq)
+{
+    return *(struct wait_bucket *volatile *) &wq->bucket != NULL;
+}
+
+/**
+ * @brief  Check if the wait queue is empty
+ * @param  wq: The wait queue to check.
+ * @retval bool: true or false.
+ */
+bool wait_queue_empty(struct wait_queue *wq);
+
+/**
+ * @brief  Get the first highest-priority thread from the wait queue
+ * @param  wq: The wait queue to check.
+ * @retval struct thread_info *: The thread or NULL if the queue is empty.
+ */
+struct thread_info *wait_queue_first(struct wait_queue *wq);
+
+/**
+ * @brief  Suspend current thread and place it into the wait queue according
+ *         to its priority with a new state
+ * @param  wq: The wait queue to place the thread.
+ * @param  thread: The thread to to place in the wait queue.
+ * @param  state: The new state of the thread.
+ * @retval None
+ */
+void prepare_to_wait_queue(struct wait_queue *wq,
+                           struct thread_info *thread,
+                           int state);
+
+/**
+ * @brief  Wake up the first highest-priority thread from the wait queue
+ * @param  wq: The wait queue that contains suspended threads.
+ * @retval None
+ */
+void wake_up_queue(struct wait_queue *wq);
+
+/**
+ * @brief  Wake up all threads from the wait queue
+ * @param  wq: The wait queue that contains suspended threads.
+ * @retval None
+ */
+void wake_up_queue_all(struct wait_queue *wq);
+
+/**
+ * @brief  Reposition the thread in the wait queue it is blocked on after its
+ *         priority is changed
+ * @param  thread: The thread to requeue.
+ * @retval None
+ */
+void wait_queue_requeue(struct thread_info *thread);
+
 /**
  * @brief  Move the thread from a wait list into a ready list and
  *         set it to be ready
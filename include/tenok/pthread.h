@@ -23,9 +23,9 @@
 #define PTHREAD_PRIO_INHERIT 1
 
 #define __SIZEOF_PTHREAD_MUTEXATTR_T 4 /* sizeof(struct mutex_attr) */
-#define __SIZEOF_PTHREAD_MUTEX_T 16    /* sizeof(struct mutex) */
-#define __SIZEOF_PTHREAD_ATTR_T 20     /* sizeof(struct thread_attr) */
-#define __SIZEOF_PTHREAD_COND_T 8      /* sizeof(struct cond) */
+#define __SIZEOF_PTHREAD_MUTEX_T 20    /* sizeof(struct mutex) */
+#define __SIZEOF_PTHREAD_ATTR_T 24     /* sizeof(struct thread_attr) */
+#define __SIZEOF_PTHREAD_COND_T 4      /* sizeof(struct cond) */
 #define __SIZEOF_PTHREAD_ONCE_T 12     /* sizeof(struct thread_once) */
 
 typedef uint32_t pthread_t;
@@ -172,6 +172,26 @@ int pthread_attr_setstackaddr(pthread_attr_t *attr, void *stackaddr);
  */
 int pthread_attr_getstackaddr(const pthread_attr_t *attr, void **stackaddr);
 
+/**
+ * @brief  Set the signal queue depth parameter of a thread attriute object.
+ *         The queue holds the pending signals of the thread, and sending a
+ *         signal to a thread with a full queue fails with EAGAIN
+ * @param  attr: The attribute object to set signal queue depth.
+ * @param  size: The signal queue depth in number of signals, which should be
+ *         between 1 and SIGQUEUE_MAX.
+ * @retval int: 0 on success and nonzero error number on error.
+ */
+int pthread_attr_setsigqueuesize(pthread_attr_t *attr, int size);
+
+/**
+ * @brief  Get the signal queue depth parameter of a thread attriute object
+ * @param  attr: The attribute object to retrieve signal queue depth.
+ * @param  size: For returning the signal queue depth from the attribute
+ *         object.
+ * @retval int: 0 on success and nonzero error number on error.
+ */
+int pthread_attr_getsigqueuesize(const pthread_attr_t *attr, int *size);
+
 /**
  * @brief  Start a new thread in the calling task
  * @param  thread: The thread ID of the new thread to return.
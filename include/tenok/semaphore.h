@@ -7,7 +7,7 @@
 #include <stdint.h>
 #include <time.h>
 
-#define __SIZEOF_SEM_T 12 /* sizeof(struct semaphore) */
+#define __SIZEOF_SEM_T 8 /* sizeof(struct semaphore) */
 
 typedef union {
     char __size[__SIZEOF_SEM_T];
@@ -14,12 +14,19 @@ struct timespec;
 #define SIGSTOP 19
 #define SIGCONT 18
 #define SIGKILL 9
-#define SIGNAL_CNT 6
+#define SIGRTMIN 34 /* First real-time signal */
+#define SIGRTMAX 41 /* Last real-time signal */
+#define SIGNAL_CNT 14
+
+#define SI_USER 0   /* Sent by kill() or raise() */
+#define SI_QUEUE -1 /* Sent by sigqueue() */
+#define SI_TIMER -2 /* Sent by an expired timer */
 
 #define SA_SIGINFO 0x2
 
 #define SIGEV_NONE 1
 #define SIGEV_SIGNAL 2
+#define SIGEV_THREAD 3
 
 typedef uint32_t sigset_t;
 
@@ -156,4 +163,18 @@ int kill(pid_t pid, int sig);
  */
 int raise(int sig);
 
+/**
+ * @brief  Send a signal with a value to a task. Unlike the standard signals,
+ *         multiple instances of a real-time signal (SIGRTMIN to SIGRTMAX) are
+ *         queued, and the pending signals are delivered in the order of the
+ *         standard signals first then the real-time signals by ascending
+ *         signal number
+ * @param  pid: The task ID to provide.
+ * @param  sig: The signal number to provide.
+ * @param  value: The value passed with si_value of the siginfo.
+ * @retval int: 0 on success and nonzero error number on error. -EAGAIN is
+ *         returned if the signal queue of the receiver is full.
+ */
+int sigqueue(pid_t pid, int sig, const union sigval value);
+
 #endif
@@ -0,0 +1,66 @@
+/**
+ * @file
+ */
+#ifndef __EPOLL_H__
+#define __EPOLL_H__
+
+#include <poll.h>
+#include <stdint.h>
+
+#define EPOLLIN POLLIN
+#define EPOLLOUT POLLOUT
+
+#define EPOLL_CTL_ADD 1 /* Register the file descriptor */
+#define EPOLL_CTL_DEL 2 /* Deregister the file descriptor */
+#define EPOLL_CTL_MOD 3 /* Change the events of the file descriptor */
+
+typedef union epoll_data {
+    void *ptr;
+    int fd;
+    uint32_t u32;
+} epoll_data_t;
+
+struct epoll_event {
+    uint32_t events;   /* Epoll events */
+    epoll_data_t data; /* User data variable */
+};
+
+/**
+ * @brief  Create a new epoll instance for monitoring multiple file
+ *         descriptors. The cost of epoll_wait() is proportional to the
+ *         number of the ready file descriptors instead of the watched ones.
+ *         The descriptor is released by close() and is readable for poll()
+ *         while events are ready
+ * @param  size: Ignored, but must be greater than zero.
+ * @retval int: The epoll descriptor on success and nonzero error number on
+ *         error.
+ */
+int epoll_create(int size);
+
+/**
+ * @brief  Add, modify, or remove entries in the interest list of the epoll
+ *         instance
+ * @param  epfd: The epoll descriptor to provide.
+ * @param  op: EPOLL_CTL_ADD, EPOLL_CTL_MOD or EPOLL_CTL_DEL.
+ * @param  fd: The target file descriptor.
+ * @param  event: The events to monitor and the user data to return.
+ * @retval int: 0 on success and nonzero error number on error.
+ */
+int epoll_ctl(int epfd, int op, int fd, struct epoll_event *event);
+
+/**
+ * @brief  Wait for events on the epoll instance (level-triggered)
+ * @param  epfd: The epoll descriptor to provide.
+ * @param  events: The buffer for returning the ready events.
+ * @param  maxevents: The max number of the events to return.
+ * @param  timeout: The number of milliseconds to block. Negative value means
+ *         an infinite timeout and zero causes the call to return immediately.
+ * @retval int: The number of the ready file descriptors on success and nonzero
+ *         error number on error.
+ */
+int epoll_wait(int epfd,
+               struct epoll_event *events,
+               int maxevents,
+               int timeout);
+
+#endif
@@ -0,0 +1,22 @@
+/**
+ * @file
+ */
+#ifndef __SYS_IMU_H__
+#define __SYS_IMU_H__
+
+#include <stdint.h>
+
+#define IMU_DEV "/dev/imu0"
+#define IMU_FIFO_DEV "/dev/imu0_fifo"
+
+/* Record read from the IMU devices. The sequence number counts the
+ * data-ready interrupts, so a gap means the samples in between were lost */
+struct imu_sample {
+    uint64_t timestamp; /* Data-ready time in microseconds */
+    uint32_t seq;
+    float accel[3]; /* m/s^2 */
+    float gyro[3];  /* deg/s */
+    float temp;     /* degC */
+};
+
+#endif
@@ -0,0 +1,23 @@
+/**
+ * @file
+ */
+#ifndef __SYS_LOG_DEV_H__
+#define __SYS_LOG_DEV_H__
+
+#include <stdint.h>
+
+#define LOG_DEV "/dev/log"
+
+/* Requests of the ioctl() on the log device */
+#define LOG_DEV_ERASE 0  /* Erase the device and rewind the read position */
+#define LOG_DEV_STATUS 1 /* Copy the status to the struct log_dev_status */
+
+/* The log device behaves like a flash being programmed sequentially: write()
+ * appends to the end of the data, read() and lseek() use a separate read
+ * position, and the data is kept until erased */
+struct log_dev_status {
+    uint32_t capacity; /* Bytes */
+    uint32_t used;     /* Bytes written since the last erase */
+};
+
+#endif
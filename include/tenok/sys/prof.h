@@ -0,0 +1,33 @@
+/**
+ * @file
+ */
+#ifndef __PROF_H__
+#define __PROF_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PROF_DEV "/dev/prof"
+
+/* Requests of the ioctl() on the profiler device */
+#define PROF_START 0  /* Clear the samples and start sampling */
+#define PROF_STOP 1   /* Stop sampling */
+#define PROF_STATUS 2 /* Copy the status to the struct prof_status pointer */
+
+#define PROF_TID_KERNEL -1 /* The kernel or an interrupt is sampled */
+
+/* Record read from the profiler device */
+struct prof_sample {
+    uint32_t pc; /* Interrupted program counter */
+    uint32_t lr; /* Link register (the caller if the function is a leaf) */
+    int32_t tid; /* Thread ID or PROF_TID_KERNEL */
+};
+
+struct prof_status {
+    bool running;
+    uint32_t freq;    /* Sampling frequency in Hz */
+    uint32_t samples; /* Samples ready to read */
+    uint32_t dropped; /* Samples dropped as the buffer is full */
+};
+
+#endif
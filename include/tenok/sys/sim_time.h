@@ -0,0 +1,27 @@
+/**
+ * @file
+ */
+#ifndef __SYS_SIM_TIME_H__
+#define __SYS_SIM_TIME_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SIM_TIME_DEV "/dev/simtime"
+
+/* Requests of the ioctl() on the simulator time device */
+#define SIM_TIME_RELEASE 0 /* Resume the system timer */
+#define SIM_TIME_STATUS 1  /* Copy the status to the struct sim_time_status */
+
+/* Writing the uint64_t simulator time in microseconds advances the system
+ * time by the same amount. The first write switches the system time from the
+ * system timer to the simulator, which then drives the sleeps and the timers
+ * until released or silent for SIM_TIME_TIMEOUT_MS */
+struct sim_time_status {
+    uint64_t sim_usec; /* Last simulator time written */
+    uint32_t steps;    /* Writes received */
+    uint32_t resyncs;  /* Simulator restarts or jumps */
+    bool lockstep;     /* The system time is driven by the simulator */
+};
+
+#endif
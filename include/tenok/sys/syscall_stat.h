@@ -0,0 +1,34 @@
+/**
+ * @file
+ */
+#ifndef __SYSCALL_STAT_H__
+#define __SYSCALL_STAT_H__
+
+#include <stdint.h>
+
+#define SYSCALL_STAT_DEV "/dev/syscalls"
+
+/* Requests of the ioctl() on the syscall statistics device */
+#define SYSCALL_STAT_RESET 0 /* Clear the statistics */
+#define SYSCALL_STAT_FREQ 1  /* Copy the cycle frequency to the uint32_t */
+
+#define SYSCALL_NAME_MAX 24
+
+/* Bucket 0 counts the latencies below 2^SYSCALL_HIST_SHIFT cycles, bucket n
+ * counts [2^(SYSCALL_HIST_SHIFT + n - 1), 2^(SYSCALL_HIST_SHIFT + n)) and the
+ * last bucket is unbounded */
+#define SYSCALL_HIST_SHIFT 10
+#define SYSCALL_HIST_BUCKETS 20
+
+/* Record read from the syscall statistics device, one per syscall invoked
+ * since the last reset */
+struct syscall_stat {
+    char name[SYSCALL_NAME_MAX];
+    uint32_t num;
+    uint32_t cnt;    /* Invocations */
+    uint32_t max;    /* Longest latency in cycles */
+    uint64_t cycles; /* Cumulative latency of the returned calls in cycles */
+    uint32_t hist[SYSCALL_HIST_BUCKETS];
+};
+
+#endif
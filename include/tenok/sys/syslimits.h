@@ -12,4 +12,6 @@
 #define OPEN_MAX _OPEN_MAX
 #define LINE_MAX _LINE_MAX
 
+#define DELAYTIMER_MAX 2147483647 /* Max overrun count of a timer */
+
 #endif
@@ -0,0 +1,50 @@
+/**
+ * @file
+ */
+#ifndef __TIMERFD_H__
+#define __TIMERFD_H__
+
+#include <fcntl.h>
+#include <time.h>
+
+#define TFD_NONBLOCK O_NONBLOCK         /* Non-blocking read */
+#define TFD_TIMER_ABSTIME TIMER_ABSTIME /* Absolute initial expiration */
+
+/**
+ * @brief  Create a timer that notifies the expirations via a file
+ *         descriptor. Reading the file returns the number of the expirations
+ *         as an uint64_t since the last read, and the file can be watched
+ *         with poll() or epoll_wait()
+ * @param  clockid: The clock ID to provide, only CLOCK_MONOTONIC is
+ *         supported.
+ * @param  flags: 0 or TFD_NONBLOCK.
+ * @retval int: The file descriptor on success and nonzero error number on
+ *         error.
+ */
+int timerfd_create(int clockid, int flags);
+
+/**
+ * @brief  Arm or disarm the timer. The following expirations are scheduled
+ *         on absolute times with the interval, hence the period does not
+ *         drift even if the reader is late
+ * @param  fd: The timer file descriptor to provide.
+ * @param  flags: 0 or TFD_TIMER_ABSTIME.
+ * @param  new_value: The initial expiration and the interval. Zero initial
+ *         expiration disarms the timer.
+ * @param  old_value: For returning the previous setting (optional).
+ * @retval int: 0 on success and nonzero error number on error.
+ */
+int timerfd_settime(int fd,
+                    int flags,
+                    const struct itimerspec *new_value,
+                    struct itimerspec *old_value);
+
+/**
+ * @brief  Get the time until the next expiration and the interval
+ * @param  fd: The timer file descriptor to provide.
+ * @param  curr_value: For returning the current setting.
+ * @retval int: 0 on success and nonzero error number on error.
+ */
+int timerfd_gettime(int fd, struct itimerspec *curr_value);
+
+#endif
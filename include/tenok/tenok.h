@@ -11,6 +11,8 @@
 
 #include "kconfig.h"
 
+struct timespec;
+
 struct thread_stat {
     int pid;
     int tid;
@@ -60,6 +62,14 @@ void setprogname(const char *name);
  */
 int delay_ticks(uint32_t ticks);
 
+/**
+ * @brief  To cause the calling thread to sleep until the first system tick
+ *         at or after the absolute time of CLOCK_MONOTONIC
+ * @param  abstime: The absolute time to wake up.
+ * @retval int: 0 on success and nonzero error number on error.
+ */
+int delay_until(const struct timespec *abstime);
+
 /**
  * @brief  Get memory information of the system
  * @param  name: The information to acquire (check MINFO_NAMES).
@@ -67,4 +77,13 @@ int delay_ticks(uint32_t ticks);
  */
 int minfo(int name);
 
+/**
+ * @brief  Get the CPU cycle count for the time measurements. The DWT cycle
+ *         counter is used if available; otherwise the count is derived from
+ *         the system time
+ * @param  None
+ * @retval uint32_t: The free-running cycle count, which wraps around.
+ */
+uint32_t getcycles(void);
+
 #endif
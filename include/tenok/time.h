@@ -47,7 +47,12 @@ int clock_gettime(clockid_t clockid, struct timespec *tp);
 int clock_settime(clockid_t clockid, const struct timespec *tp);
 
 /**
- * @brief  Create a new per-thread interval timer
+ * @brief  Create a new interval timer. SIGEV_SIGNAL sends sigev_signo to
+ *         the creating thread and SIGEV_THREAD calls sigev_notify_function
+ *         from a new thread of the task, created with the
+ *         sigev_notify_attributes (NULL for the defaults) and detached.
+ *         The expirations while the callback is running are counted as
+ *         the overruns of the next call
  * @param  clk_id: The clock ID to provide.
  * @param  sevp: For signaling an event when the timer expired.
  * @param  timerid: For returning the ID of the newly created timer.
@@ -84,6 +89,16 @@ int timer_settime(timer_t timerid,
  */
 int timer_gettime(timer_t timerid, struct itimerspec *curr_value);
 
+/**
+ * @brief  Return the overrun count of the timer. Only one notification of
+ *         a timer can be pending, the expirations that occurred until the
+ *         last notification was delivered are counted as the overruns
+ * @param  timerid: The timer ID to provide.
+ * @retval int: The overrun count on success and nonzero error number on
+ *         error.
+ */
+int timer_getoverrun(timer_t timerid);
+
 /**
  * @brief  Return the time as the number of seconds since
  *         1970-01-01 00:00:00 +0000 (UTC)
@@ -22,7 +22,7 @@
 #define IDLE_STACK_SIZE 1024
 #define SOFTIRQD_STACK_SIZE 2048
 #define FILESYSD_STACK_SIZE 2048
-#define PRINTKD_STACK_SIZE 1024
+#define PRINTKD_STACK_SIZE 2048
 
 /* Task */
 #define TASK_MAX 64 /* Max number of tasks in the system */
@@ -36,12 +36,20 @@
 #define MQUEUE_MAX 50  /* Max number of message queue can be allocated */
 #define _MQ_PRIO_MAX 5 /* Max message queue priority number */
 
+/* Epoll */
+#define EPOLL_MAX 10 /* Max number of epoll instances can be created */
+
+/* Timers */
+#define TIMER_MAX 32   /* Max number of POSIX timers can be created */
+#define TIMERFD_MAX 10 /* Max number of timer files can be created */
+
 /* Pipe size. Note that if the size is too small, the file system daemon *
  * may not work properly                                                 */
 #define _PIPE_BUF 100 /* Bytes */
 
 /* Signals */
-#define SIGNAL_QUEUE_SIZE 5
+#define SIGNAL_QUEUE_SIZE 5 /* Default depth of the thread signal queue */
+#define SIGQUEUE_MAX 32     /* Max depth of the thread signal queue */
 
 /* Standard I/O (Use /dev/null if not implemented) */
 #define STDIN_PATH "/dev/console"
@@ -49,9 +57,35 @@
 #define STDERR_PATH "/dev/console"
 
 #define PRINT_SIZE_MAX 100 /* Buffer size of the printf and printk */
+#define PRINTK_RING_SIZE 2048 /* Bytes, a multiple of 4 and less than 64 KiB */
 
 #define USE_TENOK_PRINTF 0 /* 1: Use Tenok printf, 0: Use NewlibC printf */
 
+/* Profiler (sampling the interrupted PC on every tick, see the `prof` command
+ * of the shell) */
+#define PROFILER_ENABLE 0     /* 1: Enable the profiler, 0: Disable */
+#define PROFILER_SAMPLES 1024 /* Depth of the sample buffer */
+
+/* Tracing of the longest preemption-disabled sections and the interrupt
+ * handlers (see /proc/irqsoff and /proc/interrupts) */
+#define IRQSOFF_TRACE_ENABLE 0 /* 1: Enable the tracing, 0: Disable */
+#define IRQSOFF_TRACE_SITES 32 /* Max number of the call sites recorded */
+
+/* Per-syscall counters and latency histograms (see the `syscalls` command of
+ * the shell) */
+#define SYSCALL_STAT_ENABLE 0 /* 1: Enable the statistics, 0: Disable */
+
+/* RAM-backed stand-in of the flash storing the telemetry logs (see /dev/log
+ * and the `log` command of the shell). It is a short capture buffer, the
+ * quadrotor fills 16 KiB in about 0.5 s of armed flight */
+#define LOG_DEV_ENABLE 0   /* 1: Enable the device, 0: Disable */
+#define LOG_DEV_SIZE 16384 /* Capacity in bytes */
+
+/* Lockstep simulation, where the simulator time written to /dev/simtime
+ * drives the system time instead of the system timer */
+#define SIM_TIME_ENABLE 0        /* 1: Enable the time source, 0: Disable */
+#define SIM_TIME_TIMEOUT_MS 1000 /* Resume the system timer after the silence */
+
 /* File system */
 #define _NAME_MAX 30    /* Max length of files in bytes */
 #define _PATH_MAX 128   /* Max length of pathname in bytes */
@@ -61,6 +95,7 @@
 #define INODE_MAX 100   /* Max number of the inode can have */
 #define FS_BLK_SIZE 128 /* Block size of the file system in bytes */
 #define FS_BLK_CNT 100  /* Block number of the file system */
+#define POLL_FDS_MAX 8  /* Files a poll() call waits on without kmalloc() */
 
 /* Shell */
 #define _LINE_MAX 50
@@ -0,0 +1,246 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <arch/host.h>
+#include <arch/port.h>
+#include <kernel/kernel.h>
+#include <kernel/preempt.h>
+#include <kernel/profiler.h>
+#include <kernel/trace.h>
+#include <kernel/thread.h>
+#include <kernel/time.h>
+
+#include "kconfig.h"
+
+#define TICK_PERIOD_NSEC (1000000000 / OS_TICK_FREQ)
+#define SYSTICK_ISR_NUM 15
+
+struct context {
+    /* Pushed by the OS */
+    uint32_t edi, esi, ebx, ebp;
+    uint32_t syscall_num;
+    uint32_t r0, r1, r2, r3;
+
+    /* Return address */
+    uint32_t eip;
+};
+
+struct thread_frame {
+    struct context context; /* Resumes at the function */
+    uint32_t ret;           /* Return address of the function */
+    uint32_t args[4];       /* Arguments of the function */
+    uint32_t return_handler;
+};
+
+void __host_switch_to_kernel(void);
+void __host_thread_return(void);
+
+/* Board drivers may poll the host devices along with the tick */
+void Console_IRQHandler(void) __attribute__((weak));
+
+static uint64_t last_tick_nsec;
+
+uint32_t get_proc_mode(void)
+{
+    /* Only the tick is delivered as an interrupt on the host */
+    return host_irq_active() ? SYSTICK_ISR_NUM : 0;
+}
+
+void __preempt_disable(void)
+{
+    host_irq_disable();
+}
+
+void __preempt_enable(void)
+{
+    host_irq_enable();
+}
+
+void os_env_init(void *stack)
+{
+    /* The kernel runs on the stack of the host process with the interrupts
+     * disabled */
+    __preempt_disable();
+    preempt_count_inc();
+}
+
+void jump_to_kernel(void)
+{
+    /* Force disable interrupts */
+    __preempt_disable();
+
+    CURRENT_THREAD_INFO(curr_thread);
+
+    /* Preserve nesting level of preemption for current thread */
+    curr_thread->preempt_cnt = preempt_count();
+
+    /* Reset preemption level */
+    preempt_count_set(0);
+
+    /* Jump back to the kernel loop, the interrupts are enabled again once
+     * the thread is resumed */
+    __host_switch_to_kernel();
+
+    /* Restore nesting level of preemption for current thread */
+    preempt_count_set(curr_thread->preempt_cnt);
+
+    /* Restore preemption state */
+    if (preempt_count())
+        __preempt_disable();
+}
+
+void __stack_init(uint32_t **stack_top,
+                  uint32_t func,
+                  uint32_t return_handler,
+                  uint32_t args[4])
+{
+    /* The i386 System V ABI requires the arguments to be 16-byte aligned on
+     * the function entry */
+    uint32_t args_addr = ((uint32_t) *stack_top - sizeof(struct thread_frame) +
+                          offsetof(struct thread_frame, args)) &
+                         ~0xf;
+    struct thread_frame *frame =
+        (struct thread_frame *) (args_addr -
+                                 offsetof(struct thread_frame, args));
+
+    /* The function is entered with the ret instruction of the context
+     * switch and returns to the __host_thread_return, which passes the
+     * return value to the return handler */
+    memset(frame, 0, sizeof(struct thread_frame));
+    frame->context.eip = func;
+    frame->ret = (uint32_t) __host_thread_return;
+    frame->args[0] = args[0];
+    frame->args[1] = args[1];
+    frame->args[2] = args[2];
+    frame->args[3] = args[3];
+    frame->return_handler = return_handler;
+
+    *stack_top = (uint32_t *) frame;
+}
+
+void __platform_init(void)
+{
+    /* Generate the system tick with the interval timer of the host */
+    last_tick_nsec = host_clock_nsec();
+    host_timer_start(OS_TICK_FREQ);
+
+    /* Enable the CPU cycle counter for the time measurements */
+    cycle_counter_init();
+
+    /* The kernel keeps using the stack of the host process */
+    os_env_init(NULL);
+}
+
+uint32_t get_tick_elapsed_nsec(void)
+{
+    uint64_t elapsed = host_clock_nsec() - last_tick_nsec;
+
+    /* The tick may be delayed by the masked interrupts, saturate the
+     * interpolation so the time never goes backward */
+    if (elapsed >= TICK_PERIOD_NSEC)
+        return TICK_PERIOD_NSEC - 1;
+
+    return elapsed;
+}
+
+void oneshot_timer_start(uint32_t nsec)
+{
+    host_oneshot_start(nsec);
+}
+
+void oneshot_timer_cancel(void)
+{
+    host_oneshot_cancel();
+}
+
+uint32_t get_timer_resolution_nsec(void)
+{
+    return 1;
+}
+
+void cycle_counter_init(void)
+{
+    /* The monotonic clock of the host is always available */
+}
+
+uint32_t get_cycle_count(void)
+{
+    /* Count the cycles of a virtual 1 GHz CPU */
+    return (uint32_t) host_clock_nsec();
+}
+
+uint32_t get_cycle_freq(void)
+{
+    return 1000000000;
+}
+
+unsigned long get_syscall_num(void *sp)
+{
+    struct context *context = (struct context *) sp;
+    return context->syscall_num;
+}
+
+void get_syscall_args(void *sp, unsigned long *pargs[4])
+{
+    struct context *context = (struct context *) sp;
+    pargs[0] = (unsigned long *) &context->r0;
+    pargs[1] = (unsigned long *) &context->r1;
+    pargs[2] = (unsigned long *) &context->r2;
+    pargs[3] = (unsigned long *) &context->r3;
+}
+
+void __idle(void)
+{
+    host_wait_for_interrupt();
+}
+
+void halt(void)
+{
+    preempt_disable();
+
+    /* Nothing can be resumed on the host, terminate the process */
+    host_exit(1);
+}
+
+void SysTick_Handler(void)
+{
+    trace_irq_enter();
+
+    /* The ticks arriving in the kernel are deferred until the interrupts
+     * are unmasked, which is where the kernel is sampled */
+    bool masked;
+    uint32_t pc = host_irq_pc(&masked);
+    profiler_sample(pc, 0, masked);
+
+    last_tick_nsec = host_clock_nsec();
+    system_ticks_update();
+
+    trace_irq_exit();
+
+    /* Leave the interrupt context before switching to the kernel */
+    host_irq_return();
+    jump_to_kernel();
+}
+
+void host_irq_handler(void)
+{
+    unsigned int irqs = host_irq_take();
+
+    if (Console_IRQHandler)
+        Console_IRQHandler();
+
+    if (irqs & HOST_IRQ_ONESHOT) {
+        trace_irq_enter();
+        system_oneshot_update();
+        trace_irq_exit();
+    }
+
+    if (irqs & HOST_IRQ_TICK) {
+        SysTick_Handler();
+        return;
+    }
+
+    host_irq_return();
+    jump_to_kernel();
+}
@@ -6,7 +6,10 @@
 #include <kernel/kernel.h>
 #include <kernel/preempt.h>
 #include <kernel/printk.h>
+#include <kernel/profiler.h>
+#include <kernel/trace.h>
 #include <kernel/thread.h>
+#include <kernel/time.h>
 
 #include "kconfig.h"
 #include "stm32f4xx.h"
@@ -56,6 +59,9 @@ struct context_fpu {
     uint32_t s0_to_s15_fpscr[17]; /* S0, ..., S15, FPSCR */
 };
 
+static bool cycle_counter_enabled;
+static uint32_t oneshot_timer_freq;
+
 uint32_t get_proc_mode(void)
 {
     /* Get the 9 bits ISR number from the ipsr register.
@@ -129,6 +135,48 @@ void __stack_init(uint32_t **stack_top,
      */
 }
 
+/* TIM5 is counted by the APB1 timer clock and stopped by its own update
+ * interrupt */
+static void oneshot_timer_init(void)
+{
+    RCC_ClocksTypeDef clocks;
+    RCC_GetClocksFreq(&clocks);
+
+    /* The timer clock is doubled if the APB1 is prescaled */
+    oneshot_timer_freq = clocks.PCLK1_Frequency;
+    if (clocks.HCLK_Frequency != clocks.PCLK1_Frequency)
+        oneshot_timer_freq *= 2;
+
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM5, ENABLE);
+    TIM5->PSC = 0;
+    TIM5->CR1 = TIM_CR1_URS; /* Only the overflow raises the interrupt */
+    TIM5->EGR = TIM_EGR_UG;  /* Load the prescaler */
+    TIM5->SR = 0;
+    TIM5->DIER = TIM_DIER_UIE;
+
+    NVIC_SetPriority(TIM5_IRQn, 1);
+    NVIC_EnableIRQ(TIM5_IRQn);
+}
+
+void oneshot_timer_start(uint32_t nsec)
+{
+    uint32_t cycles = (uint64_t) nsec * oneshot_timer_freq / 1000000000ULL;
+
+    TIM5->CR1 &= ~TIM_CR1_CEN;
+    TIM5->ARR = cycles ? cycles : 1;
+    TIM5->CNT = 0;
+    TIM5->SR = 0;
+    NVIC_ClearPendingIRQ(TIM5_IRQn);
+    TIM5->CR1 |= TIM_CR1_CEN;
+}
+
+void oneshot_timer_cancel(void)
+{
+    TIM5->CR1 &= ~TIM_CR1_CEN;
+    TIM5->SR = 0;
+    NVIC_ClearPendingIRQ(TIM5_IRQn);
+}
+
 void __platform_init(void)
 {
     /* Priority range of group 4 is 0-15 */
@@ -143,11 +191,75 @@ void __platform_init(void)
     /* Enable SysTick timer */
     SysTick_Config(SystemCoreClock / OS_TICK_FREQ);
 
+    /* Enable the one-shot timer for the sub-tick deadlines */
+    oneshot_timer_init();
+
+    /* Enable the CPU cycle counter for the time measurements */
+    cycle_counter_init();
+
     /* Use a dummy stack to initialize the os environment */
     uint32_t stack_empty[32];
     os_env_init(&stack_empty[31]);
 }
 
+uint32_t get_tick_elapsed_nsec(void)
+{
+    uint32_t load = SysTick->LOAD;
+    uint32_t val, pending;
+
+    /* SysTick counts down, so a larger second read means the counter
+     * reloaded between the reads and the pending bit may be inconsistent */
+    do {
+        val = SysTick->VAL;
+        pending = SCB->ICSR & SCB_ICSR_PENDSTSET_Msk;
+    } while (SysTick->VAL > val);
+
+    uint32_t cycles = load - val;
+
+    /* The tick is expired but not yet accounted by the SysTick handler */
+    if (pending)
+        cycles += load + 1;
+
+    return (uint64_t) cycles * 1000000000ULL / SystemCoreClock;
+}
+
+uint32_t get_timer_resolution_nsec(void)
+{
+    return (1000000000UL + SystemCoreClock - 1) / SystemCoreClock;
+}
+
+void cycle_counter_init(void)
+{
+    if (DWT->CTRL & DWT_CTRL_NOCYCCNT_Msk)
+        return;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    /* QEMU does not model the counter, check if it is running */
+    asm volatile("nop\n nop\n nop\n nop\n");
+    cycle_counter_enabled = DWT->CYCCNT != 0;
+}
+
+uint32_t get_cycle_count(void)
+{
+    if (cycle_counter_enabled)
+        return DWT->CYCCNT;
+
+    /* Derive the cycles from the system time, the count wraps around
+     * consistently with the modular arithmetic */
+    struct timespec tp;
+    get_sys_time(&tp);
+    return (uint32_t) tp.tv_sec * SystemCoreClock +
+           (uint32_t) ((uint64_t) tp.tv_nsec * SystemCoreClock / 1000000000ULL);
+}
+
+uint32_t get_cycle_freq(void)
+{
+    return SystemCoreClock;
+}
+
 unsigned long get_syscall_num(void *sp)
 {
     uint32_t lr = ((uint32_t *) sp)[8];
@@ -290,9 +402,42 @@ NACKED void UsageFault_Handler(void)
     FAULT_DUMP(USAGE_FAULT);
 }
 
-void SysTick_Handler(void)
+NACKED void SysTick_Handler(void)
 {
+    /* Pass the exception frame of the interrupted context, the handler
+     * returns with the EXC_RETURN preserved in the lr */
+    asm volatile(
+        "tst   lr, #4            \n"
+        "ite   eq                \n"
+        "mrseq r0, msp           \n"
+        "mrsne r0, psp           \n"
+        "mov   r1, lr            \n"
+        "b     __systick_handler \n");
+}
+
+void __systick_handler(uint32_t *frame, uint32_t exc_return)
+{
+    trace_irq_enter();
+
+    /* EXC_RETURN[2]: 0 = Kernel or interrupt (msp) / 1 = Thread (psp) */
+    profiler_sample(frame[6], frame[5], !(exc_return & 0x4));
+
     system_ticks_update();
+
+    trace_irq_exit();
+    jump_to_kernel();
+}
+
+void TIM5_IRQHandler(void)
+{
+    trace_irq_enter();
+
+    TIM5->CR1 &= ~TIM_CR1_CEN;
+    TIM5->SR = 0;
+
+    system_oneshot_update();
+
+    trace_irq_exit();
     jump_to_kernel();
 }
 
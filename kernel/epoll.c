@@ -0,0 +1,238 @@
+#include <errno.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/epoll.h>
+
+#include <arch/port.h>
+#include <common/list.h>
+#include <kernel/epoll.h>
+#include <kernel/errno.h>
+#include <kernel/kernel.h>
+#include <kernel/poll.h>
+#include <kernel/syscall.h>
+#include <kernel/wait.h>
+#include <mm/mm.h>
+
+static int epoll_open(struct inode *inode, struct file *file)
+{
+    return 0;
+}
+
+/* The epoll file is only waited on by poll() or another epoll instance */
+static struct file_operations epoll_ops = {
+    .open = epoll_open,
+};
+
+void __epoll_init(struct eventpoll *ep)
+{
+    /* The poll wait list is kept since the pollers may still be linked to
+     * the recycled file */
+    ep->file.f_inode = NULL;
+    ep->file.f_op = &epoll_ops;
+    ep->file.f_events = 0;
+    ep->file.f_flags = 0;
+
+    INIT_LIST_HEAD(&ep->items);
+    INIT_LIST_HEAD(&ep->rdllist);
+    init_wait_queue(&ep->wait_list);
+}
+
+static void ep_remove(struct epitem *epi);
+
+static void ep_poll_callback(struct poll_wait_entry *wait, struct file *filp)
+{
+    struct epitem *epi = container_of(wait, struct epitem, wait);
+
+    /* The watched file is closed, drop the item */
+    if (list_empty(&wait->list)) {
+        ep_remove(epi);
+        return;
+    }
+
+    /* Ignore the events that are not watched */
+    if (!(filp->f_events & epi->event.events))
+        return;
+
+    struct eventpoll *ep = epi->ep;
+
+    /* Move the item to the ready list */
+    if (!epi->ready) {
+        list_add_tail(&epi->rdllink, &ep->rdllist);
+        epi->ready = true;
+    }
+
+    /* Wake up the threads blocked in the epoll_wait() */
+    wake_up_queue_all(&ep->wait_list);
+
+    /* Notify the pollers of the epoll file, once per readiness */
+    if (!(ep->file.f_events & POLLIN)) {
+        ep->file.f_events |= POLLIN;
+        poll_notify(&ep->file);
+    }
+}
+
+static struct epitem *ep_find(struct eventpoll *ep, int fd)
+{
+    struct epitem *epi;
+    list_for_each_entry (epi, &ep->items, list) {
+        if (epi->fd == fd)
+            return epi;
+    }
+
+    return NULL;
+}
+
+static void ep_remove(struct epitem *epi)
+{
+    poll_remove_wait(&epi->wait);
+
+    if (epi->ready)
+        list_del(&epi->rdllink);
+
+    list_del(&epi->list);
+    kfree(epi);
+}
+
+void __epoll_release(struct eventpoll *ep)
+{
+    struct list_head *curr, *next;
+    list_for_each_safe (curr, next, &ep->items) {
+        ep_remove(list_entry(curr, struct epitem, list));
+    }
+
+    /* Fail the blocked waiters and detach the pollers before the slot is
+     * recycled */
+    ep->gen++;
+    ep->file.f_events = 0;
+    wake_up_queue_all(&ep->wait_list);
+    poll_release(&ep->file);
+}
+
+struct eventpoll *file_to_epoll(struct file *filp)
+{
+    if (!filp || filp->f_op != &epoll_ops)
+        return NULL;
+
+    return container_of(filp, struct eventpoll, file);
+}
+
+int __epoll_ctl(struct eventpoll *ep,
+                int op,
+                int fd,
+                struct file *filp,
+                struct epoll_event *event)
+{
+    /* An instance watching itself would notify itself */
+    if (filp == &ep->file)
+        return -EINVAL;
+
+    struct epitem *epi = ep_find(ep, fd);
+
+    switch (op) {
+    case EPOLL_CTL_ADD:
+        if (!event)
+            return -EINVAL;
+
+        if (epi)
+            return -EEXIST;
+
+        epi = kmalloc(sizeof(struct epitem));
+        if (!epi)
+            return -ENOMEM;
+
+        memset(epi, 0, sizeof(struct epitem));
+        epi->ep = ep;
+        epi->filp = filp;
+        epi->fd = fd;
+        epi->event = *event;
+        list_add_tail(&epi->list, &ep->items);
+
+        /* Watch the file events */
+        poll_add_wait(filp, &epi->wait, ep_poll_callback);
+        break;
+    case EPOLL_CTL_MOD:
+        if (!event)
+            return -EINVAL;
+
+        if (!epi)
+            return -ENOENT;
+
+        epi->event = *event;
+        break;
+    case EPOLL_CTL_DEL:
+        if (!epi)
+            return -ENOENT;
+
+        ep_remove(epi);
+        return 0;
+    default:
+        return -EINVAL;
+    }
+
+    /* Check the events that are already observed */
+    ep_poll_callback(&epi->wait, filp);
+
+    return 0;
+}
+
+int __epoll_harvest(struct eventpoll *ep,
+                    struct epoll_event *events,
+                    int maxevents)
+{
+    LIST_HEAD(reported_list);
+    int cnt = 0;
+
+    /* Only the items on the ready list are checked */
+    struct list_head *curr, *next;
+    list_for_each_safe (curr, next, &ep->rdllist) {
+        if (cnt >= maxevents)
+            break;
+
+        struct epitem *epi = list_entry(curr, struct epitem, rdllink);
+
+        uint32_t revents = epi->filp->f_events & epi->event.events;
+        if (!revents) {
+            /* Events are consumed, wait for the next notification */
+            list_del(&epi->rdllink);
+            epi->ready = false;
+            continue;
+        }
+
+        events[cnt].events = revents;
+        events[cnt].data = epi->event.data;
+        cnt++;
+
+        /* Level-triggered: keep the item but serve the others first on the
+         * next call */
+        list_move_tail(&epi->rdllink, &reported_list);
+    }
+
+    while (!list_empty(&reported_list))
+        list_move_tail(reported_list.next, &ep->rdllist);
+
+    /* The epoll file stays readable until the ready list drains */
+    if (list_empty(&ep->rdllist))
+        ep->file.f_events &= ~POLLIN;
+
+    return cnt;
+}
+
+NACKED int epoll_create(int size)
+{
+    SYSCALL(EPOLL_CREATE);
+}
+
+NACKED int epoll_ctl(int epfd, int op, int fd, struct epoll_event *event)
+{
+    SYSCALL(EPOLL_CTL);
+}
+
+NACKED int epoll_wait(int epfd,
+                      struct epoll_event *events,
+                      int maxevents,
+                      int timeout)
+{
+    SYSCALL(EPOLL_WAIT);
+}
@@ -109,6 +109,20 @@ int register_blkdev(char *name, struct file_operations *fops)
     return 0;
 }
 
+int register_proc_file(char *name, struct file_operations *fops)
+{
+    char proc_path[100] = {0};
+    snprintf(proc_path, PATH_MAX, "/proc/%s", name);
+
+    /* Create new file reporting the kernel information */
+    int fd = fs_create_file(proc_path, S_IFCHR);
+
+    /* Link the file operations */
+    files[fd]->f_op = fops;
+
+    return 0;
+}
+
 struct file *fs_alloc_file(void)
 {
     preempt_disable();
@@ -0,0 +1,152 @@
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/log_dev.h>
+#include <sys/types.h>
+
+#include <fs/fs.h>
+#include <fs/log_dev.h>
+#include <kernel/preempt.h>
+#include <kernel/printk.h>
+
+#include "kconfig.h"
+
+#if (LOG_DEV_ENABLE != 0)
+
+static struct {
+    uint8_t data[LOG_DEV_SIZE];
+    uint32_t len; /* Next byte to program */
+    uint32_t pos; /* Next byte to read */
+} log_dev;
+
+static int log_dev_open(struct inode *inode, struct file *file)
+{
+    inode->i_size = log_dev.len;
+    return 0;
+}
+
+static ssize_t log_dev_read(struct file *filp,
+                            char *buf,
+                            size_t size,
+                            off_t offset)
+{
+    preempt_disable();
+
+    uint32_t pos = log_dev.pos;
+    size_t n = 0;
+    if (pos < log_dev.len) {
+        n = log_dev.len - pos;
+        if (n > size)
+            n = size;
+    }
+    log_dev.pos = pos + n;
+
+    preempt_enable();
+
+    /* The programmed data is never modified before the erase */
+    memcpy(buf, &log_dev.data[pos], n);
+
+    return n;
+}
+
+static ssize_t log_dev_write(struct file *filp,
+                             const char *buf,
+                             size_t size,
+                             off_t offset)
+{
+    preempt_disable();
+
+    /* Reserve the space so the writers never interleave */
+    uint32_t len = log_dev.len;
+    size_t n = LOG_DEV_SIZE - len;
+    if (n > size)
+        n = size;
+    log_dev.len = len + n;
+
+    preempt_enable();
+
+    if (n == 0 && size > 0)
+        return -ENOSPC;
+
+    memcpy(&log_dev.data[len], buf, n);
+
+    return n;
+}
+
+static off_t log_dev_lseek(struct file *filp, off_t offset, int whence)
+{
+    off_t pos;
+
+    preempt_disable();
+
+    switch (whence) {
+    case SEEK_SET:
+        pos = offset;
+        break;
+    case SEEK_CUR:
+        pos = log_dev.pos + offset;
+        break;
+    case SEEK_END:
+        pos = log_dev.len + offset;
+        break;
+    default:
+        pos = -EINVAL;
+        goto leave;
+    }
+
+    if (pos < 0 || pos > (off_t) log_dev.len) {
+        pos = -EINVAL;
+        goto leave;
+    }
+
+    log_dev.pos = pos;
+
+leave:
+    preempt_enable();
+    return pos;
+}
+
+static int log_dev_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
+{
+    switch (cmd) {
+    case LOG_DEV_ERASE:
+        preempt_disable();
+        log_dev.len = 0;
+        log_dev.pos = 0;
+        preempt_enable();
+
+        /* Erased flash reads as 0xff */
+        memset(log_dev.data, 0xff, sizeof(log_dev.data));
+        return 0;
+    case LOG_DEV_STATUS: {
+        struct log_dev_status *status = (struct log_dev_status *) arg;
+        if (!status)
+            return -EFAULT;
+
+        status->capacity = LOG_DEV_SIZE;
+        status->used = log_dev.len;
+        return 0;
+    }
+    default:
+        return -EINVAL;
+    }
+}
+
+static struct file_operations log_dev_ops = {
+    .lseek = log_dev_lseek,
+    .read = log_dev_read,
+    .write = log_dev_write,
+    .ioctl = log_dev_ioctl,
+    .open = log_dev_open,
+};
+
+void log_dev_init(void)
+{
+    memset(log_dev.data, 0xff, sizeof(log_dev.data));
+    register_blkdev("log", &log_dev_ops);
+    printk("blkdev log: telemetry log storage (%d KiB)", LOG_DEV_SIZE / 1024);
+}
+
+#endif
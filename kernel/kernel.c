@@ -12,9 +12,11 @@
 #include <stdint.h>
 #include <string.h>
 #include <strings.h>
+#include <sys/epoll.h>
 #include <sys/limits.h>
 #include <sys/mount.h>
 #include <sys/stat.h>
+#include <sys/timerfd.h>
 #include <task.h>
 #include <tenok.h>
 #include <time.h>
@@ -25,25 +27,33 @@
 #include <common/list.h>
 #include <common/util.h>
 #include <fs/fs.h>
+#include <fs/log_dev.h>
 #include <fs/null_dev.h>
 #include <fs/rom_dev.h>
 #include <fs/vfs.h>
 #include <kernel/daemon.h>
+#include <kernel/epoll.h>
 #include <kernel/errno.h>
 #include <kernel/kernel.h>
 #include <kernel/kfifo.h>
 #include <kernel/mqueue.h>
 #include <kernel/mutex.h>
 #include <kernel/pipe.h>
+#include <kernel/poll.h>
 #include <kernel/preempt.h>
 #include <kernel/printk.h>
+#include <kernel/profiler.h>
 #include <kernel/sched.h>
 #include <kernel/semaphore.h>
 #include <kernel/signal.h>
+#include <kernel/sim_time.h>
 #include <kernel/softirq.h>
 #include <kernel/syscall.h>
+#include <kernel/syscall_stat.h>
 #include <kernel/thread.h>
 #include <kernel/time.h>
+#include <kernel/timerfd.h>
+#include <kernel/trace.h>
 #include <kernel/tty.h>
 #include <kernel/wait.h>
 #include <mm/mm.h>
@@ -52,15 +62,11 @@
 
 #include "kconfig.h"
 
-#define PRI_RESERVED 2
-#define KTHREAD_PRI_MAX (THREAD_PRIORITY_MAX + PRI_RESERVED)
-
 static LIST_HEAD(tasks_list);   /* List of all tasks in the system */
 static LIST_HEAD(threads_list); /* List of all threads in the system */
 static LIST_HEAD(sleep_list);   /* List of all threads in the sleeping state */
 static LIST_HEAD(suspend_list); /* List of all threads that are suspended */
 static LIST_HEAD(timeout_list); /* List of all blocked threads with timeout */
-static LIST_HEAD(timers_list);  /* List of all timers in the system */
 static LIST_HEAD(poll_list);    /* List of all threads suspended by poll() */
 static LIST_HEAD(mqueue_list);  /* List of all posix message queues */
 
@@ -83,6 +89,10 @@ static struct thread_info *running_thread;
 static uint32_t bitmap_tasks[BITMAP_SIZE(TASK_MAX)];
 static uint32_t bitmap_threads[BITMAP_SIZE(THREAD_MAX)];
 
+/* Wait queue buckets, one is owned by every thread */
+static struct wait_bucket wait_buckets[THREAD_MAX];
+static struct wait_bucket *free_wait_buckets;
+
 /* Daemons information */
 static int daemon_id_table[DAEMON_CNT];
 
@@ -102,6 +112,22 @@ static uint32_t bitmap_fds[BITMAP_SIZE(OPEN_MAX)];
 static struct mq_desc mqd_table[MQUEUE_MAX];
 static uint32_t bitmap_mqds[BITMAP_SIZE(MQUEUE_MAX)];
 
+/* Epoll instances */
+static struct eventpoll epoll_table[EPOLL_MAX];
+static uint32_t bitmap_epolls[BITMAP_SIZE(EPOLL_MAX)];
+
+/* POSIX timers */
+static struct timer timer_table[TIMER_MAX];
+static uint32_t bitmap_timers[BITMAP_SIZE(TIMER_MAX)];
+
+/* Timers with pending SIGEV_THREAD notifications */
+static LIST_HEAD(timer_notify_list);
+static struct tasklet_struct timer_notify_tasklet;
+
+/* Timer file objects */
+static struct timerfd timerfd_table[TIMERFD_MAX];
+static uint32_t bitmap_timerfds[BITMAP_SIZE(TIMERFD_MAX)];
+
 /* Memory allocators */
 static struct kmalloc_slab_info kmalloc_slab_info[] = {
     /* clang-format off */
@@ -153,8 +179,10 @@ inline void preempt_count_dec(void)
 
 void preempt_disable(void)
 {
-    if (preempt_cnt == 0)
+    if (preempt_cnt == 0) {
         __preempt_disable();
+        trace_preempt_off((uintptr_t) __builtin_return_address(0));
+    }
 
     /* Increase nesting level */
     preempt_count_inc();
@@ -165,8 +193,10 @@ void preempt_enable(void)
     /* Decrease nesting level */
     preempt_count_dec();
 
-    if (preempt_cnt == 0)
+    if (preempt_cnt == 0) {
+        trace_preempt_on();
         __preempt_enable();
+    }
 }
 
 int preempt_count(void)
@@ -176,6 +206,13 @@ int preempt_count(void)
 
 void preempt_count_set(uint32_t count)
 {
+    /* Sections split by switching to the kernel, which are resumed at the
+     * call site of the port */
+    if (preempt_cnt && !count)
+        trace_preempt_on();
+    else if (!preempt_cnt && count)
+        trace_preempt_off((uintptr_t) __builtin_return_address(0));
+
     preempt_cnt = count;
 }
 
@@ -334,25 +371,106 @@ static void *thread_pipe_alloc(uint32_t tid, void *stack_top)
     return (void *) buf;
 }
 
-/* Consume the stack memory from the thread and create a signal
- * handler queue
+/* Consume the stack memory from the thread and create a pending
+ * signal queue
  */
-static void *thread_signal_queue_alloc(struct kfifo *signal_queue,
-                                       void *stack_top)
-{
-    size_t payload_size =
-        kfifo_header_size() + sizeof(struct staged_handler_info);
-    size_t queue_size = ALIGN(payload_size * SIGNAL_QUEUE_SIZE, sizeof(long));
-    char *buf = (char *) ((uintptr_t) stack_top - queue_size);
-    kfifo_init(signal_queue, buf, payload_size, SIGNAL_QUEUE_SIZE);
-    return (void *) buf;
+static void *thread_signal_queue_alloc(struct thread_info *thread,
+                                       void *stack_top,
+                                       int queue_size)
+{
+    size_t size = ALIGN(sizeof(siginfo_t) * queue_size, sizeof(long));
+    thread->sig_queue = (siginfo_t *) ((uintptr_t) stack_top - size);
+    thread->sig_queue_size = queue_size;
+    thread->sig_queue_cnt = 0;
+    return (void *) thread->sig_queue;
 }
 
-static int thread_create(struct thread_info **new_thread,
-                         thread_func_t thread_func,
-                         struct thread_attr *attr,
-                         void *thread_arg,
-                         bool kernel_thread)
+static void wait_bucket_add(struct wait_bucket *bucket,
+                            struct thread_info *thread)
+{
+    list_add_tail(&thread->list, &bucket->lists[thread->priority]);
+    bucket->bitmap |= 1 << thread->priority;
+}
+
+static void wait_bucket_del(struct wait_bucket *bucket,
+                            struct thread_info *thread)
+{
+    /* The last thread of a list is linked to the list head on both sides,
+     * which tells the priority it is queued with */
+    if (thread->list.next == thread->list.prev) {
+        int pri = thread->list.next - bucket->lists;
+        bucket->bitmap &= ~(1 << pri);
+    }
+
+    list_del(&thread->list);
+}
+
+static void wait_queue_insert(struct wait_queue *wq,
+                              struct thread_info *thread)
+{
+    struct wait_bucket *bucket = thread->wait_bucket;
+    thread->wait_bucket = NULL;
+
+    /* Lend the bucket of the thread to the queue, as a spare if the queue
+     * already has one */
+    if (wq->bucket) {
+        bucket->next = wq->bucket->next;
+        wq->bucket->next = bucket;
+    } else {
+        wq->bucket = bucket;
+    }
+
+    wait_bucket_add(wq->bucket, thread);
+    thread->wait_queue = wq;
+}
+
+static void wait_queue_remove(struct thread_info *thread)
+{
+    struct wait_queue *wq = thread->wait_queue;
+    struct wait_bucket *bucket = wq->bucket;
+
+    wait_bucket_del(bucket, thread);
+
+    /* Take a spare back, or the bucket itself from the last waiter */
+    if (bucket->next) {
+        thread->wait_bucket = bucket->next;
+        bucket->next = thread->wait_bucket->next;
+        thread->wait_bucket->next = NULL;
+    } else {
+        thread->wait_bucket = bucket;
+        wq->bucket = NULL;
+    }
+
+    thread->wait_queue = NULL;
+}
+
+static struct wait_bucket *wait_bucket_alloc(void)
+{
+    /* Never runs out as there is a bucket for every thread */
+    struct wait_bucket *bucket = free_wait_buckets;
+    free_wait_buckets = bucket->next;
+    bucket->next = NULL;
+
+    return bucket;
+}
+
+static void wait_bucket_free(struct wait_bucket *bucket)
+{
+    bucket->next = free_wait_buckets;
+    free_wait_buckets = bucket;
+}
+
+static void wait_buckets_init(void)
+{
+    for (int i = 0; i < THREAD_MAX; i++) {
+        wait_buckets[i].bitmap = 0;
+        for (int pri = 0; pri <= KTHREAD_PRI_MAX; pri++)
+            INIT_LIST_HEAD(&wait_buckets[i].lists[pri]);
+        wait_bucket_free(&wait_buckets[i]);
+    }
+}
+
+static bool thread_attr_is_valid(struct thread_attr *attr, bool kernel_thread)
 {
     /* Check if the detach state setting is invalid */
     bool bad_detach_state = attr->detachstate != PTHREAD_CREATE_DETACHED &&
@@ -371,7 +489,21 @@ static int thread_create(struct thread_info **new_thread,
     /* Check if the scheduling policy is invalid */
     bool bad_sched_policy = attr->schedpolicy != SCHED_RR;
 
-    if (bad_detach_state || bad_priority || bad_sched_policy)
+    /* Check if the signal queue depth is invalid (0 for the default) */
+    bool bad_sigqueue_size =
+        attr->sigqueuesize < 0 || attr->sigqueuesize > SIGQUEUE_MAX;
+
+    return !(bad_detach_state || bad_priority || bad_sched_policy ||
+             bad_sigqueue_size);
+}
+
+static int thread_create(struct thread_info **new_thread,
+                         thread_func_t thread_func,
+                         struct thread_attr *attr,
+                         void *thread_arg,
+                         bool kernel_thread)
+{
+    if (!thread_attr_is_valid(attr, kernel_thread))
         return -EINVAL;
 
     /* Allocate new thread Id */
@@ -396,14 +528,18 @@ static int thread_create(struct thread_info **new_thread,
         return -ENOMEM;
     }
 
+    thread->wait_bucket = wait_bucket_alloc();
+
     thread->stack_top =
         (unsigned long *) ((uintptr_t) thread->stack + stack_size);
 
     /* Allocate anonymous pipe for the thread */
     thread->stack_top = thread_pipe_alloc(tid, thread->stack_top);
 
+    int sigqueue_size =
+        attr->sigqueuesize ? attr->sigqueuesize : SIGNAL_QUEUE_SIZE;
     thread->stack_top =
-        thread_signal_queue_alloc(&thread->signal_queue, thread->stack_top);
+        thread_signal_queue_alloc(thread, thread->stack_top, sigqueue_size);
 
     /* Initialize thread stack */
     uint32_t func_args[4] = {0};
@@ -417,6 +553,7 @@ static int thread_create(struct thread_info **new_thread,
     thread->status = THREAD_WAIT;
     thread->tid = tid;
     thread->priority = attr->schedparam.sched_priority;
+    thread->original_priority = thread->priority;
     thread->kernel_thread = kernel_thread;
     thread->privilege = kernel_thread ? KERNEL_THREAD : USER_THREAD;
 
@@ -428,12 +565,16 @@ static int thread_create(struct thread_info **new_thread,
         thread->detached = false;
     }
 
-    /* Initialize poll file list */
-    INIT_LIST_HEAD(&thread->poll_files_list);
-
     /* Initialize the thread join list */
     INIT_LIST_HEAD(&thread->join_list);
 
+    /* Initialize the owned mutex list */
+    INIT_LIST_HEAD(&thread->mutex_list);
+
+    /* Initialize the timer lists */
+    INIT_LIST_HEAD(&thread->timers_list);
+    INIT_LIST_HEAD(&thread->timer_sig_list);
+
     /* Link the thread to the global thread list */
     list_add_tail(&thread->thread_list, &threads_list);
 
@@ -510,6 +651,22 @@ static void task_delete(struct task_struct *task)
     for (int i = 0; i < BITMAP_SIZE(MQUEUE_MAX); i++) {
         bitmap_mqds[i] &= ~task->bitmap_mqds[i];
     }
+
+    /* Release the epoll instances of the task */
+    for (int i = 0; i < EPOLL_MAX; i++) {
+        if (bitmap_get_bit(task->bitmap_epolls, i)) {
+            __epoll_release(&epoll_table[i]);
+            bitmap_clear_bit(bitmap_epolls, i);
+        }
+    }
+
+    /* Release the timer files of the task */
+    for (int i = 0; i < TIMERFD_MAX; i++) {
+        if (bitmap_get_bit(task->bitmap_timerfds, i)) {
+            __timerfd_release(&timerfd_table[i]);
+            bitmap_clear_bit(bitmap_timerfds, i);
+        }
+    }
 }
 
 static void stage_temporary_handler(struct thread_info *thread,
@@ -525,44 +682,118 @@ static void stage_temporary_handler(struct thread_info *thread,
     __stack_init((uint32_t **) &thread->stack_top, func, return_handler, args);
 }
 
-static void enqueue_pending_signal(struct thread_info *thread,
-                                   uint32_t func,
-                                   uint32_t args[4])
+static int enqueue_pending_signal(struct thread_info *thread,
+                                  const siginfo_t *info)
 {
-    if (thread->signal_cnt >= SIGNAL_QUEUE_SIZE)
-        printk("Warning: the oldest pending signal is overwritten");
+    int sig_idx = get_signal_index(info->si_signo);
+
+    /* Standard signals are not queued if one is already pending */
+    if (!is_rt_signal(info->si_signo)) {
+        for (int i = 0; i < thread->sig_queue_cnt; i++) {
+            if (thread->sig_queue[i].si_signo == info->si_signo)
+                return 0;
+        }
+    }
 
-    /* Push new signal into the pending queue */
-    struct staged_handler_info info;
-    info.func = func;
-    info.args[0] = args[0];
-    info.args[1] = args[1];
-    info.args[2] = args[2];
-    info.args[3] = args[3];
-    kfifo_in(&thread->signal_queue, &info, sizeof(struct staged_handler_info));
+    /* Report the overflow instead of dropping the signal */
+    if (thread->sig_queue_cnt >= thread->sig_queue_size)
+        return -EAGAIN;
+
+    /* Insert behind the pending signals of the same or higher priority */
+    int pos = thread->sig_queue_cnt;
+    while (pos > 0 &&
+           get_signal_index(thread->sig_queue[pos - 1].si_signo) > sig_idx) {
+        thread->sig_queue[pos] = thread->sig_queue[pos - 1];
+        pos--;
+    }
+    thread->sig_queue[pos] = *info;
+    thread->sig_queue_cnt++;
+
+    return 0;
+}
 
-    /* Update the number of total pending signals */
-    thread->signal_cnt = kfifo_len(&thread->signal_queue);
+static void dequeue_pending_signal(struct thread_info *thread,
+                                   siginfo_t *info)
+{
+    *info = thread->sig_queue[0];
+    thread->sig_queue_cnt--;
+    memmove(&thread->sig_queue[0], &thread->sig_queue[1],
+            sizeof(siginfo_t) * thread->sig_queue_cnt);
 }
 
-static void check_pending_signals(void)
+static void timer_notify_delivered(struct timer *timer)
 {
-    if (running_thread->signal_cnt == 0 ||
-        running_thread->stack_top_preserved) {
+    list_del_init(&timer->notify_list);
+    timer->notify_pending = false;
+
+    /* Report the overruns counted until the delivery */
+    timer->overrun_last = timer->overrun;
+    timer->overrun = 0;
+}
+
+static struct timer *find_pending_timer_signal(struct thread_info *thread)
+{
+    struct timer *pending = NULL;
+
+    /* Find the timer signal of the highest priority */
+    struct timer *timer;
+    list_for_each_entry (timer, &thread->timer_sig_list, notify_list) {
+        if (!pending || get_signal_index(timer->sev.sigev_signo) <
+                            get_signal_index(pending->sev.sigev_signo)) {
+            pending = timer;
+        }
+    }
+
+    return pending;
+}
+
+static void stage_signal_handler(struct thread_info *thread)
+{
+    int signum = thread->sig_info.si_signo;
+    struct sigaction *act = thread->sig_table[get_signal_index(signum)];
+
+    /* Signal handler is not provided */
+    if (!act || !act->sa_handler)
         return;
+
+    /* Stage signal or sigaction handler into the thread stack */
+    uint32_t func;
+    uint32_t args[4] = {0};
+    args[0] = (uint32_t) signum;
+    if (act->sa_flags & SA_SIGINFO) {
+        func = (uint32_t) act->sa_sigaction;
+        args[1] = (uint32_t) &thread->sig_info;
+        args[2] = (uint32_t) NULL /* context (TODO) */;
+    } else {
+        func = (uint32_t) act->sa_handler;
     }
+    stage_temporary_handler(thread, func, (uint32_t) signal_cleanup_handler,
+                            args);
+}
 
-    /* Retrieve a pending signal from the queue */
-    struct staged_handler_info info;
-    kfifo_out(&running_thread->signal_queue, &info,
-              sizeof(struct staged_handler_info));
+static void check_pending_signals(void)
+{
+    if (running_thread->stack_top_preserved)
+        return;
 
-    /* Stage the signal handler into the thread stack */
-    stage_temporary_handler(running_thread, info.func,
-                            (uint32_t) signal_cleanup_handler, info.args);
+    /* Timer signals are coalesced per timer instead of being queued */
+    struct timer *timer = find_pending_timer_signal(running_thread);
+
+    /* Queued signals go first if the priority is the same */
+    if (running_thread->sig_queue_cnt > 0 &&
+        (!timer || get_signal_index(running_thread->sig_queue[0].si_signo) <=
+                       get_signal_index(timer->sev.sigev_signo))) {
+        dequeue_pending_signal(running_thread, &running_thread->sig_info);
+    } else if (timer) {
+        timer_notify_delivered(timer);
+        running_thread->sig_info.si_signo = timer->sev.sigev_signo;
+        running_thread->sig_info.si_code = SI_TIMER;
+        running_thread->sig_info.si_value = timer->sev.sigev_value;
+    } else {
+        return;
+    }
 
-    /* Update the number of total pending signals */
-    running_thread->signal_cnt = kfifo_len(&running_thread->signal_queue);
+    stage_signal_handler(running_thread);
 }
 
 static void thread_suspend(struct thread_info *thread)
@@ -582,16 +813,62 @@ static void thread_resume(struct thread_info *thread)
     list_move_tail(&thread->list, &ready_list[thread->priority]);
 }
 
+static void timer_notify_queue(struct timer *timer)
+{
+    /* The callback thread is created by the tasklet as the notification
+     * may come from the interrupt context */
+    list_add_tail(&timer->notify_list, &timer_notify_list);
+    tasklet_schedule(&timer_notify_tasklet);
+}
+
+static void timer_notify_exit(struct thread_info *thread)
+{
+    struct timer *timer = thread->notify_timer;
+    if (!timer)
+        return;
+
+    timer->notify_thread = NULL;
+
+    /* Deliver the notification that expired during the callback */
+    if (timer->notify_pending)
+        timer_notify_queue(timer);
+}
+
+static void timer_release(struct timer *timer)
+{
+    ktimer_cancel(&timer->ktimer);
+
+    list_del_init(&timer->notify_list);
+
+    /* Let the running callback thread finish without the timer */
+    if (timer->notify_thread)
+        timer->notify_thread->notify_timer = NULL;
+
+    list_del(&timer->list);
+    bitmap_clear_bit(bitmap_timers, timer->id);
+}
+
 static void thread_delete(struct thread_info *thread)
 {
     /* Remove the thread from the system */
     list_del(&thread->task_list);
     list_del(&thread->thread_list);
-    if (thread != running_thread)
+    if (thread->wait_queue)
+        wait_queue_remove(thread);
+    else if (thread != running_thread)
         list_del(&thread->list);
+    wait_bucket_free(thread->wait_bucket);
+    mutex_remove_waiter(thread);
+    timer_notify_exit(thread);
     thread->status = THREAD_TERMINATED;
     bitmap_clear_bit(bitmap_threads, thread->tid);
 
+    /* Release the timers of the thread */
+    struct list_head *curr, *next;
+    list_for_each_safe (curr, next, &thread->timers_list) {
+        timer_release(list_entry(curr, struct timer, list));
+    }
+
     /* Free the thread stack memory */
     free_pages((uint32_t) thread->stack,
                size_to_page_order(thread->stack_size));
@@ -618,6 +895,14 @@ void finish_wait(struct thread_info *thread)
 {
     preempt_disable();
 
+    if (thread->wait_queue) {
+        wait_queue_remove(thread);
+
+        /* Woken up before leaving to the kernel, keep running */
+        if (thread == running_thread)
+            thread->status = THREAD_RUNNING;
+    }
+
     if (thread != running_thread) {
         thread->status = THREAD_READY;
         list_move_tail(&thread->list, &ready_list[thread->priority]);
@@ -668,6 +953,83 @@ void wake_up_all(struct list_head *wait_list)
     preempt_enable();
 }
 
+void init_wait_queue(struct wait_queue *wq)
+{
+    wq->bucket = NULL;
+}
+
+struct thread_info *wait_queue_first(struct wait_queue *wq)
+{
+    preempt_disable();
+
+    struct thread_info *thread = NULL;
+    struct wait_bucket *bucket = wq->bucket;
+
+    /* The highest marked list holds the first highest-priority thread */
+    if (bucket) {
+        int pri = _flsl(bucket->bitmap) - 1;
+        thread = list_first_entry(&bucket->lists[pri], struct thread_info,
+                                  list);
+    }
+
+    preempt_enable();
+
+    return thread;
+}
+
+bool wait_queue_empty(struct wait_queue *wq)
+{
+    return wq->bucket == NULL;
+}
+
+void prepare_to_wait_queue(struct wait_queue *wq,
+                           struct thread_info *thread,
+                           int state)
+{
+    preempt_disable();
+
+    wait_queue_insert(wq, thread);
+    thread->status = state;
+
+    preempt_enable();
+}
+
+void wait_queue_requeue(struct thread_info *thread)
+{
+    preempt_disable();
+
+    struct wait_queue *wq = thread->wait_queue;
+    if (wq && thread->status == THREAD_WAIT) {
+        wait_bucket_del(wq->bucket, thread);
+        wait_bucket_add(wq->bucket, thread);
+    }
+
+    preempt_enable();
+}
+
+void wake_up_queue(struct wait_queue *wq)
+{
+    preempt_disable();
+
+    /* Wake up the first highest-priority thread in the wait queue */
+    struct thread_info *thread = wait_queue_first(wq);
+    if (thread)
+        finish_wait(thread);
+
+    preempt_enable();
+}
+
+void wake_up_queue_all(struct wait_queue *wq)
+{
+    preempt_disable();
+
+    /* The queue returns the bucket once the last thread leaves */
+    while (wq->bucket)
+        finish_wait(wait_queue_first(wq));
+
+    preempt_enable();
+}
+
 static inline void thread_join_handler(void)
 {
     /* Wake up the threads that waiting to join */
@@ -693,6 +1055,8 @@ static inline void thread_join_handler(void)
     /* Remove the thread from the system */
     list_del(&running_thread->thread_list);
     list_del(&running_thread->task_list);
+    wait_bucket_free(running_thread->wait_bucket);
+    timer_notify_exit(running_thread);
     running_thread->status = THREAD_TERMINATED;
     bitmap_clear_bit(bitmap_threads, running_thread->tid);
 
@@ -826,6 +1190,91 @@ static int timespec_cmp(const struct timespec *a, const struct timespec *b)
     return (a->tv_sec > b->tv_sec) ? 1 : -1;
 }
 
+static void oneshot_timer_rearm(void)
+{
+    /* The external time source only advances with its driver */
+    if (sys_time_is_external()) {
+        oneshot_timer_cancel();
+        return;
+    }
+
+    /* Find the earliest deadline of the timers and the sleeping threads */
+    struct timespec next;
+    bool pending = ktimer_next_expiry(&next);
+
+    struct thread_info *thread;
+    list_for_each_entry (thread, &timeout_list, timeout_list) {
+        /* Skip the threads that are already woken up */
+        if (thread->syscall_is_timeout)
+            continue;
+
+        if (!pending || timespec_cmp(&thread->syscall_timeout, &next) < 0) {
+            next = thread->syscall_timeout;
+            pending = true;
+        }
+    }
+
+    if (!pending) {
+        oneshot_timer_cancel();
+        return;
+    }
+
+    struct timespec now;
+    get_sys_time(&now);
+
+    int64_t delta = (int64_t) (next.tv_sec - now.tv_sec) * 1000000000LL +
+                    (next.tv_nsec - now.tv_nsec);
+
+    /* Deadlines after the next tick are handled by the tick */
+    if (delta >= (int64_t) (1000000000 / OS_TICK_FREQ) -
+                     (int64_t) get_tick_elapsed_nsec()) {
+        oneshot_timer_cancel();
+        return;
+    }
+
+    oneshot_timer_start(delta > 0 ? delta : 0);
+}
+
+static int sys_delay_until(const struct timespec *abstime)
+{
+    preempt_disable();
+
+    int retval;
+
+    if (!timespec_valid(abstime)) {
+        retval = -EINVAL;
+        goto leave;
+    }
+
+    /* Check if the deadline is already passed */
+    struct timespec now;
+    get_sys_time(&now);
+    if (timespec_cmp(&now, abstime) >= 0) {
+        retval = 0;
+        goto leave;
+    }
+
+    /* Wake up on the absolute deadline */
+    running_thread->syscall_is_timeout = false;
+    running_thread->syscall_timeout = *abstime;
+    list_add_tail(&running_thread->timeout_list, &timeout_list);
+    oneshot_timer_rearm();
+
+    while (!running_thread->syscall_is_timeout) {
+        prepare_to_wait(&suspend_list, running_thread, THREAD_WAIT);
+        schedule();
+    }
+
+    list_del(&running_thread->timeout_list);
+
+    /* Return success */
+    retval = 0;
+
+leave:
+    preempt_enable();
+    return retval;
+}
+
 static int sys_task_create(task_func_t task_func,
                            uint8_t priority,
                            int stack_size)
@@ -888,6 +1337,11 @@ static int sys_minfo(int name)
     return retval;
 }
 
+static uint32_t sys_getcycles(void)
+{
+    return get_cycle_count();
+}
+
 static int sys_sched_yield(void)
 {
     /* Suspend current thread */
@@ -916,10 +1370,21 @@ static void sys_exit(int status)
         /* Remove current thread of iteration from the system */
         list_del(&thread->thread_list);
         list_del(&thread->task_list);
-        list_del(&thread->list);
+        if (thread->wait_queue)
+            wait_queue_remove(thread);
+        else
+            list_del(&thread->list);
+        wait_bucket_free(thread->wait_bucket);
+        timer_notify_exit(thread);
         thread->status = THREAD_TERMINATED;
         bitmap_clear_bit(bitmap_threads, thread->tid);
 
+        /* Release the timers of the thread */
+        struct list_head *timer_curr, *timer_next;
+        list_for_each_safe (timer_curr, timer_next, &thread->timers_list) {
+            timer_release(list_entry(timer_curr, struct timer, list));
+        }
+
         /* Free the stack memory */
         free_pages((uint32_t) thread->stack,
                    size_to_page_order(thread->stack_size));
@@ -1015,6 +1480,16 @@ err:
     return retval;
 }
 
+static bool file_referenced(struct file *filp)
+{
+    for (int i = 0; i < OPEN_MAX; i++) {
+        if (bitmap_get_bit(bitmap_fds, i) && fdtable[i].file == filp)
+            return true;
+    }
+
+    return false;
+}
+
 static int sys_close(int fd)
 {
     preempt_disable();
@@ -1044,6 +1519,24 @@ static int sys_close(int fd)
     bitmap_clear_bit(bitmap_fds, fdesc_idx);
     bitmap_clear_bit(task->bitmap_fds, fdesc_idx);
 
+    /* Release the timer file if no other descriptor refers to it */
+    struct timerfd *tfd = file_to_timerfd(fdtable[fdesc_idx].file);
+    if (tfd && !file_referenced(&tfd->file)) {
+        int tfd_idx = tfd - timerfd_table;
+        __timerfd_release(tfd);
+        bitmap_clear_bit(bitmap_timerfds, tfd_idx);
+        bitmap_clear_bit(task->bitmap_timerfds, tfd_idx);
+    }
+
+    /* Release the epoll instance if no other descriptor refers to it */
+    struct eventpoll *ep = file_to_epoll(fdtable[fdesc_idx].file);
+    if (ep && !file_referenced(&ep->file)) {
+        int ep_idx = ep - epoll_table;
+        __epoll_release(ep);
+        bitmap_clear_bit(bitmap_epolls, ep_idx);
+        bitmap_clear_bit(task->bitmap_epolls, ep_idx);
+    }
+
     /* Return success */
     retval = 0;
 
@@ -1526,77 +2019,116 @@ static int sys_mkfifo(const char *pathname, mode_t mode)
     }
 }
 
-void poll_notify(struct file *notify_file)
+void poll_add_wait(struct file *filp,
+                   struct poll_wait_entry *entry,
+                   poll_func_t func)
 {
-    /* Iterate through all threads suspended by the poll() syscall */
-    struct list_head *curr_thread_l, *next_thread_l;
-    list_for_each_safe (curr_thread_l, next_thread_l, &poll_list) {
-        struct thread_info *thread =
-            list_entry(curr_thread_l, struct thread_info, list);
+    preempt_disable();
 
-        struct file *file;
-        list_for_each_entry (file, &thread->poll_files_list, list) {
-            if (file == notify_file)
-                finish_wait(thread);
-        }
-    }
+    /* The list of the file is initialized on first use */
+    if (filp->poll_wait_list.next == NULL)
+        INIT_LIST_HEAD(&filp->poll_wait_list);
+
+    entry->func = func;
+    list_add_tail(&entry->list, &filp->poll_wait_list);
+
+    preempt_enable();
 }
 
-static int sys_poll(struct pollfd *fds, nfds_t nfds, int timeout)
+void poll_remove_wait(struct poll_wait_entry *entry)
 {
     preempt_disable();
+    list_del(&entry->list);
+    preempt_enable();
+}
 
-    int retval;
-    int ready = 0;
+void poll_notify(struct file *notify_file)
+{
+    preempt_disable();
 
-    if (!fds && nfds > 0) {
-        retval = -EINVAL;
-        goto leave;
+    /* Only the pollers of the file are notified */
+    if (notify_file->poll_wait_list.next != NULL) {
+        struct list_head *curr, *next;
+        list_for_each_safe (curr, next, &notify_file->poll_wait_list) {
+            struct poll_wait_entry *entry =
+                list_entry(curr, struct poll_wait_entry, list);
+            entry->func(entry, notify_file);
+        }
     }
 
-    /* Reset timeout flag */
-    running_thread->syscall_is_timeout = false;
+    preempt_enable();
+}
 
-    /* Set polling deadline */
-    if (timeout > 0) {
-        struct timespec tp;
-        get_sys_time(&tp);
-        time_add(&tp, 0, timeout * 1000000);
-        running_thread->syscall_timeout = tp;
+void poll_release(struct file *filp)
+{
+    preempt_disable();
+
+    if (filp->poll_wait_list.next != NULL) {
+        struct list_head *curr, *next;
+        list_for_each_safe (curr, next, &filp->poll_wait_list) {
+            struct poll_wait_entry *entry =
+                list_entry(curr, struct poll_wait_entry, list);
+            list_del_init(&entry->list);
+            entry->func(entry, filp);
+        }
     }
 
-    /* Initialize the polling file list */
-    INIT_LIST_HEAD(&running_thread->poll_files_list);
+    preempt_enable();
+}
 
-    /* Check file events */
-    struct file *filp;
-    struct task_struct *task = current_task_info();
+static struct file *fd_to_file(struct task_struct *task, int fd)
+{
+    if (fd < 0) {
+        return NULL;
+    } else if (fd < FILE_RESERVED_NUM) {
+        return files[fd];
+    }
+
+    int fdesc_idx = fd - FILE_RESERVED_NUM;
+    if (fdesc_idx >= OPEN_MAX || !bitmap_get_bit(bitmap_fds, fdesc_idx) ||
+        !bitmap_get_bit(task->bitmap_fds, fdesc_idx)) {
+        return NULL;
+    }
+
+    return fdtable[fdesc_idx].file;
+}
+
+struct poll_table_entry {
+    struct poll_wait_entry wait;
+    struct thread_info *thread;
+    uint32_t events;
+};
+
+static void poll_wake_up(struct poll_wait_entry *wait, struct file *filp)
+{
+    struct poll_table_entry *entry =
+        container_of(wait, struct poll_table_entry, wait);
+
+    /* Wake up the poller if the requested events are observed or the file
+     * is closed */
+    if (list_empty(&wait->list) || (filp->f_events & entry->events))
+        finish_wait(entry->thread);
+}
+
+static int poll_check_events(struct task_struct *task,
+                             struct pollfd *fds,
+                             nfds_t nfds)
+{
+    int ready = 0;
 
     for (int i = 0; i < nfds; i++) {
         fds[i].revents = 0;
 
-        int fd = fds[i].fd;
-        if (fd < 0) {
+        if (fds[i].fd < 0)
             continue; /* Ignore */
-        } else if (fd < FILE_RESERVED_NUM) {
-            filp = files[fd];
-            if (!filp) {
-                fds[i].revents |= POLLNVAL;
-                ready++;
-                continue;
-            }
-        } else {
-            int fdesc_idx = fd - FILE_RESERVED_NUM;
-            if (fdesc_idx < 0 || fdesc_idx >= OPEN_MAX ||
-                !bitmap_get_bit(bitmap_fds, fdesc_idx) ||
-                !bitmap_get_bit(task->bitmap_fds, fdesc_idx)) {
-                fds[i].revents |= POLLNVAL;
-                ready++;
-                continue;
-            }
 
-            filp = fdtable[fdesc_idx].file;
+        struct file *filp = fd_to_file(task, fds[i].fd);
+        if (!filp) {
+            fds[i].revents |= POLLNVAL;
+            ready++;
+            continue;
         }
+
         uint32_t events = filp->f_events & fds[i].events;
         if (events) {
             fds[i].revents |= events;
@@ -1604,6 +2136,35 @@ static int sys_poll(struct pollfd *fds, nfds_t nfds, int timeout)
         }
     }
 
+    return ready;
+}
+
+static int sys_poll(struct pollfd *fds, nfds_t nfds, int timeout)
+{
+    preempt_disable();
+
+    int retval;
+
+    if ((!fds && nfds > 0) || nfds > OPEN_MAX) {
+        retval = -EINVAL;
+        goto leave;
+    }
+
+    /* Reset timeout flag */
+    running_thread->syscall_is_timeout = false;
+
+    /* Set polling deadline */
+    if (timeout > 0) {
+        struct timespec tp;
+        get_sys_time(&tp);
+        time_add(&tp, 0, timeout * 1000000);
+        running_thread->syscall_timeout = tp;
+    }
+
+    /* Check file events */
+    struct task_struct *task = current_task_info();
+    int ready = poll_check_events(task, fds, nfds);
+
     if (ready > 0) {
         /* Return number of fds with events */
         retval = ready;
@@ -1616,42 +2177,51 @@ static int sys_poll(struct pollfd *fds, nfds_t nfds, int timeout)
         goto leave;
     }
 
-    /* Suspend current thread */
-    prepare_to_wait(&poll_list, running_thread, THREAD_WAIT);
+    /* A poll wait entry for every polled file, kept on the stack of the
+     * thread unless there are too many of them */
+    struct poll_table_entry stack_table[POLL_FDS_MAX];
+    struct poll_table_entry *table = stack_table;
 
-    /* Add current thread into the timeout monitoring list */
-    if (timeout > 0)
-        list_add_tail(&running_thread->timeout_list, &timeout_list);
+    if (nfds > POLL_FDS_MAX) {
+        table = kmalloc(sizeof(struct poll_table_entry) * nfds);
+        if (!table) {
+            retval = -ENOMEM;
+            goto leave;
+        }
+    }
 
-    /* Record all files for polling */
+    /* Register current thread on the poll wait lists of the files, thus the
+     * thread is woken up by the notifications of the polled files only */
     for (int i = 0; i < nfds; i++) {
-        int fd = fds[i].fd;
-        if (fd < 0)
+        table[i].thread = NULL;
+
+        struct file *filp = fd_to_file(task, fds[i].fd);
+        if (!filp)
             continue;
 
-        if (fd < FILE_RESERVED_NUM) {
-            filp = files[fd];
-            if (!filp)
-                continue;
-        } else {
-            int fdesc_idx = fd - FILE_RESERVED_NUM;
-            if (fdesc_idx < 0 || fdesc_idx >= OPEN_MAX ||
-                !bitmap_get_bit(bitmap_fds, fdesc_idx) ||
-                !bitmap_get_bit(task->bitmap_fds, fdesc_idx)) {
-                continue;
-            }
+        table[i].thread = running_thread;
+        table[i].events = fds[i].events;
+        poll_add_wait(filp, &table[i].wait, poll_wake_up);
+    }
 
-            filp = fdtable[fdesc_idx].file;
-        }
+    /* Suspend current thread */
+    prepare_to_wait(&poll_list, running_thread, THREAD_WAIT);
 
-        list_add_tail(&filp->list, &running_thread->poll_files_list);
-    }
+    /* Add current thread into the timeout monitoring list */
+    if (timeout > 0)
+        list_add_tail(&running_thread->timeout_list, &timeout_list);
 
     /* Wait until the file event happens */
     schedule();
 
-    /* clear list of poll files */
-    INIT_LIST_HEAD(&running_thread->poll_files_list);
+    /* Unregister from the poll wait lists */
+    for (int i = 0; i < nfds; i++) {
+        if (table[i].thread)
+            poll_remove_wait(&table[i].wait);
+    }
+
+    if (table != stack_table)
+        kfree(table);
 
     /* Remove the thread from the polling list */
     if (timeout > 0)
@@ -1662,40 +2232,242 @@ static int sys_poll(struct pollfd *fds, nfds_t nfds, int timeout)
         goto leave;
     }
 
-    ready = 0;
-    for (int i = 0; i < nfds; i++) {
-        fds[i].revents = 0;
+    retval = poll_check_events(task, fds, nfds);
 
-        int fd = fds[i].fd;
-        if (fd < 0) {
-            continue; /* Ignore */
-        } else if (fd < FILE_RESERVED_NUM) {
-            filp = files[fd];
-            if (!filp) {
-                fds[i].revents |= POLLNVAL;
-                ready++;
-                continue;
-            }
-        } else {
-            int fdesc_idx = fd - FILE_RESERVED_NUM;
-            if (fdesc_idx < 0 || fdesc_idx >= OPEN_MAX ||
-                !bitmap_get_bit(bitmap_fds, fdesc_idx) ||
-                !bitmap_get_bit(task->bitmap_fds, fdesc_idx)) {
-                fds[i].revents |= POLLNVAL;
-                ready++;
-                continue;
-            }
+leave:
+    preempt_enable();
+    return retval;
+}
 
-            filp = fdtable[fdesc_idx].file;
-        }
-        uint32_t events = filp->f_events & fds[i].events;
-        if (events) {
-            fds[i].revents |= events;
-            ready++;
+static int sys_epoll_create(int size)
+{
+    preempt_disable();
+
+    int retval;
+
+    if (size <= 0) {
+        retval = -EINVAL;
+        goto leave;
+    }
+
+    /* Check if new epoll instance can be dispatched */
+    int ep_idx = find_first_zero_bit(bitmap_epolls, EPOLL_MAX);
+    if (ep_idx >= EPOLL_MAX) {
+        retval = -ENOMEM;
+        goto leave;
+    }
+
+    /* Find a free entry on the file descriptor table */
+    int fdesc_idx = find_first_zero_bit(bitmap_fds, OPEN_MAX);
+    if (fdesc_idx >= OPEN_MAX) {
+        retval = -ENFILE;
+        goto leave;
+    }
+
+    struct task_struct *task = current_task_info();
+    bitmap_set_bit(bitmap_epolls, ep_idx);
+    bitmap_set_bit(task->bitmap_epolls, ep_idx);
+    bitmap_set_bit(bitmap_fds, fdesc_idx);
+    bitmap_set_bit(task->bitmap_fds, fdesc_idx);
+
+    struct eventpoll *ep = &epoll_table[ep_idx];
+    __epoll_init(ep);
+
+    /* Register new file descriptor on the table */
+    fdtable[fdesc_idx].file = &ep->file;
+    fdtable[fdesc_idx].flags = 0;
+
+    /* Return the epoll descriptor */
+    retval = fdesc_idx + FILE_RESERVED_NUM;
+
+leave:
+    preempt_enable();
+    return retval;
+}
+
+static struct eventpoll *acquire_epoll(int epfd)
+{
+    struct task_struct *task = current_task_info();
+    return file_to_epoll(fd_to_file(task, epfd));
+}
+
+static int sys_epoll_ctl(int epfd, int op, int fd, struct epoll_event *event)
+{
+    preempt_disable();
+
+    int retval;
+
+    struct eventpoll *ep = acquire_epoll(epfd);
+    if (!ep) {
+        retval = -EBADF;
+        goto leave;
+    }
+
+    struct file *filp = fd_to_file(current_task_info(), fd);
+    if (!filp) {
+        retval = -EBADF;
+        goto leave;
+    }
+
+    retval = __epoll_ctl(ep, op, fd, filp, event);
+
+leave:
+    preempt_enable();
+    return retval;
+}
+
+static int sys_epoll_wait(int epfd,
+                          struct epoll_event *events,
+                          int maxevents,
+                          int timeout)
+{
+    preempt_disable();
+
+    int retval;
+
+    if (!events || maxevents <= 0) {
+        retval = -EINVAL;
+        goto leave;
+    }
+
+    struct eventpoll *ep = acquire_epoll(epfd);
+    if (!ep) {
+        retval = -EBADF;
+        goto leave;
+    }
+
+    /* Set waiting deadline */
+    running_thread->syscall_is_timeout = false;
+    if (timeout > 0) {
+        struct timespec tp;
+        get_sys_time(&tp);
+        time_add(&tp, 0, timeout * 1000000);
+        running_thread->syscall_timeout = tp;
+        list_add_tail(&running_thread->timeout_list, &timeout_list);
+    }
+
+    uint32_t gen = ep->gen;
+
+    while (1) {
+        /* Collect the events from the ready list */
+        retval = __epoll_harvest(ep, events, maxevents);
+        if (retval > 0 || timeout == 0 || running_thread->syscall_is_timeout)
+            break;
+
+        /* Wait until the ready list is updated */
+        prepare_to_wait_queue(&ep->wait_list, running_thread, THREAD_WAIT);
+        schedule();
+
+        /* The file is closed while sleeping, the slot may be reused */
+        if (ep->gen != gen) {
+            retval = -EBADF;
+            break;
         }
     }
 
-    retval = ready;
+    if (timeout > 0)
+        list_del(&running_thread->timeout_list);
+
+leave:
+    preempt_enable();
+    return retval;
+}
+
+static int sys_timerfd_create(int clockid, int flags)
+{
+    preempt_disable();
+
+    int retval;
+
+    if (clockid != CLOCK_MONOTONIC || (flags & ~TFD_NONBLOCK)) {
+        retval = -EINVAL;
+        goto leave;
+    }
+
+    /* Check if new timer file can be dispatched */
+    int tfd_idx = find_first_zero_bit(bitmap_timerfds, TIMERFD_MAX);
+    if (tfd_idx >= TIMERFD_MAX) {
+        retval = -ENOMEM;
+        goto leave;
+    }
+
+    /* Find a free entry on the file descriptor table */
+    int fdesc_idx = find_first_zero_bit(bitmap_fds, OPEN_MAX);
+    if (fdesc_idx >= OPEN_MAX) {
+        retval = -ENFILE;
+        goto leave;
+    }
+
+    struct task_struct *task = current_task_info();
+    bitmap_set_bit(bitmap_timerfds, tfd_idx);
+    bitmap_set_bit(task->bitmap_timerfds, tfd_idx);
+    bitmap_set_bit(bitmap_fds, fdesc_idx);
+    bitmap_set_bit(task->bitmap_fds, fdesc_idx);
+
+    struct timerfd *tfd = &timerfd_table[tfd_idx];
+    __timerfd_init(tfd);
+
+    /* Register new file descriptor on the table */
+    fdtable[fdesc_idx].file = &tfd->file;
+    fdtable[fdesc_idx].flags = flags;
+
+    /* Return the file descriptor */
+    retval = fdesc_idx + FILE_RESERVED_NUM;
+
+leave:
+    preempt_enable();
+    return retval;
+}
+
+static struct timerfd *acquire_timerfd(int fd)
+{
+    struct task_struct *task = current_task_info();
+    return file_to_timerfd(fd_to_file(task, fd));
+}
+
+static int sys_timerfd_settime(int fd,
+                               int flags,
+                               const struct itimerspec *new_value,
+                               struct itimerspec *old_value)
+{
+    preempt_disable();
+
+    int retval;
+
+    struct timerfd *tfd = acquire_timerfd(fd);
+    if (!tfd) {
+        retval = -EBADF;
+        goto leave;
+    }
+
+    retval = __timerfd_settime(tfd, flags, new_value, old_value);
+
+leave:
+    preempt_enable();
+    return retval;
+}
+
+static int sys_timerfd_gettime(int fd, struct itimerspec *curr_value)
+{
+    preempt_disable();
+
+    int retval;
+
+    if (!curr_value) {
+        retval = -EFAULT;
+        goto leave;
+    }
+
+    struct timerfd *tfd = acquire_timerfd(fd);
+    if (!tfd) {
+        retval = -EBADF;
+        goto leave;
+    }
+
+    __timerfd_gettime(tfd, curr_value);
+
+    /* Return success */
+    retval = 0;
 
 leave:
     preempt_enable();
@@ -2364,11 +3136,9 @@ static int sys_pthread_setschedparam(pthread_t tid,
         goto leave;
     }
 
-    /* Apply settings */
-    if (thread->priority_inherited)
-        thread->original_priority = param->sched_priority;
-    else
-        thread->priority = param->sched_priority;
+    /* Apply settings, the inherited priority is kept if it is higher */
+    thread->original_priority = param->sched_priority;
+    thread_update_priority(thread);
 
     /* Return success */
     retval = 0;
@@ -2407,10 +3177,7 @@ static int sys_pthread_getschedparam(pthread_t tid,
 
     /* Return settings */
     *policy = SCHED_RR;
-    if (thread->priority_inherited)
-        param->sched_priority = thread->original_priority;
-    else
-        param->sched_priority = thread->priority;
+    param->sched_priority = thread->original_priority;
 
     /* Return success */
     retval = 0;
@@ -2429,8 +3196,9 @@ static int sys_pthread_yield(void)
     return 0;
 }
 
-static void handle_signal(struct thread_info *thread, int signum)
+static int handle_signal(struct thread_info *thread, const siginfo_t *info)
 {
+    int signum = info->si_signo;
     bool stage_handler = false;
 
     /* Wake up the thread from the signal waiting list */
@@ -2442,9 +3210,7 @@ static void handle_signal(struct thread_info *thread, int signum)
         finish_wait(thread);
         *thread->ret_sig = signum;
         if (thread->ret_siginfo) {
-            thread->ret_siginfo->si_signo = signum;
-            thread->ret_siginfo->si_code = 0;
-            thread->ret_siginfo->si_value.sival_int = 0;
+            *thread->ret_siginfo = *info;
             thread->ret_siginfo = NULL;
         }
         SYSCALL_ARG(thread, int, 0) = 0;
@@ -2473,10 +3239,14 @@ static void handle_signal(struct thread_info *thread, int signum)
         thread_delete(thread);
         break;
     }
+    default:
+        /* Real-time signals */
+        stage_handler = true;
+        break;
     }
 
     if (!stage_handler) {
-        return;
+        return 0;
     }
 
     int sig_idx = get_signal_index(signum);
@@ -2484,23 +3254,13 @@ static void handle_signal(struct thread_info *thread, int signum)
 
     /* Signal handler is not provided */
     if (act == NULL) {
-        return;
+        return 0;
     } else if (act->sa_handler == NULL) {
-        return;
+        return 0;
     }
 
-    /* Stage signal or sigaction handler */
-    if (act->sa_flags & SA_SIGINFO) {
-        uint32_t args[4] = {0};
-        args[0] = (uint32_t) signum;
-        args[1] = (uint32_t) NULL /* info (TODO) */;
-        args[2] = (uint32_t) NULL /* context (TODO) */;
-        enqueue_pending_signal(thread, (uint32_t) act->sa_sigaction, args);
-    } else {
-        uint32_t args[4] = {0};
-        args[0] = (uint32_t) signum;
-        enqueue_pending_signal(thread, (uint32_t) act->sa_handler, args);
-    }
+    /* The handler is resolved again when the signal is delivered */
+    return enqueue_pending_signal(thread, info);
 }
 
 static int sys_pthread_kill(pthread_t tid, int sig)
@@ -2532,10 +3292,12 @@ static int sys_pthread_kill(pthread_t tid, int sig)
         goto leave;
     }
 
-    handle_signal(thread, sig);
-
-    /* Return success */
-    retval = 0;
+    siginfo_t info = {
+        .si_signo = sig,
+        .si_code = SI_USER,
+        .si_value.sival_int = 0,
+    };
+    retval = handle_signal(thread, &info);
 
 leave:
     preempt_enable();
@@ -2552,53 +3314,48 @@ static void sys_pthread_exit(void *retval)
     preempt_enable();
 }
 
-void thread_inherit_priority(struct mutex *mutex)
+static void thread_set_priority(struct thread_info *thread, uint8_t priority)
 {
-    if (mutex->protocol != PTHREAD_PRIO_INHERIT)
-        return;
-
-    preempt_disable();
+    thread->priority = priority;
+    thread->priority_inherited = priority != thread->original_priority;
 
-    struct thread_info *onwer_thread = mutex->owner;
-
-    /* Preserve original priority */
-    if (!onwer_thread->priority_inherited) {
-        running_thread->original_priority = running_thread->priority;
-        onwer_thread->priority_inherited = true;
-    }
+    /* Requeue the thread according to the new priority */
+    if (thread->status == THREAD_READY)
+        list_move_tail(&thread->list, &ready_list[priority]);
+    else
+        wait_queue_requeue(thread);
+}
 
-    /* Priority Inheritance Protocol (PIP) */
-    if (running_thread->priority > onwer_thread->priority) {
-        /* Raise the priority of the owner thread */
-        uint8_t old_priority = onwer_thread->priority;
-        uint8_t new_priority = running_thread->priority;
+void thread_update_priority(struct thread_info *thread)
+{
+    preempt_disable();
 
-        /* Move the owner thread from the ready list with lower priority to
-         * the new list with raised priority  */
-        struct list_head *curr, *next;
-        list_for_each_safe (curr, next, &ready_list[old_priority]) {
-            struct thread_info *thread =
-                list_entry(curr, struct thread_info, list);
-            if (thread == mutex->owner) {
-                list_move_tail(&thread->list, &ready_list[new_priority]);
-            }
+    /* Walk through the blocking chain, the depth is bounded by the number of
+     * the threads in case of a deadlock cycle */
+    for (int i = 0; thread && i < THREAD_MAX; i++) {
+        /* Priority Inheritance Protocol (PIP): the effective priority is the
+         * highest one among the thread and the waiters of its mutexes */
+        uint8_t priority = thread->original_priority;
+
+        struct mutex *mtx;
+        list_for_each_entry (mtx, &thread->mutex_list, list) {
+            struct thread_info *waiter = mutex_top_waiter(mtx);
+            if (waiter && waiter->priority > priority)
+                priority = waiter->priority;
         }
 
-        /* Set new raised priority */
-        onwer_thread->priority = new_priority;
-    }
+        if (priority == thread->priority)
+            break;
 
-    preempt_enable();
-}
+        thread_set_priority(thread, priority);
 
-void thread_reset_inherited_priority(struct mutex *mutex)
-{
-    preempt_disable();
+        /* Propagate to the owner of the mutex that the thread is blocked on */
+        mtx = thread->waiting_mutex;
+        if (thread->status != THREAD_WAIT || !mtx ||
+            mtx->protocol != PTHREAD_PRIO_INHERIT)
+            break;
 
-    if (running_thread->priority_inherited) {
-        /* Recover the original thread priority */
-        running_thread->priority = running_thread->original_priority;
-        running_thread->priority_inherited = false;
+        thread = mtx->owner;
     }
 
     preempt_enable();
@@ -2614,11 +3371,6 @@ static int sys_pthread_mutex_lock(pthread_mutex_t *mutex)
     return mutex_lock((struct mutex *) mutex);
 }
 
-static int sys_pthread_mutex_trylock(pthread_mutex_t *mutex)
-{
-    return mutex_trylock((struct mutex *) mutex);
-}
-
 static int sys_pthread_mutex_timedlock(pthread_mutex_t *mutex,
                                        const struct timespec *abstime)
 {
@@ -2627,46 +3379,56 @@ static int sys_pthread_mutex_timedlock(pthread_mutex_t *mutex,
 
     struct mutex *mtx = (struct mutex *) mutex;
 
-    while (1) {
-        int retval = mutex_trylock(mtx);
-
-        if (retval == 0) {
-            thread_reset_inherited_priority(mtx);
-            return 0;
-        }
+    preempt_disable();
 
-        if (retval != -EBUSY)
-            return retval;
+    int retval = mutex_trylock(mtx);
+    if (retval != -EBUSY)
+        goto leave;
 
-        thread_inherit_priority(mtx);
+    if (mtx->owner == running_thread) {
+        retval = -EDEADLK;
+        goto leave;
+    }
 
-        struct timespec now;
-        get_sys_time(&now);
-        if (timespec_cmp(&now, abstime) >= 0)
-            return -ETIMEDOUT;
+    struct timespec now;
+    get_sys_time(&now);
+    if (timespec_cmp(&now, abstime) >= 0) {
+        retval = -ETIMEDOUT;
+        goto leave;
+    }
 
-        preempt_disable();
-        running_thread->syscall_is_timeout = false;
-        running_thread->syscall_timeout = *abstime;
-        list_add_tail(&running_thread->timeout_list, &timeout_list);
-        preempt_enable();
+    running_thread->syscall_is_timeout = false;
+    running_thread->syscall_timeout = *abstime;
+    list_add_tail(&running_thread->timeout_list, &timeout_list);
 
+    while (mtx->owner != running_thread) {
+        mutex_wait(mtx);
         schedule();
 
-        preempt_disable();
-        list_del(&running_thread->timeout_list);
-        bool timeout = running_thread->syscall_is_timeout;
-        preempt_enable();
+        /* The mutex is handed over by mutex_unlock() */
+        if (mtx->owner == running_thread)
+            break;
 
-        if (timeout)
-            return -ETIMEDOUT;
+        /* Woken up by timeout or spuriously */
+        mutex_remove_waiter(running_thread);
+
+        if (running_thread->syscall_is_timeout)
+            break;
     }
+
+    list_del(&running_thread->timeout_list);
+
+    retval = mtx->owner == running_thread ? 0 : -ETIMEDOUT;
+
+leave:
+    preempt_enable();
+    return retval;
 }
 
 static int sys_pthread_cond_signal(pthread_cond_t *cond)
 {
     /* Wake up a thread from the wait list */
-    wake_up(&((struct cond *) cond)->task_wait_list);
+    wake_up_queue(&((struct cond *) cond)->task_wait_list);
 
     /* Return success */
     return 0;
@@ -2675,7 +3437,7 @@ static int sys_pthread_cond_signal(pthread_cond_t *cond)
 static int sys_pthread_cond_broadcast(pthread_cond_t *cond)
 {
     /* Wake up all threads from the wait list */
-    wake_up_all(&((struct cond *) cond)->task_wait_list);
+    wake_up_queue_all(&((struct cond *) cond)->task_wait_list);
 
     /* Return success */
     return 0;
@@ -2697,8 +3459,8 @@ static int sys_pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex)
     }
 
     /* Enqueue current thread into the wait list */
-    prepare_to_wait(&((struct cond *) cond)->task_wait_list, running_thread,
-                    THREAD_WAIT);
+    prepare_to_wait_queue(&((struct cond *) cond)->task_wait_list,
+                          running_thread, THREAD_WAIT);
 
     preempt_enable();
 
@@ -2730,8 +3492,8 @@ static int sys_pthread_cond_timedwait(pthread_cond_t *cond,
     running_thread->syscall_timeout = *abstime;
     list_add_tail(&running_thread->timeout_list, &timeout_list);
 
-    prepare_to_wait(&((struct cond *) cond)->task_wait_list, running_thread,
-                    THREAD_WAIT);
+    prepare_to_wait_queue(&((struct cond *) cond)->task_wait_list,
+                          running_thread, THREAD_WAIT);
     preempt_enable();
 
     schedule();
@@ -2822,7 +3584,7 @@ static int sys_sem_timedwait(sem_t *sem, const struct timespec *abstime)
     list_add_tail(&running_thread->timeout_list, &timeout_list);
 
     while (ksem->count <= 0) {
-        prepare_to_wait(&ksem->wait_list, running_thread, THREAD_WAIT);
+        prepare_to_wait_queue(&ksem->wait_list, running_thread, THREAD_WAIT);
         schedule();
 
         if (running_thread->syscall_is_timeout)
@@ -2925,12 +3687,8 @@ static int sys_sigwait(const sigset_t *set, int *sig)
         goto leave;
     }
 
-    sigset_t invalid_mask =
-        ~(sig2bit(SIGUSR1) | sig2bit(SIGUSR2) | sig2bit(SIGPOLL) |
-          sig2bit(SIGSTOP) | sig2bit(SIGCONT) | sig2bit(SIGKILL));
-
     /* Reject waiting request of an undefined signal */
-    if (*set & invalid_mask) {
+    if (!is_sigset_valid(set)) {
         /* Return error */
         retval = -EINVAL;
         goto leave;
@@ -2964,11 +3722,7 @@ static int sys_sigwaitinfo(const sigset_t *set, siginfo_t *info)
         goto leave;
     }
 
-    sigset_t invalid_mask =
-        ~(sig2bit(SIGUSR1) | sig2bit(SIGUSR2) | sig2bit(SIGPOLL) |
-          sig2bit(SIGSTOP) | sig2bit(SIGCONT) | sig2bit(SIGKILL));
-
-    if (*set & invalid_mask) {
+    if (!is_sigset_valid(set)) {
         retval = -EINVAL;
         goto leave;
     }
@@ -3007,11 +3761,7 @@ static int sys_sigtimedwait(const sigset_t *set,
         goto leave;
     }
 
-    sigset_t invalid_mask =
-        ~(sig2bit(SIGUSR1) | sig2bit(SIGUSR2) | sig2bit(SIGPOLL) |
-          sig2bit(SIGSTOP) | sig2bit(SIGCONT) | sig2bit(SIGKILL));
-
-    if (*set & invalid_mask) {
+    if (!is_sigset_valid(set)) {
         retval = -EINVAL;
         goto leave;
     }
@@ -3062,6 +3812,22 @@ leave:
     return retval;
 }
 
+static int task_signal(struct task_struct *task, const siginfo_t *info)
+{
+    int retval = 0;
+
+    /* Send the signal to all threads of the task */
+    struct list_head *curr, *next;
+    list_for_each_safe (curr, next, &task->threads_list) {
+        struct thread_info *thread =
+            list_entry(curr, struct thread_info, task_list);
+        if (handle_signal(thread, info) == -EAGAIN)
+            retval = -EAGAIN;
+    }
+
+    return retval;
+}
+
 static int sys_kill(pid_t pid, int sig)
 {
     preempt_disable();
@@ -3084,15 +3850,12 @@ static int sys_kill(pid_t pid, int sig)
         goto leave;
     }
 
-    struct list_head *curr, *next;
-    list_for_each_safe (curr, next, &task->threads_list) {
-        struct thread_info *thread =
-            list_entry(curr, struct thread_info, task_list);
-        handle_signal(thread, sig);
-    }
-
-    /* Return success */
-    retval = 0;
+    siginfo_t info = {
+        .si_signo = sig,
+        .si_code = SI_USER,
+        .si_value.sival_int = 0,
+    };
+    retval = task_signal(task, &info);
 
 leave:
     preempt_enable();
@@ -3121,15 +3884,46 @@ int sys_raise(int sig)
         goto leave;
     }
 
-    struct list_head *curr, *next;
-    list_for_each_safe (curr, next, &task->threads_list) {
-        struct thread_info *thread =
-            list_entry(curr, struct thread_info, task_list);
-        handle_signal(thread, sig);
+    siginfo_t info = {
+        .si_signo = sig,
+        .si_code = SI_USER,
+        .si_value.sival_int = 0,
+    };
+    retval = task_signal(task, &info);
+
+leave:
+    preempt_enable();
+    return retval;
+}
+
+static int sys_sigqueue(pid_t pid, int sig, const union sigval value)
+{
+    preempt_disable();
+
+    int retval;
+
+    struct task_struct *task = acquire_task(pid);
+
+    /* Failed to find the task */
+    if (!task) {
+        /* Return error */
+        retval = -ESRCH;
+        goto leave;
     }
 
-    /* Return success */
-    retval = 0;
+    /* Check if the signal number is defined */
+    if (!is_signal_defined(sig)) {
+        /* Return error */
+        retval = -EINVAL;
+        goto leave;
+    }
+
+    siginfo_t info = {
+        .si_signo = sig,
+        .si_code = SI_QUEUE,
+        .si_value = value,
+    };
+    retval = task_signal(task, &info);
 
 leave:
     preempt_enable();
@@ -3190,17 +3984,78 @@ leave:
     return retval;
 }
 
-static struct timer *acquire_timer(int timerid)
+static struct timer *acquire_timer(timer_t timerid)
 {
-    /* Find the timer with given ID */
-    struct timer *timer;
-    list_for_each_entry (timer, &running_thread->timers_list, list) {
-        /* Compare the timer ID */
-        if (timerid == timer->id)
-            return timer; /* Found */
+    if (timerid < 0 || timerid >= TIMER_MAX ||
+        !bitmap_get_bit(bitmap_timers, timerid)) {
+        return NULL;
+    }
+
+    /* Timers are shared by the threads of the task */
+    struct timer *timer = &timer_table[timerid];
+    if (timer->thread->task != current_task_info())
+        return NULL;
+
+    return timer;
+}
+
+static void timer_expire(struct ktimer *ktimer, uint64_t expirations)
+{
+    struct timer *timer = container_of(ktimer, struct timer, ktimer);
+
+    if (timer->sev.sigev_notify == SIGEV_NONE)
+        return;
+
+    /* Only one notification of the timer can be pending, the expirations
+     * before its delivery are counted as overruns */
+    uint64_t overrun = timer->overrun + expirations;
+    if (!timer->notify_pending)
+        overrun--;
+    timer->overrun = (overrun > DELAYTIMER_MAX) ? DELAYTIMER_MAX : overrun;
+
+    if (timer->notify_pending)
+        return;
+
+    timer->notify_pending = true;
+
+    if (timer->sev.sigev_notify == SIGEV_SIGNAL) {
+        list_add_tail(&timer->notify_list, &timer->thread->timer_sig_list);
+    } else if (!timer->notify_thread) {
+        /* Otherwise queued when the running callback returns */
+        timer_notify_queue(timer);
     }
+}
+
+static void timer_notify_tasklet_func(unsigned long data)
+{
+    while (!list_empty(&timer_notify_list)) {
+        struct timer *timer =
+            list_first_entry(&timer_notify_list, struct timer, notify_list);
+        struct thread_info *owner = timer->thread;
+
+        /* Run the callback in a new user thread of the timer owner */
+        struct thread_info *thread;
+        int retval = thread_create(
+            &thread, (thread_func_t) timer->sev.sigev_notify_function,
+            &timer->notify_attr, timer->sev.sigev_value.sival_ptr, false);
 
-    return NULL; /* Not found */
+        if (retval) {
+            /* Count the lost notification as an overrun of the next one */
+            list_del_init(&timer->notify_list);
+            timer->notify_pending = false;
+            if (timer->overrun < DELAYTIMER_MAX)
+                timer->overrun++;
+            continue;
+        }
+
+        strncpy(thread->name, owner->name, THREAD_NAME_MAX);
+        thread->task = owner->task;
+        list_add_tail(&thread->task_list, &owner->task->threads_list);
+
+        thread->notify_timer = timer;
+        timer->notify_thread = thread;
+        timer_notify_delivered(timer);
+    }
 }
 
 static int sys_timer_create(clockid_t clockid,
@@ -3210,6 +4065,7 @@ static int sys_timer_create(clockid_t clockid,
     preempt_disable();
 
     int retval;
+    struct thread_attr notify_attr = {0};
 
     /* Unsupported clock source */
     if (clockid != CLOCK_MONOTONIC) {
@@ -3218,46 +4074,76 @@ static int sys_timer_create(clockid_t clockid,
         goto leave;
     }
 
-    if (!sevp) {
+    if (!sevp || !timerid) {
         retval = -EINVAL;
         goto leave;
     }
 
-    if (sevp->sigev_notify != SIGEV_NONE &&
-        sevp->sigev_notify != SIGEV_SIGNAL) {
-        /* Return error */
+    switch (sevp->sigev_notify) {
+    case SIGEV_NONE:
+        break;
+    case SIGEV_SIGNAL:
+        /* The signal must be able to be caught */
+        if (!is_signal_defined(sevp->sigev_signo) ||
+            sevp->sigev_signo == SIGKILL || sevp->sigev_signo == SIGSTOP) {
+            retval = -EINVAL;
+            goto leave;
+        }
+        break;
+    case SIGEV_THREAD:
+        if (!sevp->sigev_notify_function) {
+            retval = -EINVAL;
+            goto leave;
+        }
+
+        if (sevp->sigev_notify_attributes) {
+            notify_attr = *(struct thread_attr *) sevp->sigev_notify_attributes;
+        } else {
+            pthread_attr_init((pthread_attr_t *) &notify_attr);
+            notify_attr.schedparam.sched_priority =
+                (running_thread->priority > THREAD_PRIORITY_MAX)
+                    ? THREAD_PRIORITY_MAX
+                    : running_thread->priority;
+        }
+
+        /* The callback threads can not be joined */
+        notify_attr.detachstate = PTHREAD_CREATE_DETACHED;
+        notify_attr.stackaddr = NULL;
+
+        if (!thread_attr_is_valid(&notify_attr, false)) {
+            retval = -EINVAL;
+            goto leave;
+        }
+        break;
+    default:
         retval = -EINVAL;
         goto leave;
     }
 
-    /* Allocate memory for the new timer */
-    struct timer *new_tm = kmalloc(sizeof(struct timer));
-
-    /* Failed to allocate memory */
-    if (new_tm == NULL) {
+    /* Check if new timer can be dispatched */
+    int id = find_first_zero_bit(bitmap_timers, TIMER_MAX);
+    if (id >= TIMER_MAX) {
         /* Return error */
-        retval = -ENOMEM;
+        retval = -EAGAIN;
         goto leave;
     }
+    bitmap_set_bit(bitmap_timers, id);
 
     /* Record timer settings */
-    new_tm->id = running_thread->timer_cnt;
+    struct timer *new_tm = &timer_table[id];
+    memset(new_tm, 0, sizeof(struct timer));
+    new_tm->id = id;
     new_tm->sev = *sevp;
+    new_tm->notify_attr = notify_attr;
     new_tm->thread = running_thread;
+    INIT_LIST_HEAD(&new_tm->notify_list);
+    ktimer_init(&new_tm->ktimer, timer_expire);
 
-    /* Initialize thread timer list */
-    if (running_thread->timer_cnt == 0)
-        INIT_LIST_HEAD(&running_thread->timers_list);
-
-    /* Link the new timer to the list */
-    list_add_tail(&new_tm->g_list, &timers_list);
+    /* Link the new timer to the thread */
     list_add_tail(&new_tm->list, &running_thread->timers_list);
 
     /* Return timer ID */
-    *timerid = running_thread->timer_cnt;
-
-    /* Increase timer count */
-    running_thread->timer_cnt++;
+    *timerid = id;
 
     /* Return success */
     retval = 0;
@@ -3283,10 +4169,8 @@ static int sys_timer_delete(timer_t timerid)
         goto leave;
     }
 
-    /* Remove the timer from the lists and free the memory */
-    list_del(&timer->g_list);
-    list_del(&timer->list);
-    kfree(timer);
+    /* Disarm the timer and free it */
+    timer_release(timer);
 
     /* Return success */
     retval = 0;
@@ -3296,6 +4180,12 @@ leave:
     return retval;
 }
 
+static void timer_get_setting(struct timer *timer, struct itimerspec *setting)
+{
+    setting->it_interval = timer->ktimer.interval;
+    ktimer_remaining(&timer->ktimer, &setting->it_value);
+}
+
 static int sys_timer_settime(timer_t timerid,
                              int flags,
                              const struct itimerspec *new_value,
@@ -3306,23 +4196,8 @@ static int sys_timer_settime(timer_t timerid,
     int retval;
 
     /* Bad arguments */
-    if (!new_value) {
-        retval = -EINVAL;
-        goto leave;
-    }
-
-    if (new_value->it_value.tv_sec < 0 || new_value->it_value.tv_nsec < 0 ||
-        new_value->it_value.tv_nsec > 999999999 ||
-        new_value->it_interval.tv_sec < 0 ||
-        new_value->it_interval.tv_nsec < 0 ||
-        new_value->it_interval.tv_nsec > 999999999) {
-        /* Return error */
-        retval = -EINVAL;
-        goto leave;
-    }
-
-    /* The thread has no timer */
-    if (running_thread->timer_cnt == 0) {
+    if (!new_value || !timespec_valid(&new_value->it_value) ||
+        !timespec_valid(&new_value->it_interval)) {
         /* Return error */
         retval = -EINVAL;
         goto leave;
@@ -3340,16 +4215,22 @@ static int sys_timer_settime(timer_t timerid,
 
     /* Return old setting of the timer */
     if (old_value != NULL)
-        *old_value = timer->setting;
-
-    /* Save new setting of the timer */
-    timer->flags = flags;
-    timer->setting = *new_value;
-    timer->ret_time = timer->setting;
+        timer_get_setting(timer, old_value);
 
-    /* Enable the timer */
-    timer->counter = timer->setting.it_value;
-    timer->enabled = true;
+    if (new_value->it_value.tv_sec == 0 && new_value->it_value.tv_nsec == 0) {
+        /* Zero initial expiration disarms the timer */
+        ktimer_cancel(&timer->ktimer);
+        timer->ktimer.interval = new_value->it_interval;
+    } else {
+        /* Arm the timer on the absolute expiration time */
+        struct timespec expiry = new_value->it_value;
+        if (!(flags & TIMER_ABSTIME)) {
+            get_sys_time(&expiry);
+            time_add(&expiry, new_value->it_value.tv_sec,
+                     new_value->it_value.tv_nsec);
+        }
+        ktimer_start(&timer->ktimer, &expiry, &new_value->it_interval);
+    }
 
     /* Return success */
     retval = 0;
@@ -3380,7 +4261,7 @@ static int sys_timer_gettime(timer_t timerid, struct itimerspec *curr_value)
         goto leave;
     }
 
-    *curr_value = timer->ret_time;
+    timer_get_setting(timer, curr_value);
 
     /* Return success */
     retval = 0;
@@ -3390,6 +4271,29 @@ leave:
     return retval;
 }
 
+static int sys_timer_getoverrun(timer_t timerid)
+{
+    preempt_disable();
+
+    int retval;
+
+    /* Acquire the timer with given ID */
+    struct timer *timer = acquire_timer(timerid);
+
+    /* Failed to acquire the timer */
+    if (timer == NULL) {
+        retval = -EINVAL;
+        goto leave;
+    }
+
+    /* Return the overrun count of the last delivered notification */
+    retval = timer->overrun_last;
+
+leave:
+    preempt_enable();
+    return retval;
+}
+
 static void *sys_malloc(size_t size)
 {
     preempt_disable();
@@ -3430,43 +4334,6 @@ static void threads_ticks_update(void)
     }
 }
 
-static void timers_update(void)
-{
-    struct timer *timer;
-    list_for_each_entry (timer, &timers_list, g_list) {
-        if (!timer->enabled)
-            continue;
-
-        /* Update the timer */
-        timer_down_count(&timer->counter);
-
-        /* Update the return time */
-        timer->ret_time.it_value = timer->counter;
-
-        /* Check if the time is up */
-        if (timer->counter.tv_sec != 0 || timer->counter.tv_nsec != 0) {
-            continue; /* No */
-        }
-
-        /* Reload the timer */
-        timer->counter = timer->setting.it_interval;
-
-        /* Shutdown the one-shot type timer */
-        if (timer->setting.it_interval.tv_sec == 0 &&
-            timer->setting.it_interval.tv_nsec == 0) {
-            timer->enabled = false;
-        }
-
-        /* Stage the signal handler */
-        if (timer->sev.sigev_notify == SIGEV_SIGNAL) {
-            uint32_t args[4] = {0};
-            sa_handler_t notify_func =
-                (sa_handler_t) timer->sev.sigev_notify_function;
-            enqueue_pending_signal(timer->thread, (uint32_t) notify_func, args);
-        }
-    }
-}
-
 static void syscall_timeout_update(void)
 {
     /* Get current time */
@@ -3501,22 +4368,60 @@ static inline bool need_resched(void)
     return need_resched_flag;
 }
 
+static void system_tick(void)
+{
+    system_timer_update();
+    threads_ticks_update();
+    ktimers_update();
+    syscall_timeout_update();
+    oneshot_timer_rearm();
+}
+
 void system_ticks_update(void)
 {
     __preempt_disable();
 
-    system_timer_update();
-    threads_ticks_update();
-    timers_update();
+    /* The time of the external source is advanced by its driver, the system
+     * timer only keeps the preemption going */
+    if (!sim_time_tick())
+        system_tick();
+
+    set_need_resched();
+
+    __preempt_enable();
+}
+
+void system_oneshot_update(void)
+{
+    __preempt_disable();
+
+    /* Expire the deadlines that fall between two ticks */
+    ktimers_update();
     syscall_timeout_update();
+    oneshot_timer_rearm();
 
     set_need_resched();
 
     __preempt_enable();
 }
 
+void system_ticks_advance(uint32_t ticks)
+{
+    preempt_disable();
+
+    for (uint32_t i = 0; i < ticks; i++)
+        system_tick();
+
+    if (ticks)
+        set_need_resched();
+
+    preempt_enable();
+}
+
 static void syscall_return_event_handler(void)
 {
+    syscall_stat_exit(running_thread);
+
     running_thread->stack_top =
         (unsigned long *) running_thread->syscall_stack_top;
     running_thread->privilege =
@@ -3632,6 +4537,8 @@ static void syscall_handler(void)
             running_thread->privilege = KERNEL_THREAD;
             running_thread->syscall_mode = true;
 
+            syscall_stat_enter(running_thread, syscall_num);
+
             return;
         }
     }
@@ -3747,6 +4654,11 @@ static void *init(void *arg)
     __board_init();
     rom_dev_init();
     null_dev_init();
+    log_dev_init();
+    profiler_init();
+    trace_init();
+    syscall_stat_init();
+    sim_time_init();
     link_stdin_dev(STDIN_PATH);
     link_stdout_dev(STDOUT_PATH);
     link_stderr_dev(STDERR_PATH);
@@ -3818,18 +4730,27 @@ void sched_start(void)
         INIT_LIST_HEAD(&ready_list[i]);
     }
 
+    /* Initialize the buckets of the wait queues */
+    wait_buckets_init();
+
     /* Create kernel threads for basic services */
     kthread_create(idle, 0, IDLE_STACK_SIZE);
     kthread_create(softirqd, KTHREAD_PRI_MAX, SOFTIRQD_STACK_SIZE);
     kthread_create(filesysd, KTHREAD_PRI_MAX - 1, FILESYSD_STACK_SIZE);
     kthread_create(printkd, KTHREAD_PRI_MAX - 1, PRINTKD_STACK_SIZE);
 
+    /* Create the SIGEV_THREAD callback threads out of the tick handler */
+    tasklet_init(&timer_notify_tasklet, timer_notify_tasklet_func, 0);
+
     /* Dequeue and execute the init thread */
     running_thread = &threads[0];
     threads[0].status = THREAD_RUNNING;
     list_del(&threads[0].list);
 
     while (1) {
+        /* The kernel runs with the interrupts disabled */
+        trace_preempt_off(TRACE_SITE_KERNEL);
+
         /* Syscall request */
         if (get_syscall_flag()) {
             reset_syscall_flag();
@@ -3845,6 +4766,8 @@ void sched_start(void)
         /* Check thread stack pointer to detect stack overflow */
         check_thread_stack();
 
+        trace_preempt_on();
+
         /* Jump to the selected thread */
         running_thread->stack_top = jump_to_thread(running_thread->stack_top,
                                                    running_thread->privilege);
@@ -42,8 +42,8 @@ struct mqueue *__mq_allocate(struct mq_attr *attr)
 
     /* Initialize message queue list heads */
     INIT_LIST_HEAD(&new_mq->free_list);
-    INIT_LIST_HEAD(&new_mq->r_wait_list);
-    INIT_LIST_HEAD(&new_mq->w_wait_list);
+    init_wait_queue(&new_mq->r_wait_list);
+    init_wait_queue(&new_mq->w_wait_list);
     for (int i = 0; i <= MQ_PRIO_MAX; i++)
         INIT_LIST_HEAD(&new_mq->used_list[i]);
 
@@ -137,8 +137,8 @@ ssize_t __mq_receive(struct mqueue *mq,
             return -EAGAIN;
         } else { /* Block mode */
             /* Enqueue the thread into the waiting list */
-            prepare_to_wait(&mq->r_wait_list, current_thread_info(),
-                            THREAD_WAIT);
+            prepare_to_wait_queue(&mq->r_wait_list, current_thread_info(),
+                                  THREAD_WAIT);
             return -ERESTARTSYS;
         }
     }
@@ -147,7 +147,7 @@ ssize_t __mq_receive(struct mqueue *mq,
     size_t read_size = __mq_out(mq, msg_ptr, msg_prio);
 
     /* Wake up the highest-priority thread from the waiting list */
-    wake_up(&mq->w_wait_list);
+    wake_up_queue(&mq->w_wait_list);
 
     /* Return read size */
     return read_size;
@@ -174,8 +174,8 @@ ssize_t __mq_send(struct mqueue *mq,
             return -EAGAIN;
         } else { /* Block mode */
             /* Enqueue the thread into the waiting list */
-            prepare_to_wait(&mq->w_wait_list, current_thread_info(),
-                            THREAD_WAIT);
+            prepare_to_wait_queue(&mq->w_wait_list, current_thread_info(),
+                                  THREAD_WAIT);
             return -ERESTARTSYS;
         }
     }
@@ -184,7 +184,7 @@ ssize_t __mq_send(struct mqueue *mq,
     __mq_in(mq, msg_ptr, msg_len, msg_prio);
 
     /* Wake up the highest-priority thread from the waiting list */
-    wake_up(&mq->r_wait_list);
+    wake_up_queue(&mq->r_wait_list);
 
     /* Return success */
     return 0;
@@ -15,7 +15,8 @@
 void __mutex_init(struct mutex *mtx)
 {
     memset(mtx, 0, sizeof(*mtx));
-    INIT_LIST_HEAD(&mtx->wait_list);
+    init_wait_queue(&mtx->wait_list);
+    INIT_LIST_HEAD(&mtx->list);
 }
 
 void mutex_init(struct mutex *mtx)
@@ -24,6 +25,53 @@ void mutex_init(struct mutex *mtx)
     mtx->protocol = PTHREAD_PRIO_INHERIT;
 }
 
+struct thread_info *mutex_top_waiter(struct mutex *mtx)
+{
+    return wait_queue_first(&mtx->wait_list);
+}
+
+void mutex_wait(struct mutex *mtx)
+{
+    preempt_disable();
+
+    CURRENT_THREAD_INFO(curr_thread);
+
+    /* Enqueue current thread into the wait queue */
+    curr_thread->waiting_mutex = mtx;
+    prepare_to_wait_queue(&mtx->wait_list, curr_thread, THREAD_WAIT);
+
+    if (mtx->protocol == PTHREAD_PRIO_INHERIT) {
+        /* Track the contended mutex for priority computation of the owner */
+        if (list_empty(&mtx->list))
+            list_add_tail(&mtx->list, &mtx->owner->mutex_list);
+
+        /* Boost the owner and the chain of the owners it is blocked on */
+        thread_update_priority(mtx->owner);
+    }
+
+    preempt_enable();
+}
+
+void mutex_remove_waiter(struct thread_info *thread)
+{
+    /* The thread is already detached from the wait list by the caller */
+    struct mutex *mtx = thread->waiting_mutex;
+    if (!mtx)
+        return;
+
+    thread->waiting_mutex = NULL;
+
+    if (mtx->protocol != PTHREAD_PRIO_INHERIT)
+        return;
+
+    /* No more contention, untrack the mutex from the owner */
+    if (wait_queue_empty(&mtx->wait_list))
+        list_del_init(&mtx->list);
+
+    /* Drop the priority inherited from the thread */
+    thread_update_priority(mtx->owner);
+}
+
 bool mutex_is_locked(struct mutex *mtx)
 {
     preempt_disable();
@@ -58,25 +106,31 @@ int mutex_trylock(struct mutex *mtx)
 
 int mutex_lock(struct mutex *mtx)
 {
-    int retval;
-    CURRENT_THREAD_INFO(curr_thread);
+    preempt_disable();
 
-    while (1) {
-        retval = mutex_trylock(mtx);
+    int retval = 0;
 
-        if (retval == -EBUSY) {
-            thread_inherit_priority(mtx);
-            prepare_to_wait(&mtx->wait_list, curr_thread, THREAD_WAIT);
-        } else {
-            break;
-        }
+    CURRENT_THREAD_INFO(curr_thread);
 
-        schedule();
+    if (mtx->owner == NULL) {
+        /* Occupy the mutex by setting the owner */
+        mtx->owner = curr_thread;
+    } else if (mtx->owner == curr_thread) {
+        /* Relocking the mutex never succeeds */
+        retval = -EDEADLK;
+    } else {
+        while (mtx->owner != curr_thread) {
+            mutex_wait(mtx);
+            schedule();
+
+            /* The mutex is handed over by mutex_unlock(), otherwise the
+             * thread is woken up spuriously */
+            if (mtx->owner != curr_thread)
+                mutex_remove_waiter(curr_thread);
+        }
     }
 
-    /* Reset priority inheritance */
-    if (retval == 0)
-        thread_reset_inherited_priority(mtx);
+    preempt_enable();
 
     return retval;
 }
@@ -95,14 +149,30 @@ int mutex_unlock(struct mutex *mtx)
         goto leave;
     }
 
-    /* Release the mutex */
-    mtx->owner = NULL;
+    /* Untrack the mutex from the owner */
+    if (!list_empty(&mtx->list))
+        list_del_init(&mtx->list);
 
-    /* Reset priority inheritance */
-    thread_reset_inherited_priority(mtx);
+    if (wait_queue_empty(&mtx->wait_list)) {
+        /* Release the mutex */
+        mtx->owner = NULL;
+    } else {
+        /* Hand the mutex over to the highest-priority waiter */
+        struct thread_info *next = mutex_top_waiter(mtx);
+        next->waiting_mutex = NULL;
+        mtx->owner = next;
+        finish_wait(next);
+
+        /* The new owner inherits the priority of the remaining waiters */
+        if (mtx->protocol == PTHREAD_PRIO_INHERIT &&
+            !wait_queue_empty(&mtx->wait_list)) {
+            list_add_tail(&mtx->list, &next->mutex_list);
+            thread_update_priority(next);
+        }
+    }
 
-    /* Wake up the highest-priority thread from the waiting list */
-    wake_up(&mtx->wait_list);
+    /* Drop the priority inherited from the waiters of the mutex */
+    thread_update_priority(curr_thread);
 
     /* Return success */
     retval = 0;
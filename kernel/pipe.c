@@ -6,6 +6,7 @@
 #include <sys/types.h>
 
 #include <common/list.h>
+#include <common/log2.h>
 #include <fs/fs.h>
 #include <kernel/errno.h>
 #include <kernel/kernel.h>
@@ -21,23 +22,44 @@ int fifo_open(struct inode *inode, struct file *file)
     return 0;
 }
 
-static void fifo_wake_up(struct list_head *wait_list, size_t avail_size)
+static int fifo_wait_class(size_t size)
 {
-    struct thread_info *highest_pri_thread = NULL;
+    if (size == 0)
+        return 0;
 
-    struct list_head *curr, *next;
-    list_for_each_safe (curr, next, wait_list) {
-        struct thread_info *thread = list_entry(curr, struct thread_info, list);
+    int class = ilog2(size);
+    return class < PIPE_WAIT_CLASSES ? class : PIPE_WAIT_CLASSES - 1;
+}
 
-        if (thread->file_request_size <= avail_size &&
-            (highest_pri_thread == NULL ||
-             thread->priority > highest_pri_thread->priority)) {
-            highest_pri_thread = thread;
-        }
+static void fifo_wait(struct wait_queue *wqs,
+                      struct thread_info *thread,
+                      size_t size)
+{
+    /* Save the request size */
+    thread->file_request_size = size;
+
+    /* Enqueue the thread into the waiting list of the size class */
+    prepare_to_wait_queue(&wqs[fifo_wait_class(size)], thread, THREAD_WAIT);
+}
+
+static void fifo_wake_up(struct wait_queue *wqs, size_t avail_size)
+{
+    struct thread_info *thread = NULL;
+
+    /* Wake up the highest-priority thread among the first ones of the size
+     * classes whose requests fit, the lower classes fit entirely. The cost is
+     * bounded by the number of the classes, but a thread queued behind a
+     * larger request of the same class waits for it */
+    int max_class = fifo_wait_class(avail_size);
+    for (int i = 0; i <= max_class; i++) {
+        struct thread_info *first = wait_queue_first(&wqs[i]);
+        if (first && first->file_request_size <= avail_size &&
+            (!thread || first->priority > thread->priority))
+            thread = first;
     }
 
-    if (highest_pri_thread)
-        finish_wait(highest_pri_thread);
+    if (thread)
+        finish_wait(thread);
 }
 
 static ssize_t __fifo_read(struct file *filp, char *buf, size_t size)
@@ -58,11 +80,7 @@ static ssize_t __fifo_read(struct file *filp, char *buf, size_t size)
                 return -EAGAIN;
             }
         } else { /* Block mode */
-            /* Save the read request size */
-            curr_thread->file_request_size = size;
-
-            /* Enqueue the thread into the waiting list */
-            prepare_to_wait(&pipe->r_wait_list, curr_thread, THREAD_WAIT);
+            fifo_wait(pipe->r_wait_list, curr_thread, size);
             return -ERESTARTSYS;
         }
     }
@@ -72,7 +90,7 @@ static ssize_t __fifo_read(struct file *filp, char *buf, size_t size)
         kfifo_out(fifo, &buf[i], sizeof(char));
 
     /* Wake up the highest-priority thread */
-    fifo_wake_up(&pipe->w_wait_list, kfifo_avail(fifo));
+    fifo_wake_up(pipe->w_wait_list, kfifo_avail(fifo));
 
     return size;
 }
@@ -95,11 +113,7 @@ static ssize_t __fifo_write(struct file *filp, const char *buf, size_t size)
                 return -EAGAIN;
             }
         } else { /* Block mode */
-            /* Save the write request size */
-            curr_thread->file_request_size = size;
-
-            /* Enqueue the thread into the waiting list */
-            prepare_to_wait(&pipe->w_wait_list, curr_thread, THREAD_WAIT);
+            fifo_wait(pipe->w_wait_list, curr_thread, size);
             return -ERESTARTSYS;
         }
     }
@@ -109,7 +123,7 @@ static ssize_t __fifo_write(struct file *filp, const char *buf, size_t size)
         kfifo_in(fifo, &buf[i], sizeof(char));
 
     /* Wake up the highest-priority thread */
-    fifo_wake_up(&pipe->r_wait_list, kfifo_len(fifo));
+    fifo_wake_up(pipe->r_wait_list, kfifo_len(fifo));
 
     return size;
 }
@@ -169,8 +183,10 @@ int fifo_init(int fd,
               struct pipe *pipe)
 {
     /* Initialize the pipe */
-    INIT_LIST_HEAD(&pipe->r_wait_list);
-    INIT_LIST_HEAD(&pipe->w_wait_list);
+    for (int i = 0; i < PIPE_WAIT_CLASSES; i++) {
+        init_wait_queue(&pipe->r_wait_list[i]);
+        init_wait_queue(&pipe->w_wait_list[i]);
+    }
 
     /* Register the pipe on the file table */
     memset(&pipe->file, 0, sizeof(pipe->file));
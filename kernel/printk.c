@@ -1,14 +1,17 @@
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/param.h>
 #include <tenok.h>
 #include <time.h>
 #include <unistd.h>
 
 #include <arch/port.h>
 #include <common/list.h>
+#include <common/util.h>
 #include <kernel/kernel.h>
 #include <kernel/preempt.h>
 #include <kernel/printk.h>
@@ -20,83 +23,394 @@
 
 #include "kconfig.h"
 
-#define PRINTK_QUEUE_SIZE 20
-
-struct printk_data {
-    struct list_head list;
-    size_t size;
-    char data[PRINT_SIZE_MAX];
+#define PRINTK_COMMITTED 0x1 /* The record is completely written */
+#define PRINTK_PADDING 0x2   /* Unused space before the ring wraps around */
+#define PRINTK_RAW 0x4       /* The payload is a raw string to write */
+
+#define PRINTK_PAYLOAD_MAX PRINT_SIZE_MAX
+#define PRINTK_LINE_MAX (PRINT_SIZE_MAX + 32)
+#define PRINTK_BATCH_SIZE 512
+
+#define PRINTK_OFFSET(head) ((head) & 0xffff)
+#define PRINTK_SEQ(head) ((head) >> 16)
+
+/* The printk messages are stored as variable-length records in a ring.
+ * Instead of the formatted text, a record carries the format string pointer
+ * and the raw arguments so the formatting cost is moved from the caller to
+ * printkd */
+struct printk_record {
+    uint16_t size;  /* Record size in bytes including the header */
+    uint8_t flags;  /* Written last to commit the record */
+    uint8_t reserved;
+    uint16_t seq;          /* Sequence number of the message */
+    uint16_t payload_size; /* Size of the packed arguments or the raw string */
+    uint32_t sec;          /* Timestamp of the message */
+    uint32_t nsec;
+    const char *format;
+    uint32_t payload[0];
 };
 
-static struct printk_data printk_buf[PRINTK_QUEUE_SIZE];
+static uint32_t printk_ring[PRINTK_RING_SIZE / sizeof(uint32_t)];
+
+/* Write position (low 16 bits) and the next sequence number (high 16 bits)
+ * are placed in one word so both can be reserved by a single exclusive
+ * store, which is safe against the interrupts without disabling them */
+static volatile uint32_t printk_head;
+static volatile uint32_t printk_tail;    /* Read position, owned by printkd */
+static volatile uint32_t printk_dropped; /* Total number of dropped messages */
+
+static char printk_batch[PRINTK_BATCH_SIZE];
+static size_t printk_batch_len;
 
 static LIST_HEAD(printkd_wait);
-static LIST_HEAD(printk_free_list);
-static LIST_HEAD(printk_wait_list);
 
 static bool stdout_initialized;
 static bool printk_is_writing;
 
-ssize_t console_write(const char *buf, size_t size)
+static inline void printk_atomic_inc(volatile uint32_t *val)
 {
-    preempt_disable();
+    uint32_t old;
+    do {
+        old = load_exclusive(val);
+    } while (!store_exclusive(val, old + 1));
+}
+
+static struct printk_record *printk_reserve(size_t size)
+{
+    uint32_t head, pos, next, need;
+    bool full;
+
+    do {
+        head = load_exclusive(&printk_head);
+        pos = PRINTK_OFFSET(head);
+
+        /* Skip the space at the end of the ring if it is too small */
+        need = size;
+        next = pos + size;
+        if (next > PRINTK_RING_SIZE) {
+            need += PRINTK_RING_SIZE - pos;
+            next = size;
+        }
 
-    struct printk_data *entry;
+        /* A word is always left unused to tell a full ring from an empty
+         * one */
+        uint32_t used =
+            (pos + PRINTK_RING_SIZE - printk_tail) % PRINTK_RING_SIZE;
+        full = used + need >= PRINTK_RING_SIZE;
+
+        /* The sequence number is consumed even if the message is dropped so
+         * printkd can detect the gap */
+        next = full ? pos : next % PRINTK_RING_SIZE;
+    } while (!store_exclusive(&printk_head,
+                              ((PRINTK_SEQ(head) + 1) << 16) | next));
+
+    if (full) {
+        printk_atomic_inc(&printk_dropped);
+        return NULL;
+    }
 
-    /* Check if the free list still has space */
-    if (list_empty(&printk_free_list)) {
-        /* No, overwrite the oldest buffer */
-        entry = list_first_entry(&printk_wait_list, struct printk_data, list);
-        /* Move the buffer to the end of the wait queue */
-        list_del(&entry->list);
-        list_add_tail(&entry->list, &printk_wait_list);
-    } else {
-        /* Yes, take one buffer from the free queue */
-        entry = list_first_entry(&printk_free_list, struct printk_data, list);
-        /* Move the buffer to the wait queue */
-        list_move_tail(&entry->list, &printk_wait_list);
+    char *ring = (char *) printk_ring;
+
+    if (pos + size > PRINTK_RING_SIZE) {
+        /* Mark the skipped space as padding */
+        struct printk_record *pad = (struct printk_record *) &ring[pos];
+        pad->size = PRINTK_RING_SIZE - pos;
+        pad->flags = PRINTK_PADDING | PRINTK_COMMITTED;
+        pos = 0;
     }
 
-    /* Copy write message to the prink buffer */
-    memcpy(entry->data, buf, sizeof(char) * size);
-    entry->size = size;
+    struct printk_record *rec = (struct printk_record *) &ring[pos];
+    rec->size = size;
+    rec->seq = PRINTK_SEQ(head);
+
+    return rec;
+}
+
+static void printk_commit(struct printk_record *rec, uint8_t flags)
+{
+    /* Publish the record after all of its data is written */
+    asm volatile("" ::: "memory");
+    rec->flags = flags | PRINTK_COMMITTED;
 
     /* Wake up the printk daemon */
     if (!printk_is_writing)
         wake_up_all(&printkd_wait);
+}
 
-    preempt_enable();
+static bool printk_store(const char *format,
+                         const void *payload,
+                         size_t payload_size,
+                         uint8_t flags)
+{
+    struct timespec tp;
+    get_sys_time(&tp);
 
-    return 0;
+    size_t size = sizeof(struct printk_record) + payload_size;
+    struct printk_record *rec =
+        printk_reserve(CEILING(size, sizeof(uint32_t)) * sizeof(uint32_t));
+    if (!rec)
+        return false;
+
+    rec->payload_size = payload_size;
+    rec->sec = tp.tv_sec;
+    rec->nsec = tp.tv_nsec;
+    rec->format = format;
+    memcpy(rec->payload, payload, payload_size);
+
+    printk_commit(rec, flags);
+
+    return true;
 }
 
-void printk(char *format, ...)
+enum {
+    PRINTK_ARG_INT,
+    PRINTK_ARG_LONG,
+    PRINTK_ARG_LLONG,
+};
+
+/* Scan the conversion specification after the '%' character. Return the
+ * pointer after the specification */
+static const char *printk_parse_spec(const char *p, char *conv, int *length)
 {
-    va_list args;
-    va_start(args, format);
+    int l_cnt = 0;
+    bool j_flag = false;
+
+    while (*p && strchr("-+ #0123456789.*hljztL", *p)) {
+        if (*p == 'l')
+            l_cnt++;
+        else if (*p == 'j')
+            j_flag = true;
+        p++;
+    }
 
-    struct timespec tp;
-    preempt_disable();
-    get_sys_time(&tp);
-    preempt_enable();
+    if (l_cnt >= 2 || j_flag)
+        *length = PRINTK_ARG_LLONG;
+    else if (l_cnt == 1)
+        *length = PRINTK_ARG_LONG;
+    else
+        *length = PRINTK_ARG_INT;
+
+    *conv = *p;
+    return *p ? p + 1 : p;
+}
+
+static size_t printk_pack_args(const char *format,
+                               va_list args,
+                               char *payload,
+                               size_t payload_max)
+{
+    size_t pos = 0;
 
-    char sec[sizeof(long) * 8 + 1] = {0};
-    ltoa(tp.tv_sec, sec, 10);
+    /* Only the arguments are copied, the formatting is deferred */
+    for (const char *p = format; *p;) {
+        if (*p++ != '%')
+            continue;
 
-    char rem[sizeof(long) * 8 + 1] = {0};
-    ltoa(tp.tv_nsec, rem, 10);
+        if (*p == '%') {
+            p++;
+            continue;
+        }
+
+        /* Width and precision given by arguments */
+        for (const char *s = p; *s && strchr("-+ #0123456789.*", *s); s++) {
+            if (*s != '*')
+                continue;
+
+            int val = va_arg(args, int);
+            if (pos + sizeof(val) > payload_max)
+                return pos;
+            memcpy(&payload[pos], &val, sizeof(val));
+            pos += sizeof(val);
+        }
 
-    char zeros[15] = {0};
-    for (int i = 0; i < (9 - strlen(rem)); i++) {
-        zeros[i] = '0';
+        char conv;
+        int length;
+        p = printk_parse_spec(p, &conv, &length);
+
+        if (conv && strchr("diouxXc", conv)) {
+            if (length == PRINTK_ARG_LLONG) {
+                long long val = va_arg(args, long long);
+                if (pos + sizeof(val) > payload_max)
+                    return pos;
+                memcpy(&payload[pos], &val, sizeof(val));
+                pos += sizeof(val);
+            } else if (length == PRINTK_ARG_LONG) {
+                long val = va_arg(args, long);
+                if (pos + sizeof(val) > payload_max)
+                    return pos;
+                memcpy(&payload[pos], &val, sizeof(val));
+                pos += sizeof(val);
+            } else {
+                uint32_t val = va_arg(args, uint32_t);
+                if (pos + sizeof(val) > payload_max)
+                    return pos;
+                memcpy(&payload[pos], &val, sizeof(val));
+                pos += sizeof(val);
+            }
+        } else if (conv && strchr("fFeEgGaA", conv)) {
+            double val = va_arg(args, double);
+            if (pos + sizeof(val) > payload_max)
+                return pos;
+            memcpy(&payload[pos], &val, sizeof(val));
+            pos += sizeof(val);
+        } else if (conv == 'p') {
+            void *val = va_arg(args, void *);
+            if (pos + sizeof(val) > payload_max)
+                return pos;
+            memcpy(&payload[pos], &val, sizeof(val));
+            pos += sizeof(val);
+        } else if (conv == 's') {
+            /* The string may not outlive the caller, copy it */
+            const char *str = va_arg(args, const char *);
+            if (!str)
+                str = "(null)";
+            if (pos >= payload_max)
+                return pos;
+            size_t len = strnlen(str, payload_max - pos - 1);
+            memcpy(&payload[pos], str, len);
+            payload[pos + len] = '\0';
+            pos += len + 1;
+        } else if (conv == 'n') {
+            (void) va_arg(args, int *);
+        }
     }
 
-    char buf[PRINT_SIZE_MAX] = {'\r', 0};
-    int pos = snprintf(&buf[1], PRINT_SIZE_MAX, "[%5s.%s%s] ", sec, zeros, rem);
-    vsnprintf(&buf[pos + 1], PRINT_SIZE_MAX, format, args);
-    strcat(buf, "\n\r");
+    return pos;
+}
+
+static size_t printk_render_args(char *buf,
+                                 size_t size,
+                                 const char *format,
+                                 const char *payload,
+                                 size_t payload_size)
+{
+    size_t len = 0;
+    size_t pos = 0;
+
+#define PRINTK_ARG(var)                                         \
+    do {                                                        \
+        if (pos + sizeof(var) > payload_size)                   \
+            goto leave;                                         \
+        memcpy(&var, &payload[pos], sizeof(var));               \
+        pos += sizeof(var);                                     \
+    } while (0)
+
+    for (const char *p = format; *p && len < size - 1;) {
+        if (*p != '%') {
+            buf[len++] = *p++;
+            continue;
+        }
+
+        if (p[1] == '%') {
+            buf[len++] = '%';
+            p += 2;
+            continue;
+        }
 
-    console_write(buf, strlen(buf));
+        /* Rebuild the specification with the width and precision arguments
+         * expanded */
+        char spec[24];
+        size_t n = 0;
+        spec[n++] = *p++;
+        while (*p && strchr("-+ #0123456789.*hljztL", *p)) {
+            if (*p == '*') {
+                int val;
+                PRINTK_ARG(val);
+                n += snprintf(&spec[n], sizeof(spec) - n, "%d", val);
+                n = MIN(n, sizeof(spec) - 3);
+            } else if (n < sizeof(spec) - 3) {
+                spec[n++] = *p;
+            }
+            p++;
+        }
+
+        char conv = *p;
+        if (!conv)
+            break;
+        p++;
+
+        spec[n++] = conv;
+        spec[n] = '\0';
+
+        int length;
+        printk_parse_spec(&spec[1], &conv, &length);
+
+        char *out = &buf[len];
+        size_t avail = size - len;
+        int retval = 0;
+
+        if (strchr("diouxXc", conv)) {
+            if (length == PRINTK_ARG_LLONG) {
+                long long val;
+                PRINTK_ARG(val);
+                retval = snprintf(out, avail, spec, val);
+            } else if (length == PRINTK_ARG_LONG) {
+                long val;
+                PRINTK_ARG(val);
+                retval = snprintf(out, avail, spec, val);
+            } else {
+                uint32_t val;
+                PRINTK_ARG(val);
+                retval = snprintf(out, avail, spec, val);
+            }
+        } else if (strchr("fFeEgGaA", conv)) {
+            double val;
+            PRINTK_ARG(val);
+            if (strchr(spec, 'L'))
+                retval = snprintf(out, avail, spec, (long double) val);
+            else
+                retval = snprintf(out, avail, spec, val);
+        } else if (conv == 'p') {
+            void *val;
+            PRINTK_ARG(val);
+            retval = snprintf(out, avail, spec, val);
+        } else if (conv == 's') {
+            if (pos >= payload_size)
+                goto leave;
+            const char *str = &payload[pos];
+            pos += strnlen(str, payload_size - pos) + 1;
+            retval = snprintf(out, avail, spec, str);
+        } else if (conv == 'n') {
+            continue;
+        } else {
+            retval = snprintf(out, avail, "%s", spec);
+        }
+
+        if (retval > 0)
+            len += MIN((size_t) retval, avail - 1);
+    }
+
+#undef PRINTK_ARG
+
+leave:
+    buf[len] = '\0';
+    return len;
+}
+
+ssize_t console_write(const char *buf, size_t size)
+{
+    size_t written = 0;
+
+    /* Split the data into records, a full ring ends with a short count */
+    while (written < size) {
+        size_t n = MIN(size - written, PRINTK_PAYLOAD_MAX);
+        if (!printk_store(NULL, &buf[written], n, PRINTK_RAW))
+            break;
+
+        written += n;
+    }
+
+    return written;
+}
+
+void printk(char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+
+    char payload[PRINTK_PAYLOAD_MAX];
+    size_t size = printk_pack_args(format, args, payload, sizeof(payload));
+    printk_store(format, payload, size, 0);
 
     va_end(args);
 }
@@ -119,9 +433,9 @@ void panic(char *format, ...)
 
 void printkd_init(void)
 {
-    /* Place all prink buffers to the free queue */
-    for (int i = 0; i < PRINTK_QUEUE_SIZE; i++)
-        list_add_tail(&printk_buf[i].list, &printk_free_list);
+    memset(printk_ring, 0, sizeof(printk_ring));
+    printk_head = 0;
+    printk_tail = 0;
 }
 
 void printkd_start(void)
@@ -131,49 +445,135 @@ void printkd_start(void)
     wake_up_all(&printkd_wait);
 }
 
+static bool printk_ring_empty(void)
+{
+    return PRINTK_OFFSET(printk_head) == printk_tail;
+}
+
+static bool printk_ring_pending(void)
+{
+    /* Check if the oldest record is ready to be consumed */
+    struct printk_record *rec =
+        (struct printk_record *) &((char *) printk_ring)[printk_tail];
+    return !printk_ring_empty() && (rec->flags & PRINTK_COMMITTED);
+}
+
 static void printkd_sleep(void)
 {
-    prepare_to_wait(&printkd_wait, current_thread_info(), THREAD_WAIT);
+    preempt_disable();
+
+    /* The ring is checked again to avoid missing the wake up. The daemon
+     * also sleeps on a record that is still being written since the writer
+     * wakes it up on commit */
+    if (!stdout_initialized || !printk_ring_pending())
+        prepare_to_wait(&printkd_wait, current_thread_info(), THREAD_WAIT);
+
+    preempt_enable();
+
     schedule();
 }
 
 bool printk_all_flushed(void)
 {
-    return list_empty(&printk_wait_list);
+    return printk_ring_empty() && !printk_batch_len;
+}
+
+static void printkd_flush(void)
+{
+    if (!printk_batch_len)
+        return;
+
+    /* Write the batched messages to the serial at once */
+    printk_is_writing = true;
+    write(STDOUT_FILENO, printk_batch, printk_batch_len);
+    printk_is_writing = false;
+
+    printk_batch_len = 0;
+}
+
+static char *printkd_line_buf(void)
+{
+    /* Flush the batch if the next line may not fit */
+    if (PRINTK_BATCH_SIZE - printk_batch_len < PRINTK_LINE_MAX)
+        printkd_flush();
+
+    return &printk_batch[printk_batch_len];
+}
+
+static void printkd_report_drops(uint16_t *expected_seq, uint16_t seq)
+{
+    uint16_t dropped = seq - *expected_seq;
+    *expected_seq = seq;
+
+    if (!dropped)
+        return;
+
+    char *line = printkd_line_buf();
+    printk_batch_len +=
+        snprintf(line, PRINTK_LINE_MAX,
+                 "\r[printk] %u messages dropped (total %lu)\n\r", dropped,
+                 (unsigned long) printk_dropped);
+}
+
+static void printkd_render(struct printk_record *rec)
+{
+    char *line = printkd_line_buf();
+    size_t len = 0;
+
+    if (rec->flags & PRINTK_RAW) {
+        len = MIN(rec->payload_size, PRINTK_LINE_MAX);
+        memcpy(line, rec->payload, len);
+    } else {
+        len = snprintf(line, PRINTK_LINE_MAX, "\r[%5lu.%09lu] ",
+                       (unsigned long) rec->sec, (unsigned long) rec->nsec);
+        len += printk_render_args(&line[len], PRINTK_LINE_MAX - len - 2,
+                                  rec->format, (char *) rec->payload,
+                                  rec->payload_size);
+        line[len++] = '\n';
+        line[len++] = '\r';
+    }
+
+    printk_batch_len += len;
 }
 
 void printkd(void)
 {
     setprogname("printk");
 
-    struct printk_data *entry;
+    char *ring = (char *) printk_ring;
+    uint16_t expected_seq = 0;
 
     /* Wait until stdout is ready */
     while (!stdout_initialized)
         printkd_sleep();
 
     while (1) {
-        /* Check if there is any printk message to write */
-        if (list_empty(&printk_wait_list)) {
-            /* No, suspend the daemon */
-            printkd_sleep();
-        } else {
-            /* Pop one prink data from the wait queue */
-            preempt_disable();
-            entry =
-                list_first_entry(&printk_wait_list, struct printk_data, list);
-            list_del(&entry->list);
-            preempt_enable();
-
-            /* Write printk message to the serial */
-            printk_is_writing = true;
-            write(STDOUT_FILENO, entry->data, entry->size);
-            printk_is_writing = false;
-
-            /* Place the used buffer back to the free queue */
-            preempt_disable();
-            list_add_tail(&entry->list, &printk_free_list);
-            preempt_enable();
+        /* Consume all committed records */
+        while (printk_ring_pending()) {
+            struct printk_record *rec =
+                (struct printk_record *) &ring[printk_tail];
+            uint16_t size = rec->size;
+
+            if (!(rec->flags & PRINTK_PADDING)) {
+                printkd_report_drops(&expected_seq, rec->seq);
+                printkd_render(rec);
+                expected_seq++;
+            }
+
+            /* Clear the record so stale data is never seen as committed,
+             * then release the space */
+            memset(rec, 0, size);
+            printk_tail = (printk_tail + size) % PRINTK_RING_SIZE;
         }
+
+        /* Report the messages dropped after the last record */
+        uint32_t head = printk_head;
+        if (PRINTK_OFFSET(head) == printk_tail)
+            printkd_report_drops(&expected_seq, PRINTK_SEQ(head));
+
+        printkd_flush();
+
+        /* Suspend the daemon until new messages arrive */
+        printkd_sleep();
     }
 }
@@ -0,0 +1,132 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/prof.h>
+#include <sys/types.h>
+
+#include <fs/fs.h>
+#include <kernel/kernel.h>
+#include <kernel/preempt.h>
+#include <kernel/profiler.h>
+#include <kernel/thread.h>
+
+#include "kconfig.h"
+
+#if (PROFILER_ENABLE != 0)
+
+static struct {
+    struct prof_sample samples[PROFILER_SAMPLES];
+    uint32_t head; /* Next sample to write */
+    uint32_t tail; /* Next sample to read */
+    uint32_t cnt;
+    uint32_t dropped;
+    bool running;
+} prof;
+
+void profiler_sample(uint32_t pc, uint32_t lr, bool kernel)
+{
+    if (!prof.running)
+        return;
+
+    /* Keep the oldest samples so the profile covers a contiguous period */
+    if (prof.cnt == PROFILER_SAMPLES) {
+        prof.dropped++;
+        return;
+    }
+
+    CURRENT_THREAD_INFO(curr_thread);
+
+    struct prof_sample *sample = &prof.samples[prof.head];
+    sample->pc = pc;
+    sample->lr = lr;
+    sample->tid = (kernel || !curr_thread) ? PROF_TID_KERNEL : curr_thread->tid;
+
+    prof.head = (prof.head + 1) % PROFILER_SAMPLES;
+    prof.cnt++;
+}
+
+static int prof_dev_open(struct inode *inode, struct file *file)
+{
+    return 0;
+}
+
+static ssize_t prof_dev_read(struct file *filp,
+                             char *buf,
+                             size_t size,
+                             off_t offset)
+{
+    size_t n = size / sizeof(struct prof_sample);
+
+    preempt_disable();
+
+    /* Consume the samples, 0 is returned if nothing is ready */
+    if (n > prof.cnt)
+        n = prof.cnt;
+
+    for (size_t i = 0; i < n; i++) {
+        memcpy(&buf[i * sizeof(struct prof_sample)], &prof.samples[prof.tail],
+               sizeof(struct prof_sample));
+        prof.tail = (prof.tail + 1) % PROFILER_SAMPLES;
+    }
+    prof.cnt -= n;
+
+    preempt_enable();
+
+    return n * sizeof(struct prof_sample);
+}
+
+static int prof_dev_ioctl(struct file *filp,
+                          unsigned int cmd,
+                          unsigned long arg)
+{
+    int retval = 0;
+
+    preempt_disable();
+
+    switch (cmd) {
+    case PROF_START:
+        prof.head = 0;
+        prof.tail = 0;
+        prof.cnt = 0;
+        prof.dropped = 0;
+        prof.running = true;
+        break;
+    case PROF_STOP:
+        prof.running = false;
+        break;
+    case PROF_STATUS: {
+        struct prof_status *status = (struct prof_status *) arg;
+        if (!status) {
+            retval = -EFAULT;
+            break;
+        }
+
+        status->running = prof.running;
+        status->freq = OS_TICK_FREQ;
+        status->samples = prof.cnt;
+        status->dropped = prof.dropped;
+        break;
+    }
+    default:
+        retval = -EINVAL;
+    }
+
+    preempt_enable();
+
+    return retval;
+}
+
+static struct file_operations prof_dev_ops = {
+    .read = prof_dev_read,
+    .ioctl = prof_dev_ioctl,
+    .open = prof_dev_open,
+};
+
+void profiler_init(void)
+{
+    register_chrdev("prof", &prof_dev_ops);
+}
+
+#endif
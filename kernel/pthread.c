@@ -5,6 +5,7 @@
 
 #include <arch/port.h>
 #include <common/list.h>
+#include <kernel/kernel.h>
 #include <kernel/mutex.h>
 #include <kernel/syscall.h>
 #include <kernel/thread.h>
@@ -20,6 +21,7 @@ int pthread_attr_init(pthread_attr_t *attr)
     _attr->stackaddr = NULL;
     _attr->schedpolicy = SCHED_RR;
     _attr->detachstate = PTHREAD_CREATE_JOINABLE;
+    _attr->sigqueuesize = SIGNAL_QUEUE_SIZE;
     return 0;
 }
 
@@ -178,6 +180,31 @@ int pthread_attr_getstackaddr(const pthread_attr_t *attr, void **stackaddr)
     return 0;
 }
 
+int pthread_attr_setsigqueuesize(pthread_attr_t *attr, int size)
+{
+    if (!attr)
+        return -EINVAL;
+
+    if (size < 1 || size > SIGQUEUE_MAX)
+        return -EINVAL;
+
+    struct thread_attr *_attr = (struct thread_attr *) attr;
+    _attr->sigqueuesize = size;
+
+    return 0;
+}
+
+int pthread_attr_getsigqueuesize(const pthread_attr_t *attr, int *size)
+{
+    if (!attr || !size)
+        return -EINVAL;
+
+    struct thread_attr *_attr = (struct thread_attr *) attr;
+    *size = _attr->sigqueuesize;
+
+    return 0;
+}
+
 NACKED int pthread_create(pthread_t *thread,
                           const pthread_attr_t *attr,
                           void *(*start_routine)(void *),
@@ -285,25 +312,95 @@ NACKED void pthread_exit(void *retval)
     SYSCALL(PTHREAD_EXIT);
 }
 
-NACKED int pthread_mutex_unlock(pthread_mutex_t *mutex)
+/* Try to occupy a free mutex in the user space. Return false if the
+ * mutex is currently locked */
+static inline bool mutex_fast_lock(struct mutex *mtx)
+{
+    CURRENT_THREAD_INFO(curr_thread);
+    volatile uint32_t *owner = (volatile uint32_t *) &mtx->owner;
+
+    do {
+        if (load_exclusive(owner) != 0) {
+            clear_exclusive();
+            return false;
+        }
+    } while (!store_exclusive(owner, (uint32_t) curr_thread));
+
+    return true;
+}
+
+/* Try to release the mutex in the user space. Return false if the kernel
+ * has to hand the mutex over to a waiting thread. An uncontended mutex
+ * never contributes to the inherited priority of the owner */
+static inline bool mutex_fast_unlock(struct mutex *mtx)
+{
+    CURRENT_THREAD_INFO(curr_thread);
+    volatile uint32_t *owner = (volatile uint32_t *) &mtx->owner;
+
+    do {
+        /* The wait list is checked within the exclusive access window so
+         * any change made by the kernel aborts the store */
+        if (load_exclusive(owner) != (uint32_t) curr_thread ||
+            wait_queue_active(&mtx->wait_list)) {
+            clear_exclusive();
+            return false;
+        }
+    } while (!store_exclusive(owner, 0));
+
+    return true;
+}
+
+static NACKED int _pthread_mutex_unlock(pthread_mutex_t *mutex)
 {
     SYSCALL(PTHREAD_MUTEX_UNLOCK);
 }
 
-NACKED int pthread_mutex_lock(pthread_mutex_t *mutex)
+static NACKED int _pthread_mutex_lock(pthread_mutex_t *mutex)
 {
     SYSCALL(PTHREAD_MUTEX_LOCK);
 }
 
-NACKED int pthread_mutex_trylock(pthread_mutex_t *mutex)
+static NACKED int _pthread_mutex_timedlock(pthread_mutex_t *mutex,
+                                           const struct timespec *abstime)
 {
-    SYSCALL(PTHREAD_MUTEX_TRYLOCK);
+    SYSCALL(PTHREAD_MUTEX_TIMEDLOCK);
 }
 
-NACKED int pthread_mutex_timedlock(pthread_mutex_t *mutex,
-                                   const struct timespec *abstime)
+int pthread_mutex_unlock(pthread_mutex_t *mutex)
 {
-    SYSCALL(PTHREAD_MUTEX_TIMEDLOCK);
+    if (mutex && mutex_fast_unlock((struct mutex *) mutex))
+        return 0;
+
+    /* Slow path: wake up the waiting threads */
+    return _pthread_mutex_unlock(mutex);
+}
+
+int pthread_mutex_lock(pthread_mutex_t *mutex)
+{
+    if (mutex && mutex_fast_lock((struct mutex *) mutex))
+        return 0;
+
+    /* Slow path: the mutex is contended, block in the kernel */
+    return _pthread_mutex_lock(mutex);
+}
+
+int pthread_mutex_trylock(pthread_mutex_t *mutex)
+{
+    if (!mutex)
+        return -EINVAL;
+
+    /* No need to trap into the kernel as trylock never blocks */
+    return mutex_fast_lock((struct mutex *) mutex) ? 0 : -EBUSY;
+}
+
+int pthread_mutex_timedlock(pthread_mutex_t *mutex,
+                            const struct timespec *abstime)
+{
+    if (mutex && mutex_fast_lock((struct mutex *) mutex))
+        return 0;
+
+    /* Slow path: the mutex is contended, block in the kernel */
+    return _pthread_mutex_timedlock(mutex, abstime);
 }
 int pthread_condattr_init(pthread_condattr_t *attr)
 {
@@ -329,7 +426,7 @@ int pthread_cond_init(pthread_cond_t *cond, pthread_condattr_t cond_attr)
     if (!cond)
         return -EINVAL;
 
-    INIT_LIST_HEAD(&((struct cond *) cond)->task_wait_list);
+    init_wait_queue(&((struct cond *) cond)->task_wait_list);
     return 0;
 }
 
@@ -41,6 +41,11 @@ NACKED int delay_ticks(uint32_t ticks)
     SYSCALL(DELAY_TICKS);
 }
 
+NACKED int delay_until(const struct timespec *abstime)
+{
+    SYSCALL(DELAY_UNTIL);
+}
+
 unsigned int sleep(unsigned int seconds)
 {
     if (seconds == 0)
@@ -66,15 +71,10 @@ int usleep(useconds_t usec)
     if (usec == 0)
         return 0;
 
-    if (usec >= 1000000)
-        return -EINVAL;
+    struct timespec req = {
+        .tv_sec = usec / 1000000,
+        .tv_nsec = (usec % 1000000) * 1000,
+    };
 
-    uint64_t ticks =
-        (OS_TICK_FREQ * (uint64_t) usec + 1000000ULL - 1) / 1000000ULL;
-
-    if (ticks == 0)
-        ticks = 1;
-
-    delay_ticks((uint32_t) ticks);
-    return 0;
+    return nanosleep(&req, NULL);
 }
@@ -17,7 +17,7 @@
 void sema_init(struct semaphore *sem, int val)
 {
     sem->count = val;
-    INIT_LIST_HEAD(&sem->wait_list);
+    init_wait_queue(&sem->wait_list);
 }
 
 int down(struct semaphore *sem)
@@ -27,7 +27,8 @@ int down(struct semaphore *sem)
     while (sem->count <= 0) {
         /* Failed to acquire the semaphore, enqueue the current thread into the
          * waiting list */
-        prepare_to_wait(&sem->wait_list, current_thread_info(), THREAD_WAIT);
+        prepare_to_wait_queue(&sem->wait_list, current_thread_info(),
+                              THREAD_WAIT);
 
         schedule();
     }
@@ -74,9 +75,8 @@ int up(struct semaphore *sem)
         sem->count++;
 
         /* Wake up the highest-priority thread from the waiting list */
-        if (sem->count > 0 && !list_empty(&sem->wait_list)) {
-            wake_up(&sem->wait_list);
-        }
+        if (sem->count > 0)
+            wake_up_queue(&sem->wait_list);
 
         retval = 0;
     }
@@ -104,26 +104,104 @@ int sem_destroy(sem_t *sem)
     return 0;
 }
 
-NACKED int sem_post(sem_t *sem)
+/* Try to decrease the semaphore in the user space. Return false if the
+ * semaphore is not available */
+static inline bool sem_fast_down(struct semaphore *sem)
 {
-    SYSCALL(SEM_POST);
+    volatile uint32_t *count = (volatile uint32_t *) &sem->count;
+    int32_t val;
+
+    do {
+        val = (int32_t) load_exclusive(count);
+        if (val <= 0) {
+            clear_exclusive();
+            return false;
+        }
+    } while (!store_exclusive(count, val - 1));
+
+    return true;
+}
+
+/* Try to increase the semaphore in the user space. Return false if the
+ * kernel has to wake up the waiting threads or report the overflow */
+static inline bool sem_fast_up(struct semaphore *sem)
+{
+    volatile uint32_t *count = (volatile uint32_t *) &sem->count;
+    int32_t val;
+
+    do {
+        /* The wait list is checked within the exclusive access window so
+         * any change made by the kernel aborts the store */
+        val = (int32_t) load_exclusive(count);
+        if (val >= (INT32_MAX - 1) || wait_queue_active(&sem->wait_list)) {
+            clear_exclusive();
+            return false;
+        }
+    } while (!store_exclusive(count, val + 1));
+
+    return true;
 }
 
-NACKED int sem_trywait(sem_t *sem)
+static NACKED int _sem_post(sem_t *sem)
 {
-    SYSCALL(SEM_TRYWAIT);
+    SYSCALL(SEM_POST);
 }
 
-NACKED int sem_wait(sem_t *sem)
+static NACKED int _sem_wait(sem_t *sem)
 {
     SYSCALL(SEM_WAIT);
 }
 
-NACKED int sem_timedwait(sem_t *sem, const struct timespec *abstime)
+static NACKED int _sem_timedwait(sem_t *sem, const struct timespec *abstime)
 {
     SYSCALL(SEM_TIMEDWAIT);
 }
 
+int sem_post(sem_t *sem)
+{
+    if (!sem)
+        return -EINVAL;
+
+    if (sem_fast_up((struct semaphore *) sem))
+        return 0;
+
+    /* Slow path: wake up the waiting threads */
+    return _sem_post(sem);
+}
+
+int sem_trywait(sem_t *sem)
+{
+    if (!sem)
+        return -EINVAL;
+
+    /* No need to trap into the kernel as trywait never blocks */
+    return sem_fast_down((struct semaphore *) sem) ? 0 : -EAGAIN;
+}
+
+int sem_wait(sem_t *sem)
+{
+    if (!sem)
+        return -EINVAL;
+
+    if (sem_fast_down((struct semaphore *) sem))
+        return 0;
+
+    /* Slow path: the semaphore is not available, block in the kernel */
+    return _sem_wait(sem);
+}
+
+int sem_timedwait(sem_t *sem, const struct timespec *abstime)
+{
+    if (!sem)
+        return -EINVAL;
+
+    if (sem_fast_down((struct semaphore *) sem))
+        return 0;
+
+    /* Slow path: the semaphore is not available, block in the kernel */
+    return _sem_timedwait(sem, abstime);
+}
+
 NACKED int sem_getvalue(sem_t *sem, int *sval)
 {
     SYSCALL(SEM_GETVALUE);
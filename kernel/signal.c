@@ -10,8 +10,19 @@
     case name:                 \
         return (1 << bit)
 
+/* Real-time signals are placed after the standard signals */
+#define SIGRT_BASE 6
+
+bool is_rt_signal(int signum)
+{
+    return signum >= SIGRTMIN && signum <= SIGRTMAX;
+}
+
 bool is_signal_defined(int signum)
 {
+    if (is_rt_signal(signum))
+        return true;
+
     switch (signum) {
     case SIGUSR1:
     case SIGUSR2:
@@ -27,6 +38,9 @@ bool is_signal_defined(int signum)
 
 uint32_t sig2bit(int signum)
 {
+    if (is_rt_signal(signum))
+        return 1 << (SIGRT_BASE + signum - SIGRTMIN);
+
     switch (signum) {
         DEF_SIG_BIT(SIGUSR1, 0);
         DEF_SIG_BIT(SIGUSR2, 1);
@@ -41,6 +55,9 @@ uint32_t sig2bit(int signum)
 
 int get_signal_index(int signum)
 {
+    if (is_rt_signal(signum))
+        return SIGRT_BASE + signum - SIGRTMIN;
+
     switch (signum) {
     case SIGUSR1:
         return 0;
@@ -59,6 +76,12 @@ int get_signal_index(int signum)
     return 0; /* Should never happened */
 }
 
+bool is_sigset_valid(const sigset_t *set)
+{
+    sigset_t valid_set = (1 << SIGNAL_CNT) - 1;
+    return !(*set & ~valid_set);
+}
+
 int sigemptyset(sigset_t *set)
 {
     if (!set)
@@ -142,8 +165,7 @@ NACKED int sigtimedwait(const sigset_t *set,
 int pause(void)
 {
     int sig;
-    sigset_t set = sig2bit(SIGUSR1) | sig2bit(SIGUSR2) | sig2bit(SIGPOLL) |
-                   sig2bit(SIGSTOP) | sig2bit(SIGCONT) | sig2bit(SIGKILL);
+    sigset_t set = (1 << SIGNAL_CNT) - 1;
     sigwait(&set, &sig);
     return 0;
 }
@@ -163,6 +185,11 @@ int kill(pid_t pid, int sig)
     return _kill(pid, sig);
 }
 
+NACKED int sigqueue(pid_t pid, int sig, const union sigval value)
+{
+    SYSCALL(SIGQUEUE);
+}
+
 NACKED void _exit(int status)
 {
     SYSCALL(EXIT);
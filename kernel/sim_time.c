@@ -0,0 +1,146 @@
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/sim_time.h>
+#include <sys/types.h>
+
+#include <fs/fs.h>
+#include <kernel/preempt.h>
+#include <kernel/printk.h>
+#include <kernel/sim_time.h>
+#include <kernel/time.h>
+
+#include "kconfig.h"
+
+#if (SIM_TIME_ENABLE != 0)
+
+#define TICK_PERIOD_NSEC (1000000000 / OS_TICK_FREQ)
+#define SIM_TIME_TIMEOUT_TICKS (SIM_TIME_TIMEOUT_MS * OS_TICK_FREQ / 1000)
+
+/* Larger steps are taken as a restart of the simulator */
+#define SIM_TIME_STEP_MAX_USEC 1000000
+
+static struct {
+    bool lockstep;
+    uint64_t offset;     /* System time minus the simulator time in ns */
+    uint32_t elapsed;    /* Time since the last tick in ns */
+    uint32_t idle_ticks; /* Ticks of the system timer since the last write */
+    struct sim_time_status status;
+} sim_time;
+
+static uint64_t sys_time_ns(void)
+{
+    struct timespec tp;
+    get_sys_time(&tp);
+    return (uint64_t) tp.tv_sec * 1000000000ULL + tp.tv_nsec;
+}
+
+bool sim_time_tick(void)
+{
+    if (!sim_time.lockstep)
+        return false;
+
+    if (++sim_time.idle_ticks < SIM_TIME_TIMEOUT_TICKS)
+        return true;
+
+    /* The simulator is gone, let the system timer take over */
+    sim_time.lockstep = false;
+    sim_time.status.lockstep = false;
+    set_sys_time_external(false);
+
+    printk("simtime: no update from the simulator, resume the system timer");
+
+    return false;
+}
+
+static ssize_t sim_time_write(struct file *filp,
+                              const char *buf,
+                              size_t size,
+                              off_t offset)
+{
+    uint64_t usec;
+
+    if (size != sizeof(usec))
+        return -EINVAL;
+
+    memcpy(&usec, buf, sizeof(usec));
+
+    preempt_disable();
+
+    uint64_t now = sys_time_ns();
+    uint64_t last = sim_time.status.sim_usec;
+
+    /* Map the simulator time to the current time on the first write, or
+     * when the simulator restarts, so the system time never goes backward */
+    if (!sim_time.lockstep || usec < last ||
+        usec - last > SIM_TIME_STEP_MAX_USEC) {
+        if (sim_time.lockstep) {
+            sim_time.status.resyncs++;
+        } else {
+            set_sys_time_external(true);
+            sim_time.lockstep = true;
+            sim_time.status.lockstep = true;
+            sim_time.elapsed = 0;
+        }
+
+        sim_time.offset = now - usec * 1000;
+    }
+
+    sim_time.idle_ticks = 0;
+    sim_time.status.sim_usec = usec;
+    sim_time.status.steps++;
+
+    /* Run the ticks up to the simulator time and keep the remainder */
+    uint64_t target = usec * 1000 + sim_time.offset;
+    if (target > now) {
+        uint64_t elapsed = sim_time.elapsed + (target - now);
+        sim_time.elapsed = elapsed % TICK_PERIOD_NSEC;
+
+        set_sys_time_elapsed(0);
+        system_ticks_advance(elapsed / TICK_PERIOD_NSEC);
+        set_sys_time_elapsed(sim_time.elapsed);
+    }
+
+    preempt_enable();
+
+    return size;
+}
+
+static int sim_time_ioctl(struct file *filp,
+                          unsigned int cmd,
+                          unsigned long arg)
+{
+    switch (cmd) {
+    case SIM_TIME_RELEASE:
+        preempt_disable();
+        sim_time.lockstep = false;
+        sim_time.status.lockstep = false;
+        set_sys_time_external(false);
+        preempt_enable();
+        return 0;
+    case SIM_TIME_STATUS: {
+        struct sim_time_status *status = (struct sim_time_status *) arg;
+        if (!status)
+            return -EFAULT;
+
+        preempt_disable();
+        *status = sim_time.status;
+        preempt_enable();
+        return 0;
+    }
+    default:
+        return -EINVAL;
+    }
+}
+
+static struct file_operations sim_time_ops = {
+    .write = sim_time_write,
+    .ioctl = sim_time_ioctl,
+};
+
+void sim_time_init(void)
+{
+    register_chrdev("simtime", &sim_time_ops);
+}
+
+#endif
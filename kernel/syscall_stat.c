@@ -0,0 +1,143 @@
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/syscall_stat.h>
+#include <sys/types.h>
+
+#include <arch/port.h>
+#include <fs/fs.h>
+#include <kernel/kernel.h>
+#include <kernel/preempt.h>
+#include <kernel/syscall.h>
+#include <kernel/syscall_stat.h>
+
+#include "kconfig.h"
+
+#if (SYSCALL_STAT_ENABLE != 0)
+
+struct syscall_counter {
+    uint32_t cnt;
+    uint32_t max;
+    uint64_t cycles;
+    uint32_t hist[SYSCALL_HIST_BUCKETS];
+};
+
+/* Indexed by the syscall number minus one */
+static struct syscall_counter counters[SYSCALL_CNT];
+static const char *const syscall_names[SYSCALL_CNT] = {SYSCALL_NAME_INIT};
+
+/* Next syscall to read */
+static int read_idx;
+
+void syscall_stat_enter(struct thread_info *thread, unsigned long num)
+{
+    if (num < 1 || num > SYSCALL_CNT)
+        return;
+
+    counters[num - 1].cnt++;
+
+    thread->syscall_num = num;
+    thread->syscall_cycles = get_cycle_count();
+}
+
+void syscall_stat_exit(struct thread_info *thread)
+{
+    unsigned long num = thread->syscall_num;
+    if (num < 1 || num > SYSCALL_CNT)
+        return;
+
+    uint32_t cycles = get_cycle_count() - thread->syscall_cycles;
+    struct syscall_counter *counter = &counters[num - 1];
+
+    counter->cycles += cycles;
+    if (cycles > counter->max)
+        counter->max = cycles;
+
+    /* Bucket of the log2 latency */
+    int bucket = 0;
+    if (cycles >= (1UL << SYSCALL_HIST_SHIFT)) {
+        bucket = 31 - __builtin_clz(cycles) - SYSCALL_HIST_SHIFT + 1;
+        if (bucket >= SYSCALL_HIST_BUCKETS)
+            bucket = SYSCALL_HIST_BUCKETS - 1;
+    }
+    counter->hist[bucket]++;
+
+    thread->syscall_num = 0;
+}
+
+static int syscall_stat_open(struct inode *inode, struct file *file)
+{
+    /* Read from the first syscall */
+    read_idx = 0;
+    return 0;
+}
+
+static ssize_t syscall_stat_read(struct file *filp,
+                                 char *buf,
+                                 size_t size,
+                                 off_t offset)
+{
+    size_t n = size / sizeof(struct syscall_stat);
+    size_t cnt = 0;
+
+    /* Copy the syscalls invoked since the last reset */
+    for (; read_idx < SYSCALL_CNT && cnt < n; read_idx++) {
+        struct syscall_stat *stat =
+            (struct syscall_stat *) &buf[cnt * sizeof(struct syscall_stat)];
+
+        preempt_disable();
+        struct syscall_counter *counter = &counters[read_idx];
+        stat->cnt = counter->cnt;
+        stat->max = counter->max;
+        stat->cycles = counter->cycles;
+        memcpy(stat->hist, counter->hist, sizeof(stat->hist));
+        preempt_enable();
+
+        if (stat->cnt == 0)
+            continue;
+
+        stat->num = read_idx + 1;
+        strncpy(stat->name, syscall_names[read_idx], SYSCALL_NAME_MAX - 1);
+        stat->name[SYSCALL_NAME_MAX - 1] = '\0';
+        cnt++;
+    }
+
+    return cnt * sizeof(struct syscall_stat);
+}
+
+static int syscall_stat_ioctl(struct file *filp,
+                              unsigned int cmd,
+                              unsigned long arg)
+{
+    switch (cmd) {
+    case SYSCALL_STAT_RESET:
+        preempt_disable();
+        memset(counters, 0, sizeof(counters));
+        preempt_enable();
+        return 0;
+    case SYSCALL_STAT_FREQ: {
+        uint32_t *freq = (uint32_t *) arg;
+        if (!freq)
+            return -EFAULT;
+
+        *freq = get_cycle_freq();
+        return 0;
+    }
+    default:
+        return -EINVAL;
+    }
+}
+
+static struct file_operations syscall_stat_ops = {
+    .read = syscall_stat_read,
+    .ioctl = syscall_stat_ioctl,
+    .open = syscall_stat_open,
+};
+
+void syscall_stat_init(void)
+{
+    register_chrdev("syscalls", &syscall_stat_ops);
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include <errno.h>
+#include <string.h>
 #include <tenok.h>
 #include <time.h>
 
@@ -11,6 +12,15 @@
 #define NANOSECOND_TICKS (1000000000 / OS_TICK_FREQ)
 
 static struct timespec sys_time;
+static volatile uint32_t sys_time_seq;
+
+/* Driven by the external time source instead of the system timer, with the
+ * time elapsed since the last tick provided by the source */
+static bool sys_time_external;
+static uint32_t sys_time_external_elapsed;
+
+/* Armed kernel timers sorted by the expiration time */
+static LIST_HEAD(ktimer_list);
 
 static void normalize_timespec(struct timespec *time)
 {
@@ -35,19 +45,6 @@ void timer_up_count(struct timespec *time)
     }
 }
 
-void timer_down_count(struct timespec *time)
-{
-    time->tv_nsec -= NANOSECOND_TICKS;
-
-    if (time->tv_nsec < 0 && time->tv_sec > 0) {
-        time->tv_sec--;
-        time->tv_nsec += 1000000000;
-    } else if (time->tv_nsec <= 0 && time->tv_sec <= 0) {
-        time->tv_sec = 0;
-        time->tv_nsec = 0;
-    }
-}
-
 void time_add(struct timespec *time, time_t sec, long nsec)
 {
     time->tv_sec += sec;
@@ -59,16 +56,57 @@ void time_add(struct timespec *time, time_t sec, long nsec)
 void system_timer_update(void)
 {
     timer_up_count(&sys_time);
+    sys_time_seq++;
 }
 
 void get_sys_time(struct timespec *tp)
 {
-    *tp = sys_time;
+    uint32_t seq, elapsed;
+
+    /* Interpolate the tick count with the timer counter and retry if the
+     * tick is updated in the middle */
+    do {
+        seq = sys_time_seq;
+        asm volatile("" ::: "memory");
+        *tp = sys_time;
+        elapsed = sys_time_external ? sys_time_external_elapsed
+                                    : get_tick_elapsed_nsec();
+        asm volatile("" ::: "memory");
+    } while (seq != sys_time_seq);
+
+    time_add(tp, 0, elapsed);
 }
 
 void set_sys_time(const struct timespec *tp)
 {
     sys_time = *tp;
+    sys_time_seq++;
+}
+
+void set_sys_time_external(bool external)
+{
+    if (external == sys_time_external)
+        return;
+
+    /* Continue from the current time so it never goes backward */
+    struct timespec now;
+    get_sys_time(&now);
+
+    sys_time = now;
+    sys_time_external = external;
+    sys_time_external_elapsed = 0;
+    sys_time_seq++;
+}
+
+bool sys_time_is_external(void)
+{
+    return sys_time_external;
+}
+
+void set_sys_time_elapsed(uint32_t nsec)
+{
+    sys_time_external_elapsed = nsec;
+    sys_time_seq++;
 }
 
 int clock_getres(clockid_t clockid, struct timespec *res)
@@ -82,7 +120,7 @@ int clock_getres(clockid_t clockid, struct timespec *res)
         return -EINVAL;
 
     res->tv_sec = 0;
-    res->tv_nsec = NANOSECOND_TICKS;
+    res->tv_nsec = get_timer_resolution_nsec();
 
     return 0;
 }
@@ -122,6 +160,16 @@ NACKED int timer_gettime(timer_t timerid, struct itimerspec *curr_value)
     SYSCALL(TIMER_GETTIME);
 }
 
+NACKED int timer_getoverrun(timer_t timerid)
+{
+    SYSCALL(TIMER_GETOVERRUN);
+}
+
+NACKED uint32_t getcycles(void)
+{
+    SYSCALL(GETCYCLES);
+}
+
 time_t time(time_t *tloc)
 {
     struct timespec tp;
@@ -140,7 +188,18 @@ void msleep(unsigned int msecs)
 
 ktime_t ktime_get(void)
 {
-    return sys_time.tv_sec * 1000 + sys_time.tv_nsec / 1000000;
+    struct timespec tp;
+    get_sys_time(&tp);
+
+    return tp.tv_sec * 1000 + tp.tv_nsec / 1000000;
+}
+
+ktime_t ktime_get_ns(void)
+{
+    struct timespec tp;
+    get_sys_time(&tp);
+
+    return (ktime_t) tp.tv_sec * 1000000000 + tp.tv_nsec;
 }
 
 static bool timespec_valid(const struct timespec *ts)
@@ -159,30 +218,106 @@ static int timespec_cmp(const struct timespec *a, const struct timespec *b)
     return (a->tv_sec > b->tv_sec) ? 1 : -1;
 }
 
-static void timespec_sub(struct timespec *out,
-                         const struct timespec *a,
-                         const struct timespec *b)
+void ktimer_init(struct ktimer *timer, ktimer_func_t func)
+{
+    memset(timer, 0, sizeof(struct ktimer));
+    timer->func = func;
+}
+
+static void ktimer_enqueue(struct ktimer *timer)
+{
+    /* Keep the list sorted so the update stops at the first pending timer */
+    struct ktimer *pos;
+    list_for_each_entry (pos, &ktimer_list, list) {
+        if (timespec_cmp(&timer->expiry, &pos->expiry) < 0)
+            break;
+    }
+
+    list_add_tail(&timer->list, &pos->list);
+    timer->armed = true;
+}
+
+void ktimer_start(struct ktimer *timer,
+                  const struct timespec *expiry,
+                  const struct timespec *interval)
+{
+    ktimer_cancel(timer);
+
+    timer->expiry = *expiry;
+    timer->interval = *interval;
+    ktimer_enqueue(timer);
+}
+
+void ktimer_cancel(struct ktimer *timer)
 {
-    out->tv_sec = a->tv_sec - b->tv_sec;
-    out->tv_nsec = a->tv_nsec - b->tv_nsec;
-    if (out->tv_nsec < 0) {
-        out->tv_sec -= 1;
-        out->tv_nsec += 1000000000L;
+    if (timer->armed) {
+        list_del(&timer->list);
+        timer->armed = false;
     }
-    if (out->tv_sec < 0) {
-        out->tv_sec = 0;
-        out->tv_nsec = 0;
+}
+
+bool ktimer_next_expiry(struct timespec *expiry)
+{
+    if (list_empty(&ktimer_list))
+        return false;
+
+    *expiry = list_first_entry(&ktimer_list, struct ktimer, list)->expiry;
+    return true;
+}
+
+void ktimer_remaining(struct ktimer *timer, struct timespec *remaining)
+{
+    remaining->tv_sec = 0;
+    remaining->tv_nsec = 0;
+
+    if (!timer->armed)
+        return;
+
+    struct timespec now;
+    get_sys_time(&now);
+    if (timespec_cmp(&timer->expiry, &now) > 0) {
+        *remaining = timer->expiry;
+        time_add(remaining, -now.tv_sec, -now.tv_nsec);
     }
 }
 
-static uint64_t timespec_to_ticks(const struct timespec *ts)
+static uint64_t timespec_to_ns(const struct timespec *ts)
 {
-    uint64_t ns =
-        (uint64_t) ts->tv_sec * 1000000000ULL + (uint64_t) ts->tv_nsec;
-    uint64_t tick_ns = 1000000000ULL / OS_TICK_FREQ;
-    if (tick_ns == 0)
-        return 0;
-    return (ns + tick_ns - 1) / tick_ns;
+    return (uint64_t) ts->tv_sec * 1000000000ULL + (uint64_t) ts->tv_nsec;
+}
+
+void ktimers_update(void)
+{
+    struct timespec now;
+    get_sys_time(&now);
+
+    while (!list_empty(&ktimer_list)) {
+        struct ktimer *timer =
+            list_first_entry(&ktimer_list, struct ktimer, list);
+
+        /* The remaining timers are not expired yet */
+        if (timespec_cmp(&now, &timer->expiry) < 0)
+            break;
+
+        ktimer_cancel(timer);
+
+        uint64_t expirations = 1;
+        uint64_t period = timespec_to_ns(&timer->interval);
+        if (period) {
+            /* Count the missed periods and advance the deadline by whole
+             * periods so the phase never drifts */
+            uint64_t late =
+                timespec_to_ns(&now) - timespec_to_ns(&timer->expiry);
+            expirations += late / period;
+
+            uint64_t advance = expirations * period;
+            time_add(&timer->expiry, advance / 1000000000ULL,
+                     advance % 1000000000ULL);
+            ktimer_enqueue(timer);
+        }
+
+        timer->func(timer, expirations);
+    }
 }
 
 int clock_nanosleep(clockid_t clockid,
@@ -199,30 +334,20 @@ int clock_nanosleep(clockid_t clockid,
     if (flags != 0 && flags != TIMER_ABSTIME)
         return -EINVAL;
 
-    struct timespec duration = *req;
-
-    if (flags == TIMER_ABSTIME) {
-        struct timespec now;
-        get_sys_time(&now);
-        if (timespec_cmp(req, &now) <= 0) {
-            if (rem) {
-                rem->tv_sec = 0;
-                rem->tv_nsec = 0;
-            }
-            return 0;
-        }
-        timespec_sub(&duration, req, &now);
-    }
-
-    uint64_t ticks = timespec_to_ticks(&duration);
-    if (ticks > 0)
-        delay_ticks((uint32_t) ticks);
+    /* Convert the request to an absolute deadline */
+    struct timespec now, deadline = *req;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (flags != TIMER_ABSTIME)
+        time_add(&deadline, now.tv_sec, now.tv_nsec);
 
     if (rem) {
         rem->tv_sec = 0;
         rem->tv_nsec = 0;
     }
 
+    /* Deadlines between two ticks are woken up by the one-shot timer */
+    delay_until(&deadline);
+
     return 0;
 }
 
@@ -0,0 +1,190 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/timerfd.h>
+
+#include <arch/port.h>
+#include <common/list.h>
+#include <fs/fs.h>
+#include <kernel/errno.h>
+#include <kernel/kernel.h>
+#include <kernel/poll.h>
+#include <kernel/preempt.h>
+#include <kernel/syscall.h>
+#include <kernel/thread.h>
+#include <kernel/time.h>
+#include <kernel/timerfd.h>
+#include <kernel/wait.h>
+
+static bool timespec_valid(const struct timespec *ts)
+{
+    return ts && ts->tv_sec >= 0 && ts->tv_nsec >= 0 &&
+           ts->tv_nsec < 1000000000L;
+}
+
+static void timerfd_expire(struct ktimer *ktimer, uint64_t expirations)
+{
+    struct timerfd *tfd = container_of(ktimer, struct timerfd, ktimer);
+
+    tfd->expirations += expirations;
+
+    /* Wake up the readers and the pollers */
+    tfd->file.f_events |= POLLIN;
+    wake_up_queue_all(&tfd->wait_list);
+    poll_notify(&tfd->file);
+}
+
+static ssize_t timerfd_read(struct file *filp,
+                            char *buf,
+                            size_t size,
+                            off_t offset)
+{
+    CURRENT_THREAD_INFO(curr_thread);
+
+    preempt_disable();
+
+    ssize_t retval;
+    struct timerfd *tfd = container_of(filp, struct timerfd, file);
+
+    if (size < sizeof(uint64_t)) {
+        retval = -EINVAL;
+        goto leave;
+    }
+
+    uint32_t gen = tfd->gen;
+
+    while (tfd->expirations == 0) {
+        if (filp->f_flags & O_NONBLOCK) {
+            retval = -EAGAIN;
+            goto leave;
+        }
+
+        prepare_to_wait_queue(&tfd->wait_list, curr_thread, THREAD_WAIT);
+        schedule();
+
+        /* The file is closed while sleeping, the slot may be reused */
+        if (tfd->gen != gen) {
+            retval = -EBADF;
+            goto leave;
+        }
+    }
+
+    /* Return and reset the expiration count */
+    memcpy(buf, &tfd->expirations, sizeof(uint64_t));
+    tfd->expirations = 0;
+    filp->f_events &= ~POLLIN;
+
+    retval = sizeof(uint64_t);
+
+leave:
+    preempt_enable();
+    return retval;
+}
+
+static int timerfd_open(struct inode *inode, struct file *file)
+{
+    return 0;
+}
+
+static struct file_operations timerfd_ops = {
+    .read = timerfd_read,
+    .open = timerfd_open,
+};
+
+void __timerfd_init(struct timerfd *tfd)
+{
+    /* The poll wait list is kept since the pollers may still be linked to
+     * the recycled file */
+    tfd->file.f_inode = NULL;
+    tfd->file.f_op = &timerfd_ops;
+    tfd->file.f_events = 0;
+    tfd->file.f_flags = 0;
+
+    tfd->expirations = 0;
+    ktimer_init(&tfd->ktimer, timerfd_expire);
+    init_wait_queue(&tfd->wait_list);
+}
+
+void __timerfd_release(struct timerfd *tfd)
+{
+    ktimer_cancel(&tfd->ktimer);
+
+    /* Fail the blocked readers and detach the pollers before the slot is
+     * recycled */
+    tfd->gen++;
+    tfd->file.f_events = 0;
+    wake_up_queue_all(&tfd->wait_list);
+    poll_release(&tfd->file);
+}
+
+struct timerfd *file_to_timerfd(struct file *filp)
+{
+    if (!filp || filp->f_op != &timerfd_ops)
+        return NULL;
+
+    return container_of(filp, struct timerfd, file);
+}
+
+int __timerfd_settime(struct timerfd *tfd,
+                      int flags,
+                      const struct itimerspec *new_value,
+                      struct itimerspec *old_value)
+{
+    if (!new_value || !timespec_valid(&new_value->it_value) ||
+        !timespec_valid(&new_value->it_interval)) {
+        return -EINVAL;
+    }
+
+    if (flags & ~TFD_TIMER_ABSTIME)
+        return -EINVAL;
+
+    if (old_value)
+        __timerfd_gettime(tfd, old_value);
+
+    /* Reset the timer */
+    ktimer_cancel(&tfd->ktimer);
+    tfd->expirations = 0;
+    tfd->file.f_events &= ~POLLIN;
+
+    /* Zero initial expiration disarms the timer */
+    if (new_value->it_value.tv_sec == 0 && new_value->it_value.tv_nsec == 0)
+        return 0;
+
+    struct timespec expiry = new_value->it_value;
+    if (!(flags & TFD_TIMER_ABSTIME)) {
+        get_sys_time(&expiry);
+        time_add(&expiry, new_value->it_value.tv_sec,
+                 new_value->it_value.tv_nsec);
+    }
+
+    ktimer_start(&tfd->ktimer, &expiry, &new_value->it_interval);
+
+    return 0;
+}
+
+void __timerfd_gettime(struct timerfd *tfd, struct itimerspec *curr_value)
+{
+    curr_value->it_interval = tfd->ktimer.interval;
+    ktimer_remaining(&tfd->ktimer, &curr_value->it_value);
+}
+
+NACKED int timerfd_create(int clockid, int flags)
+{
+    SYSCALL(TIMERFD_CREATE);
+}
+
+NACKED int timerfd_settime(int fd,
+                           int flags,
+                           const struct itimerspec *new_value,
+                           struct itimerspec *old_value)
+{
+    SYSCALL(TIMERFD_SETTIME);
+}
+
+NACKED int timerfd_gettime(int fd, struct itimerspec *curr_value)
+{
+    SYSCALL(TIMERFD_GETTIME);
+}
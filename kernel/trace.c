@@ -0,0 +1,367 @@
+#include <errno.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <arch/port.h>
+#include <fs/fs.h>
+#include <kernel/kernel.h>
+#include <kernel/preempt.h>
+#include <kernel/thread.h>
+#include <kernel/trace.h>
+
+#include "kconfig.h"
+
+#if (IRQSOFF_TRACE_ENABLE != 0)
+
+#define TRACE_IRQ_MAX 128     /* Exception numbers of the vector table */
+#define TRACE_IRQ_NEST_MAX 8  /* Max nesting level of the interrupts */
+#define TRACE_BUF_SIZE 2048   /* Text size of a trace file */
+#define EXTERNAL_IRQ_OFFSET 16 /* Exception number of the IRQ 0 */
+
+struct trace_stat {
+    uintptr_t site;
+    uint32_t cnt;
+    uint32_t max;   /* Cycles */
+    uint64_t total; /* Cycles */
+};
+
+struct trace_file {
+    char buf[TRACE_BUF_SIZE];
+    size_t len;
+    size_t pos;
+};
+
+static struct {
+    struct trace_stat sites[IRQSOFF_TRACE_SITES];
+    uint32_t dropped; /* Sections of the sites not fitting the table */
+    uintptr_t max_site;
+    uint32_t max;
+
+    /* The section being timed */
+    uintptr_t site;
+    uint32_t start;
+    bool tracing;
+} irqsoff;
+
+static struct {
+    struct trace_stat irqs[TRACE_IRQ_MAX];
+    uint32_t start[TRACE_IRQ_NEST_MAX];
+    int depth;
+} irqs;
+
+static struct trace_stat irqsoff_snapshot[IRQSOFF_TRACE_SITES];
+static struct trace_file irqsoff_file;
+static struct trace_file irqs_file;
+
+static bool trace_privileged(void)
+{
+    CURRENT_THREAD_INFO(curr_thread);
+
+    /* The cycle counter is not accessible from the unprivileged threads */
+    return get_proc_mode() != 0 || !curr_thread ||
+           curr_thread->privilege == KERNEL_THREAD;
+}
+
+static void trace_stat_update(struct trace_stat *stat, uint32_t cycles)
+{
+    stat->cnt++;
+    stat->total += cycles;
+    if (cycles > stat->max)
+        stat->max = cycles;
+}
+
+static void irqsoff_record(uintptr_t site, uint32_t cycles)
+{
+    if (cycles > irqsoff.max) {
+        irqsoff.max = cycles;
+        irqsoff.max_site = site;
+    }
+
+    /* Open addressing with linear probing, the return addresses are at
+     * least aligned to 2 bytes */
+    uint32_t idx = (site >> 1) % IRQSOFF_TRACE_SITES;
+
+    for (int i = 0; i < IRQSOFF_TRACE_SITES; i++) {
+        struct trace_stat *stat = &irqsoff.sites[idx];
+
+        if (stat->cnt == 0)
+            stat->site = site;
+
+        if (stat->site == site) {
+            trace_stat_update(stat, cycles);
+            return;
+        }
+
+        idx = (idx + 1) % IRQSOFF_TRACE_SITES;
+    }
+
+    irqsoff.dropped++;
+}
+
+void trace_preempt_off(uintptr_t site)
+{
+    if (site != TRACE_SITE_KERNEL && !trace_privileged())
+        return;
+
+    irqsoff.site = site;
+    irqsoff.tracing = true;
+    irqsoff.start = get_cycle_count();
+}
+
+void trace_preempt_on(void)
+{
+    if (!irqsoff.tracing)
+        return;
+
+    irqsoff.tracing = false;
+    irqsoff_record(irqsoff.site, get_cycle_count() - irqsoff.start);
+}
+
+void trace_irq_enter(void)
+{
+    /* Nested interrupts are balanced, so the depth is restored before the
+     * interrupted handler continues */
+    int depth = irqs.depth++;
+    if (depth < TRACE_IRQ_NEST_MAX)
+        irqs.start[depth] = get_cycle_count();
+}
+
+void trace_irq_exit(void)
+{
+    uint32_t now = get_cycle_count();
+    uint32_t irq = get_proc_mode();
+    int depth = --irqs.depth;
+
+    if (depth >= 0 && depth < TRACE_IRQ_NEST_MAX && irq < TRACE_IRQ_MAX)
+        trace_stat_update(&irqs.irqs[irq], now - irqs.start[depth]);
+}
+
+static uint32_t cycles_to_nsec(uint64_t cycles)
+{
+    return cycles * 1000000000ULL / get_cycle_freq();
+}
+
+static void trace_file_printf(struct trace_file *file, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(&file->buf[file->len], TRACE_BUF_SIZE - file->len, fmt, args);
+    va_end(args);
+
+    file->len += strlen(&file->buf[file->len]);
+}
+
+static void irqsoff_file_update(struct trace_file *file)
+{
+    uintptr_t max_site;
+    uint32_t max, dropped;
+
+    /* Copy the statistics to format them with the preemption enabled */
+    preempt_disable();
+    memcpy(irqsoff_snapshot, irqsoff.sites, sizeof(irqsoff_snapshot));
+    max_site = irqsoff.max_site;
+    max = irqsoff.max;
+    dropped = irqsoff.dropped;
+    preempt_enable();
+
+    /* Sort the call sites by the longest section */
+    for (int i = 1; i < IRQSOFF_TRACE_SITES; i++) {
+        struct trace_stat stat = irqsoff_snapshot[i];
+        int j = i - 1;
+
+        for (; j >= 0 && irqsoff_snapshot[j].max < stat.max; j--)
+            irqsoff_snapshot[j + 1] = irqsoff_snapshot[j];
+        irqsoff_snapshot[j + 1] = stat;
+    }
+
+    file->len = 0;
+    file->pos = 0;
+
+    trace_file_printf(file, "longest: %u ns at 0x%08x, %u dropped\n\r",
+                      (unsigned int) cycles_to_nsec(max),
+                      (unsigned int) max_site, (unsigned int) dropped);
+    trace_file_printf(file, "%10s %10s %10s  %s\n\r", "max(ns)", "avg(ns)",
+                      "count", "site");
+
+    for (int i = 0; i < IRQSOFF_TRACE_SITES; i++) {
+        struct trace_stat *stat = &irqsoff_snapshot[i];
+        if (stat->cnt == 0)
+            break;
+
+        char site[16];
+        if (stat->site == TRACE_SITE_KERNEL)
+            strncpy(site, "[kernel]", sizeof(site));
+        else
+            snprintf(site, sizeof(site), "0x%08x", (unsigned int) stat->site);
+
+        trace_file_printf(file, "%10u %10u %10u  %s\n\r",
+                          (unsigned int) cycles_to_nsec(stat->max),
+                          (unsigned int) cycles_to_nsec(stat->total / stat->cnt),
+                          (unsigned int) stat->cnt, site);
+    }
+}
+
+static void irqs_file_update(struct trace_file *file)
+{
+    file->len = 0;
+    file->pos = 0;
+
+    trace_file_printf(file, "%5s %10s %10s %10s\n\r", "irq", "max(ns)",
+                      "avg(ns)", "count");
+
+    for (int i = 0; i < TRACE_IRQ_MAX; i++) {
+        /* Copy the statistics of the interrupt with the preemption
+         * disabled, the entries are consistent individually */
+        preempt_disable();
+        struct trace_stat stat = irqs.irqs[i];
+        preempt_enable();
+
+        if (stat.cnt == 0)
+            continue;
+
+        /* Negative numbers are the system exceptions, e.g., -1 for the
+         * SysTick */
+        trace_file_printf(file, "%5d %10u %10u %10u\n\r",
+                          i - EXTERNAL_IRQ_OFFSET,
+                          (unsigned int) cycles_to_nsec(stat.max),
+                          (unsigned int) cycles_to_nsec(stat.total / stat.cnt),
+                          (unsigned int) stat.cnt);
+    }
+}
+
+static ssize_t trace_file_read(struct trace_file *file, char *buf, size_t size)
+{
+    if (file->pos >= file->len)
+        return 0;
+
+    size_t n = file->len - file->pos;
+    if (n > size)
+        n = size;
+
+    memcpy(buf, &file->buf[file->pos], n);
+    file->pos += n;
+
+    return n;
+}
+
+static off_t trace_file_lseek(struct trace_file *file, off_t offset, int whence)
+{
+    off_t pos;
+
+    switch (whence) {
+    case SEEK_SET:
+        pos = offset;
+        break;
+    case SEEK_CUR:
+        pos = file->pos + offset;
+        break;
+    case SEEK_END:
+        pos = file->len + offset;
+        break;
+    default:
+        return -EINVAL;
+    }
+
+    if (pos < 0 || pos > (off_t) file->len)
+        return -EINVAL;
+
+    file->pos = pos;
+
+    return pos;
+}
+
+static int irqsoff_proc_open(struct inode *inode, struct file *file)
+{
+    /* The text is generated once per open */
+    irqsoff_file_update(&irqsoff_file);
+    inode->i_size = irqsoff_file.len;
+    return 0;
+}
+
+static ssize_t irqsoff_proc_read(struct file *filp,
+                                 char *buf,
+                                 size_t size,
+                                 off_t offset)
+{
+    return trace_file_read(&irqsoff_file, buf, size);
+}
+
+static ssize_t irqsoff_proc_write(struct file *filp,
+                                  const char *buf,
+                                  size_t size,
+                                  off_t offset)
+{
+    /* Writing anything resets the statistics */
+    preempt_disable();
+    memset(irqsoff.sites, 0, sizeof(irqsoff.sites));
+    irqsoff.dropped = 0;
+    irqsoff.max = 0;
+    irqsoff.max_site = 0;
+    preempt_enable();
+
+    return size;
+}
+
+static off_t irqsoff_proc_lseek(struct file *filp, off_t offset, int whence)
+{
+    return trace_file_lseek(&irqsoff_file, offset, whence);
+}
+
+static int irqs_proc_open(struct inode *inode, struct file *file)
+{
+    irqs_file_update(&irqs_file);
+    inode->i_size = irqs_file.len;
+    return 0;
+}
+
+static ssize_t irqs_proc_read(struct file *filp,
+                              char *buf,
+                              size_t size,
+                              off_t offset)
+{
+    return trace_file_read(&irqs_file, buf, size);
+}
+
+static ssize_t irqs_proc_write(struct file *filp,
+                               const char *buf,
+                               size_t size,
+                               off_t offset)
+{
+    preempt_disable();
+    memset(irqs.irqs, 0, sizeof(irqs.irqs));
+    preempt_enable();
+
+    return size;
+}
+
+static off_t irqs_proc_lseek(struct file *filp, off_t offset, int whence)
+{
+    return trace_file_lseek(&irqs_file, offset, whence);
+}
+
+static struct file_operations irqsoff_proc_ops = {
+    .lseek = irqsoff_proc_lseek,
+    .read = irqsoff_proc_read,
+    .write = irqsoff_proc_write,
+    .open = irqsoff_proc_open,
+};
+
+static struct file_operations irqs_proc_ops = {
+    .lseek = irqs_proc_lseek,
+    .read = irqs_proc_read,
+    .write = irqs_proc_write,
+    .open = irqs_proc_open,
+};
+
+void trace_init(void)
+{
+    register_proc_file("irqsoff", &irqsoff_proc_ops);
+    register_proc_file("interrupts", &irqs_proc_ops);
+}
+
+#endif
@@ -10,6 +10,8 @@ LD_GENERATED := generated.ld
 
 ST_LIB := ./lib/STM32F4xx_StdPeriph_Driver
 
+ARCH := armv7m
+
 include ./makefiles/$(PLATFORM).mk
 
 MSG_DIR   := ./msg
@@ -18,12 +20,15 @@ MSG_BUILD := ./build/msg
 LDFLAGS += -Wl,--no-warn-rwx-segments
 LDFLAGS += -lm
 
-CFLAGS += -O2 -g -mlittle-endian -mthumb \
-          -fcommon \
+CFLAGS += -O2 -g -fcommon
+
+ifeq ($(ARCH),armv7m)
+CFLAGS += -mlittle-endian -mthumb \
           -mcpu=cortex-m4 \
           -mfpu=fpv4-sp-d16 -mfloat-abi=hard \
           --specs=nano.specs \
           --specs=nosys.specs
+endif
 
 CFLAGS += -Wall \
           -Werror=undef \
@@ -32,6 +37,7 @@ CFLAGS += -Wall \
           -Wno-address-of-packed-member \
           -Wno-array-bounds # FIXME
 
+ifeq ($(ARCH),armv7m)
 CFLAGS += -D USE_STDPERIPH_DRIVER \
           -D STM32F4xx \
           -D ARM_MATH_CM4 \
@@ -39,6 +45,7 @@ CFLAGS += -D USE_STDPERIPH_DRIVER \
           -D __FPU_USED=1
 
 CFLAGS += -Wl,-T,$(LD_GENERATED)
+endif
 
 USER = $(shell whoami)
 CFLAGS += -D__USER_NAME__=\"$(USER)\"
@@ -46,9 +53,11 @@ CFLAGS += -D__USER_NAME__=\"$(USER)\"
 REVISION = $(shell git rev-parse --short=10 HEAD)
 CFLAGS += -D__REVISION__=\"$(REVISION)\"
 
+ifeq ($(ARCH),armv7m)
 CFLAGS += -I./lib/CMSIS/ST/STM32F4xx/Include
 CFLAGS += -I./lib/CMSIS/Include
 CFLAGS += -I$(ST_LIB)/inc
+endif
 
 CFLAGS += -I./lib/mavlink
 CFLAGS += -I./lib/mavlink/common
@@ -67,6 +76,7 @@ CFLAGS += -I./user
 CFLAGS += -I./user/debug-link
 CFLAGS += -I./build/msg
 
+ifeq ($(ARCH),armv7m)
 SRC += lib/CMSIS/DSP_Lib/Source/CommonTables/arm_common_tables.c \
        lib/CMSIS/DSP_Lib/Source/FastMathFunctions/arm_cos_f32.c \
        lib/CMSIS/DSP_Lib/Source/FastMathFunctions/arm_sin_f32.c \
@@ -97,13 +107,23 @@ SRC += $(ST_LIB)/src/misc.c \
        $(ST_LIB)/src/stm32f4xx_syscfg.c \
        $(ST_LIB)/src/stm32f4xx_exti.c
 
-SRC += ./kernel/arch/v7m_port.c \
-       ./kernel/fs/fs.c \
+SRC += ./kernel/arch/v7m_port.c
+
+ASM := ./kernel/arch/v7m_entry.S \
+       ./platform/startup_stm32f4xx.s
+else
+SRC += ./kernel/arch/host_port.c
+
+ASM := ./kernel/arch/host_entry.S
+endif
+
+SRC += ./kernel/fs/fs.c \
        ./kernel/fs/vfs.c \
        ./kernel/fs/wrapper.c \
        ./kernel/fs/reg_file.c \
        ./kernel/fs/rom_dev.c \
        ./kernel/fs/null_dev.c \
+       ./kernel/fs/log_dev.c \
        ./kernel/mm/mpool.c \
        ./kernel/mm/mm.c \
        ./kernel/mm/page.c \
@@ -113,6 +133,7 @@ SRC += ./kernel/arch/v7m_port.c \
        ./kernel/task.c \
        ./kernel/sched.c \
        ./kernel/file.c \
+       ./kernel/epoll.c \
        ./kernel/pipe.c \
        ./kernel/mqueue.c \
        ./kernel/mutex.c \
@@ -120,14 +141,21 @@ SRC += ./kernel/arch/v7m_port.c \
        ./kernel/pthread.c \
        ./kernel/signal.c \
        ./kernel/time.c \
+       ./kernel/timerfd.c \
        ./kernel/printf.c \
        ./kernel/printk.c \
        ./kernel/softirq.c \
+       ./kernel/profiler.c \
+       ./kernel/trace.c \
+       ./kernel/syscall_stat.c \
+       ./kernel/sim_time.c \
        ./main.c
 
 SRC += ./user/debug-link/debug_link.c 
 
+ifeq ($(ARCH),armv7m)
 -include ./drivers/drivers.mk
+endif
 -include ./user/shell/shell.mk
 -include ./user/mavlink/mavlink.mk
 -include ./user/benchmarks/benchmarks.mk
@@ -137,16 +165,28 @@ OBJS += ./tools/mkromfs/romfs.o
 
 DEPEND = $(SRC:.c=.d)
 
-ASM := ./kernel/arch/v7m_entry.S \
-       ./platform/startup_stm32f4xx.s
-
 all: gen_syscalls msggen $(LD_GENERATED) $(ELF)
-	@$(MAKE) -C ./tools/mkromfs/ -f Makefile
-
+	@$(MAKE) -C ./tools/mkromfs/ -f Makefile ARCH=$(ARCH)
+
+ifeq ($(ARCH),host)
+# Link the kernel into a relocatable image with the private symbols
+# localized, then link the image with the host startup code
+$(ELF): $(ASM) $(OBJS) $(HOST_SRC)
+	@echo "LD" $(PROJECT).o
+	@$(CC) $(CFLAGS) -nostdlib -r -Wl,-d $(OBJS) $(ASM) -o $(PROJECT).o
+	@$(OBJCOPY) --redefine-sym main=tenok_main \
+	 $(addprefix --keep-global-symbol=,$(HOST_SYMS)) $(PROJECT).o
+	@echo "LD" $@
+	@$(CC) $(HOST_CFLAGS) $(PROJECT).o $(HOST_SRC) \
+	 -Wl,-T,$(LD_GENERATED) $(LDFLAGS) -o $@
+	@rm $(PROJECT).o
+	@rm $(LD_GENERATED)
+else
 $(ELF): $(ASM) $(OBJS)
 	@echo "LD" $@
 	@$(CC) $(CFLAGS) $(OBJS) $(ASM) $(LDFLAGS) -o $@
 	@rm $(LD_GENERATED)
+endif
 
 $(BIN): $(ELF)
 	@echo "OBJCPY" $@
@@ -158,7 +198,7 @@ gen_syscalls:
 -include $(DEPEND)
 
 tools/mkromfs/romfs.o:
-	@$(MAKE) -C ./tools/mkromfs/ -f Makefile
+	@$(MAKE) -C ./tools/mkromfs/ -f Makefile ARCH=$(ARCH)
 
 $(LD_GENERATED): $(LD_SCRIPT) 
 	@echo "CC" $< ">" $@
@@ -189,6 +229,7 @@ msggen:
 	mkdir -p $(MSG_BUILD)
 	@echo "msggen" $(MSG_DIR) $(MSG_BUILD)
 	@./tools/msggen/msggen $(MSG_DIR) $(MSG_BUILD)
+	@$(MAKE) -C ./tools/msggen/ -f Makefile decoder
 
 gdbauto:
 	cgdb -d $(GDB) -x ./gdb/openocd_gdb.gdb
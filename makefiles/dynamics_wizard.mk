@@ -28,6 +28,7 @@ SRC += ./user/quadrotor/quadrotor.c
 SRC += ./user/quadrotor/shell.c
 
 include ./user/navigation/navigation.mk
+include ./user/logger/logger.mk
 
 flash:
 	openocd -f interface/stlink.cfg \
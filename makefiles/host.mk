@@ -0,0 +1,53 @@
+# POSIX host port, runs the kernel as a Linux process (i386 as the kernel
+# assumes 32-bit pointers, install gcc-multilib on the x86_64 hosts)
+
+ARCH := host
+
+CC := gcc
+OBJCOPY := objcopy
+OBJDUMP := objdump
+GDB := gdb
+SIZE := size
+
+LD_SCRIPT += platform/host.ld
+
+CFLAGS += -m32 -mstackrealign -fno-pie \
+          -fno-stack-protector \
+          -fno-builtin-printf \
+          -fno-builtin-fprintf
+
+# The uint32_t of the glibc is unsigned int instead of unsigned long
+CFLAGS += -Wno-incompatible-pointer-types
+
+CFLAGS += -D BUILD_HOST \
+          -D __ARCH__=\"i386\" \
+          -D __BOARD_NAME__=\"host\"
+
+CFLAGS += -I./drivers/boards
+CFLAGS += -I./user/tasks
+
+# The startup code is built against the C library of the host
+HOST_CFLAGS := -m32 -O2 -g -Wall -no-pie -I./include
+HOST_SRC := ./platform/host_startup.c
+
+# Entries of the kernel image called by the startup code, the other symbols
+# are localized to avoid the conflicts with the C library of the host
+HOST_SYMS := main tenok_main __host_irq_entry
+
+# Board specific driver
+SRC += ./drivers/boards/host.c
+
+# Example tasks
+SRC += ./user/tasks/shell_task.c
+#SRC += ./user/tasks/examples/semaphore.c
+#SRC += ./user/tasks/examples/priority-inversion.c
+#SRC += ./user/tasks/examples/signal-ex.c
+#SRC += ./user/tasks/examples/timer-ex.c
+#SRC += ./user/tasks/examples/poll-ex.c
+#SRC += ./user/tasks/examples/pthread-ex.c
+
+# Quit with `Ctrl+a x`
+host: all
+	./$(ELF)
+
+.PHONY: host
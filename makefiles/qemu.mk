@@ -34,6 +34,22 @@ SRC += ./user/tasks/mavlink_task.c
 #SRC += ./user/tasks/examples/poll-ex.c
 #SRC += ./user/tasks/examples/pthread-ex.c
 
+# The stress scenarios are built in for `make stress`
+ifneq ($(filter stress,$(MAKECMDGOALS)),)
+STRESS := 1
+endif
+
+# Scenarios and thresholds of `make stress`
+STRESS_CONF ?= ./user/benchmarks/stress/stress.conf
+
+# Extra options of scripts/stress.py, e.g., `--suggest` to print the
+# thresholds derived from the results
+STRESS_FLAGS ?=
+
+# The instruction counter drives the virtual clock so the results do not
+# depend on the load of the host
+STRESS_ICOUNT ?= shift=3,align=off,sleep=off
+
 # Some useful qemu debug options.
 # Type `$(QEMU) -d help` for more information.
 # QEMU_DEBUG = -d in_asm
@@ -53,4 +69,17 @@ qemu: all
 	-gdb tcp::3333 \
 	-kernel ./$(ELF)
 
-.PHONY: qemu
+stress: all
+	./scripts/stress.py --config $(STRESS_CONF) $(STRESS_FLAGS) -- \
+	$(QEMU) \
+	-display none \
+	-monitor none \
+	-cpu cortex-m4 \
+	-M netduinoplus2 \
+	-icount $(STRESS_ICOUNT) \
+	-serial stdio \
+	-serial null \
+	-serial null \
+	-kernel ./$(ELF)
+
+.PHONY: qemu stress
@@ -0,0 +1,304 @@
+/* Startup of the host port. The file is built against the C library of
+ * the host and is linked with the kernel image, of which all symbols except
+ * the entries declared in the arch/host.h are localized */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <termios.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include <arch/host.h>
+
+#define CTRL_A 1
+
+static volatile sig_atomic_t irq_masked = 1;
+static volatile sig_atomic_t irq_active;
+static volatile sig_atomic_t irq_pending;
+static volatile sig_atomic_t irq_sources;
+static volatile unsigned long irq_pc;
+static volatile bool irq_pc_masked;
+
+static timer_t oneshot_timer;
+
+static struct termios term_saved;
+static bool term_raw;
+static bool console_escape;
+
+/* Signals are handled on a dedicated stack as the thread stacks are small */
+static char signal_stack[65536];
+
+void host_irq_disable(void)
+{
+    irq_masked = 1;
+}
+
+void host_irq_enable(void)
+{
+    irq_masked = 0;
+
+    /* Serve the tick that arrived while the interrupts are masked */
+    if (irq_pending && !irq_active) {
+        irq_pending = 0;
+        irq_active = 1;
+        irq_pc = (unsigned long) __builtin_return_address(0);
+        irq_pc_masked = true;
+        __host_irq_entry();
+    }
+}
+
+bool host_irq_active(void)
+{
+    return irq_active;
+}
+
+unsigned long host_irq_pc(bool *masked)
+{
+    *masked = irq_pc_masked;
+    return irq_pc;
+}
+
+void host_irq_return(void)
+{
+    irq_active = 0;
+}
+
+unsigned int host_irq_take(void)
+{
+    sigset_t set, old;
+    sigemptyset(&set);
+    sigaddset(&set, SIGALRM);
+    sigaddset(&set, SIGRTMIN);
+
+    /* The signals are not masked in the interrupt context */
+    sigprocmask(SIG_BLOCK, &set, &old);
+    unsigned int sources = irq_sources;
+    irq_sources = 0;
+    sigprocmask(SIG_SETMASK, &old, NULL);
+
+    return sources;
+}
+
+static void irq_raise(int source, void *ucontext)
+{
+    irq_sources |= source;
+
+    if (irq_masked || irq_active) {
+        irq_pending = 1;
+        return;
+    }
+
+    irq_active = 1;
+
+    /* Emulate the exception entry by pushing the interrupted address on the
+     * interrupted stack and resuming at the interrupt entry of the kernel */
+    greg_t *gregs = ((ucontext_t *) ucontext)->uc_mcontext.gregs;
+    irq_pc = gregs[REG_EIP];
+    irq_pc_masked = false;
+
+    uint32_t *sp = (uint32_t *) gregs[REG_ESP];
+    *--sp = gregs[REG_EIP];
+    gregs[REG_ESP] = (greg_t) sp;
+    gregs[REG_EIP] = (greg_t) __host_irq_entry;
+}
+
+static void tick_handler(int sig, siginfo_t *info, void *ucontext)
+{
+    irq_raise(HOST_IRQ_TICK, ucontext);
+}
+
+static void oneshot_handler(int sig, siginfo_t *info, void *ucontext)
+{
+    irq_raise(HOST_IRQ_ONESHOT, ucontext);
+}
+
+void host_timer_start(unsigned int freq)
+{
+    /* The interrupt signals never nest */
+    struct sigaction sa = {
+        .sa_sigaction = tick_handler,
+        .sa_flags = SA_SIGINFO | SA_ONSTACK | SA_RESTART,
+    };
+    sigemptyset(&sa.sa_mask);
+    sigaddset(&sa.sa_mask, SIGRTMIN);
+    sigaction(SIGALRM, &sa, NULL);
+
+    sa.sa_sigaction = oneshot_handler;
+    sigemptyset(&sa.sa_mask);
+    sigaddset(&sa.sa_mask, SIGALRM);
+    sigaction(SIGRTMIN, &sa, NULL);
+
+    struct sigevent sev = {
+        .sigev_notify = SIGEV_SIGNAL,
+        .sigev_signo = SIGRTMIN,
+    };
+    timer_create(CLOCK_MONOTONIC, &sev, &oneshot_timer);
+
+    long period_usec = 1000000 / freq;
+    struct itimerval timer = {
+        .it_interval = {.tv_sec = 0, .tv_usec = period_usec},
+        .it_value = {.tv_sec = 0, .tv_usec = period_usec},
+    };
+    setitimer(ITIMER_REAL, &timer, NULL);
+}
+
+void host_oneshot_start(uint64_t nsec)
+{
+    /* A zero expiration disarms the timer */
+    if (nsec == 0)
+        nsec = 1;
+
+    struct itimerspec its = {
+        .it_value = {.tv_sec = nsec / 1000000000ULL,
+                     .tv_nsec = nsec % 1000000000ULL},
+    };
+    timer_settime(oneshot_timer, 0, &its, NULL);
+}
+
+void host_oneshot_cancel(void)
+{
+    struct itimerspec its = {0};
+    timer_settime(oneshot_timer, 0, &its, NULL);
+}
+
+uint64_t host_clock_nsec(void)
+{
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return (uint64_t) tp.tv_sec * 1000000000ULL + tp.tv_nsec;
+}
+
+int host_console_read(char *buf, size_t size)
+{
+    struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN};
+    if (poll(&pfd, 1, 0) <= 0 || !(pfd.revents & POLLIN))
+        return 0;
+
+    ssize_t n = read(STDIN_FILENO, buf, size);
+    if (n <= 0)
+        return 0;
+
+    /* Filter the escape sequences like the QEMU monitor: Ctrl+a x quits
+     * and Ctrl+a Ctrl+a sends a single Ctrl+a */
+    int len = 0;
+    for (ssize_t i = 0; i < n; i++) {
+        char c = buf[i];
+
+        if (console_escape) {
+            console_escape = false;
+            if (c == 'x')
+                host_exit(0);
+            if (c != CTRL_A)
+                continue;
+        } else if (c == CTRL_A && term_raw) {
+            console_escape = true;
+            continue;
+        } else if (c == '\n' && !term_raw) {
+            /* Lines from a pipe are terminated like the serial terminal */
+            c = '\r';
+        }
+
+        buf[len++] = c;
+    }
+
+    return len;
+}
+
+void host_console_write(const char *buf, size_t size)
+{
+    while (size > 0) {
+        ssize_t n = write(STDOUT_FILENO, buf, size);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+
+        buf += n;
+        size -= n;
+    }
+}
+
+void host_wait_for_interrupt(void)
+{
+    pause();
+}
+
+void host_exit(int status)
+{
+    exit(status);
+}
+
+static void console_restore(void)
+{
+    if (term_raw)
+        tcsetattr(STDIN_FILENO, TCSANOW, &term_saved);
+}
+
+static void console_init(void)
+{
+    if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &term_saved) < 0)
+        return;
+
+    /* Pass every key to the shell as a serial terminal does */
+    struct termios term = term_saved;
+    cfmakeraw(&term);
+    tcsetattr(STDIN_FILENO, TCSANOW, &term);
+
+    term_raw = true;
+    atexit(console_restore);
+}
+
+static void fault_handler(int sig, siginfo_t *info, void *ucontext)
+{
+    greg_t *gregs = ((ucontext_t *) ucontext)->uc_mcontext.gregs;
+
+    char msg[128];
+    int len = snprintf(msg, sizeof(msg),
+                       "\n\r%s: faulting instruction address = 0x%08x, "
+                       "address = %p\n\r",
+                       strsignal(sig), (unsigned int) gregs[REG_EIP],
+                       info->si_addr);
+    write(STDERR_FILENO, msg, len);
+
+    console_restore();
+    _exit(EXIT_FAILURE);
+}
+
+static void faults_init(void)
+{
+    struct sigaction sa = {
+        .sa_sigaction = fault_handler,
+        .sa_flags = SA_SIGINFO | SA_ONSTACK,
+    };
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGSEGV, &sa, NULL);
+    sigaction(SIGBUS, &sa, NULL);
+    sigaction(SIGILL, &sa, NULL);
+    sigaction(SIGFPE, &sa, NULL);
+}
+
+int main(void)
+{
+    stack_t ss = {
+        .ss_sp = signal_stack,
+        .ss_size = sizeof(signal_stack),
+    };
+    sigaltstack(&ss, NULL);
+
+    faults_init();
+    console_init();
+
+    /* Start the kernel */
+    return tenok_main();
+}
@@ -48,7 +48,6 @@ syscalls = \
      'pthread_exit',
      'pthread_mutex_unlock',
      'pthread_mutex_lock',
-     'pthread_mutex_trylock',
      'pthread_mutex_timedlock',
      'pthread_cond_signal',
      'pthread_cond_broadcast',
@@ -75,7 +74,17 @@ syscalls = \
      'mq_timedsend',
      'mq_timedreceive',
      'malloc',
-     'free']
+     'free',
+     'epoll_create',
+     'epoll_ctl',
+     'epoll_wait',
+     'delay_until',
+     'timerfd_create',
+     'timerfd_settime',
+     'timerfd_gettime',
+     'timer_getoverrun',
+     'sigqueue',
+     'getcycles']
 
 reserved_events = [
     'SYSCALL_RETURN_EVENT',
@@ -121,5 +130,13 @@ for i in range(0, syscall_cnt):
     else:
         print('    DEF_SYSCALL(%s, %s), \\' % (syscall, id))
 
+print('#define SYSCALL_NAME_INIT \\')
+
+for i in range(0, syscall_cnt):
+    if i == syscall_cnt - 1:
+        print('    "%s" \\\n' % (syscalls[i]))
+    else:
+        print('    "%s", \\' % (syscalls[i]))
+
 print('#endif')
 print('/* clang-format on */')
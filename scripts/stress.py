@@ -0,0 +1,257 @@
+#!/usr/bin/env python3
+
+# Headless stress test runner. The emulator command is given after the
+# options (see the `stress` target of makefiles/qemu.mk). The runner waits
+# for the shell, executes the scenarios of the configuration file with the
+# `stress` command and compares the results against the thresholds.
+#
+# The `warn` lines are checked like the `check` lines but only reported,
+# for the thresholds not yet measured on a known-good build.
+#
+# Exit status: 0 if all checks pass, 1 if any check fails, 2 if the
+# scenarios cannot be executed.
+
+import argparse
+import operator
+import os
+import re
+import select
+import subprocess
+import sys
+import time
+
+PROMPT = '$ '
+
+RESULT_RE = re.compile(r'stress,([^,]+),([^,]+)(?:,([^,]*))?(?:,([^,]*))?')
+
+OPS = {
+    '<=': operator.le,
+    '<': operator.lt,
+    '>=': operator.ge,
+    '>': operator.gt,
+    '==': operator.eq,
+}
+
+
+class HarnessError(Exception):
+    pass
+
+
+def parse_config(path):
+    runs = []
+    checks = []
+
+    with open(path) as f:
+        for lineno, line in enumerate(f, 1):
+            fields = line.split('#', 1)[0].split()
+            if not fields:
+                continue
+
+            where = '%s:%d' % (path, lineno)
+
+            if fields[0] == 'run' and len(fields) >= 3:
+                runs.append((fields[1], fields[2:]))
+            elif fields[0] in ('check', 'warn') and len(fields) == 4:
+                label, _, metric = fields[1].partition('.')
+                if not metric or fields[2] not in OPS:
+                    raise HarnessError('%s: invalid check' % where)
+                gating = fields[0] == 'check'
+                checks.append((label, metric, fields[2], int(fields[3]),
+                               gating))
+            else:
+                raise HarnessError('%s: invalid line' % where)
+
+    return runs, checks
+
+
+class Console:
+    def __init__(self, proc, verbose):
+        self.proc = proc
+        self.fd = proc.stdout.fileno()
+        self.buf = ''
+        self.verbose = verbose
+
+    def write(self, text):
+        self.proc.stdin.write(text.encode())
+        self.proc.stdin.flush()
+
+    def wait_for(self, match, timeout, partial=False):
+        """Read the console until match() holds for a line, or for the
+        incomplete line if partial is set (e.g., the prompt)"""
+        deadline = time.monotonic() + timeout
+
+        while True:
+            while '\n' in self.buf:
+                line, self.buf = self.buf.split('\n', 1)
+                line = line.strip('\r')
+                if self.verbose:
+                    print(line)
+                if match(line):
+                    return line
+
+            if partial and match(self.buf):
+                return self.buf
+
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                raise HarnessError('timeout')
+
+            ready, _, _ = select.select([self.fd], [], [], remaining)
+            if not ready:
+                continue
+
+            data = os.read(self.fd, 4096)
+            if not data:
+                raise HarnessError('emulator exited')
+            self.buf += data.decode('ascii', 'replace')
+
+
+def run_scenario(console, label, args, timeout):
+    results = {}
+    status = {}
+
+    def match(line):
+        m = RESULT_RE.search(line)
+        if not m:
+            return False
+
+        metric = m.group(2)
+        if metric == 'done':
+            return True
+        if metric == 'error':
+            status['error'] = m.group(3)
+            return True
+
+        try:
+            results[metric] = (int(m.group(3)), m.group(4) or '')
+        except (TypeError, ValueError):
+            pass
+        return False
+
+    console.write('stress %s\r' % ' '.join(args))
+    console.wait_for(match, timeout)
+
+    # Drain the output until the next prompt
+    console.wait_for(lambda line: line.endswith(PROMPT), timeout, True)
+
+    if 'error' in status:
+        raise HarnessError('%s: %s' % (label, status['error']))
+
+    return results
+
+
+# Margins of the suggested thresholds over the measured baseline
+LATENCY_MARGIN = 1.25
+THROUGHPUT_MARGIN = 0.8
+
+
+def suggest(label, metric, value):
+    """Thresholds of the measured result plus a small margin"""
+    if metric.startswith('lat_'):
+        # Round up to microseconds
+        return '<=', -(-int(value * LATENCY_MARGIN) // 1000) * 1000
+    if metric == 'throughput':
+        return '>=', int(value * THROUGHPUT_MARGIN)
+    if metric in ('errors', 'inversions', 'overruns', 'samples'):
+        return '==', value
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Run the stress scenarios on the emulator')
+    parser.add_argument('--config', required=True,
+                        help='scenarios and thresholds')
+    parser.add_argument('--boot-timeout', type=float, default=60,
+                        help='seconds to wait for the shell')
+    parser.add_argument('--timeout', type=float, default=600,
+                        help='seconds to wait for each scenario')
+    parser.add_argument('--output', help='save the results as a CSV file')
+    parser.add_argument('--suggest', action='store_true',
+                        help='print the thresholds derived from the results')
+    parser.add_argument('--verbose', action='store_true',
+                        help='print the console output')
+    parser.add_argument('command', nargs=argparse.REMAINDER,
+                        help='emulator command')
+    args = parser.parse_args()
+
+    command = args.command
+    if command and command[0] == '--':
+        command = command[1:]
+    if not command:
+        parser.error('the emulator command is missing')
+
+    try:
+        runs, checks = parse_config(args.config)
+    except (OSError, HarnessError) as e:
+        print('stress: %s' % e, file=sys.stderr)
+        return 2
+
+    proc = subprocess.Popen(command, stdin=subprocess.PIPE,
+                            stdout=subprocess.PIPE)
+    console = Console(proc, args.verbose)
+    results = {}
+
+    try:
+        console.wait_for(lambda line: line.endswith(PROMPT),
+                         args.boot_timeout, True)
+
+        for label, run_args in runs:
+            print('stress: run %s (%s)' % (label, ' '.join(run_args)))
+            start = time.monotonic()
+            results[label] = run_scenario(console, label, run_args,
+                                          args.timeout)
+            print('stress: %s finished in %.1f s' %
+                  (label, time.monotonic() - start))
+    except HarnessError as e:
+        print('stress: %s' % e, file=sys.stderr)
+        return 2
+    finally:
+        proc.terminate()
+        try:
+            proc.wait(timeout=5)
+        except subprocess.TimeoutExpired:
+            proc.kill()
+
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write('label,metric,value,unit\n')
+            for label, metrics in results.items():
+                for metric, (value, unit) in metrics.items():
+                    f.write('%s,%s,%d,%s\n' % (label, metric, value, unit))
+
+    failed = 0
+    warned = 0
+    for label, metric, op, limit, gating in checks:
+        if label not in results or metric not in results[label]:
+            verdict = 'MISSING'
+            value = '-'
+        else:
+            value = results[label][metric][0]
+            verdict = 'PASS' if OPS[op](value, limit) else 'FAIL'
+
+        if verdict != 'PASS' and gating:
+            failed += 1
+        elif verdict != 'PASS':
+            verdict = 'WARN'
+            warned += 1
+
+        print('%-7s %-28s %12s %2s %d' %
+              (verdict, label + '.' + metric, value, op, limit))
+
+    if args.suggest:
+        print()
+        for label, metrics in results.items():
+            for metric, (value, _) in metrics.items():
+                threshold = suggest(label, metric, value)
+                if threshold:
+                    print('check %s.%s %s %d' % ((label, metric) + threshold))
+
+    print('stress: %d of %d checks failed, %d unvalidated checks warned' %
+          (failed, len(checks), warned))
+
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,195 @@
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "forward.h"
+
+#define MAVLINK_V1_MAGIC 0xfe
+#define MAVLINK_V2_MAGIC 0xfd
+#define MAVLINK_V1_OVERHEAD 8  /* Header (6) and checksum (2) */
+#define MAVLINK_V2_OVERHEAD 12 /* Header (10) and checksum (2) */
+#define MAVLINK_SIGNATURE_SIZE 13
+#define MAVLINK_IFLAG_SIGNED 0x01
+
+uint64_t forward_now_us(void)
+{
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return (uint64_t) tp.tv_sec * 1000000 + tp.tv_nsec / 1000;
+}
+
+/* Returns the size of the frame, 0 if incomplete, or -1 if the byte does not
+ * start a frame */
+static int mavlink_frame_size(const uint8_t *data, size_t size)
+{
+    switch (data[0]) {
+    case MAVLINK_V1_MAGIC:
+        if (size < 2)
+            return 0;
+        return MAVLINK_V1_OVERHEAD + data[1];
+    case MAVLINK_V2_MAGIC: {
+        if (size < 3)
+            return 0;
+
+        int frame_size = MAVLINK_V2_OVERHEAD + data[1];
+        if (data[2] & MAVLINK_IFLAG_SIGNED)
+            frame_size += MAVLINK_SIGNATURE_SIZE;
+        return frame_size;
+    }
+    default:
+        return -1;
+    }
+}
+
+/* Advance the flushing point over the complete frames, the bytes outside of
+ * the frames are forwarded as they are */
+static void forward_scan(struct forward *fwd)
+{
+    size_t pos = fwd->flush_end;
+
+    while (pos < fwd->tail) {
+        size_t avail = fwd->tail - pos;
+        int size = mavlink_frame_size(&fwd->buf[pos], avail);
+        if (size < 0) {
+            pos++;
+            continue;
+        }
+
+        /* Hold the incomplete frame */
+        if (size == 0 || (size_t) size > avail)
+            break;
+
+        pos += size;
+        fwd->stats.frames++;
+    }
+
+    fwd->flush_end = pos;
+}
+
+void forward_init(struct forward *fwd, const char *name, int in_fd, int out_fd)
+{
+    memset(fwd, 0, sizeof(*fwd));
+    fwd->name = name;
+    fwd->in_fd = in_fd;
+    fwd->out_fd = out_fd;
+}
+
+bool forward_can_read(struct forward *fwd)
+{
+    return !fwd->eof && (fwd->tail < FORWARD_BUF_SIZE || fwd->head > 0);
+}
+
+bool forward_has_output(struct forward *fwd)
+{
+    return fwd->flush_end > fwd->head;
+}
+
+bool forward_is_held(struct forward *fwd)
+{
+    return fwd->tail > fwd->flush_end;
+}
+
+int forward_read(struct forward *fwd)
+{
+    /* Move the pending bytes to the front */
+    if (fwd->tail == FORWARD_BUF_SIZE && fwd->head > 0) {
+        memmove(fwd->buf, &fwd->buf[fwd->head], fwd->tail - fwd->head);
+        fwd->tail -= fwd->head;
+        fwd->flush_end -= fwd->head;
+        fwd->head = 0;
+    }
+
+    ssize_t n =
+        read(fwd->in_fd, &fwd->buf[fwd->tail], FORWARD_BUF_SIZE - fwd->tail);
+    if (n == 0) {
+        fwd->eof = true;
+        return 0;
+    } else if (n < 0) {
+        return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+    }
+
+    uint64_t now = forward_now_us();
+    if (fwd->head == fwd->tail)
+        fwd->pending_since = now;
+    fwd->last_read = now;
+
+    fwd->tail += n;
+    fwd->stats.bytes += n;
+    fwd->stats.reads++;
+
+    forward_scan(fwd);
+
+    return n;
+}
+
+int forward_write(struct forward *fwd, bool force)
+{
+    /* Write the complete frames only unless forced */
+    size_t end = force ? fwd->tail : fwd->flush_end;
+    if (end == fwd->head)
+        return 0;
+
+    ssize_t n = write(fwd->out_fd, &fwd->buf[fwd->head], end - fwd->head);
+    if (n < 0)
+        return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+
+    uint64_t latency = forward_now_us() - fwd->pending_since;
+    fwd->stats.writes++;
+    fwd->stats.latency_sum += latency;
+    fwd->stats.latency_cnt++;
+    if (latency > fwd->stats.latency_max)
+        fwd->stats.latency_max = latency;
+    if (latency > fwd->latency_max)
+        fwd->latency_max = latency;
+
+    fwd->head += n;
+    if (fwd->flush_end < fwd->head)
+        fwd->flush_end = fwd->head;
+
+    if (fwd->head == fwd->tail) {
+        fwd->head = fwd->flush_end = fwd->tail = 0;
+    } else {
+        /* The remaining bytes arrived by the last read at the latest */
+        fwd->pending_since = fwd->last_read;
+    }
+
+    return n;
+}
+
+void forward_report(struct forward *fwd,
+                    struct forward_stats *last,
+                    double interval)
+{
+    struct forward_stats *stats = &fwd->stats;
+    uint64_t frames = stats->frames - last->frames;
+    uint64_t writes = stats->writes - last->writes;
+    uint64_t latency_cnt = stats->latency_cnt - last->latency_cnt;
+    uint64_t latency_sum = stats->latency_sum - last->latency_sum;
+
+    printf(
+        "[%s] %.1f KB/s, %.1f frames/s, %.2f writes/frame, "
+        "latency avg %.1f us max %lu us\n",
+        fwd->name, (stats->bytes - last->bytes) / interval / 1000.0,
+        frames / interval, frames ? (double) writes / frames : 0.0,
+        latency_cnt ? (double) latency_sum / latency_cnt : 0.0,
+        (unsigned long) fwd->latency_max);
+
+    *last = *stats;
+    fwd->latency_max = 0;
+}
+
+void forward_summary(struct forward *fwd, double elapsed)
+{
+    struct forward_stats *stats = &fwd->stats;
+
+    printf(
+        "[%s] %lu bytes, %lu frames, %lu reads, %lu writes in %.1f s, "
+        "latency avg %.1f us max %lu us\n",
+        fwd->name, (unsigned long) stats->bytes, (unsigned long) stats->frames,
+        (unsigned long) stats->reads, (unsigned long) stats->writes, elapsed,
+        stats->latency_cnt ? (double) stats->latency_sum / stats->latency_cnt
+                           : 0.0,
+        (unsigned long) stats->latency_max);
+}
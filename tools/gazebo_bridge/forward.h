@@ -0,0 +1,56 @@
+#ifndef __FORWARD_H__
+#define __FORWARD_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FORWARD_BUF_SIZE 65536
+
+/* Incomplete MAVLink frames are held back for at most this long, so the bytes
+ * that only look like a frame header are not stuck */
+#define FORWARD_HOLD_TIMEOUT_US 5000
+
+struct forward_stats {
+    uint64_t bytes;
+    uint64_t frames;       /* Complete MAVLink frames */
+    uint64_t reads;        /* read() calls returning data */
+    uint64_t writes;       /* write() calls */
+    uint64_t latency_sum;  /* Time the bytes waited in the bridge, in us */
+    uint64_t latency_max;
+    uint64_t latency_cnt;
+};
+
+/* One direction of the bridge, from in_fd to out_fd */
+struct forward {
+    const char *name;
+    int in_fd;
+    int out_fd;
+
+    uint8_t buf[FORWARD_BUF_SIZE];
+    size_t head;      /* Next byte to write */
+    size_t flush_end; /* End of the complete frames */
+    size_t tail;      /* End of the data */
+
+    uint64_t pending_since; /* Time the oldest byte was read, in us */
+    uint64_t last_read;
+    uint64_t latency_max; /* Since the last report */
+
+    bool eof;
+
+    struct forward_stats stats;
+};
+
+uint64_t forward_now_us(void);
+void forward_init(struct forward *fwd, const char *name, int in_fd, int out_fd);
+int forward_read(struct forward *fwd);
+int forward_write(struct forward *fwd, bool force);
+bool forward_can_read(struct forward *fwd);
+bool forward_has_output(struct forward *fwd);
+bool forward_is_held(struct forward *fwd);
+void forward_report(struct forward *fwd,
+                    struct forward_stats *last,
+                    double interval);
+void forward_summary(struct forward *fwd, double elapsed);
+
+#endif
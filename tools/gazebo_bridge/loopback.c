@@ -0,0 +1,214 @@
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "forward.h"
+#include "loopback.h"
+
+/* MAVLink v2 frame used by the self test: header (10), payload (12) and
+ * checksum (2). The checksum is not verified by the bridge */
+#define TEST_FRAME_SIZE 24
+#define TEST_PAYLOAD_SIZE 12
+#define TEST_TIMEOUT_MS 1000
+
+static int stub_listen_fd;
+
+struct test_args {
+    int slave_fd;
+    int frame_cnt;
+};
+
+int loopback_open_pty(char *slave_name, size_t size, int *slave_fd)
+{
+    int master_fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (master_fd < 0)
+        return -1;
+
+    if (grantpt(master_fd) || unlockpt(master_fd) ||
+        ptsname_r(master_fd, slave_name, size)) {
+        close(master_fd);
+        return -1;
+    }
+
+    /* Keep the slave open so the master never reports a hang-up, and pass
+     * the bytes through the line discipline untouched */
+    *slave_fd = open(slave_name, O_RDWR | O_NOCTTY);
+    if (*slave_fd < 0) {
+        close(master_fd);
+        return -1;
+    }
+
+    struct termios options;
+    tcgetattr(*slave_fd, &options);
+    cfmakeraw(&options);
+    tcsetattr(*slave_fd, TCSANOW, &options);
+
+    return master_fd;
+}
+
+/* Stand-in of the Gazebo server echoing everything back */
+static void *stub_thread(void *arg)
+{
+    char buf[FORWARD_BUF_SIZE];
+
+    while (1) {
+        int fd = accept(stub_listen_fd, NULL, NULL);
+        if (fd < 0)
+            break;
+
+        int flag = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+        ssize_t n;
+        while ((n = read(fd, buf, sizeof(buf))) > 0) {
+            if (write(fd, buf, n) != n)
+                break;
+        }
+
+        close(fd);
+    }
+
+    return NULL;
+}
+
+int loopback_start_stub(int *port)
+{
+    stub_listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (stub_listen_fd < 0)
+        return -1;
+
+    /* Listen on an ephemeral port of the loopback interface */
+    struct sockaddr_in addr = {.sin_family = AF_INET,
+                               .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+                               .sin_port = 0};
+    socklen_t len = sizeof(addr);
+
+    if (bind(stub_listen_fd, (struct sockaddr *) &addr, sizeof(addr)) ||
+        listen(stub_listen_fd, 1) ||
+        getsockname(stub_listen_fd, (struct sockaddr *) &addr, &len)) {
+        close(stub_listen_fd);
+        return -1;
+    }
+
+    *port = ntohs(addr.sin_port);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, stub_thread, NULL)) {
+        close(stub_listen_fd);
+        return -1;
+    }
+    pthread_detach(thread);
+
+    return 0;
+}
+
+static void pack_test_frame(uint8_t *frame, uint32_t idx, uint64_t timestamp)
+{
+    memset(frame, 0, TEST_FRAME_SIZE);
+    frame[0] = 0xfd; /* MAVLink v2 */
+    frame[1] = TEST_PAYLOAD_SIZE;
+    frame[4] = idx;  /* Sequence */
+    frame[5] = 1;    /* System ID */
+    frame[6] = 1;    /* Component ID */
+    memcpy(&frame[10], &idx, sizeof(idx));
+    memcpy(&frame[14], &timestamp, sizeof(timestamp));
+}
+
+static int read_test_frame(int fd, uint8_t *frame)
+{
+    size_t size = 0;
+
+    while (size < TEST_FRAME_SIZE) {
+        struct pollfd pfd = {.fd = fd, .events = POLLIN};
+        if (poll(&pfd, 1, TEST_TIMEOUT_MS) <= 0)
+            return -1;
+
+        ssize_t n = read(fd, &frame[size], TEST_FRAME_SIZE - size);
+        if (n <= 0)
+            return -1;
+
+        size += n;
+    }
+
+    return 0;
+}
+
+/* Send the frames one at a time through the bridge and the stub, and measure
+ * the round-trip time */
+static void *test_thread(void *arg)
+{
+    struct test_args *args = arg;
+    uint8_t frame[TEST_FRAME_SIZE];
+    uint64_t rtt_sum = 0, rtt_min = UINT64_MAX, rtt_max = 0;
+    int recvd = 0;
+
+    uint64_t start = forward_now_us();
+
+    for (int i = 0; i < args->frame_cnt; i++) {
+        pack_test_frame(frame, i, forward_now_us());
+        if (write(args->slave_fd, frame, TEST_FRAME_SIZE) != TEST_FRAME_SIZE)
+            break;
+
+        if (read_test_frame(args->slave_fd, frame) < 0) {
+            printf("loopback test: frame %d timed out\n", i);
+            break;
+        }
+
+        uint32_t idx;
+        uint64_t timestamp;
+        memcpy(&idx, &frame[10], sizeof(idx));
+        memcpy(&timestamp, &frame[14], sizeof(timestamp));
+        if (idx != (uint32_t) i) {
+            printf("loopback test: expected frame %d, got %u\n", i, idx);
+            break;
+        }
+
+        uint64_t rtt = forward_now_us() - timestamp;
+        rtt_sum += rtt;
+        if (rtt < rtt_min)
+            rtt_min = rtt;
+        if (rtt > rtt_max)
+            rtt_max = rtt;
+        recvd++;
+    }
+
+    double elapsed = (forward_now_us() - start) / 1e6;
+
+    printf(
+        "loopback test: %d/%d frames in %.3f s (%.0f frames/s), "
+        "rtt min %lu us avg %.1f us max %lu us\n",
+        recvd, args->frame_cnt, elapsed, recvd / elapsed,
+        (unsigned long) (recvd ? rtt_min : 0),
+        recvd ? (double) rtt_sum / recvd : 0.0, (unsigned long) rtt_max);
+
+    /* Stop the bridge */
+    kill(getpid(), SIGTERM);
+
+    return NULL;
+}
+
+int loopback_start_test(int slave_fd, int frame_cnt)
+{
+    static struct test_args args;
+    args.slave_fd = slave_fd;
+    args.frame_cnt = frame_cnt;
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, test_thread, &args))
+        return -1;
+    pthread_detach(thread);
+
+    return 0;
+}
@@ -0,0 +1,10 @@
+#ifndef __LOOPBACK_H__
+#define __LOOPBACK_H__
+
+#include <stddef.h>
+
+int loopback_open_pty(char *slave_name, size_t size, int *slave_fd);
+int loopback_start_stub(int *port);
+int loopback_start_test(int slave_fd, int frame_cnt);
+
+#endif
@@ -1,59 +1,55 @@
 #include <arpa/inet.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <getopt.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <pthread.h>
-#include <semaphore.h>
 #include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <strings.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <unistd.h>
-#include "serial.h"
 
-pthread_t thread1, thread2;
-sem_t sem_terminate;
+#include "forward.h"
+#include "loopback.h"
+#include "serial.h"
 
-int serial_fd, socket_fd;
+struct options {
+    char *gazebo_ip;
+    char *port_number;
+    char *serial_name;
+    char *baudrate;
+    bool loopback;
+    long test_frames;
+    long stats_interval;
+};
 
-void *thread_gazebo_to_hil(void *arg)
-{
-    /* SIL/HIL to gazebo forwarding */
-    char c;
-    while (1) {
-        c = serial_getc(serial_fd);
-        write(socket_fd, &c, 1);
-    }
-}
+/* Both directions of the bridge */
+static struct forward to_gazebo, to_serial;
 
-void *thread_hil_to_gazebo(void *arg)
-{
-    /* Gazebo to SIL/HIL forwarding */
-    char c;
-    while (1) {
-        read(socket_fd, &c, 1);
-        serial_puts(serial_fd, &c, 1);
-    }
-}
+static volatile sig_atomic_t terminated;
 
-void sig_handler(int signum)
+static void sig_handler(int signum)
 {
-    pthread_cancel(thread1);
-    pthread_cancel(thread2);
-
-    close(serial_fd);
-    close(socket_fd);
-
-    sem_post(&sem_terminate);
+    terminated = 1;
 }
 
 static void usage(const char *execpath)
 {
     printf(
         "Usage: %s -i gazebo-ip -p port-number "
-        "-s serial-name [-b baudrate]\n",
-        execpath);
+        "-s serial-name [-b baudrate] [-S seconds]\n"
+        "       %s -l [-t frames] [-S seconds]\n"
+        "  -S, --stats: print the throughput and latency periodically\n"
+        "  -l, --loopback: forward between a pseudo terminal and a local "
+        "echo server\n"
+        "  -t, --test: send the frames through the loopback and measure the "
+        "round-trip time\n",
+        execpath, execpath);
 }
 
 static bool parse_long_from_str(char *str, long *value)
@@ -68,14 +64,11 @@ static bool parse_long_from_str(char *str, long *value)
     }
 }
 
-static void handle_options(int argc,
-                           char **argv,
-                           char **gazebo_ip,
-                           char **port_number,
-                           char **serial_name,
-                           char **baudrate)
+static void handle_options(int argc, char **argv, struct options *options)
 {
-    *gazebo_ip = *port_number = *serial_name = *baudrate = NULL;
+    char *test_frames = NULL, *stats_interval = NULL;
+
+    *options = (struct options){0};
 
     int optidx = 0;
 
@@ -85,24 +78,38 @@ static void handle_options(int argc,
         {"port", 1, NULL, 'p'},
         {"serial", 1, NULL, 's'},
         {"baudrate", 1, NULL, 'b'},
+        {"stats", 1, NULL, 'S'},
+        {"loopback", 0, NULL, 'l'},
+        {"test", 1, NULL, 't'},
         {"help", 0, NULL, 'h'},
+        {0},
     };
     /* clang-format on */
 
     int c;
-    while ((c = getopt_long(argc, argv, "i:p:s:b:h", opts, &optidx)) != -1) {
+    while ((c = getopt_long(argc, argv, "i:p:s:b:S:lt:h", opts, &optidx)) !=
+           -1) {
         switch (c) {
         case 'i':
-            *gazebo_ip = optarg;
+            options->gazebo_ip = optarg;
             break;
         case 'p':
-            *port_number = optarg;
+            options->port_number = optarg;
             break;
         case 's':
-            *serial_name = optarg;
+            options->serial_name = optarg;
             break;
         case 'b':
-            *baudrate = optarg;
+            options->baudrate = optarg;
+            break;
+        case 'S':
+            stats_interval = optarg;
+            break;
+        case 'l':
+            options->loopback = true;
+            break;
+        case 't':
+            test_frames = optarg;
             break;
         case 'h':
             usage(argv[0]);
@@ -112,92 +119,299 @@ static void handle_options(int argc,
         }
     }
 
-    if (!*gazebo_ip) {
+    if (stats_interval &&
+        (!parse_long_from_str(stats_interval, &options->stats_interval) ||
+         options->stats_interval <= 0)) {
+        printf("Bad statistics interval.\n");
+        exit(1);
+    }
+
+    if (test_frames) {
+        if (!options->loopback) {
+            printf("The test requires the loopback mode (-l).\n");
+            exit(1);
+        }
+
+        if (!parse_long_from_str(test_frames, &options->test_frames) ||
+            options->test_frames <= 0) {
+            printf("Bad number of test frames.\n");
+            exit(1);
+        }
+    }
+
+    /* The loopback mode provides both ends itself */
+    if (options->loopback)
+        return;
+
+    if (!options->gazebo_ip) {
         printf("Gazebo IP must be provided via -i option.\n");
         usage(argv[0]);
         exit(1);
     }
 
-    if (!*port_number) {
+    if (!options->port_number) {
         printf("Gazebo port must be provided via -p option.\n");
         usage(argv[0]);
         exit(1);
     }
 
-    if (!*serial_name) {
+    if (!options->serial_name) {
         printf("Serial name must be provided via -s option.\n");
         usage(argv[0]);
         exit(1);
     }
 
-    if (!*baudrate)
-        *baudrate = "115200";
+    if (!options->baudrate)
+        options->baudrate = "115200";
 
     /* Check if port number and baudrate value are valid integers */
     long val;
-    if (!parse_long_from_str(*port_number, &val)) {
+    if (!parse_long_from_str(options->port_number, &val)) {
         printf("Bad port number.\n");
         exit(1);
     }
 
-    if (!parse_long_from_str(*baudrate, &val)) {
+    if (!parse_long_from_str(options->baudrate, &val)) {
         printf("Bad serial baudrate value.\n");
         exit(1);
     }
 }
 
-int main(int argc, char **argv)
+static int gazebo_connect(char *gazebo_ip, int port)
 {
-    /* Parse input arguments */
-    char *gazebo_ip;
-    char *port_number;
-    char *serial_name;
-    char *baudrate;
-
-    handle_options(argc, argv, &gazebo_ip, &port_number, &serial_name,
-                   &baudrate);
-
-    printf("Gazebo IP: %s, port: %d\nSerial: %s, baudrate: %d\n", gazebo_ip,
-           atoi(port_number), serial_name, atoi(baudrate));
-
-    /* sSerial port initialization */
-    serial_fd = serial_init(serial_name, atoi(baudrate));
-    if (serial_fd == -1) {
-        printf("Failed to connect to the serial.\n");
-        exit(1);
-    }
-
-    /* Socket initialization */
-    socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+    int socket_fd = socket(AF_INET, SOCK_STREAM, 0);
     if (socket_fd == -1) {
         printf("Failed to create socket.\n");
-        exit(1);
+        return -1;
     }
 
     struct sockaddr_in serv_addr = {.sin_family = AF_INET,
                                     .sin_addr.s_addr = inet_addr(gazebo_ip),
-                                    .sin_port = htons(atoi(port_number))};
+                                    .sin_port = htons(port)};
 
     /* Attempt to connect to the Gazebo server */
     if (connect(socket_fd, (struct sockaddr *) &serv_addr, sizeof(serv_addr))) {
-        printf("Failed to connect to the Gazeobo.\n");
-        exit(1);
+        printf("Failed to connect to the Gazebo.\n");
+        close(socket_fd);
+        return -1;
     }
 
-    printf("Established connection between SIL/HIL and Gazebo.\n");
+    /* Send the flushed frames immediately instead of coalescing them */
+    int flag = 1;
+    setsockopt(socket_fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    fcntl(socket_fd, F_SETFL, fcntl(socket_fd, F_GETFL) | O_NONBLOCK);
 
-    /* Launch threads to handle message forwarding */
-    pthread_create(&thread1, NULL, thread_gazebo_to_hil, NULL);
-    pthread_create(&thread2, NULL, thread_hil_to_gazebo, NULL);
+    return socket_fd;
+}
+
+static uint32_t fd_events(struct forward *in, struct forward *out)
+{
+    uint32_t events = 0;
+
+    if (forward_can_read(in))
+        events |= EPOLLIN;
+    if (forward_has_output(out))
+        events |= EPOLLOUT;
+
+    return events;
+}
+
+static void update_events(int epoll_fd,
+                          int fd,
+                          uint32_t *current,
+                          uint32_t events)
+{
+    if (*current == events)
+        return;
+
+    struct epoll_event event = {.events = events, .data.fd = fd};
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event);
+    *current = events;
+}
+
+/* Flush the complete frames, and the held bytes once they are stale */
+static int flush(struct forward *fwd, uint64_t now)
+{
+    bool force = forward_is_held(fwd) &&
+                 now - fwd->last_read >= FORWARD_HOLD_TIMEOUT_US;
+    return forward_write(fwd, force);
+}
+
+static int bridge_run(int serial_fd, int socket_fd, long stats_interval)
+{
+    forward_init(&to_gazebo, "serial->gazebo", serial_fd, socket_fd);
+    forward_init(&to_serial, "gazebo->serial", socket_fd, serial_fd);
 
-    /* Install the signal handlers */
-    signal(SIGINT, sig_handler);
-    signal(SIGABRT, sig_handler);
-    signal(SIGTERM, sig_handler);
+    int epoll_fd = epoll_create1(0);
+    if (epoll_fd < 0)
+        return -1;
 
-    /* Wait until the program is terminated */
-    sem_init(&sem_terminate, 0, 0);
-    sem_wait(&sem_terminate);
+    uint32_t serial_events = EPOLLIN, socket_events = EPOLLIN;
+    struct epoll_event event = {.events = EPOLLIN, .data.fd = serial_fd};
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, serial_fd, &event);
+    event.data.fd = socket_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, socket_fd, &event);
+
+    struct forward_stats gazebo_last = {0}, serial_last = {0};
+    uint64_t start = forward_now_us();
+    uint64_t stats_period = stats_interval * 1000000;
+    uint64_t stats_next = start + stats_period;
+    int retval = 0;
+
+    while (!terminated) {
+        uint64_t now = forward_now_us();
+
+        /* Wake up for the next report or to flush the held bytes */
+        int timeout = -1;
+        if (stats_interval)
+            timeout = now < stats_next ? (stats_next - now) / 1000 + 1 : 0;
+        if (forward_is_held(&to_gazebo) || forward_is_held(&to_serial)) {
+            int hold_timeout = FORWARD_HOLD_TIMEOUT_US / 1000;
+            if (timeout < 0 || timeout > hold_timeout)
+                timeout = hold_timeout;
+        }
+
+        struct epoll_event events[2];
+        int n = epoll_wait(epoll_fd, events, 2, timeout);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            retval = -1;
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            bool serial = events[i].data.fd == serial_fd;
+            struct forward *in = serial ? &to_gazebo : &to_serial;
+
+            if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) &&
+                forward_read(in) < 0) {
+                printf("Failed to read from the %s.\n",
+                       serial ? "serial" : "Gazebo");
+                retval = -1;
+                goto leave;
+            }
+        }
+
+        /* Forward what was just read without waiting for another wake-up */
+        now = forward_now_us();
+        if (flush(&to_gazebo, now) < 0 || flush(&to_serial, now) < 0) {
+            printf("Failed to forward the data.\n");
+            retval = -1;
+            break;
+        }
+
+        if (to_serial.eof) {
+            printf("Gazebo closed the connection.\n");
+            break;
+        }
+
+        update_events(epoll_fd, serial_fd, &serial_events,
+                      fd_events(&to_gazebo, &to_serial));
+        update_events(epoll_fd, socket_fd, &socket_events,
+                      fd_events(&to_serial, &to_gazebo));
+
+        if (stats_interval && now >= stats_next) {
+            forward_report(&to_gazebo, &gazebo_last, stats_interval);
+            forward_report(&to_serial, &serial_last, stats_interval);
+            stats_next += stats_period;
+        }
+    }
+
+leave:
+    close(epoll_fd);
+
+    double elapsed = (forward_now_us() - start) / 1e6;
+    forward_summary(&to_gazebo, elapsed);
+    forward_summary(&to_serial, elapsed);
+
+    return retval;
+}
+
+int main(int argc, char **argv)
+{
+    /* Keep the reports in order when the output is redirected */
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    /* Parse input arguments */
+    struct options options;
+    handle_options(argc, argv, &options);
+
+    /* Install the signal handlers without restarting the interrupted
+     * epoll_wait() */
+    struct sigaction sa = {.sa_handler = sig_handler};
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGABRT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    /* The helper threads of the loopback mode leave the signals to the main
+     * thread */
+    sigset_t mask, old_mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGABRT);
+    sigaddset(&mask, SIGTERM);
+
+    int serial_fd, socket_fd;
+
+    if (options.loopback) {
+        char slave_name[64];
+        int slave_fd, port;
+
+        serial_fd =
+            loopback_open_pty(slave_name, sizeof(slave_name), &slave_fd);
+        if (serial_fd == -1) {
+            printf("Failed to open the pseudo terminal.\n");
+            exit(1);
+        }
+
+        pthread_sigmask(SIG_BLOCK, &mask, &old_mask);
+
+        if (loopback_start_stub(&port)) {
+            printf("Failed to start the echo server.\n");
+            exit(1);
+        }
+
+        printf("Loopback: serial %s, echo server 127.0.0.1:%d\n", slave_name,
+               port);
+
+        socket_fd = gazebo_connect("127.0.0.1", port);
+        if (socket_fd == -1)
+            exit(1);
+
+        if (options.test_frames &&
+            loopback_start_test(slave_fd, options.test_frames)) {
+            printf("Failed to start the loopback test.\n");
+            exit(1);
+        }
+
+        pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+    } else {
+        printf("Gazebo IP: %s, port: %d\nSerial: %s, baudrate: %d\n",
+               options.gazebo_ip, atoi(options.port_number),
+               options.serial_name, atoi(options.baudrate));
+
+        /* Serial port initialization */
+        serial_fd = serial_init(options.serial_name, atoi(options.baudrate));
+        if (serial_fd == -1) {
+            printf("Failed to connect to the serial.\n");
+            exit(1);
+        }
+
+        socket_fd =
+            gazebo_connect(options.gazebo_ip, atoi(options.port_number));
+        if (socket_fd == -1)
+            exit(1);
+    }
+
+    printf("Established connection between SIL/HIL and Gazebo.\n");
+
+    /* Forward the messages until the program is terminated */
+    int retval = bridge_run(serial_fd, socket_fd, options.stats_interval);
+
+    close(serial_fd);
+    close(socket_fd);
 
-    return 0;
+    return retval ? 1 : 0;
 }
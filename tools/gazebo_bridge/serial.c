@@ -28,7 +28,7 @@ static int get_baudrate_cflag(int baudrate)
         return B500000;
     case 576000:
         return B576000;
-    case 216000:
+    case 921600:
         return B921600;
     case 1000000:
         return B1000000;
@@ -68,20 +68,3 @@ int serial_init(char *port_name, int baudrate)
 
     return serial_fd;
 }
-
-void serial_puts(int serial_fd, char *s, size_t size)
-{
-    write(serial_fd, s, size);
-}
-
-char serial_getc(int serial_fd)
-{
-    char c;
-    int received_len = 0;
-
-    do {
-        received_len = read(serial_fd, (void *) &c, 1);
-    } while (received_len <= 0);
-
-    return c;
-}
@@ -2,7 +2,5 @@
 #define __SERIAL_H__
 
 int serial_init(char *port_name, int baudrate);
-void serial_puts(int serial_fd, char *s, size_t size);
-char serial_getc(int serial_fd);
 
 #endif
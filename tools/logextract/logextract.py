@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+
+# Extract the telemetry log recorded by user/logger into one CSV file per
+# message type. The log is read from the raw image of the storage or from a
+# console log captured while running the `log dump` shell command, where the
+# lines not starting with `log,` are ignored. The message layouts are loaded
+# from the YAML files generated by msggen.
+#
+# Extract: tools/logextract/logextract.py -m build/msg -o flight/ console.log
+#
+# The columns are flat (arrays are expanded into <name>_<index>) and typed
+# consistently, so the files can be converted with, e.g., pandas:
+#     pandas.read_csv('flight/imu.csv').to_parquet('imu.parquet')
+
+import argparse
+import csv
+import glob
+import os
+import re
+import struct
+import sys
+
+import yaml
+
+LOG_MAGIC = b'TLOG'
+LOG_HEADER_SIZE = 8
+RECORD_HEADER_SIZE = 6
+MSG_ID_DROPPED = 0xff
+DROPPED_SIZE = 4
+
+C_TYPES = {
+    'bool': '?',
+    'uint8_t': 'B',
+    'int8_t': 'b',
+    'uint16_t': 'H',
+    'int16_t': 'h',
+    'uint32_t': 'I',
+    'int32_t': 'i',
+    'uint64_t': 'Q',
+    'int64_t': 'q',
+    'float': 'f',
+    'double': 'd',
+}
+
+
+class MsgLayout:
+    def __init__(self, name, msg_id, fields):
+        self.name = name
+        self.msg_id = msg_id
+        self.columns = []
+        fmt = '<'
+
+        for field in fields:
+            array_size = field['array_size']
+            code = C_TYPES[field['c_type']]
+            if array_size == 0:
+                self.columns.append(field['var_name'])
+                fmt += code
+            else:
+                self.columns += ['%s_%d' % (field['var_name'], i)
+                                 for i in range(array_size)]
+                fmt += code * array_size
+
+        self.struct = struct.Struct(fmt)
+
+
+def load_layouts(msg_dir):
+    layouts = {}
+
+    for path in sorted(glob.glob(os.path.join(msg_dir, '*.yaml'))):
+        # debug_link_<name>_msg.yaml
+        match = re.match(r'debug_link_(.+)_msg\.yaml$', os.path.basename(path))
+        if not match:
+            continue
+
+        with open(path, 'r') as stream:
+            data = yaml.safe_load(stream)
+
+        layout = MsgLayout(match.group(1), data['msg_id'], data['payload'])
+        layouts[layout.msg_id] = layout
+
+    return layouts
+
+
+def read_log(path):
+    """Return the raw image, or the bytes of the `log dump` lines"""
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    if data.startswith(LOG_MAGIC):
+        return data
+
+    image = bytearray()
+    for line in data.decode('ascii', 'replace').splitlines():
+        start = line.find('log,')
+        if start < 0:
+            continue
+
+        field = line[start + 4:].strip()
+        if field.startswith('end'):
+            break
+
+        try:
+            image += bytes.fromhex(field)
+        except ValueError:
+            print('warning: ignored the malformed line: %s' % line,
+                  file=sys.stderr)
+
+    return bytes(image)
+
+
+def parse_log(data):
+    """Yield (session, timestamp in us, message ID, payload) of the records"""
+    session = -1
+    last = 0
+    wraps = 0
+    pos = 0
+
+    while pos + RECORD_HEADER_SIZE <= len(data):
+        # Every session starts with a header
+        if data[pos:pos + len(LOG_MAGIC)] == LOG_MAGIC:
+            session += 1
+            last = 0
+            wraps = 0
+            pos += LOG_HEADER_SIZE
+            continue
+
+        msg_id, size, timestamp = struct.unpack_from('<BBI', data, pos)
+
+        # Erased storage or a corrupted record
+        if session < 0 or (msg_id == MSG_ID_DROPPED and size != DROPPED_SIZE):
+            break
+
+        pos += RECORD_HEADER_SIZE
+        payload = data[pos:pos + size]
+        if len(payload) < size:
+            print('warning: the last record is truncated', file=sys.stderr)
+            break
+        pos += size
+
+        # Unwrap the 32-bit timestamp
+        if timestamp < last and last - timestamp > 0x80000000:
+            wraps += 1
+        last = timestamp
+
+        yield session, timestamp + (wraps << 32), msg_id, payload
+
+
+def extract(data, layouts, out_dir):
+    os.makedirs(out_dir, exist_ok=True)
+
+    files = {}
+    writers = {}
+    counts = {}
+    dropped = 0
+    unknown = 0
+
+    def writer(key, columns):
+        if key not in writers:
+            f = open(os.path.join(out_dir, key + '.csv'), 'w', newline='')
+            files[key] = f
+            writers[key] = csv.writer(f)
+            writers[key].writerow(['session', 'timestamp_us'] + columns)
+        return writers[key]
+
+    for session, timestamp, msg_id, payload in parse_log(data):
+        if msg_id == MSG_ID_DROPPED:
+            cnt = struct.unpack('<I', payload)[0]
+            writer('dropped', ['count']).writerow([session, timestamp, cnt])
+            dropped += cnt
+            continue
+
+        layout = layouts.get(msg_id)
+        if layout is None or len(payload) != layout.struct.size:
+            unknown += 1
+            continue
+
+        values = layout.struct.unpack(payload)
+        writer(layout.name, layout.columns).writerow(
+            [session, timestamp] + list(values))
+        counts[layout.name] = counts.get(layout.name, 0) + 1
+
+    for f in files.values():
+        f.close()
+
+    for name, cnt in sorted(counts.items()):
+        print('%s: %d records' % (name, cnt))
+    if dropped:
+        print('warning: %d records were dropped on the target' % dropped)
+    if unknown:
+        print('warning: %d records of unknown messages were skipped' % unknown)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Extract the telemetry log into CSV files')
+    parser.add_argument('log', help='raw log image or captured console log')
+    parser.add_argument('-m', '--msg', default='build/msg',
+                        help='directory of the YAML files generated by msggen')
+    parser.add_argument('-o', '--output', default='log',
+                        help='output directory of the CSV files')
+    args = parser.parse_args()
+
+    layouts = load_layouts(args.msg)
+    if not layouts:
+        sys.exit('error: no message definitions found in %s' % args.msg)
+
+    data = read_log(args.log)
+    if not data.startswith(LOG_MAGIC):
+        sys.exit('error: no log found in %s' % args.log)
+
+    extract(data, layouts, args.output)
+
+
+if __name__ == '__main__':
+    main()
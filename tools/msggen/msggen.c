@@ -7,19 +7,28 @@
 
 #include "list.h"
 
+/* Payload size of a message is limited by the length field of the header */
+#define MSG_PAYLOAD_SIZE_MAX 255
+
+struct msg_type {
+    char *c_type;
+    int size;      /* Size on the target in bytes */
+    char *type_id; /* Type of the field for the host decoder */
+};
+
 /* clang-format off */
-char *support_types[] = {
-    "bool",
-    "uint8_t",
-    "int8_t",
-    "uint16_t",
-    "int16_t",
-    "uint32_t",
-    "int32_t",
-    "uint64_t",
-    "int64_t",
-    "float",
-    "double",
+struct msg_type support_types[] = {
+    {"bool", 1, "DEBUG_LINK_TYPE_BOOL"},
+    {"uint8_t", 1, "DEBUG_LINK_TYPE_UINT8"},
+    {"int8_t", 1, "DEBUG_LINK_TYPE_INT8"},
+    {"uint16_t", 2, "DEBUG_LINK_TYPE_UINT16"},
+    {"int16_t", 2, "DEBUG_LINK_TYPE_INT16"},
+    {"uint32_t", 4, "DEBUG_LINK_TYPE_UINT32"},
+    {"int32_t", 4, "DEBUG_LINK_TYPE_INT32"},
+    {"uint64_t", 8, "DEBUG_LINK_TYPE_UINT64"},
+    {"int64_t", 8, "DEBUG_LINK_TYPE_INT64"},
+    {"float", 4, "DEBUG_LINK_TYPE_FLOAT"},
+    {"double", 8, "DEBUG_LINK_TYPE_DOUBLE"},
 };
 /* clang-format on */
 
@@ -145,18 +154,35 @@ int split_tokens(char *token[3],
     return token_cnt;
 }
 
-int type_check(char *type)
+int type_size(char *type)
 {
-    int len = strlen(type);
-    int type_list_size = sizeof(support_types) / sizeof(char *);
+    int type_list_size = sizeof(support_types) / sizeof(struct msg_type);
 
     int i;
     for (i = 0; i < type_list_size; i++) {
-        if (strncmp(type, support_types[i], len) == 0)
-            return 0;
+        if (strcmp(type, support_types[i].c_type) == 0)
+            return support_types[i].size;
     }
 
-    return -1;
+    return 0;
+}
+
+char *type_id(char *type)
+{
+    int type_list_size = sizeof(support_types) / sizeof(struct msg_type);
+
+    int i;
+    for (i = 0; i < type_list_size; i++) {
+        if (strcmp(type, support_types[i].c_type) == 0)
+            return support_types[i].type_id;
+    }
+
+    return NULL;
+}
+
+int type_check(char *type)
+{
+    return type_size(type) > 0 ? 0 : -1;
 }
 
 int parse_variable_name(char *input, char *var_name, char *array_size)
@@ -311,7 +337,11 @@ char *get_message_name(char *file_name)
     return msg_name;
 }
 
-int codegen(char *file_name, char *msgs, char *output_dir)
+int codegen(char *file_name,
+            char *msgs,
+            char *output_dir,
+            FILE *output_decoder,
+            FILE *decoder_table)
 {
     char *msg_name = get_message_name(file_name);
     if (msg_name == NULL)
@@ -511,7 +541,30 @@ int codegen(char *file_name, char *msgs, char *output_dir)
         }
     }
 
-    if (var_duplicated == false) {
+    /* Calculate the payload size, the fields are packed without padding */
+    int payload_size = 0;
+
+    struct list_head *curr;
+    list_for_each (curr, &msg_var_list) {
+        struct msg_var_entry *msg_var =
+            list_entry(curr, struct msg_var_entry, list);
+
+        int n = 1;
+        if (strlen(msg_var->array_size) > 0)
+            n = atoi(msg_var->array_size);
+
+        payload_size += type_size(msg_var->c_type) * n;
+    }
+
+    bool oversized = payload_size > MSG_PAYLOAD_SIZE_MAX;
+    if (oversized) {
+        printf("[msggen] %s: error, payload size %d exceeds %d bytes\n",
+               file_name, payload_size, MSG_PAYLOAD_SIZE_MAX);
+    }
+
+    bool failed = var_duplicated || oversized;
+
+    if (failed == false) {
         /*===================*
          * C code generation *
          *===================*/
@@ -519,15 +572,25 @@ int codegen(char *file_name, char *msgs, char *output_dir)
         /* Generate preprocessing code */
         fprintf(output_c_header,
                 "#pragma once\n\n"
+                "#include <assert.h>\n"
+                "#include <stddef.h>\n"
+                "#include <stdint.h>\n"
+                "#include <string.h>\n\n"
                 "#include \"debug_link.h\"\n\n"
-                "#define DEBUG_LINK_MSG_ID_%s %d\n\n",
-                msg_name, msg_cnt);
+                "#define DEBUG_LINK_MSG_ID_%s %d\n"
+                "#define DEBUG_LINK_MSG_SIZE_%s %d\n"
+                "#define DEBUG_LINK_MSG_LEN_%s \\\n"
+                "    (DEBUG_LINK_HEADER_SIZE + DEBUG_LINK_MSG_SIZE_%s + "
+                "DEBUG_LINK_CHECKSUM_SIZE)\n\n",
+                msg_name, msg_cnt, msg_name, payload_size, msg_name,
+                msg_name);
 
-        /* Generarte message structure */
-        fprintf(output_c_header, "typedef struct __debug_link_msg_%s_t {\n",
+        /* Generarte message structure with the layout of the payload */
+        fprintf(output_c_header,
+                "typedef struct __attribute__((packed)) __debug_link_msg_%s_t "
+                "{\n",
                 msg_name);
 
-        struct list_head *curr;
         list_for_each (curr, &msg_var_list) {
             struct msg_var_entry *msg_var =
                 list_entry(curr, struct msg_var_entry, list);
@@ -553,42 +616,96 @@ int codegen(char *file_name, char *msgs, char *output_dir)
 
         fprintf(output_c_header, "} debug_link_msg_%s_t;\n\n", msg_name);
 
-        /* Generate message functions */
-        fprintf(
-            output_c_header,
-            "static inline size_t pack_debug_link_%s_msg(debug_link_msg_%s_t "
-            "*msg, "
-            "uint8_t *data)\n{\n"
-            "    debug_link_payload_t payload = {.data = data};\n"
-            "    pack_debug_link_msg_header(&payload, DEBUG_LINK_MSG_ID_%s);\n",
-            msg_name, msg_name, msg_name);
+        fprintf(output_c_header,
+                "static_assert(sizeof(debug_link_msg_%s_t) == "
+                "DEBUG_LINK_MSG_SIZE_%s,\n"
+                "              \"unexpected layout of debug_link_msg_%s_t\");"
+                "\n\n",
+                msg_name, msg_name, msg_name);
+
+        /* Generate message functions, the payload is copied at once */
+        fprintf(output_c_header,
+                "static inline size_t pack_debug_link_%s_msg(debug_link_msg_%s_t "
+                "*msg, uint8_t *data)\n{\n"
+                "    memcpy(&data[DEBUG_LINK_HEADER_SIZE], msg, "
+                "DEBUG_LINK_MSG_SIZE_%s);\n"
+                "    return finish_debug_link_msg(data, DEBUG_LINK_MSG_ID_%s,\n"
+                "                                 DEBUG_LINK_MSG_SIZE_%s);\n"
+                "}\n\n",
+                msg_name, msg_name, msg_name, msg_name, msg_name);
+
+        fprintf(output_c_header,
+                "static inline int unpack_debug_link_%s_msg(debug_link_msg_%s_t "
+                "*msg, const uint8_t *data, size_t size)\n{\n"
+                "    int retval = check_debug_link_msg(data, size, "
+                "DEBUG_LINK_MSG_ID_%s,\n"
+                "                                      "
+                "DEBUG_LINK_MSG_SIZE_%s);\n"
+                "    if (retval < 0)\n"
+                "        return retval;\n\n"
+                "    memcpy(msg, &data[DEBUG_LINK_HEADER_SIZE], "
+                "DEBUG_LINK_MSG_SIZE_%s);\n"
+                "    return DEBUG_LINK_MSG_LEN_%s;\n"
+                "}\n\n",
+                msg_name, msg_name, msg_name, msg_name, msg_name, msg_name);
+
+        /* Generate functions for the batch frames */
+        fprintf(output_c_header,
+                "static inline int batch_debug_link_%s_msg(debug_link_batch_t "
+                "*batch, debug_link_msg_%s_t *msg)\n{\n"
+                "    return debug_link_batch_add(batch, DEBUG_LINK_MSG_ID_%s, "
+                "msg,\n"
+                "                                DEBUG_LINK_MSG_SIZE_%s);\n"
+                "}\n\n",
+                msg_name, msg_name, msg_name, msg_name);
+
+        fprintf(output_c_header,
+                "static inline int decode_debug_link_%s_payload("
+                "debug_link_msg_%s_t *msg, const uint8_t *payload, size_t "
+                "size)\n{\n"
+                "    if (size != DEBUG_LINK_MSG_SIZE_%s)\n"
+                "        return -1;\n\n"
+                "    memcpy(msg, payload, DEBUG_LINK_MSG_SIZE_%s);\n"
+                "    return 0;\n"
+                "}\n",
+                msg_name, msg_name, msg_name, msg_name);
+
+        /*====================================*
+         * Message table of the host decoder *
+         *====================================*/
+        int value_cnt = 0;
+        int field_cnt = 0;
+
+        fprintf(output_decoder,
+                "static const struct debug_link_field_desc %s_fields[] = {\n",
+                msg_name);
 
         list_for_each (curr, &msg_var_list) {
             struct msg_var_entry *msg_var =
                 list_entry(curr, struct msg_var_entry, list);
 
-            /* Generate functions to pack data fields */
-            if (strlen(msg_var->array_size) > 0) {
-                fprintf(output_c_header,
-                        "    pack_debug_link_msg_%s(msg->%s, &payload, %s);\n",
-                        msg_var->c_type, msg_var->var_name,
-                        msg_var->array_size);
-            } else {
-                fprintf(output_c_header,
-                        "    pack_debug_link_msg_%s(&msg->%s, &payload, 1);\n",
-                        msg_var->c_type, msg_var->var_name);
-            }
+            int n = 0;
+            if (strlen(msg_var->array_size) > 0)
+                n = atoi(msg_var->array_size);
+
+            fprintf(output_decoder, "    {%s, %d},\n",
+                    type_id(msg_var->c_type), n);
+
+            value_cnt += n > 0 ? n : 1;
+            field_cnt++;
         }
 
-        fprintf(output_c_header,
-                "    generate_debug_link_msg_checksum(&payload);\n");
+        fprintf(output_decoder, "};\n\n");
 
-        fprintf(output_c_header, "    return payload.size;\n}\n");
+        fprintf(decoder_table, "    {\"%s\", %d, %d, %d, %s_fields, %d},\n",
+                msg_name, msg_cnt, payload_size, value_cnt, msg_name,
+                field_cnt);
 
         /*======================*
          * YAML file generation *
          *======================*/
-        fprintf(output_yaml, "msg_id: %d\n\npayload:\n", msg_cnt);
+        fprintf(output_yaml, "msg_id: %d\npayload_size: %d\n\npayload:\n",
+                msg_cnt, payload_size);
 
         list_for_each (curr, &msg_var_list) {
             struct msg_var_entry *msg_var =
@@ -621,7 +738,7 @@ int codegen(char *file_name, char *msgs, char *output_dir)
     fclose(output_c_header);
     fclose(output_yaml);
 
-    struct list_head *curr, *next;
+    struct list_head *next;
     list_for_each_safe (curr, next, &msg_var_list) {
         struct msg_var_entry *msg_var =
             list_entry(curr, struct msg_var_entry, list);
@@ -638,7 +755,7 @@ int codegen(char *file_name, char *msgs, char *output_dir)
     free(c_header_name);
     free(yaml_name);
 
-    return (var_duplicated == false) ? 0 : -1;
+    return (failed == false) ? 0 : -1;
 }
 
 char *load_msg_file(char *file_name)
@@ -685,6 +802,23 @@ int main(int argc, char **argv)
         return -1;
     }
 
+    /* Create the message table of the host decoder */
+    char *decoder_name = calloc(sizeof(char), strlen(output_dir) + 50);
+    sprintf(decoder_name, "%s/debug_link_msgs.c", output_dir);
+
+    FILE *output_decoder = fopen(decoder_name, "wb");
+    FILE *decoder_table = tmpfile();
+    if (output_decoder == NULL || decoder_table == NULL) {
+        printf("[msggen] error, failed to write to %s\n", decoder_name);
+        closedir(dir);
+        free(decoder_name);
+        return -1;
+    }
+
+    fprintf(output_decoder,
+            "#include <stddef.h>\n\n"
+            "#include \"debug_link_decoder.h\"\n\n");
+
     bool failed = false;
 
     /* Enumerate all the files under the given directory path */
@@ -705,7 +839,8 @@ int main(int argc, char **argv)
             char *msgs = load_msg_file(file_path);
 
             /* Run code generation */
-            int retval = codegen(msg_file_name, msgs, output_dir);
+            int retval = codegen(msg_file_name, msgs, output_dir,
+                                 output_decoder, decoder_table);
 
             /* Clean up */
             free(msgs);
@@ -723,5 +858,27 @@ int main(int argc, char **argv)
     /* Close directory */
     closedir(dir);
 
+    /* Append the table indexed by the message ID */
+    fprintf(output_decoder,
+            "const struct debug_link_msg_desc debug_link_msgs[] = {\n");
+
+    char line[256];
+    rewind(decoder_table);
+    while (fgets(line, sizeof(line), decoder_table))
+        fputs(line, output_decoder);
+
+    fprintf(output_decoder,
+            "};\n\n"
+            "const size_t debug_link_msg_cnt = %d;\n",
+            msg_cnt);
+
+    fclose(decoder_table);
+    fclose(output_decoder);
+
+    if (failed == false)
+        printf("[msggen] generate %s\n", decoder_name);
+
+    free(decoder_name);
+
     return failed == true ? -1 : 0;
 }
@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+
+# Symbolize the samples dumped by the `prof dump` shell command against the
+# ELF of the kernel. The console log is read from the file or the stdin and
+# the lines not starting with `prof,` are ignored.
+#
+# Flat profile:     tools/prof/prof.py -e tenok.elf console.log
+# Flame graph:      tools/prof/prof.py -e tenok.elf --folded console.log | \
+#                   flamegraph.pl > prof.svg
+
+import argparse
+import collections
+import subprocess
+import sys
+
+KERNEL_TID = -1
+
+
+def parse_log(lines):
+    freq = 0
+    threads = {KERNEL_TID: '[kernel]'}
+    samples = []
+    dropped = 0
+
+    for line in lines:
+        start = line.find('prof,')
+        if start < 0:
+            continue
+
+        fields = line[start:].strip().split(',')
+        if len(fields) < 3:
+            continue
+
+        try:
+            if fields[1] == 'freq':
+                freq = int(fields[2])
+            elif fields[1] == 'thread' and len(fields) >= 4:
+                threads[int(fields[2])] = ','.join(fields[3:])
+            elif fields[1] == 'end' and len(fields) >= 4:
+                dropped = int(fields[3])
+            elif len(fields) == 4:
+                samples.append((int(fields[1], 16), int(fields[2], 16),
+                                int(fields[3])))
+        except ValueError:
+            continue
+
+    return freq, threads, samples, dropped
+
+
+def symbolize(addr2line, elf, addrs):
+    """Map the addresses to (function, file:line) with a single addr2line"""
+    addrs = sorted(addrs)
+    if not addrs:
+        return {}
+
+    query = ''.join('0x%x\n' % addr for addr in addrs)
+    try:
+        out = subprocess.run([addr2line, '-f', '-C', '-e', elf],
+                             input=query, capture_output=True, text=True,
+                             check=True).stdout.splitlines()
+    except (OSError, subprocess.CalledProcessError) as e:
+        sys.exit('prof: failed to run %s: %s' % (addr2line, e))
+
+    symbols = {}
+    for i, addr in enumerate(addrs):
+        func = out[2 * i] if 2 * i < len(out) else '??'
+        loc = out[2 * i + 1] if 2 * i + 1 < len(out) else '??:0'
+        if func == '??':
+            func = '0x%08x' % addr
+        symbols[addr] = (func, loc.split(' ')[0])
+
+    return symbols
+
+
+def caller_addr(lr):
+    """Address of the call instruction from the return address (the lr of
+    the Thumb state has the bit 0 set)"""
+    return (lr & ~1) - 1 if lr else 0
+
+
+def flat_profile(samples, symbols, threads, freq, dropped, by_line, top):
+    total = len(samples)
+    if total == 0:
+        print('no samples')
+        return
+
+    key = 1 if by_line else 0
+    funcs = collections.Counter(symbols[pc][key] for pc, _, _ in samples)
+    tids = collections.Counter(tid for _, _, tid in samples)
+
+    duration = ' over %.2f s' % (total / freq) if freq else ''
+    print('%d samples%s, %d dropped\n' % (total, duration, dropped))
+
+    print('%7s %8s  %s' % ('%', 'samples', 'line' if by_line else 'function'))
+    for name, cnt in funcs.most_common(top):
+        print('%6.2f%% %8d  %s' % (100.0 * cnt / total, cnt, name))
+
+    print('\n%7s %8s  %s' % ('%', 'samples', 'thread'))
+    for tid, cnt in tids.most_common():
+        name = threads.get(tid, 'tid %d' % tid)
+        print('%6.2f%% %8d  %s' % (100.0 * cnt / total, cnt, name))
+
+
+def folded_stacks(samples, symbols, threads, caller):
+    stacks = collections.Counter()
+
+    for pc, lr, tid in samples:
+        frames = [threads.get(tid, 'tid %d' % tid)]
+        if caller and lr:
+            frames.append(symbols[caller_addr(lr)][0])
+        frames.append(symbols[pc][0])
+        stacks[';'.join(f.replace(';', ':') for f in frames)] += 1
+
+    for stack, cnt in sorted(stacks.items()):
+        print('%s %d' % (stack, cnt))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Symbolize the samples of the Tenok profiler')
+    parser.add_argument('log', nargs='?', help='console log (default: stdin)')
+    parser.add_argument('-e', '--elf', default='tenok.elf',
+                        help='ELF of the kernel (default: tenok.elf)')
+    parser.add_argument('--addr2line', default='arm-none-eabi-addr2line',
+                        help='addr2line of the toolchain')
+    parser.add_argument('--lines', action='store_true',
+                        help='group the flat profile by source lines')
+    parser.add_argument('--top', type=int, default=30,
+                        help='entries of the flat profile (default: 30)')
+    parser.add_argument('--folded', action='store_true',
+                        help='print folded stacks for flamegraph.pl')
+    parser.add_argument('--caller', action='store_true',
+                        help='add the caller from the lr to the stacks, '
+                        'which is only exact if the function is a leaf')
+    args = parser.parse_args()
+
+    if args.log:
+        with open(args.log, errors='replace') as f:
+            freq, threads, samples, dropped = parse_log(f)
+    else:
+        freq, threads, samples, dropped = parse_log(sys.stdin)
+
+    addrs = {pc for pc, _, _ in samples}
+    if args.caller:
+        addrs |= {caller_addr(lr) for _, lr, _ in samples if lr}
+    symbols = symbolize(args.addr2line, args.elf, addrs)
+
+    if args.folded:
+        folded_stacks(samples, symbols, threads, args.caller)
+    else:
+        flat_profile(samples, symbols, threads, freq, dropped, args.lines,
+                     args.top)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,107 @@
+import ctypes
+import os
+
+# Must match user/debug-link/debug_link_decoder.h
+RECORD_BATCH = 0x1
+RECORD_TIMESTAMP = 0x2
+
+MAX_RECORDS = 256
+MAX_VALUES = 8192
+
+
+class DebugLinkRecord(ctypes.Structure):
+    _fields_ = [('msg_id', ctypes.c_int32),
+                ('flags', ctypes.c_uint32),
+                ('seq', ctypes.c_uint32),
+                ('timestamp', ctypes.c_uint32),
+                ('value_offset', ctypes.c_uint32),
+                ('value_cnt', ctypes.c_uint32)]
+
+
+class DebugLinkDecoderStats(ctypes.Structure):
+    _fields_ = [(name, ctypes.c_uint64) for name in
+                ('frames', 'batches', 'records', 'bytes_skipped',
+                 'checksum_errors', 'crc_errors', 'unknown_msgs',
+                 'batches_lost', 'batches_reordered')]
+
+
+class NativeDecoder:
+    """Bulk decoder of the debug-link frames backed by libdebuglink.so, which
+    is built by msggen with the message definitions"""
+
+    def __init__(self, lib_path):
+        lib = ctypes.CDLL(lib_path)
+
+        lib.debug_link_decoder_create.restype = ctypes.c_void_p
+        lib.debug_link_decoder_destroy.argtypes = [ctypes.c_void_p]
+        lib.debug_link_decoder_feed.restype = ctypes.c_size_t
+        lib.debug_link_decoder_feed.argtypes = [
+            ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t]
+        lib.debug_link_decoder_decode.restype = ctypes.c_size_t
+        lib.debug_link_decoder_decode.argtypes = [
+            ctypes.c_void_p, ctypes.POINTER(DebugLinkRecord), ctypes.c_size_t,
+            ctypes.POINTER(ctypes.c_double), ctypes.c_size_t]
+        lib.debug_link_decoder_get_stats.argtypes = [
+            ctypes.c_void_p, ctypes.POINTER(DebugLinkDecoderStats)]
+
+        self.lib = lib
+        self.decoder = lib.debug_link_decoder_create()
+        if not self.decoder:
+            raise MemoryError('failed to create the debug-link decoder')
+
+        self.records = (DebugLinkRecord * MAX_RECORDS)()
+        self.values = (ctypes.c_double * MAX_VALUES)()
+
+    @staticmethod
+    def load(msg_dir):
+        """Return the decoder, or None if the library is not built"""
+        lib_path = os.path.join(msg_dir, 'libdebuglink.so')
+        if not os.path.exists(lib_path):
+            return None
+
+        try:
+            return NativeDecoder(os.path.abspath(lib_path))
+        except OSError as e:
+            print('[rtplot] failed to load %s: %s' % (lib_path, e))
+            return None
+
+    def close(self):
+        if self.decoder:
+            self.lib.debug_link_decoder_destroy(self.decoder)
+            self.decoder = None
+
+    def decode(self, data):
+        """Decode the bytes into a list of (msg_id, timestamp, values), the
+        timestamp is None if the frame does not carry one"""
+        results = []
+
+        while True:
+            n = self.lib.debug_link_decoder_feed(self.decoder, data, len(data))
+            data = data[n:]
+
+            while True:
+                cnt = self.lib.debug_link_decoder_decode(
+                    self.decoder, self.records, MAX_RECORDS, self.values,
+                    MAX_VALUES)
+                if cnt == 0:
+                    break
+
+                for record in self.records[:cnt]:
+                    timestamp = None
+                    if record.flags & RECORD_TIMESTAMP:
+                        timestamp = record.timestamp
+
+                    start = record.value_offset
+                    values = self.values[start:start + record.value_cnt]
+                    results.append((record.msg_id, timestamp, values))
+
+            if len(data) == 0:
+                break
+
+        return results
+
+    def stats(self):
+        stats = DebugLinkDecoderStats()
+        self.lib.debug_link_decoder_get_stats(self.decoder,
+                                              ctypes.byref(stats))
+        return stats
@@ -1,3 +1,5 @@
+import binascii
+import itertools
 import numpy as np
 import serial
 import struct
@@ -6,6 +8,7 @@ import time
 from collections import deque
 from datetime import datetime
 
+from .native_decoder import DebugLinkDecoderStats, NativeDecoder
 from .yaml_loader import TenokMsgManager
 
 START_BYTE = '@'
@@ -18,6 +21,16 @@ SIZE_POS = 1
 MSG_ID_POS = 2
 PAYLOAD_POS = 3
 
+# Batch frame: '#', flags, sequence (u16), body size (u16), body, CRC-16
+BATCH_START_BYTE = '#'
+BATCH_HEADER_SIZE = 6
+BATCH_CRC_SIZE = 2
+BATCH_TIMESTAMP_SIZE = 4
+BATCH_RECORD_HEADER_SIZE = 2
+BATCH_FLAG_TIMESTAMP = 0x1
+BATCH_FRAME_MAX = 4096  # Larger frames are treated as noise
+CRC16_INIT_VAL = 0xffff
+
 
 class DataQueue:
     def __init__(self, max_count):
@@ -73,8 +86,28 @@ class SerialManager:
         self.update_rate_last = 0
         self.msg_manager = msg_manager
 
+        # Messages decoded from a batch frame but not yet returned
+        self.pending_msgs = deque()
+
+        # Statistics of the batch frames
+        self.timestamp = None
+        self.seq_expected = None
+        self.frames_recvd = 0
+        self.frames_lost = 0
+        self.frames_reordered = 0
+
+        # Decode with the native library built by msggen if available
+        self.decoder = None
+        if msg_manager.msg_dir is not None:
+            self.decoder = NativeDecoder.load(msg_manager.msg_dir)
+        if self.decoder is not None:
+            print("[rtplot] using the native debug-link decoder")
+        self.native_stats_last = DebugLinkDecoderStats()
+
     def close(self):
         self.ser.close()
+        if self.decoder is not None:
+            self.decoder.close()
 
     def parse_bool(self, buffer, i):
         binary_data = struct.pack("B", buffer[i*4])
@@ -201,61 +234,206 @@ class SerialManager:
 
         return print_str
 
+    def print_msg(self, msg_info, data_list):
+        print_str = self.prompt(msg_info.name, msg_info.msg_id)
+        if self.timestamp is not None:
+            print_str = print_str + \
+                '- timestamp: {:.6f}s\n'.format(self.timestamp / 1e6)
+
+        recept_cnt = 0
+
+        for field in msg_info.fields:
+            # The field is a variable if the array_size is set zero
+            if field.array_size == 0:
+                # Print variable
+                print_str = print_str + \
+                    '- {}: {}\n'.format(field.var_name, data_list[recept_cnt])
+                recept_cnt = recept_cnt + 1
+                continue
+
+            # Print array
+            for j in range(0, field.array_size):
+                print_str = print_str + \
+                    '- {}[{}]: {}\n'.format(field.var_name, j,
+                                            data_list[recept_cnt])
+                recept_cnt = recept_cnt + 1
+
+        # Print prompt message
+        print(print_str, end='')
+
     def decode_msg(self, buffer, msg_id):
         msg_info = self.msg_manager.find_id(msg_id)
 
         # Message type does not exist
         if msg_info is None:
-            return 'failed', None, None, None
-
-        msg_name = msg_info.name
-        var_cnt = len(msg_info.fields)
-
-        print_str = self.prompt(msg_name, msg_id)
+            return 'failed', None, None
 
         data_list = []
         recept_cnt = 0
 
-        for i in range(0, var_cnt):
-            var_name = msg_info.fields[i].var_name
-            array_size = msg_info.fields[i].array_size
-            c_type = msg_info.fields[i].c_type
-
+        for field in msg_info.fields:
             # The field is a variable if the array_size is set zero
-            is_array = True
+            array_size = field.array_size
             if array_size == 0:
-                is_array = False
                 array_size = 1
 
             # Decode array elements of each fields
             for j in range(0, array_size):
-                decoded_data = self.decode_field(buffer, c_type, recept_cnt)
+                decoded_data = self.decode_field(buffer, field.c_type,
+                                                 recept_cnt)
                 if decoded_data is None:
-                    return 'failed', None, None, None
+                    return 'failed', None, None
 
                 data_list.append(decoded_data)
                 recept_cnt = recept_cnt + 1
 
-                if is_array == True:
-                    # Print array
-                    print_str = print_str + \
-                        '- {}[{}]: {}\n'.format(var_name, j, decoded_data)
-                else:
-                    # Print variable
-                    print_str = print_str + \
-                        '- {}: {}\n'.format(var_name, decoded_data)
+        self.print_msg(msg_info, data_list)
 
-        # Print prompt message
-        print(print_str, end='')
+        return 'success', msg_info.name, data_list
+
+    def peek(self, size):
+        return b''.join(itertools.islice(self.serial_fifo, 0, size))
+
+    def track_seq(self, seq):
+        self.frames_recvd += 1
+
+        if self.seq_expected is not None and seq != self.seq_expected:
+            gap = (seq - self.seq_expected) & 0xffff
+            if gap >= 0x8000:
+                # The frame is older than the expected one
+                self.frames_reordered += 1
+                print("warning: frame reordered or duplicated (seq={})".format(
+                    seq))
+                return
+
+            self.frames_lost += gap
+            loss = 100.0 * self.frames_lost / \
+                (self.frames_recvd + self.frames_lost)
+            print("warning: {} frame(s) lost (seq={}), loss rate {:.2f}%".format(
+                gap, seq, loss))
+
+        self.seq_expected = (seq + 1) & 0xffff
+
+    def receive_batch(self):
+        # Wait until the header is received
+        if len(self.serial_fifo) < BATCH_HEADER_SIZE:
+            return 'retry', None, None, None
+
+        header = self.peek(BATCH_HEADER_SIZE)
+        flags, seq, body_size = struct.unpack("<BHH", header[1:])
+
+        # Resync on a corrupted size field instead of waiting for the frame
+        frame_size = BATCH_HEADER_SIZE + body_size + BATCH_CRC_SIZE
+        if frame_size > BATCH_FRAME_MAX:
+            # Shift the FIFO by discarding the oldest byte
+            self.serial_fifo.popleft()
+            print("error: batch frame too large")
+            return 'failed', None, None, None
 
-        return 'success', msg_name, data_list
+        # Wait until the whole frame is received
+        if len(self.serial_fifo) < frame_size:
+            return 'retry', None, None, None
+
+        # CRC verification, the start byte is not covered
+        frame = self.peek(frame_size)
+        crc = struct.unpack("<H", frame[-BATCH_CRC_SIZE:])[0]
+        if binascii.crc_hqx(frame[1:-BATCH_CRC_SIZE], CRC16_INIT_VAL) != crc:
+            # Shift the FIFO by discarding the oldest byte
+            self.serial_fifo.popleft()
+            print("error: CRC mismatched")
+            return 'failed', None, None, None
+
+        # Discard used bytes from serial buffer
+        for i in range(0, frame_size):
+            self.serial_fifo.popleft()
+
+        self.track_seq(seq)
+
+        pos = BATCH_HEADER_SIZE
+        end = BATCH_HEADER_SIZE + body_size
+
+        self.timestamp = None
+        if flags & BATCH_FLAG_TIMESTAMP:
+            self.timestamp = struct.unpack_from("<I", frame, pos)[0]
+            pos = pos + BATCH_TIMESTAMP_SIZE
+
+        # Decode the records of the messages
+        while pos + BATCH_RECORD_HEADER_SIZE <= end:
+            msg_id = frame[pos]
+            payload_cnt = frame[pos + 1]
+            pos = pos + BATCH_RECORD_HEADER_SIZE
+
+            if pos + payload_cnt > end:
+                print("error: truncated message in the batch")
+                break
+
+            result, msg_name, data = self.decode_msg(
+                frame[pos:pos + payload_cnt], msg_id)
+            if result == 'success':
+                self.pending_msgs.append(('success', msg_id, msg_name, data))
+
+            pos = pos + payload_cnt
+
+        if len(self.pending_msgs) == 0:
+            return 'failed', None, None, None
+
+        return self.pending_msgs.popleft()
+
+    def report_native_stats(self):
+        stats = self.decoder.stats()
+        last = self.native_stats_last
+        self.native_stats_last = stats
+
+        lost = stats.batches_lost - last.batches_lost
+        if lost > 0:
+            loss = 100.0 * stats.batches_lost / \
+                (stats.batches + stats.batches_lost)
+            print("warning: {} frame(s) lost, loss rate {:.2f}%".format(
+                lost, loss))
+
+        if stats.batches_reordered > last.batches_reordered:
+            print("warning: frame reordered or duplicated")
+
+        errors = stats.checksum_errors + stats.crc_errors
+        if errors > last.checksum_errors + last.crc_errors:
+            print("error: checksum mismatched")
+
+    def receive_msg_native(self):
+        # Read the available bytes at once, or wait for one until the timeout
+        data = self.ser.read(max(1, self.ser.inWaiting()))
+        if len(data) == 0:
+            return 'retry', None, None, None
+
+        for msg_id, timestamp, data_list in self.decoder.decode(data):
+            msg_info = self.msg_manager.find_id(msg_id)
+            if msg_info is None:
+                continue
+
+            self.timestamp = timestamp
+            self.print_msg(msg_info, data_list)
+            self.pending_msgs.append(
+                ('success', msg_id, msg_info.name, data_list))
+
+        self.report_native_stats()
+
+        if len(self.pending_msgs) == 0:
+            return 'retry', None, None, None
+
+        return self.pending_msgs.popleft()
 
     def receive_msg(self):
+        # Return the remaining messages of the last batch frame
+        if len(self.pending_msgs) > 0:
+            return self.pending_msgs.popleft()
+
+        if self.decoder is not None:
+            return self.receive_msg_native()
+
         # Collect bytes from serial
         avail_cnt = self.ser.inWaiting()
         if avail_cnt > 0:
-            for i in range(0, avail_cnt):
-                self.serial_fifo.append(self.ser.read(1))
+            data = self.ser.read(avail_cnt)
+            self.serial_fifo.extend(data[i:i + 1] for i in range(len(data)))
 
         # Wait until at least the size of header is received
         if len(self.serial_fifo) < HEADER_SIZE:
@@ -263,7 +441,9 @@ class SerialManager:
 
         # Start byte checking
         start_byte = struct.unpack("B", self.serial_fifo[START_BYTE_POS])[0]
-        if start_byte != ord(START_BYTE):
+        if start_byte == ord(BATCH_START_BYTE):
+            return self.receive_batch()
+        elif start_byte != ord(START_BYTE):
             # Move to next position by discarding the oldest byte
             self.serial_fifo.popleft()
             return 'retry', None, None, None
@@ -298,6 +478,7 @@ class SerialManager:
             return 'failed', None, None, None
 
         # Decode message fields
+        self.timestamp = None
         result, msg_name, data = self.decode_msg(buf, msg_id)
         if result == 'failed':
             return 'failed', None, None, None
@@ -1,3 +1,4 @@
+import os
 import yaml
 from dataclasses import dataclass
 
@@ -20,12 +21,14 @@ class TenokMsg:
 class TenokMsgManager:
     def __init__(self):
         self.msg_list = []
+        self.msg_dir = None
 
     def load(self, msg_file_path, msg_name):
         with open(msg_file_path, "r") as stream:
             data = yaml.load(stream, Loader=yaml.FullLoader)
 
         msg = TenokMsg(msg_name, data['msg_id'], [])
+        self.msg_dir = os.path.dirname(msg_file_path)
 
         for i in range(0, len(data['payload'])):
             m = TenokMsgField(data['payload'][i]['c_type'],
@@ -3,3 +3,10 @@ PROJ_ROOT := $(dir $(lastword $(MAKEFILE_LIST)))/../..
 # Enable the benchmark by uncommenting the line and execute them with shell
 #include $(PROJ_ROOT)/user/benchmarks/dhrystone/dhrystone.mk
 #include $(PROJ_ROOT)/user/benchmarks/coremark/coremark.mk
+#include $(PROJ_ROOT)/user/benchmarks/rtbench/rtbench.mk
+
+# Stress scenarios, run headless with `make stress` or type `stress` in the
+# shell after `make qemu STRESS=1`
+ifeq ($(STRESS),1)
+include $(PROJ_ROOT)/user/benchmarks/stress/stress.mk
+endif
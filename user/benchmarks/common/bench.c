@@ -0,0 +1,79 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+void bench_stat_init(struct bench_stat *stat,
+                     uint32_t *samples,
+                     uint32_t samples_max)
+{
+    memset(stat, 0, sizeof(*stat));
+    stat->min = UINT32_MAX;
+    stat->samples = samples;
+    stat->samples_max = samples ? samples_max : 0;
+}
+
+void bench_stat_add(struct bench_stat *stat, uint32_t val)
+{
+    /* The percentiles cover the first samples while the others cover all */
+    if (stat->cnt < stat->samples_max)
+        stat->samples[stat->cnt] = val;
+
+    stat->cnt++;
+    stat->sum += val;
+    if (val < stat->min)
+        stat->min = val;
+    if (val > stat->max)
+        stat->max = val;
+
+    int bucket = val ? 32 - __builtin_clz(val) : 0;
+    if (bucket >= BENCH_HIST_SIZE)
+        bucket = BENCH_HIST_SIZE - 1;
+    stat->hist[bucket]++;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t bench_stat_kept(struct bench_stat *stat)
+{
+    return stat->cnt < stat->samples_max ? stat->cnt : stat->samples_max;
+}
+
+uint32_t bench_stat_sort(struct bench_stat *stat)
+{
+    uint32_t n = bench_stat_kept(stat);
+    qsort(stat->samples, n, sizeof(uint32_t), cmp_u32);
+    return n;
+}
+
+uint32_t bench_stat_percentile(struct bench_stat *stat, int percent)
+{
+    uint32_t n = bench_stat_kept(stat);
+    if (n == 0)
+        return 0;
+
+    int rank = (n * percent + 99) / 100;
+    return stat->samples[rank > 0 ? rank - 1 : 0];
+}
+
+int bench_thread_create(pthread_t *tid,
+                        int priority,
+                        size_t stacksize,
+                        void *(*func)(void *),
+                        void *arg)
+{
+    struct sched_param param = {.sched_priority = priority};
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setschedparam(&attr, &param);
+    pthread_attr_setstacksize(&attr, stacksize);
+
+    return pthread_create(tid, &attr, func, arg);
+}
@@ -0,0 +1,69 @@
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define BENCH_HIST_SIZE 16 /* log2 buckets */
+
+struct bench_stat {
+    uint32_t cnt;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t hist[BENCH_HIST_SIZE];
+    uint32_t *samples; /* Kept for the percentiles if given */
+    uint32_t samples_max;
+};
+
+/**
+ * @brief  Reset the statistics
+ * @param  stat: Pointer to the statistics.
+ * @param  samples: Buffer of the samples, or NULL not to keep them.
+ * @param  samples_max: Number of the samples the buffer holds.
+ * @retval None
+ */
+void bench_stat_init(struct bench_stat *stat,
+                     uint32_t *samples,
+                     uint32_t samples_max);
+
+/**
+ * @brief  Add a sample to the statistics
+ * @param  stat: Pointer to the statistics.
+ * @param  val: The sample.
+ * @retval None
+ */
+void bench_stat_add(struct bench_stat *stat, uint32_t val);
+
+/**
+ * @brief  Sort the kept samples for bench_stat_percentile()
+ * @param  stat: Pointer to the statistics.
+ * @retval uint32_t: Number of the kept samples.
+ */
+uint32_t bench_stat_sort(struct bench_stat *stat);
+
+/**
+ * @brief  Get the percentile of the sorted samples by the nearest rank
+ * @param  stat: Pointer to the statistics.
+ * @param  percent: The percentile between 0 and 100.
+ * @retval uint32_t: The sample of the rank, or 0 without samples.
+ */
+uint32_t bench_stat_percentile(struct bench_stat *stat, int percent);
+
+/**
+ * @brief  Create a benchmark thread with the given priority and stack size
+ * @param  tid: For returning the thread ID.
+ * @param  priority: Priority of the thread.
+ * @param  stacksize: Stack size of the thread in bytes.
+ * @param  func: Thread function.
+ * @param  arg: Argument of the thread function.
+ * @retval int: 0 on success and nonzero error number on error.
+ */
+int bench_thread_create(pthread_t *tid,
+                        int priority,
+                        size_t stacksize,
+                        void *(*func)(void *),
+                        void *arg);
+
+#endif
@@ -0,0 +1,10 @@
+PROJ_ROOT := $(dir $(lastword $(MAKEFILE_LIST)))/../../..
+
+# Shared by the benchmarks, included once however many are enabled
+ifeq ($(BENCH_COMMON),)
+BENCH_COMMON := 1
+
+CFLAGS += -I $(PROJ_ROOT)/user/benchmarks/common
+
+SRC += $(PROJ_ROOT)/user/benchmarks/common/bench.c
+endif
@@ -0,0 +1,442 @@
+/* RTOS microbenchmarks. The results are printed as CSV lines so they can be
+ * collected from the console and compared between releases:
+ *
+ * rtbench,<name>,<param>,<samples>,<min>,<avg>,<max>,<unit>
+ * rtbench-hist,<name>,<param>,<log2 bucket counts...>
+ */
+
+#include <fcntl.h>
+#include <mqueue.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <tenok.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <kconfig.h>
+
+#include "bench.h"
+#include "shell.h"
+
+#define RTBENCH_ITERATIONS 1000
+#define RTBENCH_WAKE_ITERATIONS 100 /* Each sample takes a few ticks */
+#define RTBENCH_STACK_SIZE 1024
+
+/* The benchmark runs on the highest priority so the workers only start
+ * after being joined */
+#define RTBENCH_PRI_MAIN THREAD_PRIORITY_MAX
+#define RTBENCH_PRI_HIGH (THREAD_PRIORITY_MAX - 1)
+#define RTBENCH_PRI_LOW (THREAD_PRIORITY_MAX - 2)
+
+#define RTBENCH_FIFO "/rtbench_fifo"
+#define RTBENCH_MQ "/rtbench_mq"
+#define RTBENCH_PIPE_BYTES 4096
+
+#define NANOSECOND_TICKS (1000000000 / OS_TICK_FREQ)
+
+static int iterations;
+static uint32_t cycles_overhead; /* Cost of reading the cycle counter */
+
+static struct bench_stat stat;
+static sem_t sem_ping, sem_pong;
+static pthread_mutex_t mutex;
+static volatile uint32_t stamp;
+static volatile pthread_t last_yielder;
+static int fifo_fd;
+static mqd_t mqdes;
+
+static void stat_reset(void)
+{
+    bench_stat_init(&stat, NULL, 0);
+}
+
+static void stat_add(uint32_t val, bool cycles)
+{
+    /* Exclude the cost of the measurement */
+    if (cycles)
+        val = (val > cycles_overhead) ? val - cycles_overhead : 0;
+
+    bench_stat_add(&stat, val);
+}
+
+static void stat_print(const char *name, int param, const char *unit)
+{
+    if (stat.cnt == 0) {
+        printf("rtbench,%s,%d,0,0,0,0,%s\n\r", name, param, unit);
+        return;
+    }
+
+    printf("rtbench,%s,%d,%u,%u,%u,%u,%s\n\r", name, param,
+           (unsigned int) stat.cnt, (unsigned int) stat.min,
+           (unsigned int) (stat.sum / stat.cnt), (unsigned int) stat.max,
+           unit);
+}
+
+static void stat_print_hist(const char *name, int param)
+{
+    printf("rtbench-hist,%s,%d", name, param);
+    for (int i = 0; i < BENCH_HIST_SIZE; i++)
+        printf(",%u", (unsigned int) stat.hist[i]);
+    printf("\n\r");
+}
+
+static void bench_run(void *(*func1)(void *),
+                      int pri1,
+                      void *(*func2)(void *),
+                      int pri2)
+{
+    pthread_t tid1, tid2;
+
+    if (bench_thread_create(&tid1, pri1, RTBENCH_STACK_SIZE, func1, NULL) < 0)
+        return;
+
+    if (bench_thread_create(&tid2, pri2, RTBENCH_STACK_SIZE, func2, NULL) <
+        0) {
+        pthread_join(tid1, NULL);
+        return;
+    }
+
+    pthread_join(tid1, NULL);
+    pthread_join(tid2, NULL);
+}
+
+static void calibrate(void)
+{
+    cycles_overhead = UINT32_MAX;
+
+    for (int i = 0; i < 100; i++) {
+        uint32_t start = getcycles();
+        uint32_t cycles = getcycles() - start;
+        if (cycles < cycles_overhead)
+            cycles_overhead = cycles;
+    }
+
+    printf("rtbench,overhead,0,100,%u,%u,%u,cycles\n\r",
+           (unsigned int) cycles_overhead, (unsigned int) cycles_overhead,
+           (unsigned int) cycles_overhead);
+}
+
+static void bench_syscall(void)
+{
+    stat_reset();
+
+    for (int i = 0; i < iterations; i++) {
+        uint32_t start = getcycles();
+        getpid();
+        stat_add(getcycles() - start, true);
+    }
+
+    stat_print("syscall", 0, "cycles");
+}
+
+static void *yield_thread(void *arg)
+{
+    pthread_t self = pthread_self();
+
+    for (int i = 0; i < iterations; i++) {
+        /* Only count the switches from the other thread */
+        uint32_t now = getcycles();
+        if (last_yielder && last_yielder != self)
+            stat_add(now - stamp, true);
+
+        last_yielder = self;
+        stamp = getcycles();
+        sched_yield();
+    }
+
+    return NULL;
+}
+
+static void bench_context_switch(void)
+{
+    stat_reset();
+    last_yielder = 0;
+
+    bench_run(yield_thread, RTBENCH_PRI_LOW, yield_thread, RTBENCH_PRI_LOW);
+
+    stat_print("context_switch", 0, "cycles");
+}
+
+static void *sem_ping_thread(void *arg)
+{
+    for (int i = 0; i < iterations; i++) {
+        uint32_t start = getcycles();
+        sem_post(&sem_ping);
+        sem_wait(&sem_pong);
+        stat_add(getcycles() - start, true);
+    }
+
+    return NULL;
+}
+
+static void *sem_pong_thread(void *arg)
+{
+    for (int i = 0; i < iterations; i++) {
+        sem_wait(&sem_ping);
+        sem_post(&sem_pong);
+    }
+
+    return NULL;
+}
+
+static void bench_semaphore(void)
+{
+    stat_reset();
+    sem_init(&sem_ping, 0, 0);
+    sem_init(&sem_pong, 0, 0);
+
+    bench_run(sem_ping_thread, RTBENCH_PRI_LOW, sem_pong_thread,
+              RTBENCH_PRI_LOW);
+
+    stat_print("sem_pingpong", 0, "cycles");
+}
+
+static void *mutex_waiter_thread(void *arg)
+{
+    for (int i = 0; i < iterations; i++) {
+        /* Block on the mutex held by the low priority thread */
+        sem_wait(&sem_ping);
+        pthread_mutex_lock(&mutex);
+        stat_add(getcycles() - stamp, true);
+        pthread_mutex_unlock(&mutex);
+    }
+
+    return NULL;
+}
+
+static void *mutex_owner_thread(void *arg)
+{
+    for (int i = 0; i < iterations; i++) {
+        pthread_mutex_lock(&mutex);
+        sem_post(&sem_ping);
+        stamp = getcycles();
+        pthread_mutex_unlock(&mutex);
+    }
+
+    return NULL;
+}
+
+static void bench_mutex(void)
+{
+    pthread_mutex_init(&mutex, NULL);
+
+    /* Uncontended lock and unlock */
+    stat_reset();
+    for (int i = 0; i < iterations; i++) {
+        uint32_t start = getcycles();
+        pthread_mutex_lock(&mutex);
+        pthread_mutex_unlock(&mutex);
+        stat_add(getcycles() - start, true);
+    }
+    stat_print("mutex_uncontended", 0, "cycles");
+
+    /* Unlock to the wake up of the blocked waiter */
+    stat_reset();
+    sem_init(&sem_ping, 0, 0);
+    bench_run(mutex_waiter_thread, RTBENCH_PRI_HIGH, mutex_owner_thread,
+              RTBENCH_PRI_LOW);
+    stat_print("mutex_contended", 0, "cycles");
+}
+
+static int pipe_chunk_size;
+
+static void *pipe_reader_thread(void *arg)
+{
+    char buf[PIPE_BUF];
+
+    int chunks = RTBENCH_PIPE_BYTES / pipe_chunk_size;
+    for (int i = 0; i < chunks; i++)
+        read(fifo_fd, buf, pipe_chunk_size);
+
+    /* Cycles per KiB */
+    uint64_t cycles = getcycles() - stamp;
+    stat_add(cycles * 1024 / (chunks * pipe_chunk_size), false);
+
+    return NULL;
+}
+
+static void *pipe_writer_thread(void *arg)
+{
+    char buf[PIPE_BUF] = {0};
+
+    stamp = getcycles();
+    for (int i = 0; i < RTBENCH_PIPE_BYTES / pipe_chunk_size; i++)
+        write(fifo_fd, buf, pipe_chunk_size);
+
+    return NULL;
+}
+
+static void bench_pipe(void)
+{
+    /* The FIFO is kept for the next run */
+    mkfifo(RTBENCH_FIFO, 0);
+
+    fifo_fd = open(RTBENCH_FIFO, O_RDWR);
+    if (fifo_fd < 0) {
+        printf("rtbench: failed to open the fifo\n\r");
+        return;
+    }
+
+    const int chunk_sizes[] = {1, 4, 16, 64, PIPE_BUF};
+
+    for (int i = 0; i < sizeof(chunk_sizes) / sizeof(int); i++) {
+        stat_reset();
+        pipe_chunk_size = chunk_sizes[i];
+        bench_run(pipe_reader_thread, RTBENCH_PRI_LOW, pipe_writer_thread,
+                  RTBENCH_PRI_LOW);
+        stat_print("pipe_throughput", pipe_chunk_size, "cycles/KiB");
+    }
+
+    close(fifo_fd);
+}
+
+static void *mq_receiver_thread(void *arg)
+{
+    uint32_t msg;
+
+    for (int i = 0; i < iterations; i++) {
+        mq_receive(mqdes, (char *) &msg, sizeof(msg), NULL);
+        stat_add(getcycles() - msg, true);
+    }
+
+    return NULL;
+}
+
+static void *mq_sender_thread(void *arg)
+{
+    for (int i = 0; i < iterations; i++) {
+        uint32_t msg = getcycles();
+        mq_send(mqdes, (char *) &msg, sizeof(msg), 0);
+    }
+
+    return NULL;
+}
+
+static void bench_mqueue(void)
+{
+    struct mq_attr attr = {
+        .mq_maxmsg = 4,
+        .mq_msgsize = sizeof(uint32_t),
+    };
+
+    mqdes = mq_open(RTBENCH_MQ, O_CREAT | O_RDWR, &attr);
+    if (mqdes < 0) {
+        printf("rtbench: failed to open the message queue\n\r");
+        return;
+    }
+
+    stat_reset();
+    bench_run(mq_receiver_thread, RTBENCH_PRI_HIGH, mq_sender_thread,
+              RTBENCH_PRI_LOW);
+    stat_print("mq_latency", 0, "cycles");
+
+    mq_close(mqdes);
+}
+
+static void bench_malloc(void)
+{
+    const int sizes[] = {16, 64, 256};
+    void *ptrs[32];
+
+    for (int i = 0; i < sizeof(sizes) / sizeof(int); i++) {
+        stat_reset();
+
+        for (int j = 0; j < iterations; j += 32) {
+            /* Allocate a batch before freeing to fragment the heap */
+            for (int k = 0; k < 32; k++) {
+                uint32_t start = getcycles();
+                ptrs[k] = malloc(sizes[i]);
+                stat_add(getcycles() - start, true);
+            }
+
+            for (int k = 0; k < 32; k++)
+                free(ptrs[k]);
+        }
+
+        stat_print("malloc", sizes[i], "cycles");
+        stat_print_hist("malloc", sizes[i]);
+    }
+}
+
+static uint64_t timespec_to_ns(const struct timespec *tp)
+{
+    return (uint64_t) tp->tv_sec * 1000000000ULL + tp->tv_nsec;
+}
+
+static void bench_wake_latency(void)
+{
+    int fd = timerfd_create(CLOCK_MONOTONIC, 0);
+    if (fd < 0) {
+        printf("rtbench: failed to create the timer fd\n\r");
+        return;
+    }
+
+    int n = iterations < RTBENCH_WAKE_ITERATIONS ? iterations
+                                                 : RTBENCH_WAKE_ITERATIONS;
+
+    stat_reset();
+    for (int i = 0; i < n; i++) {
+        /* Expire on a tick boundary so the latency is measured from the
+         * tick interrupt (assumes the clock has not been set) */
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        uint64_t expiry =
+            (timespec_to_ns(&now) / NANOSECOND_TICKS + 2) * NANOSECOND_TICKS;
+
+        struct itimerspec its = {0};
+        its.it_value.tv_sec = expiry / 1000000000ULL;
+        its.it_value.tv_nsec = expiry % 1000000000ULL;
+        timerfd_settime(fd, TFD_TIMER_ABSTIME, &its, NULL);
+
+        uint64_t expirations;
+        read(fd, &expirations, sizeof(expirations));
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        stat_add(timespec_to_ns(&now) - expiry, false);
+    }
+    stat_print("irq_wake_latency", 0, "ns");
+
+    close(fd);
+}
+
+int rtbench(int argc, char *argv[])
+{
+    iterations = (argc > 1) ? atoi(argv[1]) : RTBENCH_ITERATIONS;
+    if (iterations <= 0) {
+        printf("usage: rtbench [iterations]\n\r");
+        return 0;
+    }
+
+    /* Raise the priority so the workers only run when being joined */
+    int policy;
+    struct sched_param param, old_param;
+    pthread_getschedparam(pthread_self(), &policy, &old_param);
+    param.sched_priority = RTBENCH_PRI_MAIN;
+    pthread_setschedparam(pthread_self(), policy, &param);
+
+    printf("rtbench,name,param,samples,min,avg,max,unit\n\r");
+
+    calibrate();
+    bench_syscall();
+    bench_context_switch();
+    bench_semaphore();
+    bench_mutex();
+    bench_pipe();
+    bench_mqueue();
+    bench_malloc();
+    bench_wake_latency();
+
+    pthread_setschedparam(pthread_self(), policy, &old_param);
+
+    return 0;
+}
+
+HOOK_SHELL_CMD("rtbench", rtbench);
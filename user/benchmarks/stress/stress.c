@@ -0,0 +1,612 @@
+/* Stress scenarios of the RTOS. Each scenario is started by the `stress`
+ * shell command and reports the results as CSV lines, which are collected
+ * and compared against the thresholds by the scripts/stress.py:
+ *
+ * stress,<scenario>,<metric>,<value>,<unit>
+ * stress,<scenario>,done
+ *
+ * The latencies are in nanoseconds. The percentiles are computed from the
+ * first STRESS_SAMPLES_MAX samples while the maximum covers all samples.
+ */
+
+#include <fcntl.h>
+#include <mqueue.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <tenok.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <kconfig.h>
+
+#include "bench.h"
+#include "shell.h"
+
+#define STRESS_SAMPLES_MAX 1024
+#define STRESS_STACK_SIZE 1024
+#define STRESS_THREADS_MAX 8
+#define STRESS_CHAIN_MAX 4
+
+/* The scenario runs on the highest priority so the workers only start
+ * after being joined */
+#define STRESS_PRI_MAIN THREAD_PRIORITY_MAX
+#define STRESS_PRI_HIGH (THREAD_PRIORITY_MAX - 1)
+#define STRESS_PRI_MEDIUM (THREAD_PRIORITY_MAX - 2)
+#define STRESS_PRI_LOW 1
+
+#define STRESS_FIFO "/stress_fifo"
+#define STRESS_MQ "/stress_mq"
+#define STRESS_MQ_DEPTH 8
+
+#define STRESS_HOLD_NS 100000     /* Critical section of the chain tail */
+#define STRESS_HOG_NS 50000000    /* CPU time burnt by the medium thread */
+#define STRESS_TIMER_WARMUP_NS 20000000
+
+#define NANOSECOND_TICKS (1000000000 / OS_TICK_FREQ)
+
+struct stress_msg {
+    uint32_t producer;
+    uint32_t seq;
+    uint64_t stamp;
+};
+
+static struct bench_stat stat;
+static uint32_t samples[STRESS_SAMPLES_MAX];
+static pthread_mutex_t stat_mtx;
+
+static int producers, consumers, messages;
+static volatile uint32_t errors;
+static int fifo_fd;
+static mqd_t mqdes;
+
+static pthread_mutex_t chain_mtx[STRESS_CHAIN_MAX];
+static sem_t chain_go[STRESS_CHAIN_MAX], chain_locked[STRESS_CHAIN_MAX];
+static sem_t hog_go;
+static volatile bool chain_quit, hog_quit, hog_stop, hog_ran;
+static int chain_depth, chain_iterations;
+static volatile uint32_t inversions;
+
+static int timer_period_ns, timer_expirations;
+static uint64_t timer_start;
+static volatile uint32_t overruns;
+
+static uint64_t now_ns(void)
+{
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return (uint64_t) tp.tv_sec * 1000000000ULL + tp.tv_nsec;
+}
+
+static void spin_ns(uint32_t ns)
+{
+    uint64_t start = now_ns();
+    while (now_ns() - start < ns)
+        ;
+}
+
+static void stat_reset(void)
+{
+    bench_stat_init(&stat, samples, STRESS_SAMPLES_MAX);
+    pthread_mutex_init(&stat_mtx, NULL);
+    errors = 0;
+}
+
+static void stat_add(uint64_t ns)
+{
+    uint32_t val = (ns > UINT32_MAX) ? UINT32_MAX : ns;
+
+    pthread_mutex_lock(&stat_mtx);
+    bench_stat_add(&stat, val);
+    pthread_mutex_unlock(&stat_mtx);
+}
+
+static void report(const char *scenario,
+                   const char *metric,
+                   uint32_t val,
+                   const char *unit)
+{
+    printf("stress,%s,%s,%u,%s\n\r", scenario, metric, (unsigned int) val,
+           unit);
+}
+
+static void report_latency(const char *scenario)
+{
+    if (bench_stat_sort(&stat) == 0) {
+        report(scenario, "samples", 0, "count");
+        return;
+    }
+
+    report(scenario, "samples", stat.cnt, "count");
+    report(scenario, "lat_p50", bench_stat_percentile(&stat, 50), "ns");
+    report(scenario, "lat_p90", bench_stat_percentile(&stat, 90), "ns");
+    report(scenario, "lat_p99", bench_stat_percentile(&stat, 99), "ns");
+    report(scenario, "lat_max", stat.max, "ns");
+}
+
+static void report_throughput(const char *scenario,
+                              uint32_t cnt,
+                              uint64_t elapsed_ns)
+{
+    uint64_t rate = elapsed_ns ? (uint64_t) cnt * 1000000000ULL / elapsed_ns
+                               : 0;
+    report(scenario, "elapsed", elapsed_ns / 1000, "us");
+    report(scenario, "throughput", rate, "1/s");
+}
+
+static int stress_thread_create(pthread_t *tid,
+                                int priority,
+                                void *(*func)(void *),
+                                void *arg)
+{
+    return bench_thread_create(tid, priority, STRESS_STACK_SIZE, func, arg);
+}
+
+/* Run the producers and consumers, which are joined afterward */
+static uint64_t stress_run_workers(void *(*producer)(void *),
+                                   void *(*consumer)(void *))
+{
+    pthread_t tids[STRESS_THREADS_MAX * 2];
+    int cnt = 0;
+
+    uint64_t start = now_ns();
+
+    for (int i = 0; i < consumers; i++) {
+        if (stress_thread_create(&tids[cnt], STRESS_PRI_LOW, consumer,
+                                 (void *) i) == 0)
+            cnt++;
+    }
+
+    for (int i = 0; i < producers; i++) {
+        if (stress_thread_create(&tids[cnt], STRESS_PRI_LOW, producer,
+                                 (void *) i) == 0)
+            cnt++;
+    }
+
+    if (cnt != producers + consumers)
+        errors++;
+
+    for (int i = 0; i < cnt; i++)
+        pthread_join(tids[i], NULL);
+
+    return now_ns() - start;
+}
+
+/* Number of messages received by the consumer so the total matches */
+static int consumer_share(int id)
+{
+    int total = producers * messages;
+    return total / consumers + (id < total % consumers);
+}
+
+static void consumer_check(struct stress_msg *msg, uint32_t *last_seq)
+{
+    /* Messages of a producer must arrive in order and intact */
+    if (msg->producer >= producers || msg->seq >= messages) {
+        errors++;
+        return;
+    }
+
+    uint32_t *last = &last_seq[msg->producer];
+    if (*last != UINT32_MAX && msg->seq <= *last)
+        errors++;
+    *last = msg->seq;
+}
+
+static void *pipe_producer_thread(void *arg)
+{
+    struct stress_msg msg = {.producer = (uint32_t) arg};
+
+    for (int i = 0; i < messages; i++) {
+        msg.seq = i;
+        msg.stamp = now_ns();
+        if (write(fifo_fd, &msg, sizeof(msg)) != sizeof(msg))
+            errors++;
+    }
+
+    return NULL;
+}
+
+static void *pipe_consumer_thread(void *arg)
+{
+    uint32_t last_seq[STRESS_THREADS_MAX];
+    memset(last_seq, 0xff, sizeof(last_seq));
+
+    struct stress_msg msg;
+    int n = consumer_share((int) arg);
+
+    for (int i = 0; i < n; i++) {
+        if (read(fifo_fd, &msg, sizeof(msg)) != sizeof(msg)) {
+            errors++;
+            continue;
+        }
+
+        stat_add(now_ns() - msg.stamp);
+        consumer_check(&msg, last_seq);
+    }
+
+    return NULL;
+}
+
+static void stress_pipe(void)
+{
+    /* The FIFO is kept for the next run */
+    mkfifo(STRESS_FIFO, 0);
+
+    fifo_fd = open(STRESS_FIFO, O_RDWR);
+    if (fifo_fd < 0) {
+        printf("stress,pipe,error,failed to open the fifo\n\r");
+        return;
+    }
+
+    stat_reset();
+    uint64_t elapsed =
+        stress_run_workers(pipe_producer_thread, pipe_consumer_thread);
+
+    report_latency("pipe");
+    report_throughput("pipe", producers * messages, elapsed);
+    report("pipe", "errors", errors, "count");
+
+    close(fifo_fd);
+}
+
+static void *mq_producer_thread(void *arg)
+{
+    struct stress_msg msg = {.producer = (uint32_t) arg};
+
+    for (int i = 0; i < messages; i++) {
+        msg.seq = i;
+        msg.stamp = now_ns();
+        if (mq_send(mqdes, (char *) &msg, sizeof(msg), 0) < 0)
+            errors++;
+    }
+
+    return NULL;
+}
+
+static void *mq_consumer_thread(void *arg)
+{
+    uint32_t last_seq[STRESS_THREADS_MAX];
+    memset(last_seq, 0xff, sizeof(last_seq));
+
+    struct stress_msg msg;
+    int n = consumer_share((int) arg);
+
+    for (int i = 0; i < n; i++) {
+        if (mq_receive(mqdes, (char *) &msg, sizeof(msg), NULL) !=
+            sizeof(msg)) {
+            errors++;
+            continue;
+        }
+
+        stat_add(now_ns() - msg.stamp);
+        consumer_check(&msg, last_seq);
+    }
+
+    return NULL;
+}
+
+static void stress_mqueue(void)
+{
+    struct mq_attr attr = {
+        .mq_maxmsg = STRESS_MQ_DEPTH,
+        .mq_msgsize = sizeof(struct stress_msg),
+    };
+
+    mqdes = mq_open(STRESS_MQ, O_CREAT | O_RDWR, &attr);
+    if (mqdes < 0) {
+        printf("stress,mq,error,failed to open the message queue\n\r");
+        return;
+    }
+
+    stat_reset();
+    uint64_t elapsed =
+        stress_run_workers(mq_producer_thread, mq_consumer_thread);
+
+    report_latency("mq");
+    report_throughput("mq", producers * messages, elapsed);
+    report("mq", "errors", errors, "count");
+
+    mq_close(mqdes);
+}
+
+/* The chain threads are ordered by priority. Each one locks its own mutex
+ * and then the mutex of the lower one, so the high thread waits for the
+ * whole chain and the lowest thread holding the tail burns the hold time.
+ * The chain must inherit the priority of the high thread, otherwise the
+ * medium thread hogs the CPU and the latency grows by its budget */
+static void *chain_thread(void *arg)
+{
+    int id = (int) arg;
+
+    while (1) {
+        sem_wait(&chain_go[id]);
+        if (chain_quit)
+            break;
+
+        pthread_mutex_lock(&chain_mtx[id]);
+        sem_post(&chain_locked[id]);
+
+        if (id > 0) {
+            pthread_mutex_lock(&chain_mtx[id - 1]);
+            pthread_mutex_unlock(&chain_mtx[id - 1]);
+        } else {
+            spin_ns(STRESS_HOLD_NS);
+        }
+
+        pthread_mutex_unlock(&chain_mtx[id]);
+    }
+
+    return NULL;
+}
+
+static void *hog_thread(void *arg)
+{
+    while (1) {
+        sem_wait(&hog_go);
+        if (hog_quit)
+            break;
+
+        /* Occupy the CPU until the high thread gets the mutex */
+        uint64_t start = now_ns();
+        while (!hog_stop && now_ns() - start < STRESS_HOG_NS)
+            hog_ran = true;
+    }
+
+    return NULL;
+}
+
+static void *chain_high_thread(void *arg)
+{
+    pthread_mutex_t *head = &chain_mtx[chain_depth - 1];
+
+    for (int i = 0; i < chain_iterations; i++) {
+        /* Build the chain from the lowest thread */
+        for (int j = 0; j < chain_depth; j++) {
+            sem_post(&chain_go[j]);
+            sem_wait(&chain_locked[j]);
+        }
+
+        /* Wake up the medium thread, which runs once the high thread
+         * blocks on the mutex */
+        hog_stop = false;
+        hog_ran = false;
+        sem_post(&hog_go);
+
+        uint64_t start = now_ns();
+        pthread_mutex_lock(head);
+        stat_add(now_ns() - start);
+
+        if (hog_ran)
+            inversions++;
+
+        hog_stop = true;
+        pthread_mutex_unlock(head);
+    }
+
+    return NULL;
+}
+
+static void stress_mutex(void)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+
+    for (int i = 0; i < chain_depth; i++) {
+        pthread_mutex_init(&chain_mtx[i], &attr);
+        sem_init(&chain_go[i], 0, 0);
+        sem_init(&chain_locked[i], 0, 0);
+    }
+    sem_init(&hog_go, 0, 0);
+
+    stat_reset();
+    inversions = 0;
+    chain_quit = false;
+    hog_quit = false;
+
+    pthread_t chain_tids[STRESS_CHAIN_MAX], hog_tid, high_tid;
+    int cnt;
+    bool hog_created = false;
+    uint64_t elapsed = 0;
+
+    for (cnt = 0; cnt < chain_depth; cnt++) {
+        if (stress_thread_create(&chain_tids[cnt], STRESS_PRI_LOW + cnt,
+                                 chain_thread, (void *) cnt) < 0)
+            goto leave;
+    }
+
+    if (stress_thread_create(&hog_tid, STRESS_PRI_MEDIUM, hog_thread, NULL) <
+        0)
+        goto leave;
+    hog_created = true;
+
+    uint64_t start = now_ns();
+    if (stress_thread_create(&high_tid, STRESS_PRI_HIGH, chain_high_thread,
+                             NULL) < 0)
+        goto leave;
+    pthread_join(high_tid, NULL);
+    elapsed = now_ns() - start;
+
+leave:
+    /* Stop the workers */
+    chain_quit = true;
+    hog_quit = true;
+    for (int i = 0; i < cnt; i++)
+        sem_post(&chain_go[i]);
+    sem_post(&hog_go);
+
+    for (int i = 0; i < cnt; i++)
+        pthread_join(chain_tids[i], NULL);
+    if (hog_created)
+        pthread_join(hog_tid, NULL);
+
+    if (!elapsed) {
+        printf("stress,mutex,error,failed to create the threads\n\r");
+        return;
+    }
+
+    report_latency("mutex");
+    report_throughput("mutex", chain_iterations, elapsed);
+    report("mutex", "inversions", inversions, "count");
+}
+
+static void *timer_thread(void *arg)
+{
+    int fd = timerfd_create(CLOCK_MONOTONIC, 0);
+    if (fd < 0) {
+        errors++;
+        return NULL;
+    }
+
+    /* All timers share the same expiries to storm the tick */
+    struct itimerspec its = {
+        .it_value.tv_sec = timer_start / 1000000000ULL,
+        .it_value.tv_nsec = timer_start % 1000000000ULL,
+        .it_interval.tv_sec = timer_period_ns / 1000000000,
+        .it_interval.tv_nsec = timer_period_ns % 1000000000,
+    };
+    timerfd_settime(fd, TFD_TIMER_ABSTIME, &its, NULL);
+
+    uint64_t expected = timer_start;
+    for (int i = 0; i < timer_expirations;) {
+        uint64_t cnt;
+        if (read(fd, &cnt, sizeof(cnt)) != sizeof(cnt)) {
+            errors++;
+            break;
+        }
+
+        /* Lateness against the last expiry being reported */
+        expected += (cnt - 1) * timer_period_ns;
+        stat_add(now_ns() - expected);
+        expected += timer_period_ns;
+
+        overruns += cnt - 1;
+        i += cnt;
+    }
+
+    close(fd);
+
+    return NULL;
+}
+
+static void stress_timer(int timers)
+{
+    pthread_t tids[STRESS_THREADS_MAX];
+    int cnt = 0;
+
+    stat_reset();
+    overruns = 0;
+
+    /* Expire on a tick boundary after the threads are ready (assumes the
+     * clock has not been set) */
+    uint64_t now = now_ns();
+    timer_start = ((now + STRESS_TIMER_WARMUP_NS) / NANOSECOND_TICKS + 1) *
+                  NANOSECOND_TICKS;
+
+    for (int i = 0; i < timers; i++) {
+        /* Spread the timers over the priorities */
+        int pri = STRESS_PRI_HIGH - (i % (STRESS_PRI_HIGH - STRESS_PRI_LOW));
+        if (stress_thread_create(&tids[cnt], pri, timer_thread, NULL) == 0)
+            cnt++;
+    }
+
+    if (cnt != timers)
+        errors++;
+
+    for (int i = 0; i < cnt; i++)
+        pthread_join(tids[i], NULL);
+
+    uint64_t elapsed = now_ns() - timer_start;
+
+    report_latency("timer");
+    report_throughput("timer", cnt * timer_expirations, elapsed);
+    report("timer", "overruns", overruns, "count");
+    report("timer", "errors", errors, "count");
+}
+
+static int arg_int(int argc, char *argv[], int idx, int def, int min, int max)
+{
+    int val = (argc > idx) ? atoi(argv[idx]) : def;
+    return (val < min || val > max) ? -1 : val;
+}
+
+static void stress_usage(void)
+{
+    printf(
+        "usage:\n\r"
+        "  stress pipe [producers] [consumers] [messages]\n\r"
+        "  stress mq [producers] [consumers] [messages]\n\r"
+        "  stress mutex [depth] [iterations]\n\r"
+        "  stress timer [timers] [period_us] [expirations]\n\r");
+}
+
+int stress(int argc, char *argv[])
+{
+    if (argc < 2) {
+        stress_usage();
+        return 0;
+    }
+
+    const char *scenario = argv[1];
+    bool valid = true;
+
+    /* Raise the priority so the workers only run when being joined */
+    int policy;
+    struct sched_param param, old_param;
+    pthread_getschedparam(pthread_self(), &policy, &old_param);
+    param.sched_priority = STRESS_PRI_MAIN;
+    pthread_setschedparam(pthread_self(), policy, &param);
+
+    if (!strcmp(scenario, "pipe") || !strcmp(scenario, "mq")) {
+        producers = arg_int(argc, argv, 2, 2, 1, STRESS_THREADS_MAX);
+        consumers = arg_int(argc, argv, 3, 2, 1, STRESS_THREADS_MAX);
+        messages = arg_int(argc, argv, 4, 500, 1, 1000000);
+        valid = producers > 0 && consumers > 0 && messages > 0;
+
+        if (valid && scenario[0] == 'p')
+            stress_pipe();
+        else if (valid)
+            stress_mqueue();
+    } else if (!strcmp(scenario, "mutex")) {
+        chain_depth = arg_int(argc, argv, 2, 3, 1, STRESS_CHAIN_MAX);
+        chain_iterations = arg_int(argc, argv, 3, 100, 1, 1000000);
+        valid = chain_depth > 0 && chain_iterations > 0;
+
+        if (valid)
+            stress_mutex();
+    } else if (!strcmp(scenario, "timer")) {
+        int timers = arg_int(argc, argv, 2, 4, 1, STRESS_THREADS_MAX);
+        int period_us = arg_int(argc, argv, 3, 10000, 1, 1000000);
+        timer_expirations = arg_int(argc, argv, 4, 100, 1, 1000000);
+        valid = timers > 0 && period_us > 0 && timer_expirations > 0;
+
+        if (valid) {
+            timer_period_ns = period_us * 1000;
+            stress_timer(timers);
+        }
+    } else {
+        valid = false;
+    }
+
+    pthread_setschedparam(pthread_self(), policy, &old_param);
+
+    if (!valid) {
+        stress_usage();
+        printf("stress,%s,error,invalid arguments\n\r", scenario);
+        return 0;
+    }
+
+    printf("stress,%s,done\n\r", scenario);
+
+    return 0;
+}
+
+HOOK_SHELL_CMD("stress", stress);
@@ -0,0 +1,5 @@
+PROJ_ROOT := $(dir $(lastword $(MAKEFILE_LIST)))/../../..
+
+SRC += $(PROJ_ROOT)/user/benchmarks/stress/stress.c
+
+include $(PROJ_ROOT)/user/benchmarks/common/bench.mk
@@ -3,148 +3,243 @@
 
 #include "debug_link.h"
 
-#define DBGLINK_HEADER_SIZE 3
 #define DBGLINK_CHECKSUM_INIT_VAL 63
+#define DBGLINK_CRC16_INIT_VAL 0xffff
 
-void pack_debug_link_msg_header(debug_link_payload_t *payload, int message_id)
+uint8_t generate_debug_link_msg_checksum(const uint8_t *payload, size_t size)
 {
-    payload->size = DBGLINK_HEADER_SIZE;
-    payload->data[2] = message_id;
+    uint32_t word, sum = 0;
+    uint8_t checksum = DBGLINK_CHECKSUM_INIT_VAL;
+
+    /* XOR a word at a time, the unaligned loads are supported by the
+     * Cortex-M4 */
+    for (; size >= sizeof(uint32_t); size -= sizeof(uint32_t)) {
+        memcpy(&word, payload, sizeof(uint32_t));
+        sum ^= word;
+        payload += sizeof(uint32_t);
+    }
+
+    /* Fold the bytes of the word */
+    sum ^= sum >> 16;
+    sum ^= sum >> 8;
+    checksum ^= (uint8_t) sum;
+
+    while (size--)
+        checksum ^= *payload++;
+
+    return checksum;
 }
 
-void pack_debug_link_msg_bool(bool *data,
-                              debug_link_payload_t *payload,
-                              size_t n)
+size_t finish_debug_link_msg(uint8_t *data, int msg_id, size_t payload_size)
 {
-    while (n--) {
-        memcpy((uint8_t *) payload->data + payload->size, (uint8_t *) data,
-               sizeof(bool));
-        payload->size += sizeof(bool);
-    }
+    data[0] = DEBUG_LINK_START_BYTE;
+    data[1] = payload_size;
+    data[2] = msg_id;
+    data[DEBUG_LINK_HEADER_SIZE + payload_size] =
+        generate_debug_link_msg_checksum(&data[DEBUG_LINK_HEADER_SIZE],
+                                         payload_size);
+
+    return DEBUG_LINK_HEADER_SIZE + payload_size + DEBUG_LINK_CHECKSUM_SIZE;
 }
 
+int get_debug_link_msg_id(const uint8_t *data, size_t size)
+{
+    if (size < DEBUG_LINK_HEADER_SIZE || data[0] != DEBUG_LINK_START_BYTE)
+        return -1;
 
-void pack_debug_link_msg_uint8_t(uint8_t *data,
-                                 debug_link_payload_t *payload,
-                                 size_t n)
+    return data[2];
+}
+
+int check_debug_link_msg(const uint8_t *data,
+                         size_t size,
+                         int msg_id,
+                         size_t payload_size)
 {
-    for (int i = 0; i < n; i++) {
-        memcpy((uint8_t *) payload->data + payload->size, (uint8_t *) &data[i],
-               sizeof(uint8_t));
-        payload->size += sizeof(uint8_t);
-    }
+    /* Incomplete frame */
+    if (size < DEBUG_LINK_HEADER_SIZE + payload_size + DEBUG_LINK_CHECKSUM_SIZE)
+        return -1;
+
+    /* Bad header */
+    if (data[0] != DEBUG_LINK_START_BYTE || data[1] != payload_size ||
+        data[2] != msg_id)
+        return -1;
+
+    /* Bad checksum */
+    uint8_t checksum = generate_debug_link_msg_checksum(
+        &data[DEBUG_LINK_HEADER_SIZE], payload_size);
+    if (data[DEBUG_LINK_HEADER_SIZE + payload_size] != checksum)
+        return -1;
+
+    return 0;
 }
 
-void pack_debug_link_msg_int8_t(int8_t *data,
-                                debug_link_payload_t *payload,
-                                size_t n)
+uint16_t generate_debug_link_crc16(const uint8_t *data, size_t size)
 {
-    for (int i = 0; i < n; i++) {
-        memcpy((uint8_t *) payload->data + payload->size, (uint8_t *) &data[i],
-               sizeof(int8_t));
-        payload->size += sizeof(int8_t);
+    uint16_t crc = DBGLINK_CRC16_INIT_VAL;
+
+    /* CRC-16/CCITT-FALSE (polynomial 0x1021) without the lookup table */
+    while (size--) {
+        crc = (crc >> 8) | (crc << 8);
+        crc ^= *data++;
+        crc ^= (crc & 0xff) >> 4;
+        crc ^= crc << 12;
+        crc ^= (crc & 0xff) << 5;
     }
+
+    return crc;
 }
 
-void pack_debug_link_msg_uint16_t(uint16_t *data,
-                                  debug_link_payload_t *payload,
-                                  size_t n)
+static void put_u16(uint8_t *data, uint16_t val)
 {
-    for (int i = 0; i < n; i++) {
-        memcpy((uint8_t *) payload->data + payload->size, (uint8_t *) &data[i],
-               sizeof(uint16_t));
-        payload->size += sizeof(uint16_t);
-    }
+    data[0] = val & 0xff;
+    data[1] = val >> 8;
 }
 
-void pack_debug_link_msg_int16_t(int16_t *data,
-                                 debug_link_payload_t *payload,
-                                 size_t n)
+static void put_u32(uint8_t *data, uint32_t val)
 {
-    for (int i = 0; i < n; i++) {
-        memcpy((uint8_t *) payload->data + payload->size, (uint8_t *) &data[i],
-               sizeof(int16_t));
-        payload->size += sizeof(int16_t);
-    }
+    put_u16(&data[0], val & 0xffff);
+    put_u16(&data[2], val >> 16);
 }
 
-void pack_debug_link_msg_uint32_t(uint32_t *data,
-                                  debug_link_payload_t *payload,
-                                  size_t n)
+static uint16_t get_u16(const uint8_t *data)
 {
-    for (int i = 0; i < n; i++) {
-        memcpy((uint8_t *) payload->data + payload->size, (uint8_t *) &data[i],
-               sizeof(uint32_t));
-        payload->size += sizeof(uint32_t);
-    }
+    return data[0] | (data[1] << 8);
 }
 
-void pack_debug_link_msg_int32_t(int32_t *data,
-                                 debug_link_payload_t *payload,
-                                 size_t n)
+void debug_link_batch_init(debug_link_batch_t *batch,
+                           uint8_t *buf,
+                           size_t buf_size)
 {
-    for (int i = 0; i < n; i++) {
-        memcpy((uint8_t *) payload->data + payload->size, (uint8_t *) &data[i],
-               sizeof(int32_t));
-        payload->size += sizeof(int32_t);
-    }
+    /* Larger frames would be rejected by the receiver */
+    if (buf_size > DEBUG_LINK_BATCH_FRAME_MAX)
+        buf_size = DEBUG_LINK_BATCH_FRAME_MAX;
+
+    batch->buf = buf;
+    batch->buf_size = buf_size;
+    batch->size = 0;
+    batch->seq = 0;
+    batch->flags = 0;
 }
 
-void pack_debug_link_msg_uint64_t(uint64_t *data,
-                                  debug_link_payload_t *payload,
-                                  size_t n)
+void debug_link_batch_begin(debug_link_batch_t *batch,
+                            bool has_timestamp,
+                            uint32_t timestamp)
 {
-    for (int i = 0; i < n; i++) {
-        memcpy((uint8_t *) payload->data + payload->size, (uint8_t *) &data[i],
-               sizeof(uint64_t));
-        payload->size += sizeof(uint64_t);
+    batch->size = DEBUG_LINK_BATCH_HEADER_SIZE;
+    batch->flags = 0;
+
+    if (has_timestamp) {
+        put_u32(&batch->buf[batch->size], timestamp);
+
+        batch->size += DEBUG_LINK_BATCH_TIMESTAMP_SIZE;
+        batch->flags |= DEBUG_LINK_BATCH_FLAG_TIMESTAMP;
     }
 }
 
-void pack_debug_link_msg_int64_t(int64_t *data,
-                                 debug_link_payload_t *payload,
-                                 size_t n)
+int debug_link_batch_add(debug_link_batch_t *batch,
+                         int msg_id,
+                         const void *payload,
+                         size_t payload_size)
 {
-    for (int i = 0; i < n; i++) {
-        memcpy((uint8_t *) payload->data + payload->size, (uint8_t *) &data[i],
-               sizeof(int64_t));
-        payload->size += sizeof(int64_t);
-    }
+    size_t record_size = DEBUG_LINK_BATCH_RECORD_HEADER_SIZE + payload_size;
+
+    /* Leave the space for the CRC */
+    if (payload_size > UINT8_MAX ||
+        batch->size + record_size + DEBUG_LINK_BATCH_CRC_SIZE >
+            batch->buf_size)
+        return -1;
+
+    uint8_t *data = &batch->buf[batch->size];
+    data[0] = msg_id;
+    data[1] = payload_size;
+    memcpy(&data[DEBUG_LINK_BATCH_RECORD_HEADER_SIZE], payload, payload_size);
+
+    batch->size += record_size;
+
+    return 0;
 }
 
-void pack_debug_link_msg_float(float *data,
-                               debug_link_payload_t *payload,
-                               size_t n)
+size_t debug_link_batch_finish(debug_link_batch_t *batch)
 {
-    for (int i = 0; i < n; i++) {
-        memcpy((uint8_t *) payload->data + payload->size, (uint8_t *) &data[i],
-               sizeof(float));
-        payload->size += sizeof(float);
-    }
+    uint8_t *data = batch->buf;
+    size_t body_size = batch->size - DEBUG_LINK_BATCH_HEADER_SIZE;
+
+    data[0] = DEBUG_LINK_BATCH_START_BYTE;
+    data[1] = batch->flags;
+    put_u16(&data[2], batch->seq);
+    put_u16(&data[4], body_size);
+
+    /* The start byte is not covered */
+    uint16_t crc = generate_debug_link_crc16(&data[1], batch->size - 1);
+    put_u16(&data[batch->size], crc);
+
+    size_t frame_size = batch->size + DEBUG_LINK_BATCH_CRC_SIZE;
+
+    batch->seq++;
+    batch->size = 0;
+
+    return frame_size;
 }
 
-void pack_debug_link_msg_double(double *data,
-                                debug_link_payload_t *payload,
-                                size_t n)
+int check_debug_link_batch(const uint8_t *data, size_t size)
 {
-    for (int i = 0; i < n; i++) {
-        memcpy((uint8_t *) payload->data + payload->size, (uint8_t *) data,
-               sizeof(double));
-        payload->size += sizeof(double);
-    }
+    /* Incomplete header */
+    if (size < DEBUG_LINK_BATCH_HEADER_SIZE)
+        return 0;
+
+    if (data[0] != DEBUG_LINK_BATCH_START_BYTE)
+        return -1;
+
+    size_t frame_size = DEBUG_LINK_BATCH_HEADER_SIZE + get_u16(&data[4]) +
+                        DEBUG_LINK_BATCH_CRC_SIZE;
+
+    /* Corrupted size field */
+    if (frame_size > DEBUG_LINK_BATCH_FRAME_MAX)
+        return -1;
+
+    /* Incomplete frame */
+    if (size < frame_size)
+        return 0;
+
+    /* Bad CRC */
+    size_t crc_pos = frame_size - DEBUG_LINK_BATCH_CRC_SIZE;
+    if (generate_debug_link_crc16(&data[1], crc_pos - 1) !=
+        get_u16(&data[crc_pos]))
+        return -1;
+
+    return frame_size;
 }
 
-void generate_debug_link_msg_checksum(debug_link_payload_t *payload)
+int next_debug_link_batch_msg(const uint8_t *data,
+                              size_t *offset,
+                              int *msg_id,
+                              const uint8_t **payload,
+                              size_t *payload_size)
 {
-    uint8_t *data = payload->data + DBGLINK_HEADER_SIZE;
-    size_t size = payload->size - DBGLINK_HEADER_SIZE;
-    uint8_t checksum = DBGLINK_CHECKSUM_INIT_VAL;
+    size_t end = DEBUG_LINK_BATCH_HEADER_SIZE + get_u16(&data[4]);
+
+    /* Start from the first record */
+    if (*offset == 0) {
+        *offset = DEBUG_LINK_BATCH_HEADER_SIZE;
+        if (data[1] & DEBUG_LINK_BATCH_FLAG_TIMESTAMP)
+            *offset += DEBUG_LINK_BATCH_TIMESTAMP_SIZE;
+    }
+
+    /* No more records */
+    if (*offset + DEBUG_LINK_BATCH_RECORD_HEADER_SIZE > end)
+        return 0;
+
+    const uint8_t *record = &data[*offset];
+    size_t size = record[1];
+
+    /* Truncated record */
+    if (*offset + DEBUG_LINK_BATCH_RECORD_HEADER_SIZE + size > end)
+        return -1;
 
-    for (int i = 0; i < size; i++)
-        checksum ^= data[i];
+    *msg_id = record[0];
+    *payload = &record[DEBUG_LINK_BATCH_RECORD_HEADER_SIZE];
+    *payload_size = size;
+    *offset += DEBUG_LINK_BATCH_RECORD_HEADER_SIZE + size;
 
-    payload->data[0] = '@';
-    payload->data[1] = payload->size - 3;
-    payload->data[payload->size] = checksum;
-    payload->size++;
+    return 1;
 }
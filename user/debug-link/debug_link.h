@@ -5,45 +5,60 @@
 #include <stddef.h>
 #include <stdint.h>
 
+/* Frame: '@', payload size, message ID, payload, checksum */
+#define DEBUG_LINK_START_BYTE '@'
+#define DEBUG_LINK_HEADER_SIZE 3
+#define DEBUG_LINK_CHECKSUM_SIZE 1
+
+/* Batch frame: '#', flags, sequence (u16), body size (u16), body, CRC-16.
+ * The body is an optional timestamp (u32) followed by the records of the
+ * messages: message ID, payload size, payload. The multi-byte fields are
+ * little-endian and the CRC-16/CCITT-FALSE covers the flags to the body */
+#define DEBUG_LINK_BATCH_START_BYTE '#'
+#define DEBUG_LINK_BATCH_HEADER_SIZE 6
+#define DEBUG_LINK_BATCH_CRC_SIZE 2
+#define DEBUG_LINK_BATCH_TIMESTAMP_SIZE 4
+#define DEBUG_LINK_BATCH_RECORD_HEADER_SIZE 2
+
+/* Batch frames claiming a larger body are treated as noise, so a corrupted
+ * size field does not stall the receiver */
+#define DEBUG_LINK_BATCH_FRAME_MAX 4096
+
+#define DEBUG_LINK_BATCH_FLAG_TIMESTAMP 0x1 /* The body starts with the time */
+
 typedef struct {
-    uint8_t *data;
-    int size;
-} debug_link_payload_t;
-
-void pack_debug_link_msg_header(debug_link_payload_t *payload, int message_id);
-void pack_debug_link_msg_bool(bool *data,
-                              debug_link_payload_t *payload,
-                              size_t n);
-void pack_debug_link_msg_uint8_t(uint8_t *data,
-                                 debug_link_payload_t *payload,
-                                 size_t n);
-void pack_debug_link_msg_int8_t(int8_t *data,
-                                debug_link_payload_t *payload,
-                                size_t n);
-void pack_debug_link_msg_uint16_t(uint16_t *data,
-                                  debug_link_payload_t *payload,
-                                  size_t n);
-void pack_debug_link_msg_int16_t(int16_t *data,
-                                 debug_link_payload_t *payload,
-                                 size_t n);
-void pack_debug_link_msg_uint32_t(uint32_t *data,
-                                  debug_link_payload_t *payload,
-                                  size_t n);
-void pack_debug_link_msg_int32_t(int32_t *data,
-                                 debug_link_payload_t *payload,
-                                 size_t n);
-void pack_debug_link_msg_uint64_t(uint64_t *data,
-                                  debug_link_payload_t *payload,
-                                  size_t n);
-void pack_debug_link_msg_int64_t(int64_t *data,
-                                 debug_link_payload_t *payload,
-                                 size_t n);
-void pack_debug_link_msg_float(float *data,
-                               debug_link_payload_t *payload,
-                               size_t n);
-void pack_debug_link_msg_double(double *data,
-                                debug_link_payload_t *payload,
-                                size_t n);
-void generate_debug_link_msg_checksum(debug_link_payload_t *payload);
+    uint8_t *buf;
+    size_t buf_size;
+    size_t size; /* Size of the frame packed so far */
+    uint16_t seq;
+    uint8_t flags;
+} debug_link_batch_t;
+
+uint8_t generate_debug_link_msg_checksum(const uint8_t *payload, size_t size);
+size_t finish_debug_link_msg(uint8_t *data, int msg_id, size_t payload_size);
+int get_debug_link_msg_id(const uint8_t *data, size_t size);
+int check_debug_link_msg(const uint8_t *data,
+                         size_t size,
+                         int msg_id,
+                         size_t payload_size);
+
+uint16_t generate_debug_link_crc16(const uint8_t *data, size_t size);
+void debug_link_batch_init(debug_link_batch_t *batch,
+                           uint8_t *buf,
+                           size_t buf_size);
+void debug_link_batch_begin(debug_link_batch_t *batch,
+                            bool has_timestamp,
+                            uint32_t timestamp);
+int debug_link_batch_add(debug_link_batch_t *batch,
+                         int msg_id,
+                         const void *payload,
+                         size_t payload_size);
+size_t debug_link_batch_finish(debug_link_batch_t *batch);
+int check_debug_link_batch(const uint8_t *data, size_t size);
+int next_debug_link_batch_msg(const uint8_t *data,
+                              size_t *offset,
+                              int *msg_id,
+                              const uint8_t **payload,
+                              size_t *payload_size);
 
 #endif
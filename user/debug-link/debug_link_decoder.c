@@ -0,0 +1,322 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "debug_link.h"
+#include "debug_link_decoder.h"
+
+struct debug_link_decoder {
+    uint8_t buf[DEBUG_LINK_DECODER_BUF_SIZE];
+    size_t pos; /* Next byte to decode */
+    size_t len; /* Bytes in the buffer */
+
+    /* Batch frame being decoded */
+    size_t batch_size;
+    size_t batch_offset;
+    uint32_t batch_flags;
+    uint32_t batch_seq;
+    uint32_t batch_timestamp;
+
+    bool seq_valid;
+    uint16_t seq_expected;
+
+    debug_link_decoder_stats_t stats;
+};
+
+debug_link_decoder_t *debug_link_decoder_create(void)
+{
+    return calloc(1, sizeof(debug_link_decoder_t));
+}
+
+void debug_link_decoder_destroy(debug_link_decoder_t *decoder)
+{
+    free(decoder);
+}
+
+size_t debug_link_decoder_feed(debug_link_decoder_t *decoder,
+                               const uint8_t *data,
+                               size_t size)
+{
+    /* Move the undecoded bytes to the front */
+    if (decoder->pos > 0) {
+        decoder->len -= decoder->pos;
+        memmove(decoder->buf, &decoder->buf[decoder->pos], decoder->len);
+        decoder->pos = 0;
+    }
+
+    size_t n = sizeof(decoder->buf) - decoder->len;
+    if (n > size)
+        n = size;
+
+    memcpy(&decoder->buf[decoder->len], data, n);
+    decoder->len += n;
+
+    return n;
+}
+
+void debug_link_decoder_get_stats(debug_link_decoder_t *decoder,
+                                  debug_link_decoder_stats_t *stats)
+{
+    *stats = decoder->stats;
+}
+
+static double decode_value(int type, const uint8_t *data, size_t *size)
+{
+    /* The host is little-endian as the target */
+    union {
+        uint8_t u8;
+        int8_t i8;
+        uint16_t u16;
+        int16_t i16;
+        uint32_t u32;
+        int32_t i32;
+        uint64_t u64;
+        int64_t i64;
+        float f;
+        double d;
+    } val;
+
+    switch (type) {
+    case DEBUG_LINK_TYPE_BOOL:
+    case DEBUG_LINK_TYPE_UINT8:
+        *size = 1;
+        return data[0];
+    case DEBUG_LINK_TYPE_INT8:
+        *size = 1;
+        return (int8_t) data[0];
+    case DEBUG_LINK_TYPE_UINT16:
+        *size = sizeof(val.u16);
+        memcpy(&val, data, *size);
+        return val.u16;
+    case DEBUG_LINK_TYPE_INT16:
+        *size = sizeof(val.i16);
+        memcpy(&val, data, *size);
+        return val.i16;
+    case DEBUG_LINK_TYPE_UINT32:
+        *size = sizeof(val.u32);
+        memcpy(&val, data, *size);
+        return val.u32;
+    case DEBUG_LINK_TYPE_INT32:
+        *size = sizeof(val.i32);
+        memcpy(&val, data, *size);
+        return val.i32;
+    case DEBUG_LINK_TYPE_UINT64:
+        *size = sizeof(val.u64);
+        memcpy(&val, data, *size);
+        return val.u64;
+    case DEBUG_LINK_TYPE_INT64:
+        *size = sizeof(val.i64);
+        memcpy(&val, data, *size);
+        return val.i64;
+    case DEBUG_LINK_TYPE_FLOAT:
+        *size = sizeof(val.f);
+        memcpy(&val, data, *size);
+        return val.f;
+    case DEBUG_LINK_TYPE_DOUBLE:
+    default:
+        *size = sizeof(val.d);
+        memcpy(&val, data, *size);
+        return val.d;
+    }
+}
+
+/* Returns 1 if decoded, 0 if the message is skipped, or -1 if the values do
+ * not fit */
+static int decode_msg(debug_link_decoder_t *decoder,
+                      int msg_id,
+                      const uint8_t *payload,
+                      size_t payload_size,
+                      debug_link_record_t *record,
+                      double *values,
+                      size_t value_offset,
+                      size_t max_values)
+{
+    if (msg_id < 0 || (size_t) msg_id >= debug_link_msg_cnt ||
+        debug_link_msgs[msg_id].payload_size != payload_size) {
+        decoder->stats.unknown_msgs++;
+        return 0;
+    }
+
+    const struct debug_link_msg_desc *desc = &debug_link_msgs[msg_id];
+    if (value_offset + desc->value_cnt > max_values)
+        return -1;
+
+    double *value = &values[value_offset];
+
+    for (size_t i = 0; i < desc->field_cnt; i++) {
+        int n = desc->fields[i].array_size;
+        if (n == 0)
+            n = 1;
+
+        for (int j = 0; j < n; j++) {
+            size_t size;
+            *value++ = decode_value(desc->fields[i].type, payload, &size);
+            payload += size;
+        }
+    }
+
+    record->msg_id = msg_id;
+    record->flags = 0;
+    record->seq = 0;
+    record->timestamp = 0;
+    record->value_offset = value_offset;
+    record->value_cnt = desc->value_cnt;
+    decoder->stats.records++;
+
+    return 1;
+}
+
+static void track_seq(debug_link_decoder_t *decoder, uint16_t seq)
+{
+    if (decoder->seq_valid && seq != decoder->seq_expected) {
+        uint16_t gap = seq - decoder->seq_expected;
+
+        /* The frame is older than the expected one */
+        if (gap >= 0x8000) {
+            decoder->stats.batches_reordered++;
+            return;
+        }
+
+        decoder->stats.batches_lost += gap;
+    }
+
+    decoder->seq_valid = true;
+    decoder->seq_expected = seq + 1;
+}
+
+static void begin_batch(debug_link_decoder_t *decoder,
+                        const uint8_t *frame,
+                        size_t frame_size)
+{
+    uint16_t seq = frame[2] | (frame[3] << 8);
+
+    decoder->stats.batches++;
+    track_seq(decoder, seq);
+
+    decoder->batch_size = frame_size;
+    decoder->batch_offset = 0;
+    decoder->batch_seq = seq;
+    decoder->batch_flags = DEBUG_LINK_RECORD_BATCH;
+    decoder->batch_timestamp = 0;
+
+    if (frame[1] & DEBUG_LINK_BATCH_FLAG_TIMESTAMP) {
+        const uint8_t *ts = &frame[DEBUG_LINK_BATCH_HEADER_SIZE];
+        decoder->batch_flags |= DEBUG_LINK_RECORD_TIMESTAMP;
+        decoder->batch_timestamp =
+            ts[0] | (ts[1] << 8) | (ts[2] << 16) | ((uint32_t) ts[3] << 24);
+    }
+}
+
+size_t debug_link_decoder_decode(debug_link_decoder_t *decoder,
+                                 debug_link_record_t *records,
+                                 size_t max_records,
+                                 double *values,
+                                 size_t max_values)
+{
+    size_t cnt = 0;
+    size_t value_cnt = 0;
+
+    while (cnt < max_records) {
+        const uint8_t *data = &decoder->buf[decoder->pos];
+        size_t avail = decoder->len - decoder->pos;
+
+        /* Continue with the records of the batch frame */
+        if (decoder->batch_size > 0) {
+            size_t offset = decoder->batch_offset;
+            const uint8_t *payload;
+            size_t payload_size;
+            int msg_id;
+
+            int retval = next_debug_link_batch_msg(data, &offset, &msg_id,
+                                                   &payload, &payload_size);
+            if (retval <= 0) {
+                /* End of the frame */
+                decoder->pos += decoder->batch_size;
+                decoder->batch_size = 0;
+                continue;
+            }
+
+            debug_link_record_t *record = &records[cnt];
+            retval = decode_msg(decoder, msg_id, payload, payload_size, record,
+                                values, value_cnt, max_values);
+            if (retval < 0)
+                break;
+
+            if (retval > 0) {
+                record->flags = decoder->batch_flags;
+                record->seq = decoder->batch_seq;
+                record->timestamp = decoder->batch_timestamp;
+                value_cnt += record->value_cnt;
+                cnt++;
+            }
+
+            decoder->batch_offset = offset;
+            continue;
+        }
+
+        if (avail == 0)
+            break;
+
+        if (data[0] == DEBUG_LINK_START_BYTE) {
+            if (avail < DEBUG_LINK_HEADER_SIZE)
+                break;
+
+            size_t payload_size = data[1];
+            size_t frame_size = DEBUG_LINK_HEADER_SIZE + payload_size +
+                                DEBUG_LINK_CHECKSUM_SIZE;
+            if (avail < frame_size)
+                break;
+
+            if (check_debug_link_msg(data, avail, data[2], payload_size) < 0) {
+                /* Resynchronize from the next byte */
+                decoder->stats.checksum_errors++;
+                decoder->pos++;
+                continue;
+            }
+
+            int retval = decode_msg(decoder, data[2],
+                                    &data[DEBUG_LINK_HEADER_SIZE], payload_size,
+                                    &records[cnt], values, value_cnt,
+                                    max_values);
+            if (retval < 0)
+                break;
+
+            if (retval > 0) {
+                value_cnt += records[cnt].value_cnt;
+                cnt++;
+            }
+
+            decoder->stats.frames++;
+            decoder->pos += frame_size;
+        } else if (data[0] == DEBUG_LINK_BATCH_START_BYTE) {
+            if (avail < DEBUG_LINK_BATCH_HEADER_SIZE)
+                break;
+
+            size_t body_size = data[4] | (data[5] << 8);
+            if (DEBUG_LINK_BATCH_HEADER_SIZE + body_size +
+                    DEBUG_LINK_BATCH_CRC_SIZE >
+                DEBUG_LINK_DECODER_FRAME_MAX) {
+                decoder->stats.bytes_skipped++;
+                decoder->pos++;
+                continue;
+            }
+
+            int frame_size = check_debug_link_batch(data, avail);
+            if (frame_size == 0)
+                break;
+
+            if (frame_size < 0) {
+                decoder->stats.crc_errors++;
+                decoder->pos++;
+                continue;
+            }
+
+            begin_batch(decoder, data, frame_size);
+        } else {
+            decoder->stats.bytes_skipped++;
+            decoder->pos++;
+        }
+    }
+
+    return cnt;
+}
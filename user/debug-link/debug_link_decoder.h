@@ -0,0 +1,89 @@
+#ifndef __DEBUG_LINK_DECODER__
+#define __DEBUG_LINK_DECODER__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "debug_link.h"
+
+/* Streaming decoder of the single and the batch frames for the host tools.
+ * The bytes are fed in bulk and decoded into the records with the fields
+ * converted to double. The message layouts come from the table generated by
+ * msggen (debug_link_msgs.c), and the decoder is built with it into a shared
+ * object (libdebuglink.so) */
+
+#define DEBUG_LINK_DECODER_FRAME_MAX DEBUG_LINK_BATCH_FRAME_MAX
+#define DEBUG_LINK_DECODER_BUF_SIZE (4 * DEBUG_LINK_DECODER_FRAME_MAX)
+
+enum {
+    DEBUG_LINK_TYPE_BOOL,
+    DEBUG_LINK_TYPE_UINT8,
+    DEBUG_LINK_TYPE_INT8,
+    DEBUG_LINK_TYPE_UINT16,
+    DEBUG_LINK_TYPE_INT16,
+    DEBUG_LINK_TYPE_UINT32,
+    DEBUG_LINK_TYPE_INT32,
+    DEBUG_LINK_TYPE_UINT64,
+    DEBUG_LINK_TYPE_INT64,
+    DEBUG_LINK_TYPE_FLOAT,
+    DEBUG_LINK_TYPE_DOUBLE,
+};
+
+struct debug_link_field_desc {
+    int type;
+    int array_size; /* 0 for a variable */
+};
+
+struct debug_link_msg_desc {
+    const char *name;
+    int msg_id;
+    size_t payload_size;
+    size_t value_cnt; /* Fields with the arrays expanded */
+    const struct debug_link_field_desc *fields;
+    size_t field_cnt;
+};
+
+/* Generated by msggen, indexed by the message ID */
+extern const struct debug_link_msg_desc debug_link_msgs[];
+extern const size_t debug_link_msg_cnt;
+
+#define DEBUG_LINK_RECORD_BATCH 0x1     /* Carried by a batch frame */
+#define DEBUG_LINK_RECORD_TIMESTAMP 0x2 /* The timestamp is valid */
+
+typedef struct {
+    int32_t msg_id;
+    uint32_t flags;
+    uint32_t seq;          /* Sequence of the batch frame */
+    uint32_t timestamp;    /* Microseconds */
+    uint32_t value_offset; /* First value in the array of the caller */
+    uint32_t value_cnt;
+} debug_link_record_t;
+
+typedef struct {
+    uint64_t frames;           /* Valid single frames */
+    uint64_t batches;          /* Valid batch frames */
+    uint64_t records;          /* Decoded messages */
+    uint64_t bytes_skipped;    /* Bytes outside of the frames */
+    uint64_t checksum_errors;  /* Single frames with a bad checksum */
+    uint64_t crc_errors;       /* Batch frames with a bad CRC */
+    uint64_t unknown_msgs;     /* Messages not in the generated table */
+    uint64_t batches_lost;     /* Gaps in the sequence numbers */
+    uint64_t batches_reordered;
+} debug_link_decoder_stats_t;
+
+typedef struct debug_link_decoder debug_link_decoder_t;
+
+debug_link_decoder_t *debug_link_decoder_create(void);
+void debug_link_decoder_destroy(debug_link_decoder_t *decoder);
+size_t debug_link_decoder_feed(debug_link_decoder_t *decoder,
+                               const uint8_t *data,
+                               size_t size);
+size_t debug_link_decoder_decode(debug_link_decoder_t *decoder,
+                                 debug_link_record_t *records,
+                                 size_t max_records,
+                                 double *values,
+                                 size_t max_values);
+void debug_link_decoder_get_stats(debug_link_decoder_t *decoder,
+                                  debug_link_decoder_stats_t *stats);
+
+#endif
@@ -0,0 +1,141 @@
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "logger.h"
+
+static void put_u32(uint8_t *data, uint32_t val)
+{
+    data[0] = val;
+    data[1] = val >> 8;
+    data[2] = val >> 16;
+    data[3] = val >> 24;
+}
+
+static void ring_copy(logger_t *logger,
+                      uint32_t pos,
+                      const void *data,
+                      size_t size)
+{
+    uint32_t off = pos & (logger->ring_size - 1);
+    size_t n = logger->ring_size - off;
+    if (n > size)
+        n = size;
+
+    /* Copy up to the end of the ring, then the wrapped part */
+    memcpy(&logger->ring[off], data, n);
+    memcpy(logger->ring, (const uint8_t *) data + n, size - n);
+}
+
+int logger_open(logger_t *logger, const char *path)
+{
+    uint8_t header[LOGGER_HEADER_SIZE] = {0};
+    memcpy(header, LOGGER_MAGIC, strlen(LOGGER_MAGIC));
+    header[4] = LOGGER_VERSION;
+
+    int fd = open(path, O_RDWR);
+    if (fd < 0)
+        return -1;
+
+    /* Start a new session */
+    if (write(fd, header, sizeof(header)) != sizeof(header)) {
+        close(fd);
+        return -1;
+    }
+
+    logger->fd = fd;
+
+    return 0;
+}
+
+int logger_write(logger_t *logger,
+                 uint32_t timestamp,
+                 int msg_id,
+                 const void *payload,
+                 size_t size)
+{
+    uint32_t head = logger->head;
+    uint32_t tail = __atomic_load_n(&logger->tail, __ATOMIC_ACQUIRE);
+    size_t len = LOGGER_RECORD_HEADER_SIZE + size;
+
+    /* Never wait for the drainer */
+    if (size > UINT8_MAX || len > logger->ring_size - (head - tail)) {
+        logger->drop_timestamp = timestamp;
+        __atomic_store_n(&logger->dropped, logger->dropped + 1,
+                         __ATOMIC_RELEASE);
+        return -1;
+    }
+
+    uint8_t header[LOGGER_RECORD_HEADER_SIZE];
+    header[0] = msg_id;
+    header[1] = size;
+    put_u32(&header[2], timestamp);
+
+    ring_copy(logger, head, header, sizeof(header));
+    ring_copy(logger, head + sizeof(header), payload, size);
+
+    /* Publish the record to the drainer */
+    __atomic_store_n(&logger->head, head + len, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+static ssize_t logger_write_dropped(logger_t *logger, uint32_t dropped)
+{
+    uint8_t record[LOGGER_RECORD_HEADER_SIZE + LOGGER_DROPPED_SIZE];
+    record[0] = LOGGER_MSG_ID_DROPPED;
+    record[1] = LOGGER_DROPPED_SIZE;
+    put_u32(&record[2], logger->drop_timestamp);
+    put_u32(&record[LOGGER_RECORD_HEADER_SIZE],
+            dropped - logger->dropped_logged);
+
+    ssize_t retval = write(logger->fd, record, sizeof(record));
+    if (retval == sizeof(record))
+        logger->dropped_logged = dropped;
+
+    return retval;
+}
+
+ssize_t logger_flush(logger_t *logger)
+{
+    if (logger->fd < 0)
+        return -1;
+
+    uint32_t dropped = __atomic_load_n(&logger->dropped, __ATOMIC_ACQUIRE);
+    uint32_t head = __atomic_load_n(&logger->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = logger->tail;
+    ssize_t total = 0;
+
+    while (tail != head && !logger->full) {
+        uint32_t off = tail & (logger->ring_size - 1);
+        size_t n = head - tail;
+        if (n > logger->ring_size - off)
+            n = logger->ring_size - off;
+
+        ssize_t retval = write(logger->fd, &logger->ring[off], n);
+        if (retval <= 0) {
+            logger->full = true;
+            break;
+        }
+
+        tail += retval;
+        total += retval;
+        __atomic_store_n(&logger->tail, tail, __ATOMIC_RELEASE);
+    }
+
+    /* Stop logging once the storage is full, the records are discarded
+     * rather than counted as dropped */
+    if (logger->full) {
+        __atomic_store_n(&logger->tail, head, __ATOMIC_RELEASE);
+        return -1;
+    }
+
+    if (dropped != logger->dropped_logged) {
+        ssize_t retval = logger_write_dropped(logger, dropped);
+        if (retval > 0)
+            total += retval;
+    }
+
+    return total;
+}
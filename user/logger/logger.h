@@ -0,0 +1,49 @@
+#ifndef __LOGGER_H__
+#define __LOGGER_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/* Log: header ("TLOG", version, 3 reserved bytes) followed by the records:
+ * message ID, payload size, timestamp in microseconds (u32), payload. The
+ * multi-byte fields are little-endian. Every logger_open() starts a new
+ * session with a header appended to the storage */
+#define LOGGER_MAGIC "TLOG"
+#define LOGGER_VERSION 1
+#define LOGGER_HEADER_SIZE 8
+#define LOGGER_RECORD_HEADER_SIZE 6
+
+/* Record counting the records dropped as the ring buffer was full. The
+ * payload is the count (u32) and the timestamp is of the last dropped one */
+#define LOGGER_MSG_ID_DROPPED 0xff
+#define LOGGER_DROPPED_SIZE 4
+
+/* The records are queued into a RAM ring buffer by a single producer, e.g.,
+ * the flight control loop, without blocking, and drained to the storage by
+ * logger_flush() from a background task */
+typedef struct {
+    uint8_t *ring;
+    uint32_t ring_size;      /* Power of two */
+    uint32_t head;           /* Advanced by the producer */
+    uint32_t tail;           /* Advanced by the drainer */
+    uint32_t dropped;        /* Incremented by the producer */
+    uint32_t drop_timestamp; /* Timestamp of the last dropped record */
+    uint32_t dropped_logged; /* Dropped records reported by the drainer */
+    int fd;
+    bool full; /* The storage is full */
+} logger_t;
+
+#define LOGGER_INIT(buf, size) \
+    {.ring = (buf), .ring_size = (size), .fd = -1}
+
+int logger_open(logger_t *logger, const char *path);
+int logger_write(logger_t *logger,
+                 uint32_t timestamp,
+                 int msg_id,
+                 const void *payload,
+                 size_t size);
+ssize_t logger_flush(logger_t *logger);
+
+#endif
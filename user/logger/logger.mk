@@ -0,0 +1,5 @@
+PROJ_ROOT := $(dir $(lastword $(MAKEFILE_LIST)))/../..
+
+CFLAGS += -I $(PROJ_ROOT)/user/logger
+
+SRC += $(PROJ_ROOT)/user/logger/logger.c
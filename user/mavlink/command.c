@@ -0,0 +1,44 @@
+#include <stdint.h>
+
+#include "mavlink.h"
+#include "mavlink/command.h"
+#include "mavlink/publisher.h"
+#include "mavlink/receiver.h"
+#include "mavlink/stream.h"
+
+static uint8_t mav_cmd_set_message_interval(mavlink_command_long_t *cmd)
+{
+    /* param1: Message ID, param2: Interval in us, -1 to disable, or 0 for
+     * the default rate */
+    if (mavlink_stream_set_interval((uint32_t) cmd->param1,
+                                    (int32_t) cmd->param2))
+        return MAV_RESULT_DENIED;
+
+    return MAV_RESULT_ACCEPTED;
+}
+
+void mav_command_long(mavlink_message_t *msg)
+{
+    mavlink_command_long_t cmd;
+    mavlink_msg_command_long_decode(msg, &cmd);
+
+    if (cmd.target_system != 0 && cmd.target_system != MAVLINK_SYS_ID)
+        return;
+
+    uint8_t result;
+
+    switch (cmd.command) {
+    case MAV_CMD_SET_MESSAGE_INTERVAL:
+        result = mav_cmd_set_message_interval(&cmd);
+        break;
+    default:
+        result = MAV_RESULT_UNSUPPORTED;
+        break;
+    }
+
+    mavlink_message_t ack;
+    mavlink_msg_command_ack_pack(MAVLINK_SYS_ID, MAVLINK_COMP_ID, &ack,
+                                 cmd.command, result, 0, 0, msg->sysid,
+                                 msg->compid);
+    mavlink_reply(&ack);
+}
@@ -0,0 +1,8 @@
+#ifndef __TENOK_MAVLINK_COMMAND_H__
+#define __TENOK_MAVLINK_COMMAND_H__
+
+#include "mavlink.h"
+
+void mav_command_long(mavlink_message_t *msg);
+
+#endif
@@ -1,9 +1,43 @@
+#include <fcntl.h>
+#include <sys/sim_time.h>
+#include <unistd.h>
+
 #include "mavlink.h"
+#include "mavlink/hil.h"
+#include "mavlink/publisher.h"
+#include "mavlink/receiver.h"
+#include "mavlink/stream.h"
+
+static int sim_time_fd = -1;
+
+void mav_hil_init(void)
+{
+    /* Run in lockstep with the simulator if the kernel provides the time
+     * source (see SIM_TIME_ENABLE) */
+    sim_time_fd = open(SIM_TIME_DEV, O_WRONLY);
+
+    /* The controls are sent on every simulator step instead */
+    if (sim_time_fd >= 0)
+        mavlink_stream_set_interval(MAVLINK_MSG_ID_HIL_ACTUATOR_CONTROLS,
+                                    MAVLINK_INTERVAL_DISABLED);
+}
 
 void mav_hil_sensor(mavlink_message_t *msg)
 {
     mavlink_hil_sensor_t hil_sensor;
     mavlink_msg_hil_sensor_decode(msg, &hil_sensor);
+
+    if (sim_time_fd < 0)
+        return;
+
+    /* Advance the system time to the sample, the higher priority tasks woken
+     * up by the step run before the write returns */
+    write(sim_time_fd, &hil_sensor.time_usec, sizeof(hil_sensor.time_usec));
+
+    /* The simulator waits for the controls before the next step */
+    mavlink_message_t reply;
+    mavlink_pack_hil_actuator_controls(&reply);
+    mavlink_reply(&reply);
 }
 
 void mav_hil_gps(mavlink_message_t *msg)
@@ -3,6 +3,8 @@
 
 #include "mavlink.h"
 
+void mav_hil_init(void);
+
 void mav_hil_sensor(mavlink_message_t *msg);
 void mav_hil_gps(mavlink_message_t *msg);
 void mav_hil_state_quaternion(mavlink_message_t *msg);
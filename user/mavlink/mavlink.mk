@@ -6,4 +6,7 @@ CFLAGS+=-I$(PROJ_ROOT)/user/mavlink
 # the unwanted features
 SRC+=$(PROJ_ROOT)/user/mavlink/parser.c \
 	$(PROJ_ROOT)/user/mavlink/publisher.c \
+	$(PROJ_ROOT)/user/mavlink/receiver.c \
+	$(PROJ_ROOT)/user/mavlink/stream.c \
+	$(PROJ_ROOT)/user/mavlink/command.c \
 	$(PROJ_ROOT)/user/mavlink/hil.c
@@ -1,18 +1,22 @@
 #include "mavlink/parser.h"
+#include "mavlink/command.h"
 #include "mavlink/hil.h"
 
-struct mavlink_cmd cmd_list[] = {
-    DEF_MAVLINK_CMD(mav_hil_sensor, 107),
-    DEF_MAVLINK_CMD(mav_hil_gps, 113),
-    DEF_MAVLINK_CMD(mav_hil_state_quaternion, 115),
+/* Indexed by the message ID, NULL for the unhandled messages */
+static const mavlink_handler_t cmd_table[MAVLINK_CMD_TABLE_SIZE] = {
+    DEF_MAVLINK_CMD(mav_command_long, MAVLINK_MSG_ID_COMMAND_LONG),
+    DEF_MAVLINK_CMD(mav_hil_sensor, MAVLINK_MSG_ID_HIL_SENSOR),
+    DEF_MAVLINK_CMD(mav_hil_gps, MAVLINK_MSG_ID_HIL_GPS),
+    DEF_MAVLINK_CMD(mav_hil_state_quaternion,
+                    MAVLINK_MSG_ID_HIL_STATE_QUATERNION),
 };
 
 void parse_mavlink_msg(mavlink_message_t *msg)
 {
-    for (int i = 0; i < (signed int) CMD_LEN(cmd_list); i++) {
-        if (msg->msgid == cmd_list[i].msg_id) {
-            cmd_list[i].handler(msg);
-            break;
-        }
-    }
+    if (msg->msgid >= MAVLINK_CMD_TABLE_SIZE)
+        return;
+
+    mavlink_handler_t handler = cmd_table[msg->msgid];
+    if (handler)
+        handler(msg);
 }
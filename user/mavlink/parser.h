@@ -5,17 +5,12 @@
 
 #include "mavlink.h"
 
-#define DEF_MAVLINK_CMD(handler_function, id)     \
-    {                                             \
-        .handler = handler_function, .msg_id = id \
-    }
+/* Message IDs below the size are dispatched by indexing the handler table */
+#define MAVLINK_CMD_TABLE_SIZE 256
 
-#define CMD_LEN(list) (sizeof(list) / sizeof(struct mavlink_cmd))
+#define DEF_MAVLINK_CMD(handler_function, id) [id] = handler_function
 
-struct mavlink_cmd {
-    uint16_t msg_id;
-    void (*handler)(mavlink_message_t *msg);
-};
+typedef void (*mavlink_handler_t)(mavlink_message_t *msg);
 
 void parse_mavlink_msg(mavlink_message_t *msg);
 
@@ -4,8 +4,7 @@
 #include <unistd.h>
 
 #include "mavlink.h"
-
-extern int mavlink_fd;
+#include "mavlink/publisher.h"
 
 void mavlink_send_msg(mavlink_message_t *msg, int fd)
 {
@@ -15,25 +14,20 @@ void mavlink_send_msg(mavlink_message_t *msg, int fd)
     write(fd, buf, len);
 }
 
-void mavlink_send_heartbeat(int fd)
+void mavlink_pack_heartbeat(mavlink_message_t *msg)
 {
-    uint8_t sys_id = 1;
     uint8_t type = MAV_TYPE_QUADROTOR;
     uint8_t autopilot = MAV_AUTOPILOT_PX4;
     uint8_t base_mode = 0;
     uint32_t custom_mode = 0;
     uint8_t sys_status = 0;
 
-    mavlink_message_t msg;
-    mavlink_msg_heartbeat_pack(sys_id, 1, &msg, type, autopilot, base_mode,
-                               custom_mode, sys_status);
-
-    mavlink_send_msg(&msg, fd);
+    mavlink_msg_heartbeat_pack(MAVLINK_SYS_ID, MAVLINK_COMP_ID, msg, type,
+                               autopilot, base_mode, custom_mode, sys_status);
 }
 
-void mavlink_send_hil_actuator_controls(int fd)
+void mavlink_pack_hil_actuator_controls(mavlink_message_t *msg)
 {
-    uint8_t sys_id = 1;
     float ctrls[16] = {0.1, 0.1, 0.1, 0.1};
     uint8_t mode = MAV_MODE_FLAG_HIL_ENABLED | MAV_MODE_FLAG_SAFETY_ARMED |
                    MAV_MODE_FLAG_AUTO_ENABLED;
@@ -43,9 +37,6 @@ void mavlink_send_hil_actuator_controls(int fd)
     clock_gettime(CLOCK_MONOTONIC, &tp);
     uint64_t time_usec = (tp.tv_sec * 1000000) + (tp.tv_nsec / 1000);
 
-    mavlink_message_t msg;
-    mavlink_msg_hil_actuator_controls_pack(sys_id, 1, &msg, time_usec, ctrls,
-                                           mode, 0);
-
-    mavlink_send_msg(&msg, fd);
+    mavlink_msg_hil_actuator_controls_pack(MAVLINK_SYS_ID, MAVLINK_COMP_ID, msg,
+                                           time_usec, ctrls, mode, 0);
 }
@@ -3,8 +3,12 @@
 
 #include "mavlink.h"
 
+#define MAVLINK_SYS_ID 1
+#define MAVLINK_COMP_ID 1
+
+void mavlink_pack_heartbeat(mavlink_message_t *msg);
+void mavlink_pack_hil_actuator_controls(mavlink_message_t *msg);
+
 void mavlink_send_msg(mavlink_message_t *msg, int fd);
-void mavlink_send_heartbeat(int fd);
-void mavlink_send_hil_actuator_controls(int fd);
 
 #endif
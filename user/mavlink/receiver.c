@@ -0,0 +1,100 @@
+#include <stdint.h>
+#include <unistd.h>
+
+#include "mavlink.h"
+#include "mavlink/parser.h"
+#include "mavlink/receiver.h"
+#include "mavlink/stream.h"
+
+struct mavlink_msg_buf {
+    mavlink_message_t msg;
+    uint32_t refcnt; /* Handles held by the consumers */
+};
+
+static struct mavlink_msg_buf msg_pool[MAVLINK_MSG_POOL_SIZE];
+
+/* The buffer being parsed, and the free one to continue with once the
+ * consumers hold the current message */
+static int rx_idx;
+static int rx_next = -1;
+
+/* Read the frames in bulk, parse them in place in the pool and dispatch them
+ * by the message ID. The handlers borrow the message until they return, or
+ * call mavlink_msg_hold() to keep it */
+void mavlink_receive(int fd)
+{
+    uint8_t buf[MAVLINK_RX_BUF_SIZE];
+    mavlink_status_t status = {0}, r_status;
+
+    while (1) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+
+        for (ssize_t i = 0; i < n; i++) {
+            mavlink_message_t *msg = &msg_pool[rx_idx].msg;
+
+            /* Frame directly into the pool buffer, the completed message is
+             * "copied" onto itself */
+            if (mavlink_frame_char_buffer(msg, &status, buf[i], msg,
+                                          &r_status) != MAVLINK_FRAMING_OK)
+                continue;
+
+            parse_mavlink_msg(msg);
+
+            /* Leave the held buffer to its consumers */
+            if (rx_next >= 0) {
+                rx_idx = rx_next;
+                rx_next = -1;
+            }
+        }
+    }
+}
+
+/* Queue the message to the stream scheduler, called by the handlers. The
+ * reply is dropped if the queue is full, as it would be on a lossy link */
+void mavlink_reply(mavlink_message_t *msg)
+{
+    mavlink_stream_queue(msg);
+}
+
+int mavlink_msg_hold(mavlink_message_t *msg)
+{
+    int idx = (struct mavlink_msg_buf *) msg - msg_pool;
+    if (idx < 0 || idx >= MAVLINK_MSG_POOL_SIZE)
+        return -1;
+
+    /* Holding the message being dispatched requires a free buffer for the
+     * receiver to continue with */
+    if (idx == rx_idx && rx_next < 0) {
+        for (int i = 0; i < MAVLINK_MSG_POOL_SIZE; i++) {
+            if (i != rx_idx &&
+                __atomic_load_n(&msg_pool[i].refcnt, __ATOMIC_ACQUIRE) == 0) {
+                rx_next = i;
+                break;
+            }
+        }
+
+        /* The pool is exhausted */
+        if (rx_next < 0)
+            return -1;
+    }
+
+    __atomic_add_fetch(&msg_pool[idx].refcnt, 1, __ATOMIC_RELAXED);
+
+    return idx;
+}
+
+mavlink_message_t *mavlink_msg_get(int handle)
+{
+    if (handle < 0 || handle >= MAVLINK_MSG_POOL_SIZE)
+        return NULL;
+
+    return &msg_pool[handle].msg;
+}
+
+void mavlink_msg_release(int handle)
+{
+    if (handle < 0 || handle >= MAVLINK_MSG_POOL_SIZE)
+        return;
+
+    __atomic_sub_fetch(&msg_pool[handle].refcnt, 1, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,16 @@
+#ifndef __TENOK_MAVLINK_RECEIVER_H__
+#define __TENOK_MAVLINK_RECEIVER_H__
+
+#include "mavlink.h"
+
+#define MAVLINK_RX_BUF_SIZE 128 /* Bytes requested per read() */
+#define MAVLINK_MSG_POOL_SIZE 4 /* Message buffers, one is being parsed */
+
+void mavlink_receive(int fd);
+void mavlink_reply(mavlink_message_t *msg);
+
+int mavlink_msg_hold(mavlink_message_t *msg);
+mavlink_message_t *mavlink_msg_get(int handle);
+void mavlink_msg_release(int handle);
+
+#endif
@@ -0,0 +1,185 @@
+#include <errno.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mavlink.h"
+#include "mavlink/publisher.h"
+#include "mavlink/stream.h"
+
+/* Listed by the priority when the budget runs short */
+static struct mavlink_stream streams[] = {
+    DEF_MAVLINK_STREAM(MAVLINK_MSG_ID_HEARTBEAT, mavlink_pack_heartbeat,
+                       1000000),
+    DEF_MAVLINK_STREAM(MAVLINK_MSG_ID_HIL_ACTUATOR_CONTROLS,
+                       mavlink_pack_hil_actuator_controls, 200000),
+};
+
+#define STREAM_CNT (sizeof(streams) / sizeof(struct mavlink_stream))
+
+/* Replies queued by the receiver, the scheduler is the only writer of the
+ * link so that the frames are not interleaved */
+static mavlink_message_t replies[MAVLINK_REPLY_QUEUE_SIZE];
+static uint32_t reply_head; /* Advanced by the scheduler */
+static uint32_t reply_tail; /* Advanced by the receiver */
+
+static sem_t reply_sem;
+static uint32_t reply_sem_ready;
+
+static uint64_t stream_now_us(void)
+{
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return (uint64_t) tp.tv_sec * 1000000 + tp.tv_nsec / 1000;
+}
+
+static int32_t stream_interval(struct mavlink_stream *stream)
+{
+    int32_t interval = __atomic_load_n(&stream->interval, __ATOMIC_RELAXED);
+    return interval == MAVLINK_INTERVAL_DEFAULT ? stream->default_interval
+                                                : interval;
+}
+
+int mavlink_stream_set_interval(uint32_t msg_id, int32_t interval_us)
+{
+    if (interval_us < MAVLINK_INTERVAL_DISABLED)
+        return -EINVAL;
+
+    for (size_t i = 0; i < STREAM_CNT; i++) {
+        if (streams[i].msg_id == msg_id) {
+            /* The scheduler picks up the change on its next wake-up */
+            __atomic_store_n(&streams[i].interval, interval_us,
+                             __ATOMIC_RELAXED);
+            __atomic_store_n(&streams[i].reset, 1, __ATOMIC_RELEASE);
+            return 0;
+        }
+    }
+
+    return -ENOENT;
+}
+
+/* Queue the message to be sent by the scheduler ahead of the streams, called
+ * by the receiver task only */
+int mavlink_stream_queue(const mavlink_message_t *msg)
+{
+    uint32_t head = __atomic_load_n(&reply_head, __ATOMIC_ACQUIRE);
+    if (reply_tail - head >= MAVLINK_REPLY_QUEUE_SIZE)
+        return -ENOBUFS;
+
+    replies[reply_tail % MAVLINK_REPLY_QUEUE_SIZE] = *msg;
+    __atomic_store_n(&reply_tail, reply_tail + 1, __ATOMIC_RELEASE);
+
+    /* The scheduler drains the queue before its first sleep anyway */
+    if (__atomic_load_n(&reply_sem_ready, __ATOMIC_ACQUIRE))
+        sem_post(&reply_sem);
+
+    return 0;
+}
+
+/* Send the queued replies and the due messages of all streams with a single
+ * write() per wake-up. The budget is refilled at MAVLINK_LINK_BUDGET bytes per
+ * second and a due message not fitting in it waits until it is refilled */
+void mavlink_stream_run(int fd)
+{
+    uint8_t buf[MAVLINK_TX_BUF_SIZE];
+    mavlink_message_t msg;
+
+    /* Bytes allowed to send, scaled by 10^6 to keep the fractions */
+    const uint64_t budget_max = (uint64_t) MAVLINK_TX_BUF_SIZE * 1000000;
+    uint64_t budget = budget_max;
+
+    uint64_t last = stream_now_us();
+
+    sem_init(&reply_sem, 0, 0);
+    __atomic_store_n(&reply_sem_ready, 1, __ATOMIC_RELEASE);
+
+    while (1) {
+        uint64_t now = stream_now_us();
+
+        budget += (now - last) * MAVLINK_LINK_BUDGET;
+        if (budget > budget_max)
+            budget = budget_max;
+        last = now;
+
+        uint64_t wakeup = now + MAVLINK_STREAM_IDLE_US;
+        size_t deficit = 0;
+        size_t len = 0;
+
+        /* The replies go first, in their order, and hold back the streams
+         * until they are sent */
+        bool held = false;
+        uint32_t tail = __atomic_load_n(&reply_tail, __ATOMIC_ACQUIRE);
+        while (reply_head != tail) {
+            mavlink_message_t *reply =
+                &replies[reply_head % MAVLINK_REPLY_QUEUE_SIZE];
+
+            size_t size = reply->len + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+            if (len + size > sizeof(buf) || (len + size) * 1000000 > budget) {
+                deficit = size;
+                held = true;
+                break;
+            }
+
+            len += mavlink_msg_to_send_buffer(&buf[len], reply);
+            __atomic_store_n(&reply_head, reply_head + 1, __ATOMIC_RELEASE);
+        }
+
+        for (size_t i = 0; i < STREAM_CNT; i++) {
+            struct mavlink_stream *stream = &streams[i];
+
+            if (__atomic_exchange_n(&stream->reset, 0, __ATOMIC_ACQUIRE))
+                stream->next = now;
+
+            int32_t interval = stream_interval(stream);
+            if (interval == MAVLINK_INTERVAL_DISABLED)
+                continue;
+
+            if (stream->next <= now) {
+                if (held)
+                    continue;
+
+                stream->pack(&msg);
+
+                /* Keep the message due if it does not fit */
+                size_t size = msg.len + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+                if (len + size > sizeof(buf) ||
+                    (len + size) * 1000000 > budget) {
+                    if (size > deficit)
+                        deficit = size;
+                    continue;
+                }
+
+                len += mavlink_msg_to_send_buffer(&buf[len], &msg);
+
+                /* Skip the missed periods instead of sending a burst */
+                stream->next += interval;
+                if (stream->next <= now)
+                    stream->next = now + interval;
+            }
+
+            if (stream->next < wakeup)
+                wakeup = stream->next;
+        }
+
+        if (len) {
+            write(fd, buf, len);
+            budget -= (uint64_t) len * 1000000;
+        }
+
+        /* Wait until the budget covers the deferred message */
+        if (deficit) {
+            uint64_t need = (uint64_t) deficit * 1000000;
+            uint64_t refill = need > budget ? (need - budget) : 0;
+            uint64_t ready = now + refill / MAVLINK_LINK_BUDGET + 1;
+            if (ready < wakeup)
+                wakeup = ready;
+        }
+
+        /* Sleep until the next due time or a new reply */
+        struct timespec tp = {.tv_sec = wakeup / 1000000,
+                              .tv_nsec = (wakeup % 1000000) * 1000};
+        sem_timedwait(&reply_sem, &tp);
+    }
+}
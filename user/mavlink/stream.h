@@ -0,0 +1,42 @@
+#ifndef __TENOK_MAVLINK_STREAM_H__
+#define __TENOK_MAVLINK_STREAM_H__
+
+#include <stdint.h>
+
+#include "mavlink.h"
+
+/* The streams use at most the given share of the link bandwidth, assuming 10
+ * bits per byte on the UART */
+#define MAVLINK_LINK_BAUDRATE 115200
+#define MAVLINK_LINK_BUDGET_PERCENT 80
+#define MAVLINK_LINK_BUDGET \
+    (MAVLINK_LINK_BAUDRATE / 10 * MAVLINK_LINK_BUDGET_PERCENT / 100)
+
+#define MAVLINK_TX_BUF_SIZE 512       /* Bytes packed per write() */
+#define MAVLINK_STREAM_IDLE_US 100000 /* Longest sleep of the scheduler */
+#define MAVLINK_REPLY_QUEUE_SIZE 4    /* Replies waiting for the scheduler */
+
+/* Interval values as of MAV_CMD_SET_MESSAGE_INTERVAL */
+#define MAVLINK_INTERVAL_DISABLED -1
+#define MAVLINK_INTERVAL_DEFAULT 0
+
+#define DEF_MAVLINK_STREAM(id, pack_function, interval_us) \
+    {                                                      \
+        .msg_id = id, .pack = pack_function,               \
+        .default_interval = interval_us                    \
+    }
+
+struct mavlink_stream {
+    uint32_t msg_id;
+    void (*pack)(mavlink_message_t *msg);
+    int32_t default_interval; /* In us, or MAVLINK_INTERVAL_DISABLED */
+    int32_t interval;         /* Requested interval in us */
+    uint32_t reset;           /* The interval is changed */
+    uint64_t next;            /* Due time in us */
+};
+
+void mavlink_stream_run(int fd);
+int mavlink_stream_queue(const mavlink_message_t *msg);
+int mavlink_stream_set_interval(uint32_t msg_id, int32_t interval_us);
+
+#endif
@@ -3,14 +3,19 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/log_dev.h>
 #include <task.h>
 #include <tenok.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "bsp_drv.h"
 #include "debug_link_attitude_msg.h"
 #include "debug_link_imu_msg.h"
 #include "debug_link_pid_msg.h"
+#include "kconfig.h"
+#include "logger.h"
 #include "madgwick_filter.h"
 #include "pwm.h"
 #include "sbus.h"
@@ -32,14 +37,13 @@
 #define THRUST_PWM_MAX 2075  // 2.075 ms
 #define THRUST_PWM_DIFF (THRUST_PWM_MAX - THRUST_PWM_MIN)
 
-#define FLIGHT_CTRL_FREQ 400                             // Hz
-#define FLIGHT_CTRL_PERIOD (1000.0f / FLIGHT_CTRL_FREQ)  // Millisecond
+#define FLIGHT_CTRL_FREQ 400                                    // Hz
+#define FLIGHT_CTRL_PERIOD_NS (1000000000L / FLIGHT_CTRL_FREQ)  // Nanosecond
 
-/* 10x faster than the control loop frequency we want for
- * enough precision. Note that the unit is microsecond.
- * sleep_time = (1 / freq * 1000) / 10
- */
-#define FLIGHT_CTRL_SLEEP_TIME (100000 / FLIGHT_CTRL_FREQ)
+/* Flight log while the motors are armed, about 33 KB/s at the full rate of
+ * the flight control */
+#define FLIGHT_LOG_RING_SIZE 4096      // Bytes, power of two
+#define FLIGHT_LOG_FLUSH_PERIOD 10000  // Microsecond
 
 typedef struct {
     float kp;
@@ -89,6 +93,13 @@ static float rpy[3];
 static float motors[4];
 static madgwick_t madgwick_ahrs;
 
+#if (LOG_DEV_ENABLE != 0)
+static uint8_t flight_log_ring[FLIGHT_LOG_RING_SIZE];
+static logger_t flight_log =
+    LOGGER_INIT(flight_log_ring, sizeof(flight_log_ring));
+static volatile bool flight_log_armed;
+#endif
+
 float calc_elapsed_time(struct timespec *tp_now, struct timespec *tp_last)
 {
     return (float) (tp_now->tv_sec - tp_last->tv_sec) * 1e3 +
@@ -309,6 +320,32 @@ static void gyro_bias_estimate(int gyro_fd, float gyro_bias[3])
 #endif
 }
 
+#if (LOG_DEV_ENABLE != 0)
+/* Queue the telemetry of the control loop without blocking it */
+static void log_flight_data(uint32_t timestamp, float accel[3], float gyro[3])
+{
+    debug_link_msg_imu_t imu_msg;
+    debug_link_msg_attitude_t att_msg;
+    debug_link_msg_pid_t pid_msg;
+
+    memcpy(imu_msg.accel, accel, sizeof(imu_msg.accel));
+    memcpy(imu_msg.gyro, gyro, sizeof(imu_msg.gyro));
+    logger_write(&flight_log, timestamp, DEBUG_LINK_MSG_ID_imu, &imu_msg,
+                 DEBUG_LINK_MSG_SIZE_imu);
+
+    memcpy(att_msg.q, madgwick_ahrs.q, sizeof(att_msg.q));
+    memcpy(att_msg.rpy, rpy, sizeof(att_msg.rpy));
+    logger_write(&flight_log, timestamp, DEBUG_LINK_MSG_ID_attitude, &att_msg,
+                 DEBUG_LINK_MSG_SIZE_attitude);
+
+    pid_msg.error_rpy[0] = pid_roll.output;
+    pid_msg.error_rpy[1] = pid_pitch.output;
+    pid_msg.error_rpy[2] = pid_yaw_rate.output;
+    logger_write(&flight_log, timestamp, DEBUG_LINK_MSG_ID_pid, &pid_msg,
+                 DEBUG_LINK_MSG_SIZE_pid);
+}
+#endif
+
 bool is_flight_ctrl_running(void)
 {
     return flight_ctrl_running;
@@ -378,24 +415,22 @@ void flight_control_task(void)
     /* Initialize thrusts for motor 1 to 4 */
     disable_all_motors(pwm_fd);
 
-    /* Execution time */
-    struct timespec time_last, time_now;
-    float time_elapsed = 0.0f;
-    clock_gettime(CLOCK_MONOTONIC, &time_last);
+    /* Deadline of the next control loop iteration */
+    struct timespec time_next;
+    clock_gettime(CLOCK_MONOTONIC, &time_next);
 
     /* Forbid ESC calibration */
     flight_ctrl_running = true;
 
     while (1) {
-        /* Loop frequency control */
-        while (time_elapsed < FLIGHT_CTRL_PERIOD) {
-            usleep(FLIGHT_CTRL_SLEEP_TIME);
-
-            clock_gettime(CLOCK_MONOTONIC, &time_now);
-            time_elapsed = calc_elapsed_time(&time_now, &time_last);
+        /* Loop frequency control with an absolute deadline so the period
+         * does not drift */
+        time_next.tv_nsec += FLIGHT_CTRL_PERIOD_NS;
+        if (time_next.tv_nsec >= 1000000000L) {
+            time_next.tv_sec++;
+            time_next.tv_nsec -= 1000000000L;
         }
-        time_last = time_now;
-        time_elapsed = 0;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time_next, NULL);
 
         /* Read RC signal */
         read(rc_fd, &rc, sizeof(sbus_t));
@@ -453,11 +488,49 @@ void flight_control_task(void)
             }
         }
 
+#if (LOG_DEV_ENABLE != 0)
+        /* Log while armed with the deadline of the iteration as the
+         * timestamp */
+        if (!rc.dual_switch1) {
+            flight_log_armed = true;
+            log_flight_data(
+                time_next.tv_sec * 1000000 + time_next.tv_nsec / 1000, accel,
+                gyro);
+        }
+#endif
+
         /* Frequency testing */
         ioctl(freq_tester_fd, FREQ_TESTER, GPIO_TOGGLE);
     }
 }
 
+#if (LOG_DEV_ENABLE != 0)
+void flight_log_task(void)
+{
+    setprogname("flight log");
+
+    /* Start the session once the motors are armed */
+    while (!flight_log_armed)
+        usleep(FLIGHT_LOG_FLUSH_PERIOD);
+
+    /* Open the log storage */
+    if (logger_open(&flight_log, LOG_DEV) < 0) {
+        printf("failed to open the flight log storage.\n\r");
+        exit(1);
+    }
+
+    /* Drain the records queued by the flight control */
+    while (1) {
+        if (logger_flush(&flight_log) < 0) {
+            printf("flight log storage is full.\n\r");
+            exit(1);
+        }
+
+        usleep(FLIGHT_LOG_FLUSH_PERIOD);
+    }
+}
+#endif
+
 void debug_link_task(void)
 {
     setprogname("debug link");
@@ -481,11 +554,25 @@ void debug_link_task(void)
     debug_link_msg_imu_t imu_msg;
     debug_link_msg_attitude_t att_msg;
     debug_link_msg_pid_t pid_msg;
-    uint8_t buf[100];
+
+    /* Send the messages in a batch frame with a single write */
+    uint8_t buf[DEBUG_LINK_BATCH_HEADER_SIZE + DEBUG_LINK_BATCH_TIMESTAMP_SIZE +
+                3 * DEBUG_LINK_BATCH_RECORD_HEADER_SIZE +
+                DEBUG_LINK_MSG_SIZE_imu + DEBUG_LINK_MSG_SIZE_attitude +
+                DEBUG_LINK_MSG_SIZE_pid + DEBUG_LINK_BATCH_CRC_SIZE];
+    debug_link_batch_t batch;
+    debug_link_batch_init(&batch, buf, sizeof(buf));
+
+    struct timespec tp;
     size_t size;
 
     /* 40Hz */
     while (1) {
+        /* Timestamp of the batch in microseconds */
+        clock_gettime(CLOCK_MONOTONIC, &tp);
+        debug_link_batch_begin(&batch, true,
+                               tp.tv_sec * 1000000 + tp.tv_nsec / 1000);
+
         read(accel_fd, accel, sizeof(float[3]));
         read(gyro_fd, gyro, sizeof(float[3]));
         imu_msg.accel[0] = accel[0];
@@ -494,8 +581,7 @@ void debug_link_task(void)
         imu_msg.gyro[0] = gyro[0];
         imu_msg.gyro[1] = gyro[1];
         imu_msg.gyro[2] = gyro[2];
-        size = pack_debug_link_imu_msg(&imu_msg, buf);
-        write(debug_link_fd, buf, size);
+        batch_debug_link_imu_msg(&batch, &imu_msg);
 
         att_msg.q[0] = madgwick_ahrs.q[0];
         att_msg.q[1] = madgwick_ahrs.q[1];
@@ -504,13 +590,14 @@ void debug_link_task(void)
         att_msg.rpy[0] = rpy[0];
         att_msg.rpy[1] = rpy[1];
         att_msg.rpy[2] = rpy[2];
-        size = pack_debug_link_attitude_msg(&att_msg, buf);
-        write(debug_link_fd, buf, size);
+        batch_debug_link_attitude_msg(&batch, &att_msg);
 
         pid_msg.error_rpy[0] = pid_roll.output;
         pid_msg.error_rpy[1] = pid_pitch.output;
         pid_msg.error_rpy[2] = 0.0f;
-        size = pack_debug_link_pid_msg(&pid_msg, buf);
+        batch_debug_link_pid_msg(&batch, &pid_msg);
+
+        size = debug_link_batch_finish(&batch);
         write(debug_link_fd, buf, size);
         usleep(25000);
     }
@@ -518,3 +605,6 @@ void debug_link_task(void)
 
 HOOK_USER_TASK(flight_control_task, THREAD_PRIORITY_MAX, 2048);
 HOOK_USER_TASK(debug_link_task, 3, 1024);
+#if (LOG_DEV_ENABLE != 0)
+HOOK_USER_TASK(flight_log_task, 2, 1024);
+#endif
@@ -39,9 +39,10 @@ int cat(int argc, char *argv[])
     /* Reset read position of the file */
     fseek(file, 0, SEEK_SET);
 
-    /* Calculate the iteration times to print the whole file */
-    int size = stat.st_size / PRINT_SIZE_MAX;
-    if ((stat.st_size % PRINT_SIZE_MAX) > 0)
+    /* Calculate the iteration times to print the whole file, each read
+     * leaves a byte for the null terminator */
+    int size = stat.st_size / (PRINT_SIZE_MAX - 1);
+    if ((stat.st_size % (PRINT_SIZE_MAX - 1)) > 0)
         size++;
 
     /* Read and print the file */
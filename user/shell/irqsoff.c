@@ -0,0 +1,74 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kconfig.h"
+#include "shell.h"
+
+#define IRQSOFF_PATH "/proc/irqsoff"
+#define INTERRUPTS_PATH "/proc/interrupts"
+
+static int irqsoff_print(const char *path)
+{
+    char str[PRINT_SIZE_MAX];
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    while (1) {
+        ssize_t size = read(fd, str, PRINT_SIZE_MAX - 1);
+        if (size <= 0)
+            break;
+
+        str[size] = '\0';
+        shell_puts(str);
+    }
+
+    close(fd);
+
+    return 0;
+}
+
+static int irqsoff_reset(const char *path)
+{
+    int fd = open(path, O_RDWR);
+    if (fd < 0)
+        return -1;
+
+    /* Writing anything resets the statistics */
+    write(fd, "0", 1);
+    close(fd);
+
+    return 0;
+}
+
+int irqsoff(int argc, char *argv[])
+{
+    int retval;
+
+    if (argc == 1) {
+        retval = irqsoff_print(IRQSOFF_PATH);
+        if (retval == 0) {
+            shell_puts("\n\r");
+            retval = irqsoff_print(INTERRUPTS_PATH);
+        }
+    } else if (argc == 2 && !strcmp(argv[1], "reset")) {
+        retval = irqsoff_reset(IRQSOFF_PATH);
+        if (retval == 0)
+            retval = irqsoff_reset(INTERRUPTS_PATH);
+    } else {
+        shell_puts("Usage: irqsoff [reset]\n\r");
+        return 1;
+    }
+
+    if (retval < 0) {
+        shell_puts("irqsoff: tracing is disabled (see IRQSOFF_TRACE_ENABLE)\n\r");
+        return 1;
+    }
+
+    return 0;
+}
+
+HOOK_SHELL_CMD("irqsoff", irqsoff);
@@ -0,0 +1,77 @@
+#include <fcntl.h>
+#include <ioctl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/log_dev.h>
+#include <unistd.h>
+
+#include "shell.h"
+
+#define LOG_DUMP_N_BYTES 32 /* Bytes per line of the dump */
+
+static void log_dump(int fd)
+{
+    static const char hex[] = "0123456789abcdef";
+    uint8_t buf[LOG_DUMP_N_BYTES];
+    char line[LOG_DUMP_N_BYTES * 2 + 1];
+    unsigned int total = 0;
+
+    /* Dump from the start of the log */
+    lseek(fd, 0, SEEK_SET);
+
+    while (1) {
+        ssize_t size = read(fd, buf, sizeof(buf));
+        if (size <= 0)
+            break;
+
+        for (int i = 0; i < size; i++) {
+            line[i * 2] = hex[buf[i] >> 4];
+            line[i * 2 + 1] = hex[buf[i] & 0xf];
+        }
+        line[size * 2] = '\0';
+
+        printf("log,%s\n\r", line);
+        total += size;
+    }
+
+    printf("log,end,%u\n\r", total);
+}
+
+int log_cmd(int argc, char *argv[])
+{
+    if (argc > 2) {
+        shell_puts(
+            "Usage: log [dump|erase]\n\r"
+            "  dump the log and extract it with tools/logextract\n\r");
+        return 1;
+    }
+
+    int fd = open(LOG_DEV, O_RDWR);
+    if (fd < 0) {
+        shell_puts("log: log device is disabled (see LOG_DEV_ENABLE)\n\r");
+        return 1;
+    }
+
+    int retval = 0;
+
+    if (argc == 1) {
+        struct log_dev_status status;
+        ioctl(fd, LOG_DEV_STATUS, (unsigned long) &status);
+        printf("%u of %u bytes used\n\r", (unsigned int) status.used,
+               (unsigned int) status.capacity);
+    } else if (!strcmp(argv[1], "dump")) {
+        log_dump(fd);
+    } else if (!strcmp(argv[1], "erase")) {
+        ioctl(fd, LOG_DEV_ERASE, 0);
+    } else {
+        shell_puts("log: unknown command\n\r");
+        retval = 1;
+    }
+
+    close(fd);
+
+    return retval;
+}
+
+HOOK_SHELL_CMD("log", log_cmd);
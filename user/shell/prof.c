@@ -0,0 +1,93 @@
+#include <fcntl.h>
+#include <ioctl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/prof.h>
+#include <tenok.h>
+#include <unistd.h>
+
+#include "shell.h"
+
+#define PROF_READ_SAMPLES 16
+
+static void prof_print_threads(void)
+{
+    struct thread_stat info;
+    void *next = NULL;
+
+    /* Thread names for symbolizing the samples on the host */
+    do {
+        next = thread_info(&info, next);
+        printf("prof,thread,%d,%s\n\r", info.tid, info.name);
+    } while (next != NULL);
+}
+
+static void prof_dump(int fd)
+{
+    struct prof_sample samples[PROF_READ_SAMPLES];
+    struct prof_status status;
+    int cnt = 0;
+
+    ioctl(fd, PROF_STATUS, (unsigned long) &status);
+    printf("prof,freq,%u\n\r", (unsigned int) status.freq);
+
+    prof_print_threads();
+
+    /* Drain the sample buffer */
+    while (1) {
+        ssize_t size = read(fd, samples, sizeof(samples));
+        if (size <= 0)
+            break;
+
+        int n = size / sizeof(struct prof_sample);
+        for (int i = 0; i < n; i++) {
+            printf("prof,%08x,%08x,%d\n\r", (unsigned int) samples[i].pc,
+                   (unsigned int) samples[i].lr, (int) samples[i].tid);
+        }
+        cnt += n;
+    }
+
+    printf("prof,end,%d,%u\n\r", cnt, (unsigned int) status.dropped);
+}
+
+int prof(int argc, char *argv[])
+{
+    if (argc != 2) {
+        shell_puts(
+            "Usage: prof start|stop|status|dump\n\r"
+            "  dump the samples and symbolize them with tools/prof/prof.py\n\r");
+        return 1;
+    }
+
+    int fd = open(PROF_DEV, O_RDWR);
+    if (fd < 0) {
+        shell_puts("prof: profiler is disabled (see PROFILER_ENABLE)\n\r");
+        return 1;
+    }
+
+    int retval = 0;
+
+    if (!strcmp(argv[1], "start")) {
+        ioctl(fd, PROF_START, 0);
+    } else if (!strcmp(argv[1], "stop")) {
+        ioctl(fd, PROF_STOP, 0);
+    } else if (!strcmp(argv[1], "status")) {
+        struct prof_status status;
+        ioctl(fd, PROF_STATUS, (unsigned long) &status);
+        printf("%s, %u samples at %u Hz, %u dropped\n\r",
+               status.running ? "running" : "stopped",
+               (unsigned int) status.samples, (unsigned int) status.freq,
+               (unsigned int) status.dropped);
+    } else if (!strcmp(argv[1], "dump")) {
+        prof_dump(fd);
+    } else {
+        shell_puts("prof: unknown command\n\r");
+        retval = 1;
+    }
+
+    close(fd);
+
+    return retval;
+}
+
+HOOK_SHELL_CMD("prof", prof);
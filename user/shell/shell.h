@@ -2,6 +2,7 @@
 #define __SHELL_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <sys/limits.h>
 
 #include <common/list.h>
@@ -16,7 +16,15 @@ SRC += $(PROJ_ROOT)/user/shell/echo.c
 SRC += $(PROJ_ROOT)/user/shell/help.c
 SRC += $(PROJ_ROOT)/user/shell/ls.c
 SRC += $(PROJ_ROOT)/user/shell/ps.c
+SRC += $(PROJ_ROOT)/user/shell/prof.c
+SRC += $(PROJ_ROOT)/user/shell/irqsoff.c
+SRC += $(PROJ_ROOT)/user/shell/syscalls.c
+SRC += $(PROJ_ROOT)/user/shell/log.c
 SRC += $(PROJ_ROOT)/user/shell/xxd.c
 SRC += $(PROJ_ROOT)/user/shell/uname.c
 SRC += $(PROJ_ROOT)/user/shell/uptime.c
+
+# Commands of the board drivers
+ifneq ($(ARCH),host)
 SRC += $(PROJ_ROOT)/user/shell/sbus.c
+endif
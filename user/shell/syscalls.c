@@ -0,0 +1,94 @@
+#include <fcntl.h>
+#include <ioctl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/syscall_stat.h>
+#include <unistd.h>
+
+#include "shell.h"
+
+static uint32_t cycles_to_usec(uint64_t cycles, uint32_t freq)
+{
+    return cycles * 1000000ULL / freq;
+}
+
+static void syscalls_print_hist(struct syscall_stat *stat)
+{
+    char range[20];
+
+    for (int i = 0; i < SYSCALL_HIST_BUCKETS; i++) {
+        if (stat->hist[i] == 0)
+            continue;
+
+        /* Bounds of the bucket in cycles */
+        if (i == 0)
+            snprintf(range, sizeof(range), "< 2^%d", SYSCALL_HIST_SHIFT);
+        else
+            snprintf(range, sizeof(range), ">= 2^%d",
+                     SYSCALL_HIST_SHIFT + i - 1);
+
+        printf("%10s %10u\n\r", range, (unsigned int) stat->hist[i]);
+    }
+}
+
+static void syscalls_dump(int fd, bool hist)
+{
+    struct syscall_stat stat;
+    uint32_t freq = 1;
+
+    ioctl(fd, SYSCALL_STAT_FREQ, (unsigned long) &freq);
+
+    printf("%10s %12s %10s %10s  %s\n\r", "calls", "total(us)", "avg(us)",
+           "max(us)", "syscall");
+
+    while (read(fd, &stat, sizeof(stat)) == sizeof(stat)) {
+        /* Average over the returned calls */
+        uint32_t returned = 0;
+        for (int i = 0; i < SYSCALL_HIST_BUCKETS; i++)
+            returned += stat.hist[i];
+
+        uint64_t avg = returned ? stat.cycles / returned : 0;
+
+        printf("%10u %12u %10u %10u  %s\n\r", (unsigned int) stat.cnt,
+               (unsigned int) cycles_to_usec(stat.cycles, freq),
+               (unsigned int) cycles_to_usec(avg, freq),
+               (unsigned int) cycles_to_usec(stat.max, freq), stat.name);
+
+        if (hist)
+            syscalls_print_hist(&stat);
+    }
+}
+
+int syscalls(int argc, char *argv[])
+{
+    bool hist = false;
+
+    if (argc == 2 && !strcmp(argv[1], "hist")) {
+        hist = true;
+    } else if (argc != 1 && !(argc == 2 && !strcmp(argv[1], "reset"))) {
+        shell_puts(
+            "Usage: syscalls [hist|reset]\n\r"
+            "  hist: print the log2 histogram of the latencies in cycles\n\r");
+        return 1;
+    }
+
+    int fd = open(SYSCALL_STAT_DEV, O_RDWR);
+    if (fd < 0) {
+        shell_puts("syscalls: statistics are disabled (see "
+                   "SYSCALL_STAT_ENABLE)\n\r");
+        return 1;
+    }
+
+    if (argc == 2 && !strcmp(argv[1], "reset"))
+        ioctl(fd, SYSCALL_STAT_RESET, 0);
+    else
+        syscalls_dump(fd, hist);
+
+    close(fd);
+
+    return 0;
+}
+
+HOOK_SHELL_CMD("syscalls", syscalls);
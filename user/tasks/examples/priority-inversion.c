@@ -9,8 +9,17 @@
 #include <time.h>
 #include <unistd.h>
 
+#define LOW_HOLD_MS 2000 /* Critical section of the lowest-priority thread */
+#define WAIT_MARGIN_MS 100
+
 static pthread_mutex_t mutex;
 
+static long elapsed_ms(struct timespec *start, struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000 +
+           (end->tv_nsec - start->tv_nsec) / 1000000;
+}
+
 void mutex_task_high(void)
 {
     setprogname("pri-inv-high");
@@ -30,13 +39,24 @@ void mutex_task_high(void)
 
     sleep(5);
 
+    struct timespec start_time, lock_time;
+
     while (1) {
         /* Start the critical section */
+        clock_gettime(CLOCK_MONOTONIC, &start_time);
         pthread_mutex_lock(&mutex);
+        clock_gettime(CLOCK_MONOTONIC, &lock_time);
 
+        long wait_ms = elapsed_ms(&start_time, &lock_time);
         printf(
             "[mutex task high] mutex is locked by the highest-priority "
-            "thread\n\r");
+            "thread after %ld ms\n\r",
+            wait_ms);
+
+        /* The wait is bounded by the critical section of the lowest-priority
+         * thread unless the median one preempts it */
+        if (wait_ms > LOW_HOLD_MS + WAIT_MARGIN_MS)
+            printf("[mutex task high] priority inversion detected\n\r");
 
         /* End the critical section */
         pthread_mutex_unlock(&mutex);
@@ -91,7 +111,7 @@ void mutex_task_low(void)
             "thread\n\r");
 
         /* Simulate some works */
-        sleep(2);
+        usleep(LOW_HOLD_MS * 1000);
 
         /* End the critical section */
         pthread_mutex_unlock(&mutex);
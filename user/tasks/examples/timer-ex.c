@@ -1,4 +1,5 @@
 #include <fcntl.h>
+#include <pthread.h>
 #include <sched.h>
 #include <signal.h>
 #include <stdio.h>
@@ -22,10 +23,16 @@ void timer_task(void)
     struct sigevent sev;
     struct itimerspec its;
 
-    /* Set up the timer callback function */
-    sev.sigev_notify = SIGEV_SIGNAL;
+    /* Give the callback thread enough stack for printf() */
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, 1024);
+
+    /* Set up the timer callback function, which is called by a new
+     * thread of the task on every expiration */
+    sev.sigev_notify = SIGEV_THREAD;
     sev.sigev_notify_function = timer_callback;
-    sev.sigev_notify_attributes = NULL;
+    sev.sigev_notify_attributes = &attr;
     sev.sigev_value.sival_ptr = &timerid;
 
     /* Create a timer */